@@ -27,6 +27,7 @@
 
 #include <log4cxx/basicconfigurator.h>
 #include <log4cxx/logger.h>
+#include <log4cxx/propertyconfigurator.h>
 #if LOG4CXX_VERSION_MAJOR > 0
 #include <log4cxx/rolling/rollingfileappender.h> 
 #else
@@ -284,7 +285,18 @@ void Application::ConfigureLogging()
         }
         Utils::SetEnvironmentString("MIKTEX_LOG_DIR", logDir.ToString());
         Utils::SetEnvironmentString("MIKTEX_LOG_NAME", logName);
-        log4cxx::xml::DOMConfigurator::configure(xmlFileName.ToWideCharString());
+        // prefer the precompiled form of the configuration: reading a
+        // properties file is much cheaper than parsing XML
+        PathName propertiesFileName = xmlFileName;
+        propertiesFileName.SetExtension(".properties");
+        if (File::Exists(propertiesFileName) && File::GetLastWriteTime(propertiesFileName) >= File::GetLastWriteTime(xmlFileName))
+        {
+            log4cxx::PropertyConfigurator::configure(log4cxx::File(propertiesFileName.ToWideCharString()));
+        }
+        else
+        {
+            log4cxx::xml::DOMConfigurator::configure(xmlFileName.ToWideCharString());
+        }
     }
     else
     {
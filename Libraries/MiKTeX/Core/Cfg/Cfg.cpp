@@ -14,6 +14,8 @@
 #include "config.h"
 
 #include <fstream>
+#include <iterator>
+#include <string_view>
 
 #include <fmt/format.h>
 #include <fmt/ostream.h>
@@ -45,25 +47,17 @@ constexpr const char* COMMENT2 = ";;";
 constexpr const char* COMMENT3 = ";;;";
 constexpr const char* COMMENT4 = ";;;;";
 
-MIKTEXSTATICFUNC(string) Trim(const string& str)
+MIKTEXSTATICFUNC(string_view) Trim(string_view str)
 {
-    string result = str;
     constexpr const char* WHITESPACE = " \t\r\n";
-    size_t pos = result.find_last_not_of(WHITESPACE);
-    if (pos != string::npos)
+    size_t pos = str.find_last_not_of(WHITESPACE);
+    if (pos == string_view::npos)
     {
-        result.erase(pos + 1);
+        return string_view();
     }
-    pos = result.find_first_not_of(WHITESPACE);
-    if (pos == string::npos)
-    {
-        result.erase();
-    }
-    else if (pos != 0)
-    {
-        result.erase(0, pos);
-    }
-    return result;
+    str.remove_suffix(str.length() - pos - 1);
+    str.remove_prefix(str.find_first_not_of(WHITESPACE));
+    return str;
 }
 
 Cfg::Value::~Value() noexcept
@@ -80,13 +74,13 @@ public:
     {
     }
 
-    CfgValue(const string& name, const string& lookupName, const string& value, const string& documentation, bool isCommentedOut) :
+    CfgValue(const string& name, const string& lookupName, string&& value, string&& documentation, bool isCommentedOut) :
         commentedOut(isCommentedOut),
-        documentation(documentation),
+        documentation(std::move(documentation)),
         lookupName(lookupName),
-        name(name),
-        value{ value }
+        name(name)
     {
+        this->value.push_back(std::move(value));
     }
 
     ~CfgValue() noexcept override
@@ -158,11 +152,6 @@ public:
     vector<string> value;
 };
 
-inline bool operator<(const CfgValue& lhs, const CfgValue& rhs)
-{
-    return lhs.lookupName < rhs.lookupName;
-}
-
 typedef unordered_map<string, shared_ptr<CfgValue>> ValueMap;
 
 Cfg::Key::~Key() noexcept
@@ -204,17 +193,17 @@ public:
         return it->second;
     }
 
-    vector<CfgValue> GetCfgValues(bool sorted) const
+    vector<const CfgValue*> GetCfgValues(bool sorted) const
     {
-        vector<CfgValue> values;
+        vector<const CfgValue*> values;
         values.reserve(valueMap.size());
         for (const auto& p : valueMap)
         {
-            values.push_back(*p.second);
+            values.push_back(p.second.get());
         }
         if (sorted)
         {
-            sort(values.begin(), values.end());
+            sort(values.begin(), values.end(), [](const CfgValue* lhs, const CfgValue* rhs) { return lhs->lookupName < rhs->lookupName; });
         }
         return values;
     }
@@ -233,11 +222,6 @@ private:
     string name;
 };
 
-inline bool operator<(const CfgKey& lhs, const CfgKey& rhs)
-{
-    return lhs.lookupName < rhs.lookupName;
-}
-
 static const char* const knownSearchPathValues[] =
 {
     "path",
@@ -261,8 +245,9 @@ bool IsSearchPathValue(const string& valueName)
 void CfgKey::WriteValues(ostream& stream) const
 {
     bool isKeyWritten = false;
-    for (const CfgValue& v : GetCfgValues(true))
+    for (const CfgValue* value : GetCfgValues(true))
     {
+        const CfgValue& v = *value;
         if (!isKeyWritten)
         {
             stream
@@ -322,7 +307,7 @@ class WalkCallback
 public:
 
     virtual ~WalkCallback() {}
-    virtual void addData(const string& data) = 0;
+    virtual void addData(string_view data) = 0;
 };
 
 class MD5WalkCallback :
@@ -331,9 +316,9 @@ class MD5WalkCallback :
 
 public:
 
-    void addData(const string& data) override
+    void addData(string_view data) override
     {
-        md5Builder.Update(data.c_str(), data.length());
+        md5Builder.Update(data.data(), data.length());
     }
 
     MD5 GetFinalMD5()
@@ -390,18 +375,18 @@ public:
         }
     }
 
-    void addData(const string& data) override
+    void addData(string_view data) override
     {
         if (isVerifying)
         {
-            if (EVP_DigestVerifyUpdate(mdctx.get(), data.c_str(), data.length()) != 1)
+            if (EVP_DigestVerifyUpdate(mdctx.get(), data.data(), data.length()) != 1)
             {
                 FatalOpenSSLError();
             }
         }
         else
         {
-            if (EVP_DigestSignUpdate(mdctx.get(), data.c_str(), data.length()) != 1)
+            if (EVP_DigestSignUpdate(mdctx.get(), data.data(), data.length()) != 1)
             {
                 FatalOpenSSLError();
             }
@@ -534,17 +519,17 @@ public:
         Write(path, header, nullptr);
     }
 
-    vector<CfgKey> GetCfgKeys(bool sorted) const
+    vector<const CfgKey*> GetCfgKeys(bool sorted) const
     {
-        vector<CfgKey> keys;
+        vector<const CfgKey*> keys;
         keys.reserve(keyMap.size());
         for (const auto& p : keyMap)
         {
-            keys.push_back(*p.second);
+            keys.push_back(p.second.get());
         }
         if (sorted)
         {
-            sort(keys.begin(), keys.end());
+            sort(keys.begin(), keys.end(), [](const CfgKey* lhs, const CfgKey* rhs) { return lhs->lookupName < rhs->lookupName; });
         }
         return keys;
     }
@@ -585,6 +570,7 @@ private:
 
     void Read(const PathName& path, const string& defaultKeyName, int level, bool mustBeSigned, const PathName& publicKeyFile);
     void Read(std::istream& reader, const string& defaultKeyName, int level, bool mustBeSigned, const PathName& publicKeyFile);
+    void Parse(string_view text, const string& defaultKeyName, int level, bool mustBeSigned, const PathName& publicKeyFile);
 
     enum PutMode {
         None,
@@ -592,7 +578,7 @@ private:
         SearchPathAppend
     };
 
-    bool ParseValueDefinition(const string& line, string& valueName, string& value, PutMode& putMode);
+    bool ParseValueDefinition(string_view line, string& valueName, string& value, PutMode& putMode);
 
     void Walk(WalkCallback* callback) const;
 
@@ -600,9 +586,11 @@ private:
 
     shared_ptr<CfgKey> FindKey(const string& keyName) const;
 
+    shared_ptr<CfgKey> GetOrCreateKey(const string& keyName);
+
     void WriteKeys(ostream& stream);
 
-    void PutValue(const string& keyName, const string& valueName, string&& value, PutMode putMode, string&& documentation, bool commentedOut);
+    void PutValue(CfgKey& key, const string& valueName, string&& value, PutMode putMode, string&& documentation, bool commentedOut);
 
     PathName currentFile;
     KeyMap keyMap;
@@ -664,9 +652,9 @@ shared_ptr<CfgKey> CfgImpl::FindKey(const string& keyName) const
 
 void CfgImpl::WriteKeys(ostream& stream)
 {
-    for (const CfgKey& k : GetCfgKeys(true))
+    for (const CfgKey* k : GetCfgKeys(true))
     {
-        k.WriteValues(stream);
+        k->WriteValues(stream);
     }
     if (tracking)
     {
@@ -686,13 +674,14 @@ void CfgImpl::DeleteKey(const string& keyName)
 
 void CfgImpl::Walk(WalkCallback* callback) const
 {
-    for (const CfgKey& key : GetCfgKeys(true))
+    for (const CfgKey* key : GetCfgKeys(true))
     {
         callback->addData("[");
-        callback->addData(key.lookupName);
+        callback->addData(key->lookupName);
         callback->addData("]\n");
-        for (const CfgValue& val : key.GetCfgValues(true))
+        for (const CfgValue* value : key->GetCfgValues(true))
         {
+            const CfgValue& val = *value;
             if (val.value.empty())
             {
                 callback->addData(val.lookupName);
@@ -765,7 +754,7 @@ bool CfgImpl::TryGetValueAsStringVector(const string& keyName, const string& val
     return true;
 }
 
-void CfgImpl::PutValue(const string& keyName_, const string& valueName, string&& value, CfgImpl::PutMode putMode, string&& documentation, bool commentedOut)
+shared_ptr<CfgKey> CfgImpl::GetOrCreateKey(const string& keyName_)
 {
     string keyName = keyName_.empty() ? GetDefaultKeyName() : keyName_;
     if (keyName.empty())
@@ -773,22 +762,25 @@ void CfgImpl::PutValue(const string& keyName_, const string& valueName, string&&
         MIKTEX_UNEXPECTED();
     }
     string lookupKeyName = Utils::MakeLower(keyName);
-    pair<KeyMap::iterator, bool> pair1 = keyMap.insert(make_pair(lookupKeyName, make_shared<CfgKey>(keyName, lookupKeyName)));
-
-    KeyMap::iterator itKey = pair1.first;
-    MIKTEX_ASSERT(itKey != keyMap.end());
+    KeyMap::iterator itKey = keyMap.find(lookupKeyName);
+    if (itKey == keyMap.end())
+    {
+        itKey = keyMap.emplace(lookupKeyName, make_shared<CfgKey>(keyName, lookupKeyName)).first;
+    }
+    return itKey->second;
+}
 
+void CfgImpl::PutValue(CfgKey& key, const string& valueName, string&& value, CfgImpl::PutMode putMode, string&& documentation, bool commentedOut)
+{
     string lookupValueName = Utils::MakeLower(valueName);
-    if (options[Option::NoOverwriteValues] && itKey->second->valueMap.find(lookupValueName) != itKey->second->valueMap.end())
+    ValueMap::iterator itVal = key.valueMap.find(lookupValueName);
+    if (itVal == key.valueMap.end())
     {
-        return;
+        key.valueMap.emplace(lookupValueName, make_shared<CfgValue>(valueName, lookupValueName, std::move(value), std::move(documentation), commentedOut));
     }
-    pair<ValueMap::iterator, bool> pair2 = itKey->second->valueMap.insert(make_pair(lookupValueName, make_shared<CfgValue>(valueName, lookupValueName, value, documentation, commentedOut)));
-
-    if (!pair2.second)
+    else if (!options[Option::NoOverwriteValues])
     {
         // modify existing value
-        ValueMap::iterator itVal = pair2.first;
         if (itVal->second->IsMultiValue() && putMode != None)
         {
             MIKTEX_UNEXPECTED();
@@ -858,12 +850,12 @@ bool CfgImpl::ClearValue(const string& keyName_, const string& valueName)
 
 void CfgImpl::PutValue(const string& keyName, const string& valueName, const string& value)
 {
-    return PutValue(keyName, valueName, string(value), None, "", false);
+    return PutValue(*GetOrCreateKey(keyName), valueName, string(value), None, "", false);
 }
 
 void CfgImpl::PutValue(const string& keyName, const string& valueName, const string& value, const string& documentation, bool commentedOut)
 {
-    return PutValue(keyName, valueName, string(value), None, string(documentation), commentedOut);
+    return PutValue(*GetOrCreateKey(keyName), valueName, string(value), None, string(documentation), commentedOut);
 }
 
 void CfgImpl::Read(const PathName& path, const string& defaultKeyName, int level, bool mustBeSigned, const PathName& publicKeyFile)
@@ -872,12 +864,33 @@ void CfgImpl::Read(const PathName& path, const string& defaultKeyName, int level
     traceStream->WriteLine("core", fmt::format(T_("parsing: {0}..."), path.ToDisplayString()));
     AutoRestore<int> autoRestore1(lineno);
     AutoRestore<PathName> autoRestore(currentFile);
-    std::ifstream reader = File::CreateInputStream(path);
-    Read(reader, defaultKeyName, level, mustBeSigned, publicKeyFile);
-    reader.close();
+    // package manifests are several megabytes: read the file in large
+    // chunks and parse the text in place instead of line by line; the
+    // file is not mapped, because other processes may rewrite it in
+    // place while it is being parsed
+    FileStream stream(File::Open(path, FileMode::Open, FileAccess::Read, false));
+    string text;
+    char buf[64 * 1024];
+    size_t n;
+    while ((n = stream.Read(buf, sizeof(buf))) > 0)
+    {
+        text.append(buf, n);
+    }
+    stream.Close();
+    Parse(text, defaultKeyName, level, mustBeSigned, publicKeyFile);
 }
 
 void CfgImpl::Read(std::istream& reader, const string& defaultKeyName, int level, bool mustBeSigned, const PathName& publicKeyFile)
+{
+    string text{ istreambuf_iterator<char>(reader), istreambuf_iterator<char>() };
+    if (reader.bad())
+    {
+        FATAL_CFG_ERROR(T_("error reading the configuration file"));
+    }
+    Parse(text, defaultKeyName, level, mustBeSigned, publicKeyFile);
+}
+
+void CfgImpl::Parse(string_view text, const string& defaultKeyName, int level, bool mustBeSigned, const PathName& publicKeyFile)
 {
     MIKTEX_ASSERT(!(level > 0 && mustBeSigned));
 
@@ -889,7 +902,7 @@ void CfgImpl::Read(std::istream& reader, const string& defaultKeyName, int level
     bool wasEmpty = Empty();
 
     string keyName = defaultKeyName;
-    string lookupKeyName = Utils::MakeLower(keyName);
+    shared_ptr<CfgKey> key;
     bool ignoreKey = false;
 
     lineno = 0;
@@ -897,10 +910,16 @@ void CfgImpl::Read(std::istream& reader, const string& defaultKeyName, int level
 
     string documentation;
 
-    for (string line; std::getline(reader, line); )
+    for (size_t pos = 0; pos < text.length(); )
     {
+        size_t endOfLine = text.find('\n', pos);
+        if (endOfLine == string_view::npos)
+        {
+            endOfLine = text.length();
+        }
+        string_view line = Trim(text.substr(pos, endOfLine - pos));
+        pos = endOfLine + 1;
         ++lineno;
-        line = Trim(line);
         if (line.empty())
         {
             documentation = "";
@@ -908,7 +927,7 @@ void CfgImpl::Read(std::istream& reader, const string& defaultKeyName, int level
         else if (line[0] == '!')
         {
             documentation = "";
-            Tokenizer tok(line.substr(1), " \t");
+            Tokenizer tok(string(line.substr(1)), " \t");
             if (!tok)
             {
                 FATAL_CFG_ERROR(T_("invalid cfg directive"));
@@ -943,14 +962,14 @@ void CfgImpl::Read(std::istream& reader, const string& defaultKeyName, int level
         else if (line[0] == '[')
         {
             documentation = "";
-            Tokenizer tok(line.substr(1), "]");
+            Tokenizer tok(string(line.substr(1)), "]");
             if (!tok)
             {
                 FATAL_CFG_ERROR(T_("incomplete secion name"));
             }
             keyName = *tok;
-            lookupKeyName = Utils::MakeLower(keyName);
-            ignoreKey = options[Option::NoOverwriteKeys] && keyMap.find(lookupKeyName) != keyMap.end();
+            key = nullptr;
+            ignoreKey = options[Option::NoOverwriteKeys] && keyMap.find(Utils::MakeLower(keyName)) != keyMap.end();
         }
         else if (line.length() >= 3 && line[0] == COMMENT_CHAR && line[1] == COMMENT_CHAR && line[2] == ' ')
         {
@@ -958,7 +977,7 @@ void CfgImpl::Read(std::istream& reader, const string& defaultKeyName, int level
             {
                 documentation += '\n';
             }
-            documentation += &line[3];
+            documentation += line.substr(3);
         }
         else if ((line.length() >= 2 && line[0] == COMMENT_CHAR && (IsAlphaNumericAScii(line[1]) || line[1] == '.')) || IsAlphaNumericAScii(line[0]) || line[0] == '.')
         {
@@ -971,13 +990,17 @@ void CfgImpl::Read(std::istream& reader, const string& defaultKeyName, int level
                 {
                     FATAL_CFG_ERROR(T_("invalid value definition"));
                 }
-                PutValue(keyName, valueName, std::move(value), putMode, std::move(documentation), line[0] == COMMENT_CHAR);
+                if (key == nullptr)
+                {
+                    key = GetOrCreateKey(keyName);
+                }
+                PutValue(*key, valueName, std::move(value), putMode, std::move(documentation), line[0] == COMMENT_CHAR);
             }
         }
         else if (line.length() >= 4 && line[0] == COMMENT_CHAR && line[1] == COMMENT_CHAR && line[2] == COMMENT_CHAR && line[3] == COMMENT_CHAR)
         {
             documentation = "";
-            Tokenizer tok(line.substr(4), " \t");
+            Tokenizer tok(string(line.substr(4)), " \t");
             if (tok)
             {
                 if (*tok == "signature/miktex:")
@@ -992,11 +1015,6 @@ void CfgImpl::Read(std::istream& reader, const string& defaultKeyName, int level
         }
     }
 
-    if (reader.bad() || (reader.fail() && !reader.eof()))
-    {
-        FATAL_CFG_ERROR(T_("error reading the configuration file"));
-    }
-
     if (mustBeSigned && signature.empty())
     {
         FATAL_CFG_ERROR(T_("the configuration file is not signed"));
@@ -1058,7 +1076,7 @@ void CfgImpl::Read(std::istream& reader, const string& defaultKeyName, int level
     }
 }
 
-bool CfgImpl::ParseValueDefinition(const string& line, string& valueName, string& value, CfgImpl::PutMode& putMode)
+bool CfgImpl::ParseValueDefinition(string_view line, string& valueName, string& value, CfgImpl::PutMode& putMode)
 {
     MIKTEX_ASSERT(!line.empty() && (isalnum(line[0]) || line[0] == '.'));
 
@@ -1066,13 +1084,12 @@ bool CfgImpl::ParseValueDefinition(const string& line, string& valueName, string
 
     putMode = None;
 
-    if (posEqual == string::npos || posEqual == 0)
+    if (posEqual == string_view::npos || posEqual == 0)
     {
         return false;
     }
 
-    value = line.substr(posEqual + 1);
-    value = Trim(value);
+    value = Trim(line.substr(posEqual + 1));
 
     if (line[posEqual - 1] == '+')
     {
@@ -1085,8 +1102,7 @@ bool CfgImpl::ParseValueDefinition(const string& line, string& valueName, string
         posEqual -= 1;
     }
 
-    valueName = line.substr(0, posEqual);
-    valueName = Trim(valueName);
+    valueName = Trim(line.substr(0, posEqual));
 
     return true;
 }
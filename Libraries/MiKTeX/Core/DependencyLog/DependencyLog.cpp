@@ -0,0 +1,216 @@
+/* DependencyLog.cpp: binary dependency log
+
+   Copyright (C) 2024 Christian Schenk
+
+   This file is part of the MiKTeX Core Library.
+
+   The MiKTeX Core Library is free software; you can redistribute it
+   and/or modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2, or
+   (at your option) any later version.
+
+   The MiKTeX Core Library is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with the MiKTeX Core Library; if not, write to the Free
+   Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+   02111-1307, USA. */
+
+#include "config.h"
+
+#include <cstdint>
+#include <cstring>
+
+#include <miktex/Core/DependencyLog>
+#include <miktex/Core/File>
+#include <miktex/Core/MD5>
+#include <miktex/Util/PathName>
+
+#include "internal.h"
+
+using namespace std;
+
+using namespace MiKTeX::Core;
+using namespace MiKTeX::Util;
+
+// file layout (integers are little-endian):
+//   char[4] magic
+//   u32 version
+//   u32 number of records
+//   records:
+//     u8 access
+//     u64 size
+//     i64 last write time
+//     u8[16] MD5
+//     u32 path length
+//     char[] path (UTF-8, not terminated)
+const char MAGIC[4] = { 'M', 'X', 'D', 'L' };
+const uint32_t VERSION = 1;
+
+namespace
+{
+  class LogWriter
+  {
+  public:
+    void PutBytes(const void* bytes, size_t n)
+    {
+      const unsigned char* p = reinterpret_cast<const unsigned char*>(bytes);
+      data.insert(data.end(), p, p + n);
+    }
+
+  public:
+    void PutUInt(uint64_t value, size_t n)
+    {
+      for (size_t i = 0; i < n; ++i)
+      {
+        data.push_back(static_cast<unsigned char>(value >> (8 * i)));
+      }
+    }
+
+  public:
+    vector<unsigned char> data;
+  };
+
+  class LogReader
+  {
+  public:
+    LogReader(const vector<unsigned char>& data, const PathName& path) :
+      data(data),
+      path(path)
+    {
+    }
+
+  public:
+    void GetBytes(void* bytes, size_t n)
+    {
+      Need(n);
+      memcpy(bytes, &data[offset], n);
+      offset += n;
+    }
+
+  public:
+    uint64_t GetUInt(size_t n)
+    {
+      Need(n);
+      uint64_t value = 0;
+      for (size_t i = 0; i < n; ++i)
+      {
+        value |= static_cast<uint64_t>(data[offset + i]) << (8 * i);
+      }
+      offset += n;
+      return value;
+    }
+
+  public:
+    void Need(size_t n)
+    {
+      if (n > data.size() - offset)
+      {
+        MIKTEX_FATAL_ERROR_2(T_("The dependency log is corrupted."), "path", path.ToString());
+      }
+    }
+
+  private:
+    const vector<unsigned char>& data;
+
+  private:
+    size_t offset = 0;
+
+  private:
+    const PathName& path;
+  };
+}
+
+vector<DependencyLogRecord> DependencyLog::GetChangedFiles(const vector<DependencyLogRecord>& records, FileAccess access)
+{
+  vector<DependencyLogRecord> result;
+  for (const DependencyLogRecord& record : records)
+  {
+    if (record.access != access)
+    {
+      continue;
+    }
+    if (!File::Exists(record.path))
+    {
+      result.push_back(record);
+      continue;
+    }
+    size_t size = File::GetSize(record.path);
+    if (size != record.size)
+    {
+      result.push_back(record);
+      continue;
+    }
+    if (File::GetLastWriteTime(record.path) == record.lastWriteTime)
+    {
+      continue;
+    }
+    // touched: compare the contents
+    if (MD5::FromFile(record.path) != record.md5)
+    {
+      result.push_back(record);
+    }
+  }
+  return result;
+}
+
+DependencyLogRecord DependencyLog::MakeRecord(const PathName& path, FileAccess access)
+{
+  DependencyLogRecord record;
+  record.access = access;
+  record.path = path;
+  record.size = File::GetSize(path);
+  record.lastWriteTime = File::GetLastWriteTime(path);
+  record.md5 = MD5::FromFile(path);
+  return record;
+}
+
+vector<DependencyLogRecord> DependencyLog::Read(const PathName& path)
+{
+  vector<unsigned char> data = File::ReadAllBytes(path);
+  LogReader reader(data, path);
+  char magic[sizeof(MAGIC)];
+  reader.GetBytes(magic, sizeof(magic));
+  if (memcmp(magic, MAGIC, sizeof(MAGIC)) != 0 || reader.GetUInt(4) != VERSION)
+  {
+    MIKTEX_FATAL_ERROR_2(T_("Not a dependency log."), "path", path.ToString());
+  }
+  uint32_t count = static_cast<uint32_t>(reader.GetUInt(4));
+  vector<DependencyLogRecord> records;
+  for (uint32_t idx = 0; idx < count; ++idx)
+  {
+    DependencyLogRecord record;
+    record.access = static_cast<FileAccess>(reader.GetUInt(1));
+    record.size = static_cast<size_t>(reader.GetUInt(8));
+    record.lastWriteTime = static_cast<time_t>(static_cast<int64_t>(reader.GetUInt(8)));
+    reader.GetBytes(record.md5.data(), record.md5.size());
+    size_t pathLength = static_cast<size_t>(reader.GetUInt(4));
+    string recordPath(pathLength, '\0');
+    reader.GetBytes(&recordPath[0], pathLength);
+    record.path = recordPath;
+    records.push_back(record);
+  }
+  return records;
+}
+
+void DependencyLog::Write(const PathName& path, const vector<DependencyLogRecord>& records)
+{
+  LogWriter writer;
+  writer.PutBytes(MAGIC, sizeof(MAGIC));
+  writer.PutUInt(VERSION, 4);
+  writer.PutUInt(records.size(), 4);
+  for (const DependencyLogRecord& record : records)
+  {
+    string recordPath = record.path.ToString();
+    writer.PutUInt(static_cast<uint64_t>(record.access), 1);
+    writer.PutUInt(record.size, 8);
+    writer.PutUInt(static_cast<uint64_t>(static_cast<int64_t>(record.lastWriteTime)), 8);
+    writer.PutBytes(record.md5.data(), record.md5.size());
+    writer.PutUInt(recordPath.length(), 4);
+    writer.PutBytes(recordPath.data(), recordPath.length());
+  }
+  File::WriteBytes(path, writer.data);
+}
@@ -81,10 +81,10 @@ bool File::Exists(const PathName& path, FileExistsOptionSet options)
   {
     if (S_ISDIR(statbuf.st_mode) != 0)
     {
-      trace_access->WriteLine("core", fmt::format(T_("{0} is a directory"), Q_(path)));
+      trace_access->WriteLine("core", [&]() { return fmt::format(T_("{0} is a directory"), Q_(path)); });
       return false;
     }
-    trace_access->WriteLine("core", fmt::format(T_("accessing file {0}: OK"), Q_(path)));
+    trace_access->WriteLine("core", [&]() { return fmt::format(T_("accessing file {0}: OK"), Q_(path)); });
     return true;
   }
   int error = errno;
@@ -92,7 +92,7 @@ bool File::Exists(const PathName& path, FileExistsOptionSet options)
   {
     MIKTEX_FATAL_CRT_ERROR_2("stat", "path", path.ToString());
   }
-  trace_access->WriteLine("core", fmt::format(T_("accessing file {0}: NOK"), Q_(path)));
+  trace_access->WriteLine("core", [&]() { return fmt::format(T_("accessing file {0}: NOK"), Q_(path)); });
   return false;
 }
 
@@ -454,7 +454,7 @@ FILE* File::Open(const PathName& path, FileMode mode, FileAccess access, bool is
 
   auto trace_files = TraceStream::Open(MIKTEX_TRACE_FILES);
 
-  trace_files->WriteLine("core", fmt::format(T_("opening file {0} ({1} {2} {3})"), Q_(path), static_cast<int>(mode), static_cast<int>(access), static_cast<int>(isTextFile)));
+  trace_files->WriteLine("core", [&]() { return fmt::format(T_("opening file {0} ({1} {2} {3})"), Q_(path), static_cast<int>(mode), static_cast<int>(access), static_cast<int>(isTextFile)); });
 
   int flags = 0;
   string strFlags;
@@ -153,7 +153,7 @@ bool FileNameDatabase::Search(const PathName& relativePath, const string& pathPa
 
   ApplyChangeFile();
 
-  trace_fndb->WriteLine("core", fmt::format(T_("fndb search: rootDirectory={0}, relativePath={1}, pathPattern={2}"), Q_(rootDirectory), Q_(relativePath), Q_(pathPattern)));
+  trace_fndb->WriteLine("core", [&]() { return fmt::format(T_("fndb search: rootDirectory={0}, relativePath={1}, pathPattern={2}"), Q_(rootDirectory), Q_(relativePath), Q_(pathPattern)); });
 
   MIKTEX_ASSERT(result.size() == 0);
   MIKTEX_ASSERT(!PathNameUtil::IsAbsolutePath(relativePath.GetData()));
@@ -177,47 +177,101 @@ bool FileNameDatabase::Search(const PathName& relativePath, const string& pathPa
     pathPattern = scratch1.ToString();
   }
 
-  // check to see whether we have this file name
-  pair<FileNameHashTable::const_iterator, FileNameHashTable::const_iterator> range = fileNames.equal_range(MakeKey(fileName));
-  if (range.first == range.second)
+  PathName key = fileName;
+  key.TransformForComparison();
+
+  // the path pattern is prepared when we see the first candidate
+  bool havePathPattern = false;
+  PathName comparablePathPattern;
+
+  ForEachRecord(key, [&](const char* directory, const char* info)
   {
-    return false;
-  }
+    if (!havePathPattern)
+    {
+      // path pattern must be relative to root directory
+      if (PathName(pathPattern).IsAbsolute())
+      {
+        const char* lpsz = Utils::GetRelativizedPath(pathPattern.c_str(), rootDirectory.GetData());
+        if (lpsz == nullptr)
+        {
+          MIKTEX_FATAL_ERROR_2(T_("Path pattern is not covered by file name database."), "pattern", pathPattern);
+        }
+        pathPattern = lpsz;
+      }
+      comparablePathPattern = pathPattern;
+      comparablePathPattern.TransformForComparison();
+      havePathPattern = true;
+    }
+    PathName relativeDirectory(directory);
+    if (!Match(comparablePathPattern.GetData(), relativeDirectory.TransformForComparison().GetData()))
+    {
+      return true;
+    }
+    PathName path;
+    path = rootDirectory;
+    path /= directory;
+    path /= fileName.ToString();
+    trace_fndb->WriteLine("core", [&]() { return fmt::format(T_("found: {0} ({1})"), Q_(path), Q_(info)); });
+    result.push_back({ path, info });
+    return all;
+  });
+
+  return !result.empty();
+}
 
-  // path pattern must be relative to root directory
-  if (PathName(pathPattern).IsAbsolute())
+template<typename Func> void FileNameDatabase::ForEachMappedRecord(const char* key, Func func) const
+{
+  MIKTEX_ASSERT(hashTable != nullptr);
+  const FileNameDatabaseRecord* table = GetTable();
+  FndbWord hash = FndbHash(key);
+  FndbWord mask = fndbHeader->hashTableSize - 1;
+  for (FndbWord idx = hash & mask; hashTable[idx].record != 0; idx = (idx + 1) & mask)
   {
-    const char* lpsz = Utils::GetRelativizedPath(pathPattern.c_str(), rootDirectory.GetData());
-    if (lpsz == nullptr)
+    if (hashTable[idx].hash != hash)
+    {
+      continue;
+    }
+    FndbWord recordIndex = hashTable[idx].record - 1;
+    if (recordIndex >= fndbHeader->numFiles)
+    {
+      FNDB_DAMAGED_2(T_("Invalid hash table entry."), "rootDirectory", rootDirectory.ToString(), "bucket", std::to_string(idx));
+    }
+    const FileNameDatabaseRecord& rec = table[recordIndex];
+    if (strcmp(GetString(rec.foKey), key) != 0)
+    {
+      continue;
+    }
+    if (!func(recordIndex, rec))
     {
-      MIKTEX_FATAL_ERROR_2(T_("Path pattern is not covered by file name database."), "pattern", pathPattern);
+      return;
     }
-    pathPattern = lpsz;
   }
+}
 
-  PathName comparablePathPattern(pathPattern);
-  comparablePathPattern.TransformForComparison();
-
+template<typename Func> void FileNameDatabase::ForEachRecord(const PathName& key, Func func) const
+{
+  bool stop = false;
+  ForEachMappedRecord(key.GetData(), [&](FndbWord recordIndex, const FileNameDatabaseRecord& rec)
+  {
+    if (erasedRecords.find(recordIndex) != erasedRecords.end())
+    {
+      return true;
+    }
+    stop = !func(GetString(rec.foDirectory), GetString(rec.foInfo));
+    return !stop;
+  });
+  if (stop || fileNames.empty())
+  {
+    return;
+  }
+  pair<FileNameHashTable::const_iterator, FileNameHashTable::const_iterator> range = fileNames.equal_range(key.ToString());
   for (FileNameHashTable::const_iterator it = range.first; it != range.second; ++it)
   {
-    PathName relativeDirectory;
-    relativeDirectory = it->second.GetDirectory();
-    if (Match(comparablePathPattern.GetData(), PathName(relativeDirectory).TransformForComparison().GetData()))
+    if (!func(it->second.GetDirectory().c_str(), it->second.GetInfo().c_str()))
     {
-      PathName path;
-      path = rootDirectory;
-      path /= relativeDirectory.ToString();
-      path /= fileName.ToString();
-      trace_fndb->WriteLine("core", fmt::format(T_("found: {0} ({1})"), Q_(path), Q_(it->second.GetInfo())));
-      result.push_back({ path, it->second.GetInfo() });
-      if (!all)
-      {
-        break;
-      }
+      return;
     }
   }
-
-  return !result.empty();
 }
 
 void FileNameDatabase::Add(const vector<Fndb::Record>& records)
@@ -296,15 +350,13 @@ bool FileNameDatabase::FileExists(const PathName& path)
   string fileName;
   string directory;
   std::tie(fileName, directory) = SplitPath(path);
-  pair<FileNameHashTable::const_iterator, FileNameHashTable::const_iterator> range = fileNames.equal_range(MakeKey(fileName));
-  for (FileNameHashTable::const_iterator it = range.first; it != range.second; ++it)
+  bool found = false;
+  ForEachRecord(PathName(MakeKey(fileName)), [&](const char* recordDirectory, const char* info)
   {
-    if (PathName::Equals(PathName(it->second.GetDirectory()), PathName(directory)))
-    {
-      return true;
-    }
-  }
-  return false;
+    found = PathName::Equals(PathName(recordDirectory), PathName(directory));
+    return !found;
+  });
+  return found;
 }
 
 tuple<string, string> FileNameDatabase::SplitPath(const PathName& path_) const
@@ -340,13 +392,15 @@ void FileNameDatabase::FastInsertRecord(FileNameDatabase::Record&& record)
 bool FileNameDatabase::InsertRecord(FileNameDatabase::Record&& record)
 {
   string key = MakeKey(record.fileName);
-  pair<FileNameHashTable::const_iterator, FileNameHashTable::const_iterator> range = fileNames.equal_range(key);
-  for (FileNameHashTable::const_iterator it = range.first; it != range.second; ++it)
+  bool exists = false;
+  ForEachRecord(PathName(key), [&](const char* directory, const char* info)
   {
-    if (PathName::Equals(PathName(it->second.GetDirectory()), PathName(record.GetDirectory())) == 0)
-    {
-      return false;
-    }
+    exists = PathName::Equals(PathName(directory), PathName(record.GetDirectory()));
+    return !exists;
+  });
+  if (exists)
+  {
+    return false;
   }
   fileNames.insert(pair<string, Record>(std::move(key), std::move(record)));
   return true;
@@ -366,23 +420,39 @@ string FileNameDatabase::MakeKey(const PathName& fileName) const
 
 void FileNameDatabase::EraseRecord(const FileNameDatabase::Record& record)
 {
-  pair<FileNameHashTable::const_iterator, FileNameHashTable::const_iterator> range = fileNames.equal_range(MakeKey(record.fileName));
-  if (range.first == range.second)
+  string key = MakeKey(record.fileName);
+  bool haveFileName = false;
+  vector<FndbWord> toBeErased;
+  ForEachMappedRecord(key.c_str(), [&](FndbWord recordIndex, const FileNameDatabaseRecord& rec)
+  {
+    if (erasedRecords.find(recordIndex) == erasedRecords.end())
+    {
+      haveFileName = true;
+      if (PathName::Equals(PathName(GetString(rec.foDirectory)), PathName(record.GetDirectory())))
+      {
+        toBeErased.push_back(recordIndex);
+      }
+    }
+    return true;
+  });
+  pair<FileNameHashTable::const_iterator, FileNameHashTable::const_iterator> range = fileNames.equal_range(key);
+  if (!haveFileName && range.first == range.second)
   {
     FNDB_DAMAGED_2(T_("The file name record could not be found in the database."), "fileName", record.fileName);
   }
   vector<FileNameHashTable::const_iterator> toBeRemoved;
   for (FileNameHashTable::const_iterator it = range.first; it != range.second; ++it)
   {
-    if (PathName::Equals(PathName(it->second.GetDirectory()), PathName(record.GetDirectory())) == 0)
+    if (PathName::Equals(PathName(it->second.GetDirectory()), PathName(record.GetDirectory())))
     {
       toBeRemoved.push_back(it);
     }
   }
-  if (toBeRemoved.empty())
+  if (toBeErased.empty() && toBeRemoved.empty())
   {
     FNDB_DAMAGED_2(T_("The file name record could not be found in the database."), "fileName", record.fileName, "directory", record.GetDirectory());
   }
+  erasedRecords.insert(toBeErased.begin(), toBeErased.end());
   for (const auto& it : toBeRemoved)
   {
     fileNames.erase(it);
@@ -391,19 +461,11 @@ void FileNameDatabase::EraseRecord(const FileNameDatabase::Record& record)
 
 void FileNameDatabase::ReadFileNames()
 {
+  // records are looked up in the mapped hash table; fileNames only
+  // holds records from the change file
   fileNames.clear();
-  fileNames.rehash(fndbHeader->numFiles);
-  CoreStopWatch stopWatch(fmt::format("fndb read file names {}", Q_(rootDirectory)));
-  ReadFileNames(GetTable());
-}
-
-void FileNameDatabase::ReadFileNames(const FileNameDatabaseRecord* table)
-{
-  for (size_t idx = 0; idx < fndbHeader->numFiles; ++idx)
-  {
-    const FileNameDatabaseRecord* rec = &table[idx];
-    FastInsertRecord(Record(this, GetString(rec->foFileName), rec->foDirectory, rec->foInfo));
-  }
+  erasedRecords.clear();
+  trace_fndb->WriteLine("core", [&]() { return fmt::format(T_("using mapped hash table of {0}: {1} buckets for {2} records"), Q_(rootDirectory), fndbHeader->hashTableSize, fndbHeader->numFiles); });
 }
 
 void FileNameDatabase::Finalize()
@@ -469,7 +531,7 @@ void FileNameDatabase::ApplyChangeFile()
     return;
   }
   MIKTEX_ASSERT(newChangeFileSize > changeFileSize);
-  CoreStopWatch stopWatch(fmt::format(T_("applying FNDB change file {0} starting at record #{1}"), Q_(changeFile), changeFileRecordCount));
+  CoreStopWatch stopWatch([&]() { return fmt::format(T_("applying FNDB change file {0} starting at record #{1}"), Q_(changeFile), changeFileRecordCount); });
   FileStream reader(File::Open(changeFile, FileMode::Open, FileAccess::Read, false));
   if (!File::TryLock(reader.GetFile(), File::LockType::Shared, 2s))
   {
@@ -550,12 +612,33 @@ void FileNameDatabase::OpenFileNameDatabase(const PathName& fndbPath)
   // check version number
   if (fndbHeader->version != FileNameDatabaseHeader::Version)
   {
-    FNDB_DAMAGED_2(T_("Unknown file name database file version."), "path", fndbPath.ToString(), "versionFound", std::to_string(fndbHeader->Version), "versionExpected", std::to_string(FileNameDatabaseHeader::Version));
+    FNDB_DAMAGED_2(T_("Unknown file name database file version."), "path", fndbPath.ToString(), "versionFound", std::to_string(fndbHeader->version), "versionExpected", std::to_string(FileNameDatabaseHeader::Version));
+  }
+
+  // check hash table
+  FndbWord hashTableSize = fndbHeader->hashTableSize;
+  if (hashTableSize == 0
+    || (hashTableSize & (hashTableSize - 1)) != 0
+    || hashTableSize <= fndbHeader->numFiles
+    || fndbHeader->foHashTable < sizeof(FileNameDatabaseHeader)
+    || fndbHeader->foHashTable + static_cast<size_t>(hashTableSize) * sizeof(FileNameDatabaseHashBucket) > foEnd)
+  {
+    FNDB_DAMAGED_2(T_("Invalid hash table."), "path", fndbPath.ToString());
+  }
+
+  // check record table
+  if (fndbHeader->numFiles > 0
+    && (fndbHeader->foTable < sizeof(FileNameDatabaseHeader)
+      || fndbHeader->foTable + static_cast<size_t>(fndbHeader->numFiles) * sizeof(FileNameDatabaseRecord) > foEnd))
+  {
+    FNDB_DAMAGED_2(T_("Invalid record table."), "path", fndbPath.ToString());
   }
+  hashTable = reinterpret_cast<const FileNameDatabaseHashBucket*>(GetPointer(fndbHeader->foHashTable));
 }
 
 void FileNameDatabase::CloseFileNameDatabase()
 {
+  hashTable = nullptr;
   if (mmap != nullptr)
   {
     if (mmap->GetPtr() != nullptr)
@@ -1,6 +1,6 @@
 /* FileNameDatabase.h: file name database                 -*- C++ -*-
 
-   Copyright (C) 1996-2021 Christian Schenk
+   Copyright (C) 1996-2024 Christian Schenk
 
    This file is part of the MiKTeX Core Library.
 
@@ -27,6 +27,8 @@
 #include <atomic>
 #include <chrono>
 #include <tuple>
+#include <unordered_map>
+#include <unordered_set>
 
 #include <miktex/Core/Debug>
 #include <miktex/Core/DirectoryLister>
@@ -78,14 +80,6 @@ public:
 private:
   struct Record
   {
-  public:
-    Record(const FileNameDatabase* fndb, std::string&& fileName, FndbByteOffset foDirectory, FndbByteOffset foInfo) :
-      fndb(fndb),
-      fileName(std::move(fileName)),
-      foDirectory(foDirectory),
-      foInfo(foInfo)
-    {
-    }
   public:
     Record(const std::string& fileName, const std::string& directory, const std::string& info) :
       fileName(fileName),
@@ -101,41 +95,19 @@ private:
     {
     }
   public:
-    std::string GetDirectory() const
+    const std::string& GetDirectory() const
     {
-      if (foDirectory != 0)
-      {
-        MIKTEX_ASSERT(fndb != nullptr);
-        return fndb->GetString(foDirectory);
-      }
-      else
-      {
-        return directory;
-      }
+      return directory;
     }
   public:
-    std::string GetInfo() const
+    const std::string& GetInfo() const
     {
-      if (foInfo != 0)
-      {
-        MIKTEX_ASSERT(fndb != nullptr);
-        return fndb->GetString(foInfo);
-      }
-      else
-      {
-        return info;
-      }
+      return info;
     }
-  private:
-    const FileNameDatabase* fndb = nullptr;
   public:
     std::string fileName;
-  private:
-    FndbByteOffset foDirectory = 0;
   private:
     std::string directory;
-  private:
-    FndbByteOffset foInfo = 0;
   private:
     std::string info;
   };
@@ -162,7 +134,10 @@ private:
   void ReadFileNames();
 
 private:
-  void ReadFileNames(const FileNameDatabaseRecord* table);
+  template<typename Func> void ForEachRecord(const MiKTeX::Util::PathName& key, Func func) const;
+
+private:
+  template<typename Func> void ForEachMappedRecord(const char* key, Func func) const;
 private:
   void Finalize();
 
@@ -237,6 +212,15 @@ private:
 private:
   FileNameHashTable fileNames;
 
+  // the on-disk hash table; fileNames only holds records from the
+  // change file
+private:
+  const FileNameDatabaseHashBucket* hashTable = nullptr;
+
+  // indices of mapped records removed by the change file
+private:
+  std::unordered_set<FndbWord> erasedRecords;
+
 private:
   std::shared_ptr<MiKTeX::Core::FileSystemWatcher> fsWatcher;
 
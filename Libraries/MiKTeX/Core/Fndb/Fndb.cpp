@@ -61,6 +61,7 @@ void Fndb::Add(const vector<Fndb::Record>& records)
       MIKTEX_UNEXPECTED();
     }
     fndb->Add(records);
+    session->InvalidateNegativeFileCache();
   }
   else
   {
@@ -91,6 +92,7 @@ void Fndb::Remove(const vector<PathName>& paths)
     MIKTEX_UNEXPECTED();
   }
   fndb->Remove(paths);
+  session->InvalidateNegativeFileCache();
 }
 
 bool Fndb::FileExists(const PathName& path)
@@ -1,6 +1,6 @@
 /* fndbmem.h: fndb file format                          -*- C++ -*-
 
-   Copyright (C) 1996-2018 Christian Schenk
+   Copyright (C) 1996-2024 Christian Schenk
 
    This file is part of the MiKTeX Core Library.
 
@@ -65,12 +65,21 @@ struct FileNameDatabaseHeader
   
   FndbWord reserved;
 
+  // pointer to hash table
+  FndbByteOffset foHashTable;
+
+  // number of hash table buckets (a power of two)
+  FndbWord hashTableSize;
+
   void Init()
   {
     MIKTEX_ASSERT(sizeof(*this) % 8 == 0);
     signature = Signature;
     version = Version;
     flags = 0;
+    reserved = 0;
+    foHashTable = 0;
+    hashTableSize = 0;
     size = sizeof(*this);
   }
 };
@@ -80,9 +89,32 @@ struct FileNameDatabaseRecord
   FndbByteOffset foFileName;
   FndbByteOffset foDirectory;
   FndbByteOffset foInfo;
-  FndbByteOffset reserved = 0;
+  // pointer to the lookup key
+  FndbByteOffset foKey = 0;
+};
+
+struct FileNameDatabaseHashBucket
+{
+  // hash value of the lookup key
+  FndbWord hash;
+
+  // 1-based record index; 0 marks an empty bucket
+  FndbWord record;
 };
 
+// FNV-1a; the value is stored in the FNDB file, i.e., must not change
+// without bumping the format version
+inline FndbWord FndbHash(const char* key)
+{
+  FndbWord h = 0x811c9dc5;
+  for (; *key != 0; ++key)
+  {
+    h ^= static_cast<uint8_t>(*key);
+    h *= 0x01000193;
+  }
+  return h;
+}
+
 CORE_INTERNAL_END_NAMESPACE;
 
 #endif
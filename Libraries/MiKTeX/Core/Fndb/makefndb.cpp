@@ -21,7 +21,12 @@
 
 #include "config.h"
 
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
 #include <fstream>
+#include <mutex>
 #include <thread>
 #include <unordered_map>
 #include <unordered_set>
@@ -61,6 +66,15 @@ struct FILENAMEINFO
   const string* Info = nullptr;
 };
 
+struct DIRECTORYNODE
+{
+  PathName parentPath;
+  string name;
+  size_t level = 0;
+  vector<FILENAMEINFO> fileNames;
+  vector<unique_ptr<DIRECTORYNODE>> subDirectories;
+};
+
 class FndbManager
 {
 public:
@@ -71,7 +85,7 @@ public:
   }
 
 public:
-  bool Create(const PathName& fndbPath, const PathName& rootPath, ICreateFndbCallback* callback, bool enableStringPooling, bool storeFileNameInfo);
+  bool Create(const PathName& fndbPath, const PathName& rootPath, ICreateFndbCallback* callback, bool enableStringPooling, bool storeFileNameInfo, unsigned numThreads);
 
 private:
   void* GetMemPointer()
@@ -129,15 +143,30 @@ private:
 private:
   void AlignMem(size_t align = 8);
 
+private:
+  static FndbWord GetHashTableSize(size_t numRecords);
+
+private:
+  void InsertHashBucket(const FileNameDatabaseHeader& fndb, FndbWord hash, FndbWord recordIndex);
+
 private:
   static void GetIgnorableFiles(const PathName& dirPath, vector<string>& filesToBeIgnored);
 
 public:
-  void ReadDirectory(const PathName& dirPath, vector<string>& subDirectoryNames, vector<FILENAMEINFO>& fileNames, bool doCleanUp);
+  void ReadDirectory(const PathName& dirPath, vector<string>& subDirectoryNames, vector<FILENAMEINFO>& fileNames, bool doCleanUp, unordered_set<string>& stringPool);
 
 private:
   void CollectFiles(const PathName& parentPath, const PathName& folderName, vector<FILENAMEINFO>& fileNames);
 
+private:
+  void ScanDirectory(DIRECTORYNODE& node, unordered_set<string>& stringPool);
+
+private:
+  void ScanDirectories(DIRECTORYNODE& root, unsigned numThreads);
+
+private:
+  void CollectFiles(DIRECTORYNODE& node, vector<FILENAMEINFO>& fileNames);
+
 private:
   PathName rootPath;
 
@@ -161,7 +190,10 @@ private:
 
 private:
   unordered_set<string> stringPool;
-  
+
+private:
+  vector<unordered_set<string>> threadStringPools;
+
 private:
   typedef unordered_map<string, FndbByteOffset> StringMap;
 
@@ -252,6 +284,33 @@ void FndbManager::AlignMem(size_t align)
   }
 }
 
+FndbWord FndbManager::GetHashTableSize(size_t numRecords)
+{
+  // keep the load factor at or below 0.5 so that linear probing stays short
+  FndbWord size = 8;
+  while (size < 2 * numRecords)
+  {
+    size *= 2;
+  }
+  return size;
+}
+
+void FndbManager::InsertHashBucket(const FileNameDatabaseHeader& fndb, FndbWord hash, FndbWord recordIndex)
+{
+  FndbWord mask = fndb.hashTableSize - 1;
+  for (FndbWord idx = hash & mask; ; idx = (idx + 1) & mask)
+  {
+    FndbByteOffset fo = fndb.foHashTable + idx * sizeof(FileNameDatabaseHashBucket);
+    FileNameDatabaseHashBucket* bucket = reinterpret_cast<FileNameDatabaseHashBucket*>(byteArray.data() + fo);
+    if (bucket->record == 0)
+    {
+      bucket->hash = hash;
+      bucket->record = recordIndex + 1;
+      return;
+    }
+  }
+}
+
 void FndbManager::GetIgnorableFiles(const PathName& dirPath, vector<string>& filesToBeIgnored)
 {
   PathName ignoreFile(dirPath / FN_MIKTEXIGNORE);
@@ -268,7 +327,7 @@ void FndbManager::GetIgnorableFiles(const PathName& dirPath, vector<string>& fil
   sort(filesToBeIgnored.begin(), filesToBeIgnored.end(), StringComparerIgnoringCase());
 }
 
-void FndbManager::ReadDirectory(const PathName& dirPath, vector<string>& subDirectoryNames, vector<FILENAMEINFO>& fileNames, bool doCleanUp)
+void FndbManager::ReadDirectory(const PathName& dirPath, vector<string>& subDirectoryNames, vector<FILENAMEINFO>& fileNames, bool doCleanUp, unordered_set<string>& stringPool)
 {
   if (!Directory::Exists(dirPath))
   {
@@ -372,7 +431,7 @@ void FndbManager::CollectFiles(const PathName& parentPath, const PathName& folde
 
   if (!done)
   {
-    ReadDirectory(path, subDirectoryNames, fileNames, true);
+    ReadDirectory(path, subDirectoryNames, fileNames, true, stringPool);
   }
 
   numDirectories += subDirectoryNames.size();
@@ -390,7 +449,160 @@ void FndbManager::CollectFiles(const PathName& parentPath, const PathName& folde
   --currentLevel;
 }
 
-bool FndbManager::Create(const PathName& fndbPath, const PathName& rootPath, ICreateFndbCallback* callback, bool enableStringPooling, bool storeFileNameInfo)
+void FndbManager::ScanDirectory(DIRECTORYNODE& node, unordered_set<string>& stringPool)
+{
+  vector<string> subDirectoryNames;
+  PathName path(node.parentPath / node.name);
+  path.MakeFullyQualified();
+  ReadDirectory(path, subDirectoryNames, node.fileNames, true, stringPool);
+  PathName pathFolder(node.parentPath / node.name);
+  node.subDirectories.reserve(subDirectoryNames.size());
+  for (const string& s : subDirectoryNames)
+  {
+    unique_ptr<DIRECTORYNODE> subDirectory = make_unique<DIRECTORYNODE>();
+    subDirectory->parentPath = pathFolder;
+    subDirectory->name = s;
+    subDirectory->level = node.level + 1;
+    node.subDirectories.push_back(move(subDirectory));
+  }
+}
+
+// Scan the directory tree with numThreads workers.  Each worker owns a
+// deque of pending directories: it takes work from the back of its own
+// deque and steals from the front of the others.  The result is a tree
+// which mirrors the directory structure, so that the serial traversal
+// order can be restored afterwards.
+void FndbManager::ScanDirectories(DIRECTORYNODE& root, unsigned numThreads)
+{
+  struct WorkQueue
+  {
+    mutex mtx;
+    deque<DIRECTORYNODE*> nodes;
+  };
+  vector<WorkQueue> queues(numThreads);
+  threadStringPools.resize(numThreads);
+  atomic<size_t> pending(1);
+  atomic<bool> failed(false);
+  exception_ptr firstException;
+  mutex idleMutex;
+  condition_variable workAvailable;
+  queues[0].nodes.push_back(&root);
+
+  auto takeWork = [&](unsigned self) -> DIRECTORYNODE*
+  {
+    {
+      lock_guard<mutex> lock(queues[self].mtx);
+      if (!queues[self].nodes.empty())
+      {
+        DIRECTORYNODE* node = queues[self].nodes.back();
+        queues[self].nodes.pop_back();
+        return node;
+      }
+    }
+    for (unsigned i = 1; i < numThreads; ++i)
+    {
+      WorkQueue& victim = queues[(self + i) % numThreads];
+      lock_guard<mutex> lock(victim.mtx);
+      if (!victim.nodes.empty())
+      {
+        DIRECTORYNODE* node = victim.nodes.front();
+        victim.nodes.pop_front();
+        return node;
+      }
+    }
+    return nullptr;
+  };
+
+  auto worker = [&](unsigned self)
+  {
+    while (pending > 0 && !failed)
+    {
+      DIRECTORYNODE* node = takeWork(self);
+      if (node == nullptr)
+      {
+        unique_lock<mutex> lock(idleMutex);
+        workAvailable.wait_for(lock, chrono::milliseconds(10));
+        continue;
+      }
+      try
+      {
+        ScanDirectory(*node, threadStringPools[self]);
+      }
+      catch (...)
+      {
+        lock_guard<mutex> lock(idleMutex);
+        if (!failed)
+        {
+          firstException = current_exception();
+          failed = true;
+        }
+        workAvailable.notify_all();
+        return;
+      }
+      if (!node->subDirectories.empty())
+      {
+        pending += node->subDirectories.size();
+        {
+          lock_guard<mutex> lock(queues[self].mtx);
+          for (auto it = node->subDirectories.rbegin(); it != node->subDirectories.rend(); ++it)
+          {
+            queues[self].nodes.push_back(it->get());
+          }
+        }
+        workAvailable.notify_all();
+      }
+      if (--pending == 0)
+      {
+        lock_guard<mutex> lock(idleMutex);
+        workAvailable.notify_all();
+      }
+    }
+  };
+
+  vector<thread> threads;
+  threads.reserve(numThreads - 1);
+  for (unsigned i = 1; i < numThreads; ++i)
+  {
+    try
+    {
+      threads.push_back(thread(worker, i));
+    }
+    catch (const system_error& e)
+    {
+      trace_error->WriteLine("core", fmt::format(T_("cannot start directory scanner thread: {0}"), e.what()));
+      break;
+    }
+  }
+  worker(0);
+  for (thread& t : threads)
+  {
+    t.join();
+  }
+  if (firstException)
+  {
+    rethrow_exception(firstException);
+  }
+}
+
+// Flatten the directory tree in the order of the serial traversal; the
+// records, and therefore the file contents, do not depend on which
+// worker scanned which directory.
+void FndbManager::CollectFiles(DIRECTORYNODE& node, vector<FILENAMEINFO>& fileNames)
+{
+  if (node.level > deepestLevel)
+  {
+    deepestLevel = node.level;
+  }
+  fileNames.insert(fileNames.end(), make_move_iterator(node.fileNames.begin()), make_move_iterator(node.fileNames.end()));
+  numDirectories += node.subDirectories.size();
+  for (unique_ptr<DIRECTORYNODE>& subDirectory : node.subDirectories)
+  {
+    // RECURSION
+    CollectFiles(*subDirectory, fileNames);
+  }
+}
+
+bool FndbManager::Create(const PathName& fndbPath, const PathName& rootPath, ICreateFndbCallback* callback, bool enableStringPooling, bool storeFileNameInfo, unsigned numThreads)
 {
   trace_fndb->WriteLine("core", fmt::format(T_("creating fndb file {0}..."), Q_(fndbPath)));
   unsigned rootIdx = SESSION_IMPL()->DeriveTEXMFRoot(rootPath);
@@ -409,11 +621,30 @@ bool FndbManager::Create(const PathName& fndbPath, const PathName& rootPath, ICr
     currentLevel = 0;
     this->callback = callback;
     vector<FILENAMEINFO> fileNames;
-    CollectFiles(rootPath, PathName(CURRENT_DIRECTORY), fileNames);
+    if (numThreads == 0)
+    {
+      numThreads = std::max(thread::hardware_concurrency(), 1u);
+    }
+    if (callback == nullptr && numThreads > 1)
+    {
+      trace_fndb->WriteLine("core", fmt::format(T_("scanning {0} with {1} threads"), Q_(rootPath), numThreads));
+      DIRECTORYNODE root;
+      root.parentPath = rootPath;
+      root.name = CURRENT_DIRECTORY;
+      ScanDirectories(root, numThreads);
+      CollectFiles(root, fileNames);
+    }
+    else
+    {
+      CollectFiles(rootPath, PathName(CURRENT_DIRECTORY), fileNames);
+    }
     numFiles = fileNames.size();
     AlignMem();
     fndb.foTable = ReserveMem(fileNames.size() * sizeof(FileNameDatabaseRecord));
     AlignMem();
+    fndb.hashTableSize = GetHashTableSize(fileNames.size());
+    fndb.foHashTable = ReserveMem(fndb.hashTableSize * sizeof(FileNameDatabaseHashBucket));
+    AlignMem();
     fndb.foStrings = GetMemTop();
     for (size_t idx = 0; idx < fileNames.size(); ++idx)
     {
@@ -421,7 +652,11 @@ bool FndbManager::Create(const PathName& fndbPath, const PathName& rootPath, ICr
       rec.foFileName = PushBack(fileNames[idx].FileName.c_str());
       rec.foDirectory = PushBack(fileNames[idx].Directory->c_str());
       rec.foInfo = PushBack(fileNames[idx].Info == nullptr ? "" : fileNames[idx].Info->c_str());
+      PathName key(fileNames[idx].FileName);
+      key.TransformForComparison();
+      rec.foKey = fileNames[idx].FileName == key.GetData() ? rec.foFileName : PushBack(key.GetData());
       SetMem(static_cast<unsigned>(fndb.foTable + idx * sizeof(rec)), &rec, sizeof(rec));
+      InsertHashBucket(fndb, FndbHash(key.GetData()), static_cast<FndbWord>(idx));
     }
     fndb.numDirs = static_cast<unsigned>(numDirectories);
     fndb.numFiles = static_cast<unsigned>(numFiles);
@@ -484,10 +719,17 @@ bool Fndb::Create(const PathName& fndbPath, const PathName& rootPath, ICreateFnd
 }
 
 bool Fndb::Create(const PathName& fndbPath, const PathName& rootPath, ICreateFndbCallback* callback, bool enableStringPooling, bool storeFileNameInfo)
+{
+  // callers which have not asked for threads (e.g., lazy FNDB creation
+  // in a TeX process) scan serially
+  return Fndb::Create(fndbPath, rootPath, callback, enableStringPooling, storeFileNameInfo, 1);
+}
+
+bool Fndb::Create(const PathName& fndbPath, const PathName& rootPath, ICreateFndbCallback* callback, bool enableStringPooling, bool storeFileNameInfo, unsigned numThreads)
 {
   FndbManager fndbmngr;
 
-  if (!fndbmngr.Create(fndbPath, rootPath, callback, enableStringPooling, storeFileNameInfo))
+  if (!fndbmngr.Create(fndbPath, rootPath, callback, enableStringPooling, storeFileNameInfo, numThreads))
   {
     return false;
   }
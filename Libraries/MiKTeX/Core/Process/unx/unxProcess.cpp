@@ -16,7 +16,9 @@
 #include <fmt/format.h>
 #include <fmt/ostream.h>
 
+#include <fcntl.h>
 #include <signal.h>
+#include <spawn.h>
 #include <sys/wait.h>
 #include <unistd.h>
 
@@ -33,17 +35,20 @@
 #   include <sys/user.h>
 #   include <kvm.h>
 #   include <libprocstat.h>
-#   include <fcntl.h>
 #endif
 
+#include <mutex>
 #include <thread>
 #include <tuple>
+#include <unordered_map>
 
 #include <miktex/Core/AutoResource>
 #include <miktex/Core/Directory>
 #include <miktex/Core/Environment>
+#include <miktex/Core/File>
 #include <miktex/Core/CommandLineBuilder>
 #include <miktex/Core/StreamReader>
+#include <miktex/Core/Utils>
 #include <miktex/Trace/Trace>
 #include <miktex/Trace/TraceStream>
 
@@ -66,12 +71,14 @@ const int filenoStdin = 0;
 const int filenoStdout = 1;
 const int filenoStderr = 2;
 
+// The duplicate is closed on exec: the spawn file actions dup2() it
+// onto the child's standard handles, which clears the flag there.
 MIKTEXSTATICFUNC(int) Dup(int fd)
 {
-    int dupfd = dup(fd);
+    int dupfd = fcntl(fd, F_DUPFD_CLOEXEC, 0);
     if (dupfd < 0)
     {
-        MIKTEX_FATAL_CRT_ERROR("dup");
+        MIKTEX_FATAL_CRT_ERROR("fcntl");
     }
     return dupfd;
 }
@@ -108,12 +115,28 @@ public:
         }
     }
 
+    // Both ends are closed on exec, so that concurrently started children
+    // do not inherit them and keep the pipe open.
     void Create()
     {
+#if defined(__APPLE__)
         if (pipe(twofd) < 0)
         {
             MIKTEX_FATAL_CRT_ERROR("pipe");
         }
+        for (int fd : twofd)
+        {
+            if (fcntl(fd, F_SETFD, FD_CLOEXEC) < 0)
+            {
+                MIKTEX_FATAL_CRT_ERROR("fcntl");
+            }
+        }
+#else
+        if (pipe2(twofd, O_CLOEXEC) < 0)
+        {
+            MIKTEX_FATAL_CRT_ERROR("pipe2");
+        }
+#endif
     }
 
     int GetReadEnd() const
@@ -193,6 +216,123 @@ tuple<char*, char**> CreateEnvironmentBlock(const unordered_map<string, string>&
     return make_tuple(environmentStrings, environmentPointers);
 }
 
+// Resolved helper programs are remembered, because each process start
+// unloads the file name database, which the next search would have to
+// load again. The search depends on the TEXMF roots and on PATH, so
+// both are part of the key.
+MIKTEXSTATICFUNC(string) MakeExecutableCacheKey(shared_ptr<SessionImpl> session, const string& name)
+{
+    string key = name;
+    unsigned numRoots = session->GetNumberOfTEXMFRoots();
+    for (unsigned r = 0; r < numRoots; ++r)
+    {
+        key += '\n';
+        key += session->GetRootDirectoryPath(r).ToString();
+    }
+    string envPath;
+    if (Utils::GetEnvironmentString("PATH", envPath))
+    {
+        key += '\n';
+        key += envPath;
+    }
+    return key;
+}
+
+MIKTEXSTATICFUNC(bool) FindExecutable(shared_ptr<SessionImpl> session, const string& name, PathName& path)
+{
+    static mutex cacheMutex;
+    static unordered_map<string, PathName> cache;
+    string key = MakeExecutableCacheKey(session, name);
+    {
+        lock_guard<mutex> lock(cacheMutex);
+        auto it = cache.find(key);
+        if (it != cache.end() && File::Exists(it->second))
+        {
+            path = it->second;
+            return true;
+        }
+    }
+    if (!session->FindFile(name, FileType::EXE, path))
+    {
+        return false;
+    }
+    lock_guard<mutex> lock(cacheMutex);
+    cache[key] = path;
+    return true;
+}
+
+// Starts the child with posix_spawn(), which, unlike fork(), does not
+// have to copy the page tables of this process. Returns -1, if the
+// child could not be started.
+MIKTEXSTATICFUNC(pid_t) Spawn(const PathName& fileName, const Argv& argv, char** environmentPointers, const Pipe& pipeStdout, const Pipe& pipeStderr, const Pipe& pipeStdin, int fdChildStderr, int fdChildStdin, TraceStream* trace_process)
+{
+    posix_spawn_file_actions_t fileActions;
+    if (posix_spawn_file_actions_init(&fileActions) != 0)
+    {
+        return -1;
+    }
+    MIKTEX_AUTO(posix_spawn_file_actions_destroy(&fileActions));
+    int err = 0;
+    auto addDup2 = [&](int fd, int fd2)
+    {
+        if (err == 0 && fd != fd2)
+        {
+            err = posix_spawn_file_actions_adddup2(&fileActions, fd, fd2);
+        }
+    };
+    auto addClose = [&](int fd)
+    {
+        if (err == 0 && fd > filenoStderr)
+        {
+            err = posix_spawn_file_actions_addclose(&fileActions, fd);
+        }
+    };
+    if (pipeStdout.GetWriteEnd() >= 0)
+    {
+        addDup2(pipeStdout.GetWriteEnd(), filenoStdout);
+    }
+    if (pipeStderr.GetWriteEnd() >= 0)
+    {
+        addDup2(pipeStderr.GetWriteEnd(), filenoStderr);
+    }
+    else if (fdChildStderr >= 0)
+    {
+        addDup2(fdChildStderr, filenoStderr);
+        addClose(fdChildStderr);
+    }
+    if (pipeStdin.GetReadEnd() >= 0)
+    {
+        addDup2(pipeStdin.GetReadEnd(), filenoStdin);
+    }
+    else if (fdChildStdin >= 0)
+    {
+        addDup2(fdChildStdin, filenoStdin);
+        addClose(fdChildStdin);
+    }
+    for (const Pipe* pipe : { &pipeStdout, &pipeStderr, &pipeStdin })
+    {
+        if (pipe->GetReadEnd() >= 0)
+        {
+            addClose(pipe->GetReadEnd());
+        }
+        if (pipe->GetWriteEnd() >= 0)
+        {
+            addClose(pipe->GetWriteEnd());
+        }
+    }
+    pid_t pid = -1;
+    if (err == 0)
+    {
+        err = posix_spawn(&pid, fileName.GetData(), &fileActions, nullptr, const_cast<char* const*>(argv.GetArgv()), environmentPointers);
+    }
+    if (err != 0)
+    {
+        trace_process->WriteLine("core", TraceLevel::Warning, [&]() { return fmt::format("posix_spawn failed: {0}", strerror(err)); });
+        return -1;
+    }
+    return pid;
+}
+
 unique_ptr<Process> Process::Start(const ProcessStartInfo& startinfo)
 {
     return make_unique<unxProcess>(startinfo);
@@ -214,7 +354,7 @@ void unxProcess::Create()
 
     PathName fileName;
 
-    if (PathNameUtil::IsAbsolutePath(startinfo.FileName) || !session->FindFile(startinfo.FileName, FileType::EXE, fileName))
+    if (PathNameUtil::IsAbsolutePath(startinfo.FileName) || !FindExecutable(session, startinfo.FileName, fileName))
     {
         fileName = startinfo.FileName;
     }
@@ -273,9 +413,19 @@ void unxProcess::Create()
 
     session->UnloadFilenameDatabase();
 
+    // spawn, if nothing has to be done in the child before exec
+    if (!startinfo.Daemonize && startinfo.WorkingDirectory.empty())
+    {
+        trace_process->WriteLine("core", TraceLevel::Info, "spawning...");
+        pid = Spawn(fileName, argv, environmentPointers, pipeStdout, pipeStderr, pipeStdin, fdChildStderr, fdChildStdin, trace_process.get());
+    }
+
     // fork
-    trace_process->WriteLine("core", TraceLevel::Info, "forking...");
-    pid = fork();
+    if (pid < 0)
+    {
+        trace_process->WriteLine("core", TraceLevel::Info, "forking...");
+        pid = fork();
+    }
     if (pid < 0)
     {
         MIKTEX_FATAL_CRT_ERROR("fork");
@@ -0,0 +1,282 @@
+/* DirectoryTreeCache.cpp: cached directory listings
+
+   Copyright (C) 2024 Christian Schenk
+
+   This file is part of the MiKTeX Core Library.
+
+   The MiKTeX Core Library is free software; you can redistribute it
+   and/or modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2, or
+   (at your option) any later version.
+
+   The MiKTeX Core Library is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with the MiKTeX Core Library; if not, write to the Free
+   Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+   02111-1307, USA. */
+
+#include "config.h"
+
+#include <cstdlib>
+
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <system_error>
+#include <thread>
+
+#include <miktex/Core/Debug>
+#include <miktex/Core/Directory>
+#include <miktex/Core/DirectoryLister>
+#include <miktex/Core/File>
+#include <miktex/Core/TemporaryFile>
+#include <miktex/Util/StringUtil>
+
+#include "internal.h"
+
+#include "Session/DirectoryTreeCache.h"
+
+using namespace std;
+
+using namespace MiKTeX::Core;
+using namespace MiKTeX::Util;
+
+const char* const FILE_HEADER = "miktex-dirtree 2";
+
+vector<string> DirectoryTreeCache::GetSubdirectories(const PathName& directory)
+{
+  return Refresh(directory);
+}
+
+vector<string> DirectoryTreeCache::Refresh(const PathName& directory)
+{
+  string key = directory.ToString();
+  {
+    lock_guard<std::mutex> lock(mutex);
+    auto it = entries.find(key);
+    if (it != entries.end() && it->second.checked)
+    {
+      return it->second.subdirectories;
+    }
+  }
+  time_t lastWriteTime = File::GetLastWriteTime(directory);
+  {
+    lock_guard<std::mutex> lock(mutex);
+    auto it = entries.find(key);
+    if (it != entries.end() && it->second.lastWriteTime != 0 && it->second.lastWriteTime == lastWriteTime)
+    {
+      it->second.checked = true;
+      return it->second.subdirectories;
+    }
+  }
+  Entry entry;
+  unique_ptr<DirectoryLister> dirLister = DirectoryLister::Open(directory, nullptr, (int)DirectoryLister::Options::DirectoriesOnly);
+  DirectoryEntry directoryEntry;
+  while (dirLister->GetNext(directoryEntry))
+  {
+    MIKTEX_ASSERT(directoryEntry.isDirectory);
+    entry.subdirectories.push_back(directoryEntry.name);
+  }
+  dirLister->Close();
+  // the last write time has a resolution of one second: a directory
+  // which has just been changed must be listed again next time
+  entry.lastWriteTime = lastWriteTime + 1 < time(nullptr) ? lastWriteTime : 0;
+  entry.checked = true;
+  vector<string> result = entry.subdirectories;
+  lock_guard<std::mutex> lock(mutex);
+  entries[key] = std::move(entry);
+  modified = true;
+  return result;
+}
+
+// Refresh the listings of a directory tree with numThreads workers.
+// Errors are ignored here: they are reported when the directory is
+// visited by the (serial) directory walk.
+void DirectoryTreeCache::Scan(const PathName& root, unsigned numThreads)
+{
+  {
+    lock_guard<std::mutex> lock(mutex);
+    auto it = entries.find(root.ToString());
+    if (it != entries.end() && it->second.checked)
+    {
+      return;
+    }
+  }
+  std::mutex queueMutex;
+  condition_variable queueChanged;
+  deque<PathName> queue;
+  size_t busy = 0;
+  queue.push_back(root);
+
+  auto worker = [&]()
+  {
+    unique_lock<std::mutex> lock(queueMutex);
+    while (true)
+    {
+      queueChanged.wait(lock, [&]() { return !queue.empty() || busy == 0; });
+      if (queue.empty())
+      {
+        return;
+      }
+      PathName directory = std::move(queue.front());
+      queue.pop_front();
+      busy++;
+      lock.unlock();
+      vector<string> subdirectories;
+      try
+      {
+        subdirectories = Refresh(directory);
+      }
+      catch (const exception&)
+      {
+      }
+      lock.lock();
+      for (const string& name : subdirectories)
+      {
+        queue.push_back(directory / name);
+      }
+      busy--;
+      queueChanged.notify_all();
+    }
+  };
+
+  vector<thread> threads;
+  threads.reserve(numThreads);
+  for (unsigned i = 1; i < numThreads; ++i)
+  {
+    try
+    {
+      threads.push_back(thread(worker));
+    }
+    catch (const system_error&)
+    {
+      break;
+    }
+  }
+  worker();
+  for (thread& t : threads)
+  {
+    t.join();
+  }
+}
+
+// The file consists of a header line, one D line per directory
+// (last write time, number of subdirectories, path), followed by its S
+// lines (subdirectory names), and an E line with the number of
+// directories. A file which does not match these counts is torn or
+// damaged and is ignored as a whole.
+void DirectoryTreeCache::Load(const PathName& path)
+{
+  if (!File::Exists(path))
+  {
+    return;
+  }
+  ifstream stream = File::CreateInputStream(path);
+  string line;
+  if (!getline(stream, line) || line != FILE_HEADER)
+  {
+    return;
+  }
+  auto parseNumber = [](const string& s, long long& number)
+  {
+    char* end = nullptr;
+    number = strtoll(s.c_str(), &end, 10);
+    return !s.empty() && *end == 0 && number >= 0;
+  };
+  unordered_map<string, Entry> loadedEntries;
+  Entry* entry = nullptr;
+  long long numMissingSubdirectories = 0;
+  bool complete = false;
+  while (getline(stream, line))
+  {
+    if (complete || line.length() < 2 || line[1] != '\t')
+    {
+      return;
+    }
+    if (line[0] == 'D' && numMissingSubdirectories == 0)
+    {
+      vector<string> fields = StringUtil::Split(line.substr(2), '\t');
+      long long lastWriteTime;
+      if (fields.size() < 3 || !parseNumber(fields[0], lastWriteTime) || lastWriteTime == 0 || !parseNumber(fields[1], numMissingSubdirectories))
+      {
+        return;
+      }
+      entry = &loadedEntries[line.substr(3 + fields[0].length() + fields[1].length() + 1)];
+      entry->lastWriteTime = static_cast<time_t>(lastWriteTime);
+    }
+    else if (line[0] == 'S' && entry != nullptr && numMissingSubdirectories > 0)
+    {
+      entry->subdirectories.push_back(line.substr(2));
+      numMissingSubdirectories--;
+    }
+    else if (line[0] == 'E' && numMissingSubdirectories == 0)
+    {
+      long long numDirectories;
+      if (!parseNumber(line.substr(2), numDirectories) || static_cast<size_t>(numDirectories) != loadedEntries.size())
+      {
+        return;
+      }
+      complete = true;
+    }
+    else
+    {
+      return;
+    }
+  }
+  if (!complete)
+  {
+    return;
+  }
+  lock_guard<std::mutex> lock(mutex);
+  for (auto& kv : loadedEntries)
+  {
+    entries.insert(std::move(kv));
+  }
+}
+
+// Several processes may save the cache at the same time: each one
+// writes a file of its own and moves it into place.
+void DirectoryTreeCache::Save(const PathName& path)
+{
+  PathName directory = path.GetDirectoryName();
+  Directory::Create(directory);
+  unique_ptr<TemporaryFile> tempFile = TemporaryFile::Create(directory);
+  PathName tempPath = tempFile->GetPathName();
+  ofstream stream = File::CreateOutputStream(tempPath);
+  stream << FILE_HEADER << "\n";
+  {
+    lock_guard<std::mutex> lock(mutex);
+    size_t numDirectories = 0;
+    for (const auto& kv : entries)
+    {
+      if (kv.second.lastWriteTime == 0 || kv.first.find('\n') != string::npos)
+      {
+        continue;
+      }
+      vector<const string*> names;
+      for (const string& name : kv.second.subdirectories)
+      {
+        if (name.find('\n') == string::npos)
+        {
+          names.push_back(&name);
+        }
+      }
+      stream << "D\t" << static_cast<long long>(kv.second.lastWriteTime) << "\t" << names.size() << "\t" << kv.first << "\n";
+      for (const string* name : names)
+      {
+        stream << "S\t" << *name << "\n";
+      }
+      numDirectories++;
+    }
+    stream << "E\t" << numDirectories << "\n";
+    modified = false;
+  }
+  stream.close();
+  File::SetAttributes(tempPath, {});
+  File::Move(tempPath, path, { FileMoveOption::ReplaceExisting });
+  tempFile->Keep();
+}
@@ -0,0 +1,85 @@
+/* DirectoryTreeCache.h: cached directory listings         -*- C++ -*-
+
+   Copyright (C) 2024 Christian Schenk
+
+   This file is part of the MiKTeX Core Library.
+
+   The MiKTeX Core Library is free software; you can redistribute it
+   and/or modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2, or
+   (at your option) any later version.
+
+   The MiKTeX Core Library is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with the MiKTeX Core Library; if not, write to the Free
+   Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+   02111-1307, USA. */
+
+#pragma once
+
+#if !defined(E4B1C0A3D9F24E0B8B7A6C1F2D3E4F50)
+#define E4B1C0A3D9F24E0B8B7A6C1F2D3E4F50
+
+#include <ctime>
+
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <miktex/Util/PathName>
+
+CORE_INTERNAL_BEGIN_NAMESPACE;
+
+// Sub directory listings used to expand recursive (//) path patterns.
+// A listing is keyed by the last write time of its directory, so that
+// it can be reused by later processes as long as the directory has
+// not changed.
+class DirectoryTreeCache
+{
+public:
+  std::vector<std::string> GetSubdirectories(const MiKTeX::Util::PathName& directory);
+
+public:
+  bool IsModified() const
+  {
+    return modified;
+  }
+
+public:
+  void Load(const MiKTeX::Util::PathName& path);
+
+public:
+  void Save(const MiKTeX::Util::PathName& path);
+
+public:
+  void Scan(const MiKTeX::Util::PathName& root, unsigned numThreads);
+
+private:
+  struct Entry
+  {
+    time_t lastWriteTime = 0;
+    std::vector<std::string> subdirectories;
+    bool checked = false;
+  };
+
+private:
+  std::vector<std::string> Refresh(const MiKTeX::Util::PathName& directory);
+
+private:
+  std::unordered_map<std::string, Entry> entries;
+
+private:
+  bool modified = false;
+
+private:
+  std::mutex mutex;
+};
+
+CORE_INTERNAL_END_NAMESPACE;
+
+#endif
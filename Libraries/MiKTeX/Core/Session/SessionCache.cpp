@@ -0,0 +1,146 @@
+/* SessionCache.cpp: delegating file lookups to a server
+
+   Copyright (C) 2024 Christian Schenk
+
+   This file is part of the MiKTeX Core Library.
+
+   The MiKTeX Core Library is free software; you can redistribute it
+   and/or modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2, or
+   (at your option) any later version.
+
+   The MiKTeX Core Library is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with the MiKTeX Core Library; if not, write to the Free
+   Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+   02111-1307, USA. */
+
+#include "config.h"
+
+#include <cstdlib>
+
+#include <miktex/Core/SessionCache>
+#include <miktex/Util/StringUtil>
+
+#include "internal.h"
+
+#include "Session/SessionCache.h"
+
+using namespace std;
+
+using namespace MiKTeX::Core;
+using namespace MiKTeX::Util;
+
+SessionCacheServer::~SessionCacheServer() noexcept
+{
+}
+
+#if !defined(MIKTEX_UNIX)
+unique_ptr<SessionCacheServer> SessionCacheServer::Create()
+{
+  MIKTEX_FATAL_ERROR(T_("The session cache server is not supported on this platform."));
+}
+#endif
+
+inline bool CanEncodeField(const string& s)
+{
+  return s.find_first_of("\t\n") == string::npos;
+}
+
+bool SessionCacheRequest::CanEncode() const
+{
+  if (workingDirectories.empty())
+  {
+    return false;
+  }
+  for (const PathName& dir : workingDirectories)
+  {
+    if (!CanEncodeField(dir.ToString()))
+    {
+      return false;
+    }
+  }
+  return CanEncodeField(applicationNames) && CanEncodeField(workingDirectory.ToString()) && CanEncodeField(fileName) && CanEncodeField(options.searchPath);
+}
+
+inline bool IsNumber(const string& s)
+{
+  return !s.empty() && s.length() <= 9 && s.find_first_not_of("0123456789") == string::npos;
+}
+
+string SessionCacheRequest::Encode() const
+{
+  string flags;
+  if (options.all)
+  {
+    flags += 'a';
+  }
+  if (options.searchFileSystem)
+  {
+    flags += 's';
+  }
+  if (flags.empty())
+  {
+    flags = "-";
+  }
+  string line = "L";
+  line += '\t';
+  line += applicationNames;
+  line += '\t';
+  line += workingDirectory.ToString();
+  line += '\t';
+  line += std::to_string(workingDirectories.size());
+  for (const PathName& dir : workingDirectories)
+  {
+    line += '\t';
+    line += dir.ToString();
+  }
+  line += '\t';
+  line += std::to_string(static_cast<int>(options.fileType));
+  line += '\t';
+  line += flags;
+  line += '\t';
+  line += options.searchPath;
+  line += '\t';
+  line += fileName;
+  line += '\n';
+  return line;
+}
+
+bool SessionCacheRequest::Decode(const string& line)
+{
+  vector<string> fields = StringUtil::Split(line, '\t');
+  if (fields.size() < 9 || fields[0] != "L" || !IsNumber(fields[3]))
+  {
+    return false;
+  }
+  size_t numWorkingDirectories = std::stoul(fields[3]);
+  if (numWorkingDirectories == 0 || fields.size() != 8 + numWorkingDirectories)
+  {
+    return false;
+  }
+  size_t idx = 4 + numWorkingDirectories;
+  if (!IsNumber(fields[idx]))
+  {
+    return false;
+  }
+  int fileType = atoi(fields[idx].c_str());
+  if (fileType >= static_cast<int>(FileType::E_N_D))
+  {
+    return false;
+  }
+  applicationNames = fields[1];
+  workingDirectory = fields[2];
+  workingDirectories.assign(fields.begin() + 4, fields.begin() + idx);
+  options = LocateOptions();
+  options.fileType = static_cast<FileType>(fileType);
+  options.all = fields[idx + 1].find('a') != string::npos;
+  options.searchFileSystem = fields[idx + 1].find('s') != string::npos;
+  options.searchPath = fields[idx + 2];
+  fileName = fields[idx + 3];
+  return true;
+}
@@ -0,0 +1,90 @@
+/* SessionCache.h: delegating file lookups to a server      -*- C++ -*-
+
+   Copyright (C) 2024 Christian Schenk
+
+   This file is part of the MiKTeX Core Library.
+
+   The MiKTeX Core Library is free software; you can redistribute it
+   and/or modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2, or
+   (at your option) any later version.
+
+   The MiKTeX Core Library is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with the MiKTeX Core Library; if not, write to the Free
+   Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+   02111-1307, USA. */
+
+#pragma once
+
+#if !defined(A1C8E3F70B2D4E6A9F5B0C7D8E2A4B63)
+#define A1C8E3F70B2D4E6A9F5B0C7D8E2A4B63
+
+#include <string>
+#include <vector>
+
+#include <miktex/Core/Session>
+#include <miktex/Util/PathName>
+
+CORE_INTERNAL_BEGIN_NAMESPACE;
+
+// A Locate() request, as sent to the session cache server. The
+// request is one line of tab-separated fields; the response is the
+// number of results, followed by one line per result.
+//
+// The working directories are the start directory and the input
+// directories of the client session; the server searches them instead
+// of its own.
+struct SessionCacheRequest
+{
+  std::string applicationNames;
+  MiKTeX::Util::PathName workingDirectory;
+  std::vector<MiKTeX::Util::PathName> workingDirectories;
+  std::string fileName;
+  MiKTeX::Core::LocateOptions options;
+
+  bool CanEncode() const;
+  std::string Encode() const;
+  bool Decode(const std::string& line);
+};
+
+// The client side of the session cache. The connection is made on
+// first use and kept open; if the server cannot be reached, the
+// client gives up for the rest of the process.
+class SessionCacheClient
+{
+public:
+  ~SessionCacheClient();
+
+public:
+  bool Locate(const MiKTeX::Util::PathName& socketPath, const SessionCacheRequest& request, std::vector<MiKTeX::Util::PathName>& result);
+
+public:
+  void Reset();
+
+private:
+  bool Connect(const MiKTeX::Util::PathName& socketPath);
+
+private:
+  void Disconnect();
+
+private:
+  bool ReadLine(std::string& line);
+
+private:
+  int fd = -1;
+
+private:
+  bool connectAttempted = false;
+
+private:
+  std::string buffer;
+};
+
+CORE_INTERNAL_END_NAMESPACE;
+
+#endif
@@ -24,6 +24,7 @@
 #if !defined(INTERNAL_CORE_SESSION_SESSIONIMPL_H)
 #define INTERNAL_CORE_SESSION_SESSIONIMPL_H
 
+#include <atomic>
 #include <deque>
 #include <fstream>
 #include <map>
@@ -52,8 +53,10 @@
 #include <miktex/Core/win/COMInitializer>
 #endif
 
+#include "DirectoryTreeCache.h"
 #include "Fndb/FileNameDatabase.h"
 #include "RootDirectoryInternals.h"
+#include "SessionCache.h"
 
 #if defined(MIKTEX_WINDOWS) && USE_LOCAL_SERVER
 #  import MIKTEX_SESSION_TLB raw_interfaces_only
@@ -112,6 +115,10 @@ struct InternalFileTypeInfo :
   public MiKTeX::Core::FileTypeInfo
 {
   std::vector<MiKTeX::Util::PathName> pathPatterns;
+
+  // negative cache: file names which could not be found in the FNDBs;
+  // maps to the path patterns which are not covered by an FNDB
+  std::unordered_map<std::string, std::vector<MiKTeX::Util::PathName>> fndbMisses;
 };
 
 struct DvipsPaperSizeInfo :
@@ -140,7 +147,8 @@ struct InternalStartupConfig :
 };
 
 class SessionImpl :
-  public MiKTeX::Core::Session
+  public MiKTeX::Core::Session,
+  public MiKTeX::Core::FileSystemWatcherCallback
 {
 public:
   SessionImpl();
@@ -160,6 +168,9 @@ public:
 public:
   void Reset() override;
 
+public:
+  void OnChange(const MiKTeX::Core::FileSystemChangeEvent& ev) override;
+
 public:
   void PushAppName(const std::string& name) override;
 
@@ -318,6 +329,9 @@ public:
 public:
   void SetRecorderPath(const MiKTeX::Util::PathName& path) override;
 
+public:
+  void FlushRecorder() override;
+
 public:
   void RecordFileInfo(const MiKTeX::Util::PathName& path, MiKTeX::Core::FileAccess access) override;
 
@@ -330,6 +344,12 @@ public:
 public:
   MiKTeX::Core::LocateResult MIKTEXTHISCALL Locate(const std::string& fileName, const MiKTeX::Core::LocateOptions& options) override;
 
+public:
+  MiKTeX::Core::LocateResult LocateNoCache(const std::string& fileName, const MiKTeX::Core::LocateOptions& options);
+
+public:
+  std::vector<MiKTeX::Core::LocateResult> MIKTEXTHISCALL FindFiles(const std::vector<MiKTeX::Core::FindRequest>& requests) override;
+
 public:
   bool FindFile(const std::string& fileName, const std::string& searchPath, FindFileOptionSet options, std::vector<MiKTeX::Util::PathName>& result) override;
 
@@ -607,6 +627,12 @@ public:
 public:
   std::shared_ptr<FileNameDatabase> GetFileNameDatabase(const char* path);
 
+public:
+  void InvalidateNegativeFileCache()
+  {
+    ++searchGeneration;
+  }
+
 public:
   MiKTeX::Util::PathName GetTempDirectory();
 
@@ -801,12 +827,41 @@ private:
 private:
   bool FindFileByType(const std::string& fileName, MiKTeX::Core::FileType fileType, bool all, bool tryHard, bool create, bool renew, std::vector<MiKTeX::Util::PathName>& result, MiKTeX::Core::IFindFileCallback* callback);
 
+private:
+  std::vector<MiKTeX::Util::PathName> GetFileNamesToTry(InternalFileTypeInfo* fti, const std::string& fileName);
+
+  // a file name to be searched in a directory (see SearchDirectory())
+private:
+  struct DirectoryQuery
+  {
+    const MiKTeX::Util::PathName* fileName;
+    bool all;
+    MiKTeX::Core::IFindFileCallback* callback;
+    std::vector<MiKTeX::Util::PathName>* result;
+    bool found = false;
+  };
+
+private:
+  void SearchDirectory(const MiKTeX::Util::PathName& pathPattern, std::vector<DirectoryQuery>& queries);
+
+private:
+  bool SkipDirectory(const MiKTeX::Util::PathName& pathPattern, bool found, bool all);
+
+private:
+  void FindFilesInFndb(const std::vector<MiKTeX::Core::FindRequest>& requests, const std::vector<std::string>& fileNames, const std::vector<std::size_t>& group, std::vector<MiKTeX::Core::LocateResult>& results, std::vector<std::size_t>& unresolved);
+
 private:
   bool SearchFileSystem(const std::string& fileName, const char* dirPath, bool all, std::vector<MiKTeX::Util::PathName>& result, MiKTeX::Core::IFindFileCallback* callback);
 
 private:
   bool CheckCandidate(MiKTeX::Util::PathName& path, const char* fileInfo, MiKTeX::Core::IFindFileCallback* callback);
 
+private:
+  bool LookupNegativeFileCache(InternalFileTypeInfo* fti, const std::string& fileName, std::vector<MiKTeX::Util::PathName>& fileSystemPatterns);
+
+private:
+  void UpdateNegativeFileCache(InternalFileTypeInfo* fti, const std::string& fileName, const std::vector<MiKTeX::Util::PathName>& pathPatterns);
+
 private:
   bool GetSessionValue(const std::string& sectionName, const std::string& valueName, std::string& value, MiKTeX::Configuration::HasNamedValues* callback);
 
@@ -976,6 +1031,9 @@ private:
 private:
   void CheckOpenFiles();
 
+private:
+  void ResolvePackageNames();
+
 private:
   void WritePackageHistory();
 
@@ -985,6 +1043,15 @@ private:
 private:
   void DirectoryWalk(const MiKTeX::Util::PathName& directory, const MiKTeX::Util::PathName& pathPattern, std::vector<MiKTeX::Util::PathName>& paths);
 
+private:
+  MiKTeX::Util::PathName GetDirectoryTreeCachePath();
+
+private:
+  void ScanDirectoryTree(const MiKTeX::Util::PathName& directory);
+
+private:
+  void SaveDirectoryTreeCache();
+
 private:
   void ExpandBraces(const std::string& toBeExpanded, std::vector<MiKTeX::Util::PathName>& paths);
 
@@ -1048,10 +1115,62 @@ private:
 private:
   SearchPathDictionary expandedPathPatterns;
 
+private:
+  // caching sub directory listings for recursive path patterns
+  DirectoryTreeCache directoryTreeCache;
+
+private:
+  bool directoryTreeCacheLoaded = false;
+
+#if defined(MIKTEX_UNIX)
+public:
+  MiKTeX::Util::PathName GetSessionCacheSocketPath();
+
+public:
+  void DisableSessionCache()
+  {
+    sessionCacheDisabled = true;
+  }
+
+public:
+  // lets the server search the working directories of a client
+  void SetWorkingDirectories(const std::vector<MiKTeX::Util::PathName>& directories);
+
+private:
+  bool TryLocateViaSessionCache(const std::string& fileName, const MiKTeX::Core::LocateOptions& options, std::vector<MiKTeX::Util::PathName>& result);
+
+private:
+  // delegating file lookups to a server process
+  SessionCacheClient sessionCacheClient;
+
+private:
+  MiKTeX::Util::PathName sessionCacheSocketPath;
+
+private:
+  bool sessionCacheDisabled = false;
+#endif
+
+private:
+  // incremented whenever search vectors or file name databases change;
+  // invalidates the negative file cache
+  std::atomic<unsigned> searchGeneration{ 0 };
+
+private:
+  unsigned negativeFileCacheGeneration = 0;
+
+private:
+  unsigned long negativeFileCacheHits = 0;
+
+private:
+  unsigned long negativeFileCacheMisses = 0;
+
 private:
   // file access history
   std::vector<MiKTeX::Core::FileInfoRecord> fileInfoRecords;
 
+private:
+  std::size_t numResolvedFileInfoRecords = 0;
+
 private:
   // true, if we record a file history
   bool recordingFileNames = false;
@@ -1104,6 +1223,9 @@ private:
 private:
   std::string applicationNames;
 
+public:
+  void SetApplicationNames(const std::string& names);
+
 private:
   const std::string& get_ApplicationNames() const
   {
@@ -66,6 +66,17 @@ void SessionImpl::PushAppName(const string& name)
   trace_config->WriteLine("core", T_("application tags: ") + applicationNames);
 }
 
+void SessionImpl::SetApplicationNames(const string& names)
+{
+  if (names == applicationNames)
+  {
+    return;
+  }
+  fileTypes.clear();
+  applicationNames = names;
+  trace_config->WriteLine("core", T_("application tags: ") + applicationNames);
+}
+
 void SessionImpl::PushBackAppName(const string& name)
 {
   MIKTEX_ASSERT(name.find(PathNameUtil::PathNameDelimiter) == string::npos);
@@ -25,6 +25,7 @@
 
 #include <fstream>
 #include <thread>
+#include <unordered_map>
 
 #include <fmt/format.h>
 #include <fmt/ostream.h>
@@ -111,26 +112,43 @@ void SessionImpl::RecordFileInfo(const PathName& path, FileAccess access)
   FileInfoRecord fir;
   fir.fileName = path.ToString();
   fir.access = access;
-  if (recordingPackageNames || !packageHistoryFile.empty())
+  fileInfoRecords.push_back(fir);
+  if (fileNameRecorderStream.is_open())
   {
+    fileNameRecorderStream << (fir.access == FileAccess::Read ? "INPUT" : "OUTPUT") << " " << PathName(fir.fileName).ToUnix() << "\n";
+  }
+}
+
+// package names are looked up in one go, when the records are needed
+void SessionImpl::ResolvePackageNames()
+{
+  if (!(recordingPackageNames || !packageHistoryFile.empty()) || numResolvedFileInfoRecords == fileInfoRecords.size())
+  {
+    numResolvedFileInfoRecords = fileInfoRecords.size();
+    return;
+  }
+  shared_ptr<FileNameDatabase> fndb = GetFileNameDatabase(GetMpmRoot());
+  unordered_map<string, string> packageNames;
+  for (; numResolvedFileInfoRecords < fileInfoRecords.size(); ++numResolvedFileInfoRecords)
+  {
+    FileInfoRecord& fir = fileInfoRecords[numResolvedFileInfoRecords];
     PathName pathRelPath;
-    if (IsTEXMFFile(path, pathRelPath))
+    if (fndb == nullptr || !IsTEXMFFile(PathName(fir.fileName), pathRelPath))
+    {
+      continue;
+    }
+    auto it = packageNames.find(pathRelPath.ToString());
+    if (it == packageNames.end())
     {
-      shared_ptr<FileNameDatabase> fndb = GetFileNameDatabase(GetMpmRoot());
-      if (fndb != nullptr)
+      string packageName;
+      vector<Fndb::Record> records;
+      if (fndb->Search(pathRelPath, MPM_ROOT_PATH, false, records))
       {
-        vector<Fndb::Record> records;
-        if (fndb->Search(pathRelPath, MPM_ROOT_PATH, false, records))
-        {
-          fir.packageName = records[0].fileNameInfo;
-        }
+        packageName = records[0].fileNameInfo;
       }
+      it = packageNames.emplace(pathRelPath.ToString(), packageName).first;
     }
-  }
-  fileInfoRecords.push_back(fir);
-  if (fileNameRecorderStream.is_open())
-  {
-    fileNameRecorderStream << (fir.access == FileAccess::Read ? "INPUT" : "OUTPUT") << " " << PathName(fir.fileName).ToUnix() << std::endl;
+    fir.packageName = it->second;
   }
 }
 
@@ -158,7 +176,7 @@ FILE* SessionImpl::TryOpenFile(const PathName& path, FileMode mode, FileAccess a
 
 FILE* SessionImpl::OpenFile(const PathName& path, FileMode mode, FileAccess access, bool text)
 {
-  trace_files->WriteLine("core", fmt::format("OpenFile(\"{0}\", {1}, {2:x}, {3})", path.ToString(), static_cast<int>(mode), static_cast<int>(access), text));
+  trace_files->WriteLine("core", [&]() { return fmt::format("OpenFile(\"{0}\", {1}, {2:x}, {3})", path.ToString(), static_cast<int>(mode), static_cast<int>(access), text); });
 
   unique_ptr<Process> process;
   FILE* file = nullptr;
@@ -203,7 +221,7 @@ FILE* SessionImpl::OpenFile(const PathName& path, FileMode mode, FileAccess acce
   {
     trace_error->WriteLine("core", TraceLevel::Error, "setvbuf() failed for some reason");
   }
-  trace_files->WriteLine("core", fmt::format("  => {0}", static_cast<void*>(file)));
+  trace_files->WriteLine("core", [&]() { return fmt::format("  => {0}", static_cast<void*>(file)); });
   return file;
 }
 
@@ -300,7 +318,7 @@ pair<bool, Session::OpenFileInfo> SessionImpl::TryGetOpenFileInfo(FILE* file)
 void SessionImpl::CloseFile(FILE* file, int& exitCode)
 {
   MIKTEX_ASSERT_BUFFER(file, sizeof(*file));
-  trace_files->WriteLine("core", fmt::format("CloseFile({0})", static_cast<void*>(file)));
+  trace_files->WriteLine("core", [&]() { return fmt::format("CloseFile({0})", static_cast<void*>(file)); });
   map<const FILE*, InternalOpenFileInfo>::iterator it = openFilesMap.find(file);
   bool isCommand = false;
   string command;
@@ -377,8 +395,17 @@ void SessionImpl::SetRecorderPath(const PathName& path)
   fileNameRecorderStream.flush();
 }
 
+void SessionImpl::FlushRecorder()
+{
+  if (fileNameRecorderStream.is_open())
+  {
+    fileNameRecorderStream.flush();
+  }
+}
+
 vector<FileInfoRecord> SessionImpl::GetFileInfoRecords()
 {
+  ResolvePackageNames();
   return fileInfoRecords;
 }
 
@@ -396,6 +423,7 @@ void SessionImpl::WritePackageHistory()
   {
     return;
   }
+  ResolvePackageNames();
   ofstream stream = File::CreateOutputStream(PathName(packageHistoryFile), ios_base::app);
   for (vector<FileInfoRecord>::const_iterator it = fileInfoRecords.begin(); it != fileInfoRecords.end(); ++it)
   {
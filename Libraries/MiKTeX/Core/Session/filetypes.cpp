@@ -298,5 +298,7 @@ void SessionImpl::ClearSearchVectors()
   for (InternalFileTypeInfo& info : fileTypes)
   {
     info.pathPatterns.clear();
+    info.fndbMisses.clear();
   }
+  InvalidateNegativeFileCache();
 }
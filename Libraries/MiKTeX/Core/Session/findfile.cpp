@@ -21,6 +21,9 @@
 
 #include "config.h"
 
+#include <algorithm>
+#include <map>
+
 #include <fmt/format.h>
 #include <fmt/ostream.h>
 
@@ -80,7 +83,7 @@ bool SessionImpl::SearchFileSystem(const string& fileName, const char* pathPatte
     return false;
   }
 
-  trace_filesearch->WriteLine("core", fmt::format(T_("file system search: fileName={0}, pathPattern={1}"), Q_(fileName), Q_(pathPattern)));
+  trace_filesearch->WriteLine("core", [&]() { return fmt::format(T_("file system search: fileName={0}, pathPattern={1}"), Q_(fileName), Q_(pathPattern)); });
 
   vector<PathName> directories;
 
@@ -114,9 +117,57 @@ bool SessionImpl::SearchFileSystem(const string& fileName, const char* pathPatte
   return found;
 }
 
+bool SessionImpl::SkipDirectory(const PathName& pathPattern, bool found, bool all)
+{
+#if FIND_FILE_DONT_TRIGGER_INSTALLER_IF_ALL
+  // don't trigger the package installer if we have found a file and if all occurrences are requested
+  return found && all && IsMpmFile(pathPattern.GetData());
+#else
+  return false;
+#endif
+}
+
+void SessionImpl::SearchDirectory(const PathName& pathPattern, vector<DirectoryQuery>& queries)
+{
+  shared_ptr<FileNameDatabase> fndb = GetFileNameDatabase(pathPattern.GetData());
+  if (fndb == nullptr)
+  {
+    // search the file system because the FNDB does not exist
+    for (DirectoryQuery& query : queries)
+    {
+      trace_filesearch->WriteLine("core", [&]() { return fmt::format(T_("no FNDB found, so going to continue on disk: filename={0}, directory={1}"), Q_(*query.fileName), Q_(pathPattern)); });
+      vector<PathName> paths;
+      if (SearchFileSystem(query.fileName->ToString(), pathPattern.GetData(), query.all, paths, query.callback))
+      {
+        query.found = true;
+        query.result->insert(query.result->end(), paths.begin(), paths.end());
+      }
+    }
+    return;
+  }
+  vector<vector<Fndb::Record>> records(queries.size());
+  for (size_t k = 0; k < queries.size(); ++k)
+  {
+    fndb->Search(*queries[k].fileName, pathPattern.ToString(), queries[k].all, records[k]);
+  }
+  // we must release the FNDB handle since CheckCandidate() might request an unload of the FNDB
+  fndb = nullptr;
+  for (size_t k = 0; k < queries.size(); ++k)
+  {
+    for (Fndb::Record& record : records[k])
+    {
+      if (CheckCandidate(record.path, record.fileNameInfo.c_str(), queries[k].callback))
+      {
+        queries[k].found = true;
+        queries[k].result->push_back(record.path);
+      }
+    }
+  }
+}
+
 bool SessionImpl::FindFileInDirectories(const string& fileName, const vector<PathName>& pathPatterns, bool all, bool useFndb, bool searchFileSystem, vector<PathName>& result, IFindFileCallback* callback)
 {
-  CoreStopWatch stopWatch(fmt::format("find file {}", Q_(fileName)));
+  CoreStopWatch stopWatch([&]() { return fmt::format("find file {}", Q_(fileName)); });
 
   MIKTEX_ASSERT(useFndb || searchFileSystem);
 
@@ -185,47 +236,17 @@ bool SessionImpl::FindFileInDirectories(const string& fileName, const vector<Pat
   // make use of the file name database
   if (useFndb)
   {
+    PathName fn(fileName);
     for (vector<PathName>::const_iterator it = pathPatterns.begin(); (!found || all) && it != pathPatterns.end(); ++it)
     {
-      trace_filesearch->WriteLine("core", fmt::format(T_("going to search in FNDB: filename={0}, directory={1}"), Q_(fileName), Q_(it->ToString())));
-#if FIND_FILE_DONT_TRIGGER_INSTALLER_IF_ALL
-      if (found && all && IsMpmFile(it->GetData()))
+      trace_filesearch->WriteLine("core", [&]() { return fmt::format(T_("going to search in FNDB: filename={0}, directory={1}"), Q_(fileName), Q_(it->ToString())); });
+      if (SkipDirectory(*it, found, all))
       {
-        // don't trigger the package installer if we have found a file and if all occurrences are requested
         continue;
       }
-#endif
-      shared_ptr<FileNameDatabase> fndb = GetFileNameDatabase(it->GetData());
-      if (fndb != nullptr)
-      {
-        // search fndb
-        vector<Fndb::Record> records;
-        bool foundInFndb = fndb->Search(PathName(fileName), it->ToString(), all, records);
-        // we must release the FNDB handle since CheckCandidate() might request an unload of the FNDB
-        fndb = nullptr;
-        if (foundInFndb)
-        {
-          for (int idx = 0; idx < records.size(); ++idx)
-          {
-            if (CheckCandidate(records[idx].path, records[idx].fileNameInfo.c_str(), callback))
-            {
-              found = true;
-              result.push_back(records[idx].path);
-            }
-          }
-        }
-      }
-      else
-      {
-        // search the file system because the FNDB does not exist
-        trace_filesearch->WriteLine("core", fmt::format(T_("no FNDB found, so going to continue on disk: filename={0}, directory={1}"), Q_(fileName), Q_(*it)));
-        vector<PathName> paths;
-        if (SearchFileSystem(fileName, it->GetData(), all, paths, callback))
-        {
-          found = true;
-          result.insert(result.end(), paths.begin(), paths.end());
-        }
-      }
+      vector<DirectoryQuery> queries{ { &fn, all, callback, &result } };
+      SearchDirectory(*it, queries);
+      found = found || queries[0].found;
     }
   }
 
@@ -267,11 +288,83 @@ bool SessionImpl::FindFileInDirectories(const string& fileName, const vector<Pat
   return found;
 }
 
+void SessionImpl::OnChange(const FileSystemChangeEvent& ev)
+{
+  // called by the file system watcher thread
+  string fileName = ev.fileName.GetFileName().ToString();
+  if (EndsWith(fileName, MIKTEX_FNDB_FILE_SUFFIX) || EndsWith(fileName, MIKTEX_FNDB_CHANGE_FILE_SUFFIX))
+  {
+    InvalidateNegativeFileCache();
+  }
+}
+
+bool SessionImpl::LookupNegativeFileCache(InternalFileTypeInfo* fti, const string& fileName, vector<PathName>& fileSystemPatterns)
+{
+  unsigned generation = searchGeneration;
+  if (generation != negativeFileCacheGeneration)
+  {
+    for (InternalFileTypeInfo& info : fileTypes)
+    {
+      info.fndbMisses.clear();
+    }
+    negativeFileCacheGeneration = generation;
+  }
+  auto it = fti->fndbMisses.find(fileName);
+  if (it == fti->fndbMisses.end())
+  {
+    negativeFileCacheMisses++;
+    return false;
+  }
+  negativeFileCacheHits++;
+  trace_filesearch->WriteLine("core", [&]() { return fmt::format(T_("negative file cache hit: fileName={0}, fileType={1} (hits={2}, misses={3})"), Q_(fileName), fti->fileTypeString, negativeFileCacheHits, negativeFileCacheMisses); });
+  fileSystemPatterns = it->second;
+  return true;
+}
+
+void SessionImpl::UpdateNegativeFileCache(InternalFileTypeInfo* fti, const string& fileName, const vector<PathName>& pathPatterns)
+{
+  // directories without an FNDB must still be searched on every lookup
+  vector<PathName> fileSystemPatterns;
+  for (const PathName& pathPattern : pathPatterns)
+  {
+    if (GetFileNameDatabase(pathPattern.GetData()) == nullptr)
+    {
+      fileSystemPatterns.push_back(pathPattern);
+    }
+  }
+  fti->fndbMisses[fileName] = fileSystemPatterns;
+}
+
 inline bool IsNewer(const PathName& path1, const PathName& path2)
 {
   return File::Exists(path1) && File::Exists(path2) && File::GetLastWriteTime(path1) > File::GetLastWriteTime(path2);
 }
 
+vector<PathName> SessionImpl::GetFileNamesToTry(InternalFileTypeInfo* fti, const string& fileName)
+{
+  // check to see whether the file name has a registered file name extension
+  PathName extension(PathName(fileName).GetExtension());
+  bool hasRegisteredExtension = !extension.Empty()
+    && (std::find_if(fti->fileNameExtensions.begin(), fti->fileNameExtensions.end(), [extension](const string& ext) { return extension == PathName(ext); }) != fti->fileNameExtensions.end()
+      || std::find_if(fti->alternateExtensions.begin(), fti->alternateExtensions.end(), [extension](const string& ext) { return extension == PathName(ext); }) != fti->alternateExtensions.end());
+
+  vector<PathName> fileNamesToTry;
+
+  // try each registered file name extension, if none was specified
+  if (!hasRegisteredExtension)
+  {
+    for (const string& ext : fti->fileNameExtensions)
+    {
+      fileNamesToTry.push_back(PathName(fileName).AppendExtension(ext));
+    }
+  }
+
+  // try it with the given file name
+  fileNamesToTry.push_back(PathName(fileName));
+
+  return fileNamesToTry;
+}
+
 bool SessionImpl::FindFileByType(const string& fileName, FileType fileType, bool all, bool searchFileSystem, bool create, bool renew, vector<PathName>& result, IFindFileCallback* callback)
 {
   MIKTEX_ASSERT(result.empty());
@@ -287,7 +380,7 @@ bool SessionImpl::FindFileByType(const string& fileName, FileType fileType, bool
     fileType = DeriveFileType(PathName(fileName));
     if (fileType == FileType::None)
     {
-      trace_filesearch->WriteLine("core", fmt::format(T_("cannot derive file type from {0}"), Q_(fileName)));
+      trace_filesearch->WriteLine("core", [&]() { return fmt::format(T_("cannot derive file type from {0}"), Q_(fileName)); });
       return false;
     }
   }
@@ -301,37 +394,27 @@ bool SessionImpl::FindFileByType(const string& fileName, FileType fileType, bool
   vector<PathName> pathPatterns = GetDirectoryPatterns(fileType);
 
   // get the file type information
-  const InternalFileTypeInfo* fti = GetInternalFileTypeInfo(fileType);
+  InternalFileTypeInfo* fti = GetInternalFileTypeInfo(fileType);
   MIKTEX_ASSERT(fti != nullptr);
 
-  // check to see whether the file name has a registered file name extension
-  PathName extension(PathName(fileName).GetExtension());
-  bool hasRegisteredExtension = !extension.Empty()
-    && (std::find_if(fti->fileNameExtensions.begin(), fti->fileNameExtensions.end(), [extension](const string& ext) { return extension == PathName(ext); }) != fti->fileNameExtensions.end()
-      || std::find_if(fti->alternateExtensions.begin(), fti->alternateExtensions.end(), [extension](const string& ext) { return extension == PathName(ext); }) != fti->alternateExtensions.end());
+  vector<PathName> fileNamesToTry = GetFileNamesToTry(fti, fileName);
 
-  vector<PathName> fileNamesToTry;
-
-  // try each registered file name extension, if none was specified
-  if (!hasRegisteredExtension)
-  {
-    for (const string& ext : fti->fileNameExtensions)
-    {
-      fileNamesToTry.push_back(PathName(fileName).AppendExtension(ext));
-    }
-  }
-
-  // try it with the given file name
-  fileNamesToTry.push_back(PathName(fileName));
-
-  // first round: use the fndb
+  // first round: use the fndb; skip the FNDBs if we already know that
+  // they don't have the file
+  unsigned generation = searchGeneration;
+  vector<PathName> fileSystemPatterns;
+  bool isKnownFndbMiss = LookupNegativeFileCache(fti, fileName, fileSystemPatterns);
   for (const PathName& fn : fileNamesToTry)
   {
-    if (FindFileInDirectories(fn.ToString(), pathPatterns, all, true, false, result, callback) && !all)
+    if (FindFileInDirectories(fn.ToString(), isKnownFndbMiss ? fileSystemPatterns : pathPatterns, all, true, false, result, callback) && !all)
     {
       return true;
     }
   }
+  if (!isKnownFndbMiss && result.empty() && generation == searchGeneration)
+  {
+    UpdateNegativeFileCache(fti, fileName, pathPatterns);
+  }
 
   // second round: don't use the FNDB
   if (searchFileSystem)
@@ -382,9 +465,37 @@ bool SessionImpl::FindFileByType(const string& fileName, FileType fileType, bool
   return !result.empty();
 }
 
+MIKTEXSTATICFUNC(vector<PathName>) RemoveDuplicates(const vector<PathName>& pathNames)
+{
+  vector<PathName> result;
+  set<PathName> resultSet;
+  for (auto& p : pathNames)
+  {
+    if (resultSet.find(p) != resultSet.end())
+    {
+      continue;
+    }
+    result.push_back(p);
+    resultSet.insert(p);
+  }
+  return result;
+}
+
 LocateResult MIKTEXTHISCALL SessionImpl::Locate(const string& givenFileName, const LocateOptions& options)
 {
   string fileName = this->ExpandValues(givenFileName, nullptr);
+#if defined(MIKTEX_UNIX)
+  vector<PathName> cachedPathNames;
+  if (TryLocateViaSessionCache(fileName, options, cachedPathNames))
+  {
+    return { cachedPathNames };
+  }
+#endif
+  return LocateNoCache(fileName, options);
+}
+
+LocateResult SessionImpl::LocateNoCache(const string& fileName, const LocateOptions& options)
+{
   bool found = false;
   vector<PathName> pathNames;
   if (options.fileType == FileType::None)
@@ -404,19 +515,176 @@ LocateResult MIKTEXTHISCALL SessionImpl::Locate(const string& givenFileName, con
   {
     return {};
   }
-  // Eliminate duplicates.
-  vector<PathName> result;
-  set<PathName> resultSet;
-  for (auto& p : pathNames)
+  return { RemoveDuplicates(pathNames) };
+}
+
+// One request of a FindFiles() batch.
+struct BatchedRequest
+{
+  size_t idx;
+  vector<PathName> fileNamesToTry;
+  IFindFileCallback* callback;
+  bool foundInRound = false;
+  bool done = false;
+  vector<PathName> pathNames;
+};
+
+void SessionImpl::FindFilesInFndb(const vector<FindRequest>& requests, const vector<string>& fileNames, const vector<size_t>& group, vector<LocateResult>& results, vector<size_t>& unresolved)
+{
+  // all requests of the group have the same file type and search path
+  const LocateOptions& groupOptions = requests[group.front()].options;
+  FileType fileType = groupOptions.fileType;
+  InternalFileTypeInfo* fti = nullptr;
+  vector<PathName> pathPatterns;
+  if (fileType == FileType::None)
   {
-    if (resultSet.find(p) != resultSet.end())
+    pathPatterns = SplitSearchPath(groupOptions.searchPath.empty() ? MIKTEX_PATH_TEXMF_PLACEHOLDER : groupOptions.searchPath);
+  }
+  else
+  {
+    pathPatterns = GetDirectoryPatterns(fileType);
+    fti = GetInternalFileTypeInfo(fileType);
+    MIKTEX_ASSERT(fti != nullptr);
+  }
+
+  unsigned generation = searchGeneration;
+
+  vector<BatchedRequest> batch;
+  batch.reserve(group.size());
+  size_t numRounds = 0;
+  for (size_t idx : group)
+  {
+    vector<PathName> fileSystemPatterns;
+    if (fti != nullptr && LookupNegativeFileCache(fti, fileNames[idx], fileSystemPatterns))
     {
+      // no FNDB has the file
+      unresolved.push_back(idx);
       continue;
     }
-    result.push_back(p);
-    resultSet.insert(p);
+    BatchedRequest request;
+    request.idx = idx;
+    request.callback = requests[idx].options.callback != nullptr ? requests[idx].options.callback : findFileCallback;
+    if (fti != nullptr)
+    {
+      request.fileNamesToTry = GetFileNamesToTry(fti, fileNames[idx]);
+    }
+    else
+    {
+      request.fileNamesToTry.push_back(PathName(fileNames[idx]));
+    }
+    numRounds = std::max(numRounds, request.fileNamesToTry.size());
+    batch.push_back(std::move(request));
+  }
+
+  // Try the file names in the same order as FindFileByType() does: for
+  // each candidate file name, all directory patterns. Each FNDB is
+  // acquired once per directory pattern and round.
+  for (size_t round = 0; round < numRounds; ++round)
+  {
+    for (BatchedRequest& request : batch)
+    {
+      request.foundInRound = false;
+    }
+    for (const PathName& pathPattern : pathPatterns)
+    {
+      vector<BatchedRequest*> pending;
+      vector<DirectoryQuery> queries;
+      for (BatchedRequest& request : batch)
+      {
+        bool all = requests[request.idx].options.all;
+        if (request.done || round >= request.fileNamesToTry.size() || (request.foundInRound && !all) || SkipDirectory(pathPattern, request.foundInRound, all))
+        {
+          continue;
+        }
+        pending.push_back(&request);
+        queries.push_back({ &request.fileNamesToTry[round], all, request.callback, &request.pathNames });
+      }
+      if (queries.empty())
+      {
+        continue;
+      }
+      trace_filesearch->WriteLine("core", [&]() { return fmt::format(T_("going to search in FNDB: {0} files, directory={1}"), queries.size(), Q_(pathPattern.ToString())); });
+      SearchDirectory(pathPattern, queries);
+      for (size_t k = 0; k < queries.size(); ++k)
+      {
+        pending[k]->foundInRound = pending[k]->foundInRound || queries[k].found;
+      }
+    }
+    for (BatchedRequest& request : batch)
+    {
+      if (request.foundInRound && !requests[request.idx].options.all)
+      {
+        request.done = true;
+      }
+    }
+  }
+
+  for (BatchedRequest& request : batch)
+  {
+    const LocateOptions& options = requests[request.idx].options;
+    if (request.pathNames.empty())
+    {
+      if (fti != nullptr && generation == searchGeneration)
+      {
+        UpdateNegativeFileCache(fti, fileNames[request.idx], pathPatterns);
+      }
+      if (options.searchFileSystem || options.create)
+      {
+        unresolved.push_back(request.idx);
+      }
+      continue;
+    }
+    if (options.create && (fileType == FileType::BASE || fileType == FileType::FMT || fileType == FileType::MEM))
+    {
+      // FindFileByType() decides whether the format must be renewed
+      unresolved.push_back(request.idx);
+      continue;
+    }
+
+    results[request.idx] = { RemoveDuplicates(request.pathNames) };
   }
-  return { result };
+}
+
+vector<LocateResult> SessionImpl::FindFiles(const vector<FindRequest>& requests)
+{
+  CoreStopWatch stopWatch([&]() { return fmt::format("find {} files", requests.size()); });
+
+  vector<LocateResult> results(requests.size());
+  vector<string> fileNames;
+  fileNames.reserve(requests.size());
+
+  // requests with the same file type and search path are searched together
+  map<pair<FileType, string>, vector<size_t>> groups;
+
+  // requests which are searched one by one
+  vector<size_t> unresolved;
+
+  for (size_t idx = 0; idx < requests.size(); ++idx)
+  {
+    const LocateOptions& options = requests[idx].options;
+    fileNames.push_back(this->ExpandValues(requests[idx].fileName, nullptr));
+    const string& fileName = fileNames.back();
+    // FindFileByType() adds the files found on disk to all files found via the FNDB
+    bool allOnDisk = options.all && options.searchFileSystem && options.fileType != FileType::None;
+    if (options.renew || allOnDisk || PathNameUtil::IsAbsolutePath(fileName) || IsExplicitlyRelativePath(fileName.c_str()) || (!fileName.empty() && fileName[0] == '~'))
+    {
+      unresolved.push_back(idx);
+      continue;
+    }
+    groups[make_pair(options.fileType, options.fileType == FileType::None ? options.searchPath : string())].push_back(idx);
+  }
+
+  for (const auto& group : groups)
+  {
+    FindFilesInFndb(requests, fileNames, group.second, results, unresolved);
+  }
+
+  for (size_t idx : unresolved)
+  {
+    results[idx] = LocateNoCache(fileNames[idx], requests[idx].options);
+  }
+
+  return results;
 }
 
 bool SessionImpl::FindFile(const string& fileName, const string& searchPath, FindFileOptionSet options, vector<PathName>& result)
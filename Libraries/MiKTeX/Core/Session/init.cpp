@@ -144,6 +144,7 @@ void SessionImpl::Initialize(const Session::InitInfo& initInfo)
   initialized = true;
 
   fsWatcher = FileSystemWatcher::Create();
+  fsWatcher->Subscribe(this);
   fsWatcher->Start();
 
   this->initInfo = initInfo;
@@ -249,11 +250,18 @@ void SessionImpl::Close()
   trace_core->WriteLine("core", T_("uninitializing core library"));
   if (fsWatcher != nullptr)
   {
+    fsWatcher->Unsubscribe(this);
     fsWatcher->Stop();
     fsWatcher = nullptr;
   }
+  trace_filesearch->WriteLine("core", fmt::format(T_("negative file cache: {0} hits, {1} misses"), negativeFileCacheHits, negativeFileCacheMisses));
   CheckOpenFiles();
   WritePackageHistory();
+  if (fileNameRecorderStream.is_open())
+  {
+    fileNameRecorderStream.close();
+  }
+  SaveDirectoryTreeCache();
   inputDirectories.clear();
   UnregisterLibraryTraceStreams();
   configurationSettings.clear();
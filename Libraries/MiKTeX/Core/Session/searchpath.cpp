@@ -21,10 +21,13 @@
 
 #include "config.h"
 
+#include <thread>
+
 #include <fmt/format.h>
 #include <fmt/ostream.h>
 
 #include <miktex/Core/Directory>
+#include <miktex/Core/Paths>
 #include <miktex/Trace/Trace>
 #include <miktex/Trace/TraceStream>
 
@@ -34,6 +37,7 @@
 
 using namespace std;
 
+using namespace MiKTeX::Configuration;
 using namespace MiKTeX::Core;
 using namespace MiKTeX::Trace;
 using namespace MiKTeX::Util;
@@ -170,11 +174,11 @@ void SessionImpl::TraceDirectoryPatterns(const std::string& fileType, const vect
   {
     return;
   }
-  trace_filesearch->WriteLine("core", TraceLevel::Trace, fmt::format(T_("directory patterns for {0}:"), fileType));
+  trace_filesearch->WriteLine("core", TraceLevel::Trace, [&]() { return fmt::format(T_("directory patterns for {0}:"), fileType); });
   unsigned ord = 0;
   for (vector<PathName>::const_iterator it = vec.begin(); it != vec.end(); ++it, ++ord)
   {
-    trace_filesearch->WriteLine("core", TraceLevel::Trace, fmt::format("  {0}: {1}", ord, it->ToDisplayString()));
+    trace_filesearch->WriteLine("core", TraceLevel::Trace, [&]() { return fmt::format("  {0}: {1}", ord, it->ToDisplayString()); });
   }
 }
 
@@ -219,18 +223,13 @@ void SessionImpl::DirectoryWalk(const PathName& directory, const PathName& pathP
   {
     ExpandPathPattern(directory, pathPattern, paths);
   }
-  unique_ptr<DirectoryLister> dirLister = DirectoryLister::Open(directory, nullptr, (int)DirectoryLister::Options::DirectoriesOnly);
-  DirectoryEntry entry;
   vector<PathName> subdirs;
-  while (dirLister->GetNext(entry))
+  for (const string& name : directoryTreeCache.GetSubdirectories(directory))
   {
-    MIKTEX_ASSERT(entry.isDirectory);
     PathName subdir(directory);
-    subdir /= entry.name;
+    subdir /= name;
     subdirs.push_back(subdir);
   }
-  dirLister->Close();
-  // TODO: async?
   for (const PathName& subdir : subdirs)
   {
     if (!pathPattern.Empty())
@@ -242,6 +241,48 @@ void SessionImpl::DirectoryWalk(const PathName& directory, const PathName& pathP
   }
 }
 
+PathName SessionImpl::GetDirectoryTreeCachePath()
+{
+  return GetSpecialPath(SpecialPath::DataRoot) / MIKTEX_PATH_MIKTEX_CACHE_DIR / "dirtree.txt";
+}
+
+// List the directory tree in parallel before it is walked; the walk
+// itself is serial, so that the order of the expanded paths does not
+// change.
+void SessionImpl::ScanDirectoryTree(const PathName& directory)
+{
+  if (!directoryTreeCacheLoaded)
+  {
+    directoryTreeCacheLoaded = true;
+    try
+    {
+      directoryTreeCache.Load(GetDirectoryTreeCachePath());
+    }
+    catch (const exception& e)
+    {
+      trace_error->WriteLine("core", TraceLevel::Warning, fmt::format(T_("directory tree cache cannot be loaded: {0}"), e.what()));
+    }
+  }
+  unsigned numThreads = std::min(std::max(thread::hardware_concurrency(), 2u), 8u);
+  directoryTreeCache.Scan(directory, numThreads);
+}
+
+void SessionImpl::SaveDirectoryTreeCache()
+{
+  if (!directoryTreeCache.IsModified())
+  {
+    return;
+  }
+  try
+  {
+    directoryTreeCache.Save(GetDirectoryTreeCachePath());
+  }
+  catch (const exception& e)
+  {
+    trace_error->WriteLine("core", TraceLevel::Warning, fmt::format(T_("directory tree cache cannot be saved: {0}"), e.what()));
+  }
+}
+
 void SessionImpl::ExpandPathPattern(const PathName& rootDirectory, const PathName& pathPattern, vector<PathName>& paths)
 {
   MIKTEX_ASSERT(!pathPattern.Empty());
@@ -271,6 +312,7 @@ void SessionImpl::ExpandPathPattern(const PathName& rootDirectory, const PathNam
     // check to see whether the sub directory exists
     if (!IsMpmFile(directory.GetData()) && Directory::Exists(directory))
     {
+      ScanDirectoryTree(directory);
       DirectoryWalk(directory, PathName(lpszSmallerPathPattern), paths);
     }
   }
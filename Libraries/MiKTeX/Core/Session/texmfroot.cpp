@@ -287,6 +287,12 @@ void SessionImpl::InitializeRootDirectories(const InternalStartupConfig& startup
     trace_config->WriteLine("core", fmt::format("CommonConfig: {}", GetRootDirectoryPath(commonConfigRootIndex).ToDisplayString()));
     trace_config->WriteLine("core", fmt::format("CommonInstall: {}", GetRootDirectoryPath(commonInstallRootIndex).ToDisplayString()));
   }
+
+#if defined(MIKTEX_UNIX)
+  // the session cache server is chosen by the root directories
+  sessionCacheSocketPath = PathName();
+  sessionCacheClient.Reset();
+#endif
 }
 
 vector<RootDirectoryInfo> SessionImpl::GetRootDirectories()
@@ -865,6 +871,9 @@ shared_ptr<FileNameDatabase> SessionImpl::GetFileNameDatabase(unsigned r)
 
   root.SetFndb(pFndb);
 
+  // directories of this root are no longer searched on disk
+  InvalidateNegativeFileCache();
+
   return pFndb;
 }
 
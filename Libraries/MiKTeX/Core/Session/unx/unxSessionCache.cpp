@@ -0,0 +1,731 @@
+/* unxSessionCache.cpp: delegating file lookups to a server (Unix)
+
+   Copyright (C) 2024 Christian Schenk
+
+   This file is part of the MiKTeX Core Library.
+
+   The MiKTeX Core Library is free software; you can redistribute it
+   and/or modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2, or
+   (at your option) any later version.
+
+   The MiKTeX Core Library is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with the MiKTeX Core Library; if not, write to the Free
+   Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+   02111-1307, USA. */
+
+#include "config.h"
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#if defined(MIKTEX_MACOS_BUNDLE)
+#  include <crt_externs.h>
+#  define environ (*_NSGetEnviron ())
+#else
+extern char** environ;
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <thread>
+#include <utility>
+
+#include <fmt/format.h>
+#include <fmt/ostream.h>
+
+#include <miktex/Core/Directory>
+#include <miktex/Core/DirectoryLister>
+#include <miktex/Core/Environment>
+#include <miktex/Core/File>
+#include <miktex/Core/MD5>
+#include <miktex/Core/Paths>
+#include <miktex/Core/SessionCache>
+
+#include "internal.h"
+
+#include "Session/SessionCache.h"
+#include "Session/SessionImpl.h"
+
+using namespace std;
+
+using namespace MiKTeX::Core;
+using namespace MiKTeX::Trace;
+using namespace MiKTeX::Util;
+
+// a lookup which takes longer than this is done by the client itself
+const int CLIENT_TIMEOUT_SECONDS = 30;
+
+namespace
+{
+  class unxSessionCacheServer :
+    public SessionCacheServer
+  {
+  public:
+    unxSessionCacheServer();
+
+  public:
+    MIKTEXTHISCALL ~unxSessionCacheServer() override;
+
+  public:
+    PathName MIKTEXTHISCALL GetSocketPath() override
+    {
+      return socketPath;
+    }
+
+  public:
+    bool MIKTEXTHISCALL IsRunning() override
+    {
+      return serving;
+    }
+
+  public:
+    bool MIKTEXTHISCALL Start() override;
+
+  public:
+    bool MIKTEXTHISCALL Stop() override;
+
+  private:
+    struct Client
+    {
+      int fd;
+      string buffer;
+    };
+
+  private:
+    void Serve();
+
+  private:
+    bool Accept();
+
+  private:
+    bool Receive(Client& client);
+
+  private:
+    string HandleRequest(const string& line);
+
+  private:
+    bool CheckConfiguration();
+
+  private:
+    vector<pair<PathName, time_t>> GetConfigurationStamps();
+
+  private:
+    shared_ptr<SessionImpl> session;
+
+  private:
+    PathName socketPath;
+
+  private:
+    int listenFd = -1;
+
+  private:
+    int cancelEventPipe[2] = { -1, -1 };
+
+  private:
+    vector<Client> clients;
+
+  private:
+    vector<pair<PathName, time_t>> stamps;
+
+  private:
+    chrono::steady_clock::time_point lastCheck;
+
+  private:
+    thread serverThread;
+
+  private:
+    atomic_bool running{ false };
+
+  private:
+    atomic_bool serving{ false };
+  };
+}
+
+// The socket lives in a directory which is private to the user.
+MIKTEXSTATICFUNC(PathName) GetSocketDirectory()
+{
+  const char* runtimeDir = getenv("XDG_RUNTIME_DIR");
+  if (runtimeDir != nullptr && *runtimeDir == '/')
+  {
+    return PathName(runtimeDir) / "miktex";
+  }
+  return PathName(fmt::format("/tmp/miktex-{0}", getuid()));
+}
+
+MIKTEXSTATICFUNC(bool) IsPrivateDirectory(const PathName& dir)
+{
+  struct stat statbuf;
+  return lstat(dir.GetData(), &statbuf) == 0 && S_ISDIR(statbuf.st_mode) && statbuf.st_uid == getuid() && (statbuf.st_mode & (S_IWGRP | S_IWOTH)) == 0;
+}
+
+MIKTEXSTATICFUNC(bool) MakeSocketAddress(const PathName& socketPath, struct sockaddr_un& addr)
+{
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  if (socketPath.GetLength() >= sizeof(addr.sun_path))
+  {
+    return false;
+  }
+  strcpy(addr.sun_path, socketPath.GetData());
+  return true;
+}
+
+MIKTEXSTATICFUNC(bool) SendAll(int fd, const string& data)
+{
+#if defined(MSG_NOSIGNAL)
+  const int flags = MSG_NOSIGNAL;
+#else
+  const int flags = 0;
+#endif
+  size_t offset = 0;
+  while (offset < data.length())
+  {
+    ssize_t n = send(fd, data.c_str() + offset, data.length() - offset, flags);
+    if (n < 0 && errno == EINTR)
+    {
+      continue;
+    }
+    if (n <= 0)
+    {
+      return false;
+    }
+    offset += n;
+  }
+  return true;
+}
+
+MIKTEXSTATICFUNC(void) SetCloseOnExec(int fd)
+{
+  fcntl(fd, F_SETFD, FD_CLOEXEC);
+#if defined(SO_NOSIGPIPE)
+  int one = 1;
+  setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+#endif
+}
+
+// The socket name is derived from everything which determines the
+// search paths: the user, the TEXMF roots and the environment
+// variables which can override search paths.
+PathName SessionImpl::GetSessionCacheSocketPath()
+{
+  if (!sessionCacheSocketPath.Empty())
+  {
+    return sessionCacheSocketPath;
+  }
+  MD5Builder md5Builder;
+  auto add = [&md5Builder](const string& s)
+  {
+    md5Builder.Update(s.c_str(), s.length() + 1);
+  };
+  add(std::to_string(getuid()));
+  add(IsAdminMode() ? "admin" : "user");
+  for (unsigned r = 0; r < GetNumberOfTEXMFRoots(); ++r)
+  {
+    add(GetRootDirectoryPath(r).ToString());
+  }
+  vector<string> environment;
+  for (char** env = environ; *env != nullptr; ++env)
+  {
+    string entry = *env;
+    string name = entry.substr(0, entry.find('='));
+    if (name.compare(0, strlen(MIKTEX_ENV_PREFIX_), MIKTEX_ENV_PREFIX_) == 0
+      || name.find("INPUTS") != string::npos
+      || name.find("FONTS") != string::npos
+      || name.find("MAPS") != string::npos
+      || name == "TEXBIB")
+    {
+      environment.push_back(entry);
+    }
+  }
+  sort(environment.begin(), environment.end());
+  for (const string& entry : environment)
+  {
+    add(entry);
+  }
+  sessionCacheSocketPath = GetSocketDirectory() / fmt::format("session-{0}.sock", md5Builder.Final().ToString());
+  return sessionCacheSocketPath;
+}
+
+bool SessionImpl::TryLocateViaSessionCache(const string& fileName, const LocateOptions& options, vector<PathName>& result)
+{
+  // the server neither creates files nor runs programs
+  if (sessionCacheDisabled || options.create || options.renew || options.fileType == FileType::EXE)
+  {
+    return false;
+  }
+  SessionCacheRequest request;
+  request.applicationNames = applicationNames;
+  request.workingDirectory.SetToCurrentDirectory();
+  PathName dir;
+  for (unsigned idx = 0; GetWorkingDirectory(idx, dir); ++idx)
+  {
+    request.workingDirectories.push_back(dir);
+  }
+  request.fileName = fileName;
+  request.options = options;
+  request.options.callback = nullptr;
+  if (!request.CanEncode() || !sessionCacheClient.Locate(GetSessionCacheSocketPath(), request, result))
+  {
+    return false;
+  }
+  // the server does not install packages: search again, so that the
+  // callback gets its chance
+  if (result.empty() && (options.callback != nullptr || findFileCallback != nullptr))
+  {
+    return false;
+  }
+  trace_filesearch->WriteLine("core", [&]() { return fmt::format(T_("session cache: {0} -> {1} result(s)"), Q_(fileName), result.size()); });
+  return true;
+}
+
+void SessionImpl::SetWorkingDirectories(const vector<PathName>& directories)
+{
+  MIKTEX_ASSERT(!directories.empty());
+  deque<PathName> newInputDirectories(directories.begin() + 1, directories.end());
+  if (startDirectory == directories[0] && inputDirectories == newInputDirectories)
+  {
+    return;
+  }
+  startDirectory = directories[0];
+  inputDirectories = std::move(newInputDirectories);
+  // relative search path entries and cached misses depend on the
+  // working directories
+  ClearSearchVectors();
+}
+
+SessionCacheClient::~SessionCacheClient()
+{
+  Disconnect();
+}
+
+bool SessionCacheClient::Connect(const PathName& socketPath)
+{
+  struct sockaddr_un addr;
+  if (!IsPrivateDirectory(socketPath.GetDirectoryName()) || !MakeSocketAddress(socketPath, addr))
+  {
+    return false;
+  }
+  fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0)
+  {
+    return false;
+  }
+  SetCloseOnExec(fd);
+  struct timeval timeout = { CLIENT_TIMEOUT_SECONDS, 0 };
+  setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+  setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+  if (connect(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) != 0)
+  {
+    Disconnect();
+    return false;
+  }
+  return true;
+}
+
+void SessionCacheClient::Disconnect()
+{
+  if (fd >= 0)
+  {
+    close(fd);
+    fd = -1;
+  }
+  buffer.clear();
+}
+
+void SessionCacheClient::Reset()
+{
+  Disconnect();
+  connectAttempted = false;
+}
+
+bool SessionCacheClient::ReadLine(string& line)
+{
+  while (true)
+  {
+    size_t end = buffer.find('\n');
+    if (end != string::npos)
+    {
+      line = buffer.substr(0, end);
+      buffer.erase(0, end + 1);
+      return true;
+    }
+    char chunk[4096];
+    ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+    if (n < 0 && errno == EINTR)
+    {
+      continue;
+    }
+    if (n <= 0)
+    {
+      return false;
+    }
+    buffer.append(chunk, n);
+  }
+}
+
+bool SessionCacheClient::Locate(const PathName& socketPath, const SessionCacheRequest& request, vector<PathName>& result)
+{
+  if (fd < 0)
+  {
+    if (connectAttempted)
+    {
+      return false;
+    }
+    connectAttempted = true;
+    if (!Connect(socketPath))
+    {
+      return false;
+    }
+  }
+  string line;
+  if (!SendAll(fd, request.Encode()) || !ReadLine(line))
+  {
+    Disconnect();
+    return false;
+  }
+  if (line.empty() || line.find_first_not_of("0123456789") != string::npos)
+  {
+    // the server could not handle the request
+    return false;
+  }
+  size_t count = std::stoul(line);
+  vector<PathName> pathNames;
+  pathNames.reserve(count);
+  for (size_t idx = 0; idx < count; ++idx)
+  {
+    if (!ReadLine(line))
+    {
+      Disconnect();
+      return false;
+    }
+    pathNames.push_back(PathName(line));
+  }
+  result = std::move(pathNames);
+  return true;
+}
+
+unique_ptr<SessionCacheServer> SessionCacheServer::Create()
+{
+  return make_unique<unxSessionCacheServer>();
+}
+
+unxSessionCacheServer::unxSessionCacheServer() :
+  session(SESSION_IMPL())
+{
+  socketPath = session->GetSessionCacheSocketPath();
+}
+
+unxSessionCacheServer::~unxSessionCacheServer()
+{
+  try
+  {
+    Stop();
+  }
+  catch (const exception&)
+  {
+  }
+}
+
+bool unxSessionCacheServer::Start()
+{
+  bool runningExpected = false;
+  if (!running.compare_exchange_strong(runningExpected, true))
+  {
+    return false;
+  }
+  PathName socketDir = socketPath.GetDirectoryName();
+  if (mkdir(socketDir.GetData(), S_IRWXU) != 0 && errno != EEXIST)
+  {
+    running = false;
+    MIKTEX_FATAL_CRT_ERROR_2("mkdir", "path", socketDir.ToString());
+  }
+  if (!IsPrivateDirectory(socketDir))
+  {
+    running = false;
+    MIKTEX_FATAL_ERROR_2(T_("The socket directory is not private to the user."), "path", socketDir.ToString());
+  }
+  struct sockaddr_un addr;
+  if (!MakeSocketAddress(socketPath, addr))
+  {
+    running = false;
+    MIKTEX_FATAL_ERROR_2(T_("The socket path is too long."), "path", socketPath.ToString());
+  }
+  listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (listenFd < 0)
+  {
+    running = false;
+    MIKTEX_FATAL_CRT_ERROR("socket");
+  }
+  SetCloseOnExec(listenFd);
+  if (connect(listenFd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) == 0)
+  {
+    close(listenFd);
+    listenFd = -1;
+    running = false;
+    MIKTEX_FATAL_ERROR_2(T_("The session cache server is already running."), "path", socketPath.ToString());
+  }
+  // a stale socket from a previous server
+  unlink(socketPath.GetData());
+  if (bind(listenFd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) != 0 || listen(listenFd, SOMAXCONN) != 0)
+  {
+    int error = errno;
+    close(listenFd);
+    listenFd = -1;
+    running = false;
+    errno = error;
+    MIKTEX_FATAL_CRT_ERROR_2("bind", "path", socketPath.ToString());
+  }
+  if (pipe(cancelEventPipe) != 0)
+  {
+    MIKTEX_FATAL_CRT_ERROR("pipe");
+  }
+  // lookups are done on behalf of other processes: never look into
+  // the server's own socket, never install packages
+  session->DisableSessionCache();
+  session->SetFindFileCallback(nullptr);
+  stamps = GetConfigurationStamps();
+  lastCheck = chrono::steady_clock::now();
+  serving = true;
+  serverThread = thread(&unxSessionCacheServer::Serve, this);
+  return true;
+}
+
+bool unxSessionCacheServer::Stop()
+{
+  bool runningExpected = true;
+  if (!running.compare_exchange_strong(runningExpected, false))
+  {
+    return false;
+  }
+  char buf[1] = { 0 };
+  if (write(cancelEventPipe[1], buf, 1) < 0)
+  {
+    MIKTEX_FATAL_CRT_ERROR("write");
+  }
+  if (serverThread.joinable())
+  {
+    serverThread.join();
+  }
+  for (const Client& client : clients)
+  {
+    close(client.fd);
+  }
+  clients.clear();
+  close(listenFd);
+  listenFd = -1;
+  close(cancelEventPipe[0]);
+  close(cancelEventPipe[1]);
+  unlink(socketPath.GetData());
+  return true;
+}
+
+void unxSessionCacheServer::Serve()
+{
+  try
+  {
+    while (true)
+    {
+      vector<struct pollfd> fds;
+      fds.push_back({ cancelEventPipe[0], POLLIN, 0 });
+      fds.push_back({ listenFd, POLLIN, 0 });
+      for (const Client& client : clients)
+      {
+        fds.push_back({ client.fd, POLLIN, 0 });
+      }
+      int n = poll(&fds[0], fds.size(), 1000);
+      if (n < 0 && errno != EINTR)
+      {
+        MIKTEX_FATAL_CRT_ERROR("poll");
+      }
+      if ((fds[0].revents & POLLIN) != 0)
+      {
+        break;
+      }
+      if (!CheckConfiguration())
+      {
+        break;
+      }
+      if (n <= 0)
+      {
+        continue;
+      }
+      // clients which have gone are removed after the loop, so that
+      // the indices stay in sync with fds
+      vector<Client> remainingClients;
+      for (size_t idx = 0; idx < clients.size(); ++idx)
+      {
+        if ((fds[idx + 2].revents & (POLLIN | POLLHUP | POLLERR)) != 0 && !Receive(clients[idx]))
+        {
+          close(clients[idx].fd);
+          continue;
+        }
+        remainingClients.push_back(std::move(clients[idx]));
+      }
+      clients = std::move(remainingClients);
+      if ((fds[1].revents & POLLIN) != 0)
+      {
+        Accept();
+      }
+    }
+  }
+  catch (const exception& e)
+  {
+    session->trace_error->WriteLine("core", TraceLevel::Error, fmt::format(T_("session cache server: {0}"), e.what()));
+  }
+  serving = false;
+}
+
+bool unxSessionCacheServer::Accept()
+{
+  int fd = accept(listenFd, nullptr, nullptr);
+  if (fd < 0)
+  {
+    return false;
+  }
+  SetCloseOnExec(fd);
+#if defined(SO_PEERCRED)
+  struct ucred cred;
+  socklen_t len = sizeof(cred);
+  if (getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &cred, &len) != 0 || cred.uid != getuid())
+  {
+    close(fd);
+    return false;
+  }
+#endif
+  clients.push_back({ fd, "" });
+  return true;
+}
+
+bool unxSessionCacheServer::Receive(Client& client)
+{
+  char chunk[4096];
+  ssize_t n = recv(client.fd, chunk, sizeof(chunk), 0);
+  if (n < 0 && errno == EINTR)
+  {
+    return true;
+  }
+  if (n <= 0)
+  {
+    return false;
+  }
+  client.buffer.append(chunk, n);
+  size_t end;
+  while ((end = client.buffer.find('\n')) != string::npos)
+  {
+    string line = client.buffer.substr(0, end);
+    client.buffer.erase(0, end + 1);
+    if (!SendAll(client.fd, HandleRequest(line)))
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+string unxSessionCacheServer::HandleRequest(const string& line)
+{
+  SessionCacheRequest request;
+  if (!request.Decode(line))
+  {
+    return "E\n";
+  }
+  try
+  {
+    session->SetApplicationNames(request.applicationNames);
+    // relative names and relative search path entries must be resolved
+    // as the client would do
+    if (chdir(request.workingDirectory.GetData()) != 0)
+    {
+      return "E\n";
+    }
+    session->SetWorkingDirectories(request.workingDirectories);
+    LocateResult locateResult = session->LocateNoCache(request.fileName, request.options);
+    string response = std::to_string(locateResult.pathNames.size());
+    response += '\n';
+    for (const PathName& path : locateResult.pathNames)
+    {
+      if (path.ToString().find('\n') != string::npos)
+      {
+        return "E\n";
+      }
+      response += path.ToString();
+      response += '\n';
+    }
+    return response;
+  }
+  catch (const exception& e)
+  {
+    session->trace_error->WriteLine("core", TraceLevel::Warning, fmt::format(T_("session cache server: {0}"), e.what()));
+    return "E\n";
+  }
+}
+
+// The configuration is checked once a second. Changed file name
+// databases or configuration files make the server start over; it
+// stops, if the new configuration has a different socket name.
+bool unxSessionCacheServer::CheckConfiguration()
+{
+  auto now = chrono::steady_clock::now();
+  if (now - lastCheck < 1s)
+  {
+    return true;
+  }
+  lastCheck = now;
+  vector<pair<PathName, time_t>> newStamps = GetConfigurationStamps();
+  if (newStamps == stamps)
+  {
+    return true;
+  }
+  session->trace_core->WriteLine("core", T_("session cache server: configuration has changed"));
+  session->Reset();
+  session->DisableSessionCache();
+  if (session->GetSessionCacheSocketPath() != socketPath)
+  {
+    return false;
+  }
+  stamps = GetConfigurationStamps();
+  return true;
+}
+
+vector<pair<PathName, time_t>> unxSessionCacheServer::GetConfigurationStamps()
+{
+  vector<pair<PathName, time_t>> result;
+  for (unsigned r = 0; r < session->GetNumberOfTEXMFRoots(); ++r)
+  {
+    PathName fndbPath = session->GetFilenameDatabasePathName(r);
+    result.push_back(make_pair(fndbPath, File::Exists(fndbPath) ? File::GetLastWriteTime(fndbPath) : 0));
+    PathName configDir = session->GetRootDirectoryPath(r) / MIKTEX_PATH_MIKTEX_CONFIG_DIR;
+    if (!Directory::Exists(configDir))
+    {
+      continue;
+    }
+    unique_ptr<DirectoryLister> lister = DirectoryLister::Open(configDir, "*.ini", (int)DirectoryLister::Options::FilesOnly);
+    DirectoryEntry entry;
+    vector<pair<PathName, time_t>> configFiles;
+    while (lister->GetNext(entry))
+    {
+      PathName path = configDir / entry.name;
+      configFiles.push_back(make_pair(path, File::GetLastWriteTime(path)));
+    }
+    lister->Close();
+    sort(configFiles.begin(), configFiles.end());
+    result.insert(result.end(), configFiles.begin(), configFiles.end());
+  }
+  return result;
+}
@@ -24,15 +24,23 @@ class CoreStopWatch
 
 public:
 
-    CoreStopWatch(const std::string &message) : stopWatch(MiKTeX::Trace::StopWatch::Start(SESSION_IMPL()->trace_stopwatch.get(), "core", message))
+    template<typename MakeMessage> CoreStopWatch(MakeMessage&& makeMessage)
     {
+        MiKTeX::Trace::TraceStream* traceStream = SESSION_IMPL()->trace_stopwatch.get();
+        if (traceStream->IsEnabled(MiKTeX::Trace::TraceLevel::Trace) && traceStream->IsEnabled("core", MiKTeX::Trace::TraceLevel::Trace))
+        {
+            stopWatch = MiKTeX::Trace::StopWatch::Start(traceStream, "core", makeMessage());
+        }
     }
 
     ~CoreStopWatch()
     {
         try
         {
-            stopWatch->Stop();
+            if (stopWatch != nullptr)
+            {
+                stopWatch->Stop();
+            }
         }
         catch (const std::exception &)
         {
@@ -0,0 +1,108 @@
+/* miktex/Core/DependencyLog.h:                         -*- C++ -*-
+
+   Copyright (C) 2024 Christian Schenk
+
+   This file is part of the MiKTeX Core Library.
+
+   The MiKTeX Core Library is free software; you can redistribute it
+   and/or modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2, or
+   (at your option) any later version.
+
+   The MiKTeX Core Library is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with the MiKTeX Core Library; if not, write to the Free
+   Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+   02111-1307, USA. */
+
+#pragma once
+
+#if !defined(D2A4F8C1B3E54F7A9C6D0E1F2A3B4C5D)
+#define D2A4F8C1B3E54F7A9C6D0E1F2A3B4C5D
+
+#include <miktex/Core/config.h>
+
+#include <cstddef>
+#include <ctime>
+
+#include <vector>
+
+#include <miktex/Util/PathName>
+
+#include "File.h"
+#include "MD5.h"
+
+MIKTEX_CORE_BEGIN_NAMESPACE;
+
+/// A file which has been read or written by a program run.
+struct DependencyLogRecord
+{
+  /// How the file has been accessed.
+  FileAccess access = FileAccess::None;
+  /// The file system path to the file.
+  MiKTeX::Util::PathName path;
+  /// The size of the file (in bytes).
+  std::size_t size = 0;
+  /// The last write time of the file.
+  std::time_t lastWriteTime = 0;
+  /// The MD5 of the file contents.
+  MD5 md5;
+};
+
+/// Binary log of the files a program run depends on.
+class MIKTEXNOVTABLE DependencyLog
+{
+public:
+  DependencyLog() = delete;
+
+public:
+  DependencyLog(const DependencyLog& other) = delete;
+
+public:
+  DependencyLog& operator=(const DependencyLog& other) = delete;
+
+public:
+  DependencyLog(DependencyLog&& other) = delete;
+
+public:
+  DependencyLog& operator=(DependencyLog&& other) = delete;
+
+public:
+  ~DependencyLog() = delete;
+
+  /// Gets the files which have been changed since the log was written.
+  /// A file is unchanged, if size and last write time are unchanged, or,
+  /// if the MD5 of its contents is unchanged.
+  /// @param records The log records to be checked.
+  /// @param access Check only records with this kind of access.
+  /// @return Returns the records of the changed (or removed) files.
+public:
+  static MIKTEXCORECEEAPI(std::vector<DependencyLogRecord>) GetChangedFiles(const std::vector<DependencyLogRecord>& records, FileAccess access);
+
+  /// Creates a log record for an existing file.
+  /// @param path The file system path to the file.
+  /// @param access How the file has been accessed.
+  /// @return Returns the log record.
+public:
+  static MIKTEXCORECEEAPI(DependencyLogRecord) MakeRecord(const MiKTeX::Util::PathName& path, FileAccess access);
+
+  /// Reads a dependency log file.
+  /// @param path The file system path to the log file.
+  /// @return Returns the log records.
+public:
+  static MIKTEXCORECEEAPI(std::vector<DependencyLogRecord>) Read(const MiKTeX::Util::PathName& path);
+
+  /// Writes a dependency log file.
+  /// @param path The file system path to the log file.
+  /// @param records The log records.
+public:
+  static MIKTEXCORECEEAPI(void) Write(const MiKTeX::Util::PathName& path, const std::vector<DependencyLogRecord>& records);
+};
+
+MIKTEX_CORE_END_NAMESPACE;
+
+#endif
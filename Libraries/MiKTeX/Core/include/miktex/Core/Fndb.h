@@ -75,6 +75,11 @@ public:
 public:
   static MIKTEXCORECEEAPI(bool) Create(const MiKTeX::Util::PathName& fndbPath, const MiKTeX::Util::PathName& rootPath, ICreateFndbCallback* callback, bool enableStringPooling, bool storeFileNameInfo);
 
+  // numThreads == 0: one directory scanner per hardware thread; a callback forces a serial scan;
+  // the other overloads scan serially
+public:
+  static MIKTEXCORECEEAPI(bool) Create(const MiKTeX::Util::PathName& fndbPath, const MiKTeX::Util::PathName& rootPath, ICreateFndbCallback* callback, bool enableStringPooling, bool storeFileNameInfo, unsigned numThreads);
+
 public:
   static MIKTEXCORECEEAPI(bool) Search(const MiKTeX::Util::PathName& fileName, const std::string& pathPattern, bool all, std::vector<Record>& result);
 
@@ -397,6 +397,12 @@ struct LocateResult {
   std::vector<MiKTeX::Util::PathName> pathNames;
 };
 
+/// A file to be searched by `Session::FindFiles()`.
+struct FindRequest {
+  std::string fileName;
+  LocateOptions options;
+};
+
 /// The MiKTeX session interface.
 class MIKTEXNOVTABLE Session :
   public MiKTeX::Configuration::ConfigurationProvider
@@ -780,6 +786,9 @@ public:
   /// @param path The file system path to the log file.
   virtual void MIKTEXTHISCALL SetRecorderPath(const MiKTeX::Util::PathName& path) = 0;
 
+  /// Writes pending file name records to the log file.
+  virtual void MIKTEXTHISCALL FlushRecorder() = 0;
+
   /// Adds a file name record to the log file.
   /// @param The file system file to the file.
   /// @param How the file is accessed.
@@ -800,6 +809,13 @@ public:
   /// @return Return the result of the search.
   virtual LocateResult MIKTEXTHISCALL Locate(const std::string& fileName, const LocateOptions& options) = 0;
 
+  /// Searches many files at once.
+  /// Requests with equal search options share the directory patterns
+  /// and each file name database is probed once per directory pattern.
+  /// @param requests The files to search.
+  /// @return Returns one result per request, in request order.
+  virtual std::vector<LocateResult> MIKTEXTHISCALL FindFiles(const std::vector<FindRequest>& requests) = 0;
+
   /// Searches a file.
   /// @param fileName The name of the file to search.
   /// @param searchPath The search path.
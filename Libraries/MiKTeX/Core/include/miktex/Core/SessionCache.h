@@ -0,0 +1,75 @@
+/* miktex/Core/SessionCache.h:                          -*- C++ -*-
+
+   Copyright (C) 2024 Christian Schenk
+
+   This file is part of the MiKTeX Core Library.
+
+   The MiKTeX Core Library is free software; you can redistribute it
+   and/or modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2, or
+   (at your option) any later version.
+
+   The MiKTeX Core Library is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with the MiKTeX Core Library; if not, write to the Free
+   Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+   02111-1307, USA. */
+
+#pragma once
+
+#if !defined(B7E0C2D5A4F34C8B9E1D6A7F0C3B2E91)
+#define B7E0C2D5A4F34C8B9E1D6A7F0C3B2E91
+
+#include <miktex/Core/config.h>
+
+#include <memory>
+
+#include <miktex/Util/PathName>
+
+MIKTEX_CORE_BEGIN_NAMESPACE;
+
+/// Serves file lookups of other processes.
+///
+/// The server keeps the file name databases and search paths of the
+/// current session loaded. Processes of the same user, which use the
+/// same TEXMF root configuration, delegate `Session::Locate()` to the
+/// server, if it is running. They search on their own, if it is not.
+class MIKTEXNOVTABLE SessionCacheServer
+{
+public:
+  virtual MIKTEXTHISCALL ~SessionCacheServer() noexcept = 0;
+
+  /// Gets the socket on which the server accepts connections.
+  /// @return Returns the file system path to the socket.
+public:
+  virtual MiKTeX::Util::PathName MIKTEXTHISCALL GetSocketPath() = 0;
+
+  /// Tests whether the server is running.
+  /// The server stops by itself, if the root configuration changes.
+  /// @return Returns `true`, if the server is running.
+public:
+  virtual bool MIKTEXTHISCALL IsRunning() = 0;
+
+  /// Starts serving lookups on a background thread.
+  /// @return Returns `false`, if the server is already running.
+public:
+  virtual bool MIKTEXTHISCALL Start() = 0;
+
+  /// Stops serving lookups.
+  /// @return Returns `false`, if the server is not running.
+public:
+  virtual bool MIKTEXTHISCALL Stop() = 0;
+
+  /// Creates a server for the current session.
+  /// @return Returns the server object.
+public:
+  static MIKTEXCORECEEAPI(std::unique_ptr<SessionCacheServer>) Create();
+};
+
+MIKTEX_CORE_END_NAMESPACE;
+
+#endif
@@ -0,0 +1,532 @@
+/* 1.cpp: Core library benchmarks
+
+   Copyright (C) 2024 Christian Schenk
+
+   This file is part of the MiKTeX Core Library.
+
+   The MiKTeX Core Library is free software; you can redistribute it
+   and/or modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2, or
+   (at your option) any later version.
+
+   The MiKTeX Core Library is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with the MiKTeX Core Library; if not, write to the Free
+   Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+   02111-1307, USA. */
+
+#include "config.h"
+
+#include <cstdlib>
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <fmt/format.h>
+
+#include <miktex/Core/Cfg>
+#include <miktex/Core/Directory>
+#include <miktex/Core/Exceptions>
+#include <miktex/Core/File>
+#include <miktex/Core/Fndb>
+#include <miktex/Core/MD5>
+#include <miktex/Core/Process>
+#include <miktex/Core/Session>
+#include <miktex/Extractor/Extractor>
+#include <miktex/Util/PathName>
+#include <miktex/Util/PathNameUtil>
+#include <miktex/Util/StringUtil>
+#include <miktex/Wrappers/PoptWrapper>
+
+using namespace std;
+
+using namespace MiKTeX::Core;
+using namespace MiKTeX::Extractor;
+using namespace MiKTeX::Util;
+using namespace MiKTeX::Wrappers;
+
+const unsigned NUM_ROOTS = 5;
+
+const unsigned NUM_DUPLICATES = 100;
+
+struct FileKind
+{
+  const char* directory;
+  const char* extension;
+  FileType fileType;
+};
+
+const FileKind FILE_KINDS[] = {
+  { "tex/latex", ".sty", FileType::TEX },
+  { "tex/generic", ".tex", FileType::TEX },
+  { "fonts/tfm/public", ".tfm", FileType::TFM },
+  { "fonts/type1/public", ".pfb", FileType::TYPE1 },
+};
+
+const size_t NUM_FILE_KINDS = sizeof(FILE_KINDS) / sizeof(FILE_KINDS[0]);
+
+struct BenchmarkResult
+{
+  string name;
+  size_t iterations = 0;
+  double seconds = 0.0;
+  size_t errors = 0;
+  bool skipped = false;
+};
+
+class Benchmark
+{
+public:
+  int Main(int argc, const char** argv);
+
+private:
+  template<typename Func> void Measure(const string& name, size_t iterations, Func&& func)
+  {
+    BenchmarkResult result;
+    result.name = name;
+    result.iterations = iterations;
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; ++i)
+    {
+      if (!func(i))
+      {
+        result.errors++;
+      }
+    }
+    result.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    results.push_back(result);
+  }
+
+private:
+  void Skip(const string& name)
+  {
+    BenchmarkResult result;
+    result.name = name;
+    result.skipped = true;
+    results.push_back(result);
+  }
+
+private:
+  PathName GetRoot(unsigned r) const
+  {
+    return workDir / fmt::format("root{0}", r);
+  }
+
+private:
+  string GetFileName(size_t k) const
+  {
+    return fmt::format("bm{0}{1}", k, FILE_KINDS[k % NUM_FILE_KINDS].extension);
+  }
+
+private:
+  PathName GetFilePath(size_t k) const
+  {
+    return GetRoot(k % NUM_ROOTS) / FILE_KINDS[k % NUM_FILE_KINDS].directory / fmt::format("pkg{0}", k / 100) / GetFileName(k);
+  }
+
+private:
+  void CreateTree();
+
+private:
+  void CreatePackageManifests(const PathName& path);
+
+private:
+  void RunFndbBenchmarks();
+
+private:
+  void RunCfgBenchmarks();
+
+private:
+  void RunPathNameBenchmarks();
+
+private:
+  void RunMD5Benchmarks();
+
+private:
+  void RunExtractorBenchmarks();
+
+private:
+  void WriteResults(ostream& stream) const;
+
+private:
+  PathName workDir;
+
+private:
+  size_t numFiles = 100000;
+
+private:
+  string archive;
+
+private:
+  shared_ptr<Session> session;
+
+private:
+  vector<BenchmarkResult> results;
+};
+
+enum class Option
+{
+  None,
+  Archive,
+  Files,
+  Output,
+  WorkDir,
+};
+
+const struct poptOption optionTable[] = {
+  { "archive", 0, POPT_ARG_STRING, nullptr, (int)Option::Archive, "Use this tar.lzma archive for the extractor benchmark.", "FILE" },
+  { "files", 0, POPT_ARG_STRING, nullptr, (int)Option::Files, "Set the number of files in the synthetic TEXMF tree.", "N" },
+  { "output", 0, POPT_ARG_STRING, nullptr, (int)Option::Output, "Write the results (JSON) to this file.", "FILE" },
+  { "work-dir", 0, POPT_ARG_STRING, nullptr, (int)Option::WorkDir, "Set the sandbox directory.", "DIR" },
+  POPT_AUTOHELP
+  POPT_TABLEEND
+};
+
+// The tree is reused by later runs, if it has the requested size.
+void Benchmark::CreateTree()
+{
+  PathName stampFile = workDir / "tree.stamp";
+  string stamp = fmt::format("{0} {1}", NUM_ROOTS, numFiles);
+  if (File::Exists(stampFile))
+  {
+    vector<unsigned char> bytes = File::ReadAllBytes(stampFile);
+    if (string(bytes.begin(), bytes.end()) == stamp)
+    {
+      return;
+    }
+  }
+  if (Directory::Exists(workDir))
+  {
+    Directory::Delete(workDir, true);
+  }
+  for (size_t k = 0; k < numFiles; ++k)
+  {
+    PathName path = GetFilePath(k);
+    // the first files of a package cover all root/kind combinations
+    if (k % 100 < NUM_FILE_KINDS * NUM_ROOTS)
+    {
+      Directory::Create(PathName(path).RemoveFileSpec());
+    }
+    File::WriteBytes(path, {});
+  }
+  // files which exist in all roots
+  for (unsigned r = 0; r < NUM_ROOTS; ++r)
+  {
+    PathName dir = GetRoot(r) / "tex/latex/dup";
+    Directory::Create(dir);
+    for (unsigned j = 0; j < NUM_DUPLICATES; ++j)
+    {
+      File::WriteBytes(dir / fmt::format("dup{0}.sty", j), {});
+    }
+  }
+  Directory::Create(workDir / "install");
+  Directory::Create(workDir / "data");
+  File::WriteBytes(stampFile, vector<unsigned char>(stamp.begin(), stamp.end()));
+}
+
+void Benchmark::RunFndbBenchmarks()
+{
+  vector<unsigned> rootIndices;
+  for (unsigned r = 0; r < NUM_ROOTS; ++r)
+  {
+    rootIndices.push_back(session->DeriveTEXMFRoot(GetRoot(r)));
+  }
+
+  Measure("fndb.create", NUM_ROOTS, [&](size_t r) {
+    return Fndb::Create(session->GetFilenameDatabasePathName(rootIndices[r]), GetRoot(static_cast<unsigned>(r)), nullptr);
+  });
+
+  // the first search loads the file name databases
+  const size_t coldRounds = 10;
+  Measure("fndb.open.cold", coldRounds, [&](size_t i) {
+    session->UnloadFilenameDatabase();
+    PathName path;
+    return session->FindFile(GetFileName(i), FILE_KINDS[i % NUM_FILE_KINDS].fileType, path);
+  });
+
+  PathName path;
+  session->FindFile(GetFileName(0), FILE_KINDS[0].fileType, path);
+  Measure("fndb.open.warm", coldRounds, [&](size_t i) {
+    return session->FindFile(GetFileName(i), FILE_KINDS[i % NUM_FILE_KINDS].fileType, path);
+  });
+
+  const size_t lookups = 10000;
+  for (size_t kind = 0; kind < NUM_FILE_KINDS; ++kind)
+  {
+    FileType fileType = FILE_KINDS[kind].fileType;
+    string typeName = FILE_KINDS[kind].extension + 1;
+    Measure("findfile.hit." + typeName, lookups, [&](size_t i) {
+      size_t k = ((i * 7919) % (numFiles / NUM_FILE_KINDS)) * NUM_FILE_KINDS + kind;
+      return k < numFiles && session->FindFile(GetFileName(k), fileType, path);
+    });
+    Measure("findfile.miss." + typeName, lookups, [&](size_t i) {
+      return !session->FindFile(fmt::format("nonexistent{0}{1}", i, FILE_KINDS[kind].extension), fileType, path);
+    });
+  }
+
+  vector<PathName> paths;
+  Measure("findfile.all", NUM_DUPLICATES, [&](size_t j) {
+    paths.clear();
+    return session->FindFile(fmt::format("dup{0}.sty", j), FileType::TEX, { Session::FindFileOption::All }, paths) && paths.size() == NUM_ROOTS;
+  });
+}
+
+void Benchmark::CreatePackageManifests(const PathName& path)
+{
+  ofstream stream = File::CreateOutputStream(path);
+  const size_t numPackages = 5000;
+  for (size_t p = 0; p < numPackages; ++p)
+  {
+    stream
+      << "[pkg" << p << "]\n"
+      << "displayName=pkg" << p << "\n"
+      << "title=A synthetic package\n"
+      << "version=1.0\n"
+      << "description[]=This package has been created by the Core benchmark.\n"
+      << "description[]=It has no real contents.\n"
+      << "require[]=pkg" << (p + 1) % numPackages << "\n"
+      << "runSize=20480\n";
+    for (size_t f = 0; f < 20; ++f)
+    {
+      stream << "run[]=texmf/tex/latex/pkg" << p << "/file" << f << ".sty\n";
+    }
+    stream << "docSize=4096\n";
+    for (size_t f = 0; f < 3; ++f)
+    {
+      stream << "doc[]=texmf/doc/latex/pkg" << p << "/file" << f << ".pdf\n";
+    }
+    stream
+      << "timePackaged=1700000000\n"
+      << "digest=d41d8cd98f00b204e9800998ecf8427e\n\n";
+  }
+  stream.close();
+}
+
+void Benchmark::RunCfgBenchmarks()
+{
+  PathName path = workDir / "package-manifests.ini";
+  if (!File::Exists(path))
+  {
+    CreatePackageManifests(path);
+  }
+  Measure("cfg.read.package-manifests", 5, [&](size_t) {
+    unique_ptr<Cfg> cfg = Cfg::Create();
+    cfg->Read(path);
+    return cfg->GetSize() > 0;
+  });
+}
+
+void Benchmark::RunPathNameBenchmarks()
+{
+  const size_t rounds = 200000;
+  Measure("pathname.compose", rounds, [&](size_t i) {
+    PathName path = workDir / "tex" / "latex" / fmt::format("pkg{0}", i % 1000) / "file.sty";
+    path.SetExtension(".tex");
+    return path.GetFileName().ToString() == "file.tex";
+  });
+  Measure("pathname.compare", rounds, [&](size_t i) {
+    PathName path1 = GetFilePath(i % numFiles);
+    PathName path2 = GetFilePath(i % numFiles);
+    return PathName::Compare(path1, path2) == 0;
+  });
+}
+
+void Benchmark::RunMD5Benchmarks()
+{
+  PathName path = workDir / "md5.bin";
+  const size_t size = 64 * 1024 * 1024;
+  if (!File::Exists(path) || File::GetSize(path) != size)
+  {
+    vector<unsigned char> data(size);
+    for (size_t i = 0; i < size; ++i)
+    {
+      data[i] = static_cast<unsigned char>(i * 2654435761u >> 24);
+    }
+    File::WriteBytes(path, data);
+  }
+  MD5 md5 = MD5::FromFile(path);
+  Measure("md5.fromfile.64mb", 3, [&](size_t) {
+    return MD5::FromFile(path) == md5;
+  });
+}
+
+void Benchmark::RunExtractorBenchmarks()
+{
+  PathName archivePath;
+  if (!archive.empty())
+  {
+    archivePath = archive;
+  }
+  else
+  {
+    // make an archive of the first root (requires tar and xz)
+    archivePath = workDir / "root0.tar.lzma";
+    if (!File::Exists(archivePath))
+    {
+      int exitCode;
+      string commandLine = fmt::format("tar -cf - -C \"{0}\" fonts tex | xz --format=lzma > \"{1}\"", GetRoot(0).ToString(), archivePath.ToString());
+      if (!Process::ExecuteSystemCommand(commandLine, &exitCode) || exitCode != 0)
+      {
+        if (File::Exists(archivePath))
+        {
+          File::Delete(archivePath);
+        }
+        Skip("extractor.tarlzma");
+        return;
+      }
+    }
+  }
+  PathName destDir = workDir / "extracted";
+  Measure("extractor.tarlzma", 3, [&](size_t) {
+    if (Directory::Exists(destDir))
+    {
+      Directory::Delete(destDir, true);
+    }
+    Extractor::CreateExtractor(ArchiveFileType::TarLzma)->Extract(archivePath, destDir, true);
+    return Directory::Exists(destDir);
+  });
+  Directory::Delete(destDir, true);
+}
+
+void Benchmark::WriteResults(ostream& stream) const
+{
+  stream
+    << "{\n"
+    << "  \"suite\": \"miktex-core\",\n"
+    << "  \"roots\": " << NUM_ROOTS << ",\n"
+    << "  \"files\": " << numFiles << ",\n"
+    << "  \"results\": [\n";
+  for (size_t idx = 0; idx < results.size(); ++idx)
+  {
+    const BenchmarkResult& r = results[idx];
+    stream << "    { \"name\": \"" << r.name << "\"";
+    if (r.skipped)
+    {
+      stream << ", \"skipped\": true";
+    }
+    else
+    {
+      double nsPerOp = r.iterations > 0 ? r.seconds * 1e9 / r.iterations : 0.0;
+      stream
+        << ", \"iterations\": " << r.iterations
+        << ", \"seconds\": " << fmt::format("{:.6f}", r.seconds)
+        << ", \"ns_per_op\": " << fmt::format("{:.1f}", nsPerOp)
+        << ", \"errors\": " << r.errors;
+    }
+    stream << " }" << (idx + 1 < results.size() ? "," : "") << "\n";
+  }
+  stream
+    << "  ]\n"
+    << "}\n";
+}
+
+int Benchmark::Main(int argc, const char** argv)
+{
+  string outputFile;
+  workDir = PathName(TEST_BINARY_DIR) / "benchmark-sandbox";
+  PoptWrapper popt(argc, argv, optionTable);
+  int option;
+  while ((option = popt.GetNextOpt()) >= 0)
+  {
+    switch ((Option)option)
+    {
+    case Option::Archive:
+      archive = popt.GetOptArg();
+      break;
+    case Option::Files:
+    {
+      // the lookups need at least one file of each kind
+      string arg = popt.GetOptArg();
+      char* end = nullptr;
+      unsigned long long n = arg.empty() || arg[0] == '-' ? 0 : std::strtoull(arg.c_str(), &end, 10);
+      if (end == nullptr || *end != 0 || n < NUM_FILE_KINDS || n > 10000000)
+      {
+        cerr << "--files: expected a number between " << NUM_FILE_KINDS << " and 10000000: " << arg << endl;
+        return 1;
+      }
+      numFiles = n;
+      break;
+    }
+    case Option::Output:
+      outputFile = popt.GetOptArg();
+      break;
+    case Option::WorkDir:
+      workDir = popt.GetOptArg();
+      break;
+    default:
+      break;
+    }
+  }
+  if (option < -1)
+  {
+    cerr << popt.BadOption(POPT_BADOPTION_NOALIAS) << ": " << popt.Strerror(option) << endl;
+    return 1;
+  }
+  try
+  {
+    workDir.MakeFullyQualified();
+    CreateTree();
+    Session::InitInfo initInfo(argv[0]);
+    StartupConfig startupConfig;
+    vector<string> roots;
+    for (unsigned r = 0; r < NUM_ROOTS; ++r)
+    {
+      roots.push_back(GetRoot(r).ToString());
+    }
+    startupConfig.userRoots = StringUtil::Flatten(roots, PathNameUtil::PathNameDelimiter);
+    startupConfig.userInstallRoot = workDir / "install";
+    startupConfig.userDataRoot = workDir / "data";
+    initInfo.SetStartupConfig(startupConfig);
+    session = Session::Create(initInfo);
+    RunFndbBenchmarks();
+    RunCfgBenchmarks();
+    RunPathNameBenchmarks();
+    RunMD5Benchmarks();
+    RunExtractorBenchmarks();
+    session->Close();
+    session = nullptr;
+  }
+  catch (const MiKTeXException& ex)
+  {
+    cerr << ex.GetErrorMessage() << endl;
+    return 1;
+  }
+  catch (const exception& ex)
+  {
+    cerr << ex.what() << endl;
+    return 1;
+  }
+  if (outputFile.empty())
+  {
+    WriteResults(cout);
+  }
+  else
+  {
+    ofstream stream = File::CreateOutputStream(PathName(outputFile));
+    WriteResults(stream);
+    stream.close();
+  }
+  for (const BenchmarkResult& r : results)
+  {
+    if (r.errors > 0)
+    {
+      cerr << r.name << ": " << r.errors << " unexpected result(s)" << endl;
+      return 1;
+    }
+  }
+  return 0;
+}
+
+int main(int argc, const char** argv)
+{
+  Benchmark benchmark;
+  return benchmark.Main(argc, argv);
+}
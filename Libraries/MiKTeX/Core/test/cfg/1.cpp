@@ -23,6 +23,7 @@
 
 #include <miktex/Core/Test>
 
+#include <fstream>
 #include <memory>
 #include <string>
 
@@ -175,6 +176,48 @@ BEGIN_TEST_FUNCTION(8);
 }
 END_TEST_FUNCTION();
 
+BEGIN_TEST_FUNCTION(9);
+{
+  StreamWriter writer(PathName("test3.ini"));
+  writer.Write("[sec1]\r\n");
+  writer.Write("  path = abc \r\n");
+  writer.Write("path;=def\r\n");
+  writer.Write("name=abra\r\n");
+  writer.Write("name+=kadabra\r\n");
+  writer.Write(";off=1\r\n");
+  writer.Write(";; first line\r\n");
+  writer.Write(";; second line\r\n");
+  writer.Write("title = abc\r\n");
+  writer.Write("\r\n");
+  writer.Write("[Sec2]\n");
+  writer.Write("arr[]=x\n");
+  writer.Write("arr[]=y");
+  writer.Close();
+  shared_ptr<Cfg> cfg;
+  TESTX(cfg = Cfg::Create());
+  TESTX(cfg->Read(PathName("test3.ini")));
+  TEST(cfg->GetSize() == 2);
+  TEST(cfg->GetValue("sec1", "path")->AsString() == string("abc") + PathNameUtil::PathNameDelimiter + "def");
+  TEST(cfg->GetKey("sec1")->GetValue("title")->GetDocumentation() == "first line\nsecond line");
+  TEST(cfg->GetValue("sec1", "name")->AsString() == "abrakadabra");
+  TEST(cfg->GetValue("sec1", "off") == nullptr);
+  TEST(cfg->GetKey("sec1")->GetValue("off")->IsCommentedOut());
+  vector<string> arr;
+  TEST(cfg->TryGetValueAsStringVector("sec2", "arr[]", arr));
+  TEST(arr.size() == 2 && arr[0] == "x" && arr[1] == "y");
+  shared_ptr<Cfg> cfg2;
+  TESTX(cfg2 = Cfg::Create());
+  ifstream reader("test3.ini", ios_base::in | ios_base::binary);
+  TESTX(cfg2->Read(reader));
+  TEST(cfg2->GetDigest() == cfg->GetDigest());
+  TESTX(cfg->Write(PathName("test4.ini")));
+  shared_ptr<Cfg> cfg3;
+  TESTX(cfg3 = Cfg::Create());
+  TESTX(cfg3->Read(PathName("test4.ini")));
+  TEST(cfg3->GetDigest() == cfg->GetDigest());
+}
+END_TEST_FUNCTION();
+
 BEGIN_TEST_PROGRAM();
 {
   CALL_TEST_FUNCTION(1);
@@ -185,6 +228,7 @@ BEGIN_TEST_PROGRAM();
   CALL_TEST_FUNCTION(6);
   CALL_TEST_FUNCTION(7);
   CALL_TEST_FUNCTION(8);
+  CALL_TEST_FUNCTION(9);
 }
 END_TEST_PROGRAM();
 
@@ -0,0 +1,134 @@
+/* 2.cpp:
+
+   Copyright (C) 2024 Christian Schenk
+
+   This file is part of the MiKTeX Core Library.
+
+   The MiKTeX Core Library is free software; you can redistribute it
+   and/or modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2, or
+   (at your option) any later version.
+
+   The MiKTeX Core Library is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with the MiKTeX Core Library; if not, write to the Free
+   Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+   02111-1307, USA. */
+
+#include "config.h"
+
+#include <miktex/Core/Test>
+
+#include <ctime>
+
+#include <fstream>
+#include <memory>
+#include <string>
+
+#include <miktex/Core/Directory>
+#include <miktex/Core/File>
+#include <miktex/Core/Paths>
+#include <miktex/Core/Session>
+#include <miktex/Core/TemporaryDirectory>
+#include <miktex/Util/PathName>
+
+using namespace MiKTeX::Core;
+using namespace MiKTeX::Test;
+using namespace MiKTeX::Util;
+using namespace std;
+
+BEGIN_TEST_SCRIPT("expansion-2");
+
+unique_ptr<TemporaryDirectory> tmpDir;
+
+PathName TreeDir()
+{
+  return tmpDir->GetPathName() / "tree";
+}
+
+PathName CachePath()
+{
+  return pSession->GetSpecialPath(SpecialPath::DataRoot) / MIKTEX_PATH_MIKTEX_CACHE_DIR / "dirtree.txt";
+}
+
+// searches the tree recursively
+bool FindInTree(const string& fileName)
+{
+  LocateOptions options;
+  options.searchFileSystem = true;
+  options.searchPath = TreeDir().ToString() + "//";
+  return !pSession->Locate(fileName, options).pathNames.empty();
+}
+
+BEGIN_TEST_FUNCTION(1);
+{
+  // listings of directories which have not changed recently are saved
+  tmpDir = TemporaryDirectory::Create();
+  TESTX(Directory::Create(TreeDir() / "a" / "x"));
+  TESTX(Directory::Create(TreeDir() / "b"));
+  TESTX(Touch(TreeDir() / "a" / "x" / "dirtree-test-1.tex"));
+  time_t past = time(nullptr) - 3600;
+  for (const PathName& dir : { TreeDir() / "a" / "x", TreeDir() / "a", TreeDir() / "b", TreeDir() })
+  {
+    TESTX(File::SetTimes(dir, past, past, past));
+  }
+  TEST(FindInTree("dirtree-test-1.tex"));
+  TESTX(pSession->Reset());
+  TEST(File::Exists(CachePath()));
+}
+END_TEST_FUNCTION();
+
+BEGIN_TEST_FUNCTION(2);
+{
+  // a directory with a different last write time is listed again
+  TESTX(Directory::Create(TreeDir() / "b" / "y"));
+  TESTX(Touch(TreeDir() / "b" / "y" / "dirtree-test-2.tex"));
+  time_t past = time(nullptr) - 1800;
+  TESTX(File::SetTimes(TreeDir() / "b", past, past, past));
+  TEST(FindInTree("dirtree-test-1.tex"));
+  TEST(FindInTree("dirtree-test-2.tex"));
+  TESTX(pSession->Reset());
+}
+END_TEST_FUNCTION();
+
+BEGIN_TEST_FUNCTION(3);
+{
+  // a torn file, which claims that b has no subdirectories, is ignored
+  PathName dirB = TreeDir() / "b";
+  {
+    ofstream stream = File::CreateOutputStream(CachePath());
+    stream << "miktex-dirtree 2\n";
+    stream << "D\t" << static_cast<long long>(File::GetLastWriteTime(dirB)) << "\t0\t" << dirB.ToString() << "\n";
+    stream.close();
+  }
+  TEST(FindInTree("dirtree-test-2.tex"));
+  TESTX(pSession->Reset());
+  // the session has saved a complete file
+  TEST(File::Exists(CachePath()));
+  TEST(FindInTree("dirtree-test-2.tex"));
+}
+END_TEST_FUNCTION();
+
+BEGIN_TEST_FUNCTION(4);
+{
+  TESTX(tmpDir->Delete());
+  tmpDir = nullptr;
+}
+END_TEST_FUNCTION();
+
+BEGIN_TEST_PROGRAM();
+{
+  CALL_TEST_FUNCTION(1);
+  CALL_TEST_FUNCTION(2);
+  CALL_TEST_FUNCTION(3);
+  CALL_TEST_FUNCTION(4);
+}
+END_TEST_PROGRAM();
+
+END_TEST_SCRIPT();
+
+RUN_TEST_SCRIPT();
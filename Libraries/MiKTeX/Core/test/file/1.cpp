@@ -23,6 +23,7 @@
 
 #include <miktex/Core/Test>
 
+#include <miktex/Core/DependencyLog>
 #include <miktex/Core/File>
 #include <miktex/Core/FileStream>
 
@@ -62,10 +63,40 @@ BEGIN_TEST_FUNCTION(2);
 }
 END_TEST_FUNCTION();
 
+BEGIN_TEST_FUNCTION(3);
+{
+  PathName input("dep-input.txt");
+  PathName output("dep-output.txt");
+  PathName log("dep.dep");
+  File::WriteBytes(input, { 'a', 'b', 'c' });
+  File::WriteBytes(output, { 'x' });
+  vector<DependencyLogRecord> records;
+  records.push_back(DependencyLog::MakeRecord(input, FileAccess::Read));
+  records.push_back(DependencyLog::MakeRecord(output, FileAccess::Write));
+  DependencyLog::Write(log, records);
+  vector<DependencyLogRecord> loaded = DependencyLog::Read(log);
+  TEST(loaded.size() == 2);
+  TEST(loaded[0].path == input);
+  TEST(loaded[0].access == FileAccess::Read);
+  TEST(loaded[0].size == 3);
+  TEST(loaded[0].md5 == records[0].md5);
+  TEST(loaded[1].lastWriteTime == records[1].lastWriteTime);
+  TEST(DependencyLog::GetChangedFiles(loaded, FileAccess::Read).empty());
+  File::WriteBytes(input, { 'a', 'b', 'c', 'd' });
+  TEST(DependencyLog::GetChangedFiles(loaded, FileAccess::Read).size() == 1);
+  TEST(DependencyLog::GetChangedFiles(loaded, FileAccess::Write).empty());
+  File::Delete(output);
+  TEST(DependencyLog::GetChangedFiles(loaded, FileAccess::Write).size() == 1);
+  File::Delete(input);
+  File::Delete(log);
+}
+END_TEST_FUNCTION();
+
 BEGIN_TEST_PROGRAM();
 {
   CALL_TEST_FUNCTION(1);
   CALL_TEST_FUNCTION(2);
+  CALL_TEST_FUNCTION(3);
 }
 END_TEST_PROGRAM();
 
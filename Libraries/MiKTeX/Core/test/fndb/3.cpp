@@ -0,0 +1,174 @@
+/* 3.cpp:
+
+   Copyright (C) 1996-2024 Christian Schenk
+
+   This file is part of the MiKTeX Core Library.
+
+   The MiKTeX Core Library is free software; you can redistribute it
+   and/or modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2, or
+   (at your option) any later version.
+
+   The MiKTeX Core Library is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with the MiKTeX Core Library; if not, write to the Free
+   Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+   02111-1307, USA. */
+
+#include "config.h"
+
+#include <miktex/Core/Test>
+
+#include <string>
+#include <vector>
+
+#include <miktex/Core/Directory>
+#include <miktex/Core/File>
+#include <miktex/Core/Fndb>
+#include <miktex/Util/PathName>
+
+using namespace MiKTeX::Configuration;
+using namespace MiKTeX::Core;
+using namespace MiKTeX::Test;
+using namespace MiKTeX::Util;
+using namespace std;
+
+BEGIN_TEST_SCRIPT("fndb-3");
+
+// pairs of names with the same FNV-1a hash value
+const vector<pair<string, string>> collisions = {
+  { "costarring", "liquid" },
+  { "declinate", "macallums" },
+};
+
+// "zinke" collides with "altarage" but does not exist
+const string collidingAbsentee = "zinke";
+
+const size_t numBigDirFiles = 5000;
+
+PathName HashTestDir()
+{
+  return pSession->GetSpecialPath(SpecialPath::InstallRoot) / "hashtest";
+}
+
+string BigDirFileName(size_t idx)
+{
+  return "f" + std::to_string(idx) + ".tex";
+}
+
+size_t SearchAll(const string& fileName, const string& pathPattern)
+{
+  vector<Fndb::Record> result;
+  if (!Fndb::Search(PathName(fileName), pathPattern, true, result))
+  {
+    return 0;
+  }
+  for (const Fndb::Record& rec : result)
+  {
+    if (rec.path.GetFileName() != PathName(fileName))
+    {
+      return 0;
+    }
+  }
+  return result.size();
+}
+
+BEGIN_TEST_FUNCTION(1);
+{
+  PathName installRoot = pSession->GetSpecialPath(SpecialPath::InstallRoot);
+  PathName collDir = HashTestDir() / "coll";
+  TESTX(Directory::Create(collDir));
+  for (const auto& p : collisions)
+  {
+    Touch(collDir / p.first);
+    Touch(collDir / p.second);
+  }
+  Touch(collDir / "altarage");
+  PathName bigDir = HashTestDir() / "big";
+  TESTX(Directory::Create(bigDir));
+  for (size_t idx = 0; idx < numBigDirFiles; ++idx)
+  {
+    Touch(bigDir / BigDirFileName(idx));
+  }
+  // the same file name in two directories
+  TESTX(Directory::Create(HashTestDir() / "twice" / "a"));
+  TESTX(Directory::Create(HashTestDir() / "twice" / "b"));
+  Touch(HashTestDir() / "twice" / "a" / "twice.tex");
+  Touch(HashTestDir() / "twice" / "b" / "twice.tex");
+  unsigned installRootIdx = pSession->DeriveTEXMFRoot(installRoot);
+  PathName fndbInstall = pSession->GetFilenameDatabasePathName(installRootIdx);
+  TEST(Fndb::Create(fndbInstall, installRoot, nullptr));
+  TESTX(pSession->UnloadFilenameDatabase());
+}
+END_TEST_FUNCTION();
+
+BEGIN_TEST_FUNCTION(2);
+{
+  string collDir = (HashTestDir() / "coll").ToString();
+  for (const auto& p : collisions)
+  {
+    TEST(SearchAll(p.first, collDir) == 1);
+    TEST(SearchAll(p.second, collDir) == 1);
+  }
+  TEST(SearchAll("altarage", collDir) == 1);
+  TEST(SearchAll(collidingAbsentee, collDir) == 0);
+  TEST(SearchAll("twice.tex", (HashTestDir() / "twice").ToString() + "//") == 2);
+}
+END_TEST_FUNCTION();
+
+BEGIN_TEST_FUNCTION(3);
+{
+  // most probes for absent names end in an empty bucket
+  string bigDir = (HashTestDir() / "big").ToString();
+  for (size_t idx = numBigDirFiles; idx < 2 * numBigDirFiles; ++idx)
+  {
+    TEST(SearchAll(BigDirFileName(idx), bigDir) == 0);
+  }
+  TEST(SearchAll("nonexistent.tex", HashTestDir().ToString() + "//") == 0);
+}
+END_TEST_FUNCTION();
+
+BEGIN_TEST_FUNCTION(4);
+{
+  string bigDir = (HashTestDir() / "big").ToString();
+  for (size_t idx = 0; idx < numBigDirFiles; ++idx)
+  {
+    TEST(SearchAll(BigDirFileName(idx), bigDir) == 1);
+  }
+}
+END_TEST_FUNCTION();
+
+BEGIN_TEST_FUNCTION(5);
+{
+  // records from the change file overlay the mapped hash table
+  PathName collDir = HashTestDir() / "coll";
+  TESTX(Fndb::Add({ { collDir / collidingAbsentee } }));
+  TEST(SearchAll(collidingAbsentee, collDir.ToString()) == 1);
+  TEST(SearchAll("altarage", collDir.ToString()) == 1);
+  TESTX(Fndb::Remove({ collDir / "costarring" }));
+  TEST(SearchAll("costarring", collDir.ToString()) == 0);
+  TEST(SearchAll("liquid", collDir.ToString()) == 1);
+  TESTX(pSession->UnloadFilenameDatabase());
+  TEST(SearchAll(collidingAbsentee, collDir.ToString()) == 1);
+  TEST(SearchAll("costarring", collDir.ToString()) == 0);
+  TEST(SearchAll("liquid", collDir.ToString()) == 1);
+}
+END_TEST_FUNCTION();
+
+BEGIN_TEST_PROGRAM();
+{
+  CALL_TEST_FUNCTION(1);
+  CALL_TEST_FUNCTION(2);
+  CALL_TEST_FUNCTION(3);
+  CALL_TEST_FUNCTION(4);
+  CALL_TEST_FUNCTION(5);
+}
+END_TEST_PROGRAM();
+
+END_TEST_SCRIPT();
+
+RUN_TEST_SCRIPT();
@@ -0,0 +1,116 @@
+/* 4.cpp:
+
+   Copyright (C) 1996-2024 Christian Schenk
+
+   This file is part of the MiKTeX Core Library.
+
+   The MiKTeX Core Library is free software; you can redistribute it
+   and/or modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2, or
+   (at your option) any later version.
+
+   The MiKTeX Core Library is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with the MiKTeX Core Library; if not, write to the Free
+   Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+   02111-1307, USA. */
+
+#include "config.h"
+
+#include <miktex/Core/Test>
+
+#include <string>
+#include <vector>
+
+#include <miktex/Core/Directory>
+#include <miktex/Core/File>
+#include <miktex/Core/Fndb>
+#include <miktex/Core/TemporaryDirectory>
+#include <miktex/Util/PathName>
+
+using namespace MiKTeX::Configuration;
+using namespace MiKTeX::Core;
+using namespace MiKTeX::Test;
+using namespace MiKTeX::Util;
+using namespace std;
+
+BEGIN_TEST_SCRIPT("fndb-4");
+
+unique_ptr<TemporaryDirectory> tmpDir;
+
+PathName ParallelTestDir()
+{
+  return pSession->GetSpecialPath(SpecialPath::InstallRoot) / "partest";
+}
+
+void CreateTree(const PathName& dir, unsigned depth)
+{
+  Directory::Create(dir);
+  for (unsigned i = 0; i < 10; ++i)
+  {
+    Touch(dir / ("file" + std::to_string(i) + ".tex"));
+  }
+  // the same file name on every level
+  Touch(dir / "same.sty");
+  if (depth > 0)
+  {
+    for (unsigned i = 0; i < 6; ++i)
+    {
+      CreateTree(dir / ("dir" + std::to_string(i)), depth - 1);
+    }
+  }
+}
+
+vector<unsigned char> CreateFndb(unsigned numThreads)
+{
+  PathName installRoot = pSession->GetSpecialPath(SpecialPath::InstallRoot);
+  PathName fndbPath = tmpDir->GetPathName() / ("threads-" + std::to_string(numThreads) + ".fndb");
+  if (!Fndb::Create(fndbPath, installRoot, nullptr, true, false, numThreads))
+  {
+    return {};
+  }
+  return File::ReadAllBytes(fndbPath);
+}
+
+BEGIN_TEST_FUNCTION(1);
+{
+  tmpDir = TemporaryDirectory::Create();
+  TESTX(CreateTree(ParallelTestDir(), 3));
+}
+END_TEST_FUNCTION();
+
+BEGIN_TEST_FUNCTION(2);
+{
+  // the parallel scan must produce the same file as the serial one
+  vector<unsigned char> serial = CreateFndb(1);
+  TEST(!serial.empty());
+  for (unsigned numThreads : { 0, 2, 3, 8 })
+  {
+    TEST(CreateFndb(numThreads) == serial);
+  }
+}
+END_TEST_FUNCTION();
+
+BEGIN_TEST_FUNCTION(3);
+{
+  TESTX(Directory::Delete(ParallelTestDir(), true));
+  TESTX(tmpDir->Delete());
+  tmpDir = nullptr;
+}
+END_TEST_FUNCTION();
+
+BEGIN_TEST_PROGRAM();
+{
+  CALL_TEST_FUNCTION(1);
+  CALL_TEST_FUNCTION(2);
+  CALL_TEST_FUNCTION(3);
+}
+END_TEST_PROGRAM();
+
+END_TEST_SCRIPT();
+
+RUN_TEST_SCRIPT();
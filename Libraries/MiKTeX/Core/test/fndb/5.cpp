@@ -0,0 +1,133 @@
+/* 5.cpp: FindFiles() vs. Locate()
+
+   Copyright (C) 2024 Christian Schenk
+
+   This file is part of the MiKTeX Core Library.
+
+   The MiKTeX Core Library is free software; you can redistribute it
+   and/or modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2, or
+   (at your option) any later version.
+
+   The MiKTeX Core Library is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with the MiKTeX Core Library; if not, write to the Free
+   Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+   02111-1307, USA. */
+
+#include "config.h"
+
+#include <miktex/Core/Test>
+
+#include <string>
+#include <vector>
+
+#include <miktex/Core/Directory>
+#include <miktex/Core/File>
+#include <miktex/Core/Fndb>
+#include <miktex/Core/Paths>
+#include <miktex/Util/PathName>
+#include <miktex/Util/StringUtil>
+
+using namespace MiKTeX::Configuration;
+using namespace MiKTeX::Core;
+using namespace MiKTeX::Test;
+using namespace MiKTeX::Util;
+using namespace std;
+
+BEGIN_TEST_SCRIPT("fndb-5");
+
+LocateOptions Options(FileType fileType, bool all = false, const string& searchPath = "", bool searchFileSystem = false)
+{
+  LocateOptions options;
+  options.fileType = fileType;
+  options.all = all;
+  options.searchPath = searchPath;
+  options.searchFileSystem = searchFileSystem;
+  return options;
+}
+
+// a mix of hits and misses, with and without file name extension
+vector<FindRequest> MakeRequests()
+{
+  string twoTrees = StringUtil::Flatten({ "%R/ab//", "%R/jk//" }, PathNameUtil::PathNameDelimiter);
+  return {
+    { "test.tex", Options(FileType::TEX) },
+    { "test", Options(FileType::TEX) },
+    { "test.cls", Options(FileType::TEX) },
+    { "test.tex", Options(FileType::TEX, true) },
+    { "nonexistent.tex", Options(FileType::TEX) },
+    { "nonexistent", Options(FileType::TEX) },
+    { "nonexistent.tex", Options(FileType::TEX, false, "", true) },
+    { "test.tex", Options(FileType::None, false, "%R/tex//") },
+    { "base/test.tex", Options(FileType::None, false, "%R/tex//") },
+    { "nonexistent.tex", Options(FileType::None, false, "%R/tex//") },
+    { "xyz.txt", Options(FileType::None, false, twoTrees) },
+    { "xyz.txt", Options(FileType::None, true, twoTrees) },
+    { "xyz.txt", Options(FileType::None, true, twoTrees, true) },
+    { "test.tex", Options(FileType::TEX) },
+    { "nonexistent.tex", Options(FileType::TEX) },
+  };
+}
+
+bool SameResults(const vector<FindRequest>& requests, const vector<LocateResult>& results)
+{
+  if (results.size() != requests.size())
+  {
+    return false;
+  }
+  for (size_t idx = 0; idx < requests.size(); ++idx)
+  {
+    if (results[idx].pathNames != pSession->Locate(requests[idx].fileName, requests[idx].options).pathNames)
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+BEGIN_TEST_FUNCTION(1);
+{
+  PathName localRoot = pSession->GetSpecialPath(SpecialPath::DataRoot);
+  PathName installRoot = pSession->GetSpecialPath(SpecialPath::InstallRoot);
+  TESTX(Directory::Create(localRoot / MIKTEX_PATH_MIKTEX_CONFIG_DIR));
+  TEST(Fndb::Create(pSession->GetFilenameDatabasePathName(pSession->DeriveTEXMFRoot(localRoot)), localRoot, nullptr));
+  TEST(Fndb::Create(pSession->GetFilenameDatabasePathName(pSession->DeriveTEXMFRoot(installRoot)), installRoot, nullptr));
+}
+END_TEST_FUNCTION();
+
+BEGIN_TEST_FUNCTION(2);
+{
+  vector<FindRequest> requests = MakeRequests();
+  vector<LocateResult> results = pSession->FindFiles(requests);
+  TEST(SameResults(requests, results));
+  TEST(!results[0].pathNames.empty());
+  TEST(results[4].pathNames.empty());
+  TEST(results[11].pathNames.size() == 2);
+}
+END_TEST_FUNCTION();
+
+BEGIN_TEST_FUNCTION(3);
+{
+  // the misses are in the negative file cache now
+  vector<FindRequest> requests = MakeRequests();
+  TEST(SameResults(requests, pSession->FindFiles(requests)));
+  TEST(SameResults(requests, pSession->FindFiles(requests)));
+}
+END_TEST_FUNCTION();
+
+BEGIN_TEST_PROGRAM();
+{
+  CALL_TEST_FUNCTION(1);
+  CALL_TEST_FUNCTION(2);
+  CALL_TEST_FUNCTION(3);
+}
+END_TEST_PROGRAM();
+
+END_TEST_SCRIPT();
+
+RUN_TEST_SCRIPT();
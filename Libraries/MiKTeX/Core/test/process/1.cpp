@@ -23,6 +23,8 @@
 
 #include <miktex/Core/Test>
 
+#include <chrono>
+
 #include <miktex/Core/CommandLineBuilder>
 #include <miktex/Core/File>
 #include <miktex/Util/PathName>
@@ -138,6 +140,25 @@ BEGIN_TEST_FUNCTION(5);
 }
 END_TEST_FUNCTION();
 
+BEGIN_TEST_FUNCTION(6);
+{
+  PathName pathExe = pSession->GetMyLocation(false);
+  pathExe /= "core_process_test1-2" MIKTEX_EXE_FILE_SUFFIX;
+  const int rounds = 50;
+  chrono::high_resolution_clock::time_point start = chrono::high_resolution_clock::now();
+  for (int i = 0; i < rounds; ++i)
+  {
+    int exitCode;
+    ProcessOutput<1024> processOutput;
+    TEST(Process::Run(pathExe, { pathExe.ToString(), std::to_string(i) }, &processOutput, &exitCode, nullptr));
+    TEST(exitCode == 0);
+    TEST(processOutput.StdoutToString() == std::to_string(i) + "\n");
+  }
+  chrono::microseconds elapsed = chrono::duration_cast<chrono::microseconds>(chrono::high_resolution_clock::now() - start);
+  LOG4CXX_INFO(logger, "average process start/exit latency: " << elapsed.count() / rounds << " us");
+}
+END_TEST_FUNCTION();
+
 BEGIN_TEST_PROGRAM();
 {
   CALL_TEST_FUNCTION(1);
@@ -145,6 +166,7 @@ BEGIN_TEST_PROGRAM();
   CALL_TEST_FUNCTION(3);
   CALL_TEST_FUNCTION(4);
   CALL_TEST_FUNCTION(5);
+  CALL_TEST_FUNCTION(6);
 }
 END_TEST_PROGRAM();
 
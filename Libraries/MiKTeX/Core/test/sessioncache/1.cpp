@@ -0,0 +1,172 @@
+/* 1.cpp:
+
+   Copyright (C) 2024 Christian Schenk
+
+   This file is part of the MiKTeX Core Library.
+
+   The MiKTeX Core Library is free software; you can redistribute it
+   and/or modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2, or
+   (at your option) any later version.
+
+   The MiKTeX Core Library is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with the MiKTeX Core Library; if not, write to the Free
+   Software Foundation, 59 Temple Place - Suite 330, Boston, MA
+   02111-1307, USA. */
+
+#include "config.h"
+
+#include <miktex/Core/Test>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <thread>
+
+#include <miktex/Core/Directory>
+#include <miktex/Core/File>
+#include <miktex/Core/Process>
+#include <miktex/Core/SessionCache>
+#include <miktex/Core/TemporaryDirectory>
+#include <miktex/Util/PathName>
+
+using namespace std;
+
+using namespace MiKTeX::Core;
+using namespace MiKTeX::Test;
+using namespace MiKTeX::Util;
+
+BEGIN_TEST_SCRIPT("sessioncache-1");
+
+unique_ptr<TemporaryDirectory> tmpDir;
+
+unique_ptr<Process> serverProcess;
+
+PathName socketPath;
+
+PathName InputDir()
+{
+  return tmpDir->GetPathName() / "input";
+}
+
+PathName StopFile()
+{
+  return tmpDir->GetPathName() / "stop";
+}
+
+// the test file exists in the input directory only
+bool IsTestFile(const PathName& path)
+{
+  return path.GetFileName() == PathName("sessioncache-test.tex") && File::Exists(path) && !File::Exists(PathName("sessioncache-test.tex"));
+}
+
+// sends one request line to the server and returns the response
+string Exchange(const string& request, int numLines)
+{
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0)
+  {
+    return "";
+  }
+  struct sockaddr_un addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  strcpy(addr.sun_path, socketPath.GetData());
+  string response;
+  if (connect(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) == 0 && send(fd, request.c_str(), request.length(), 0) == static_cast<ssize_t>(request.length()))
+  {
+    char ch;
+    while (numLines > 0 && recv(fd, &ch, 1, 0) == 1)
+    {
+      response += ch;
+      if (ch == '\n')
+      {
+        --numLines;
+      }
+    }
+  }
+  close(fd);
+  return response;
+}
+
+BEGIN_TEST_FUNCTION(1);
+{
+  tmpDir = TemporaryDirectory::Create();
+  TESTX(Directory::Create(InputDir()));
+  TESTX(Touch(InputDir() / "sessioncache-test.tex"));
+  socketPath = SessionCacheServer::Create()->GetSocketPath();
+  PathName serverExe = pSession->GetMyLocation(false) / "core_sessioncache_test1-1" MIKTEX_EXE_FILE_SUFFIX;
+  ProcessStartInfo startInfo(serverExe);
+  startInfo.Arguments = { serverExe.ToString(), StopFile().ToString() };
+  serverProcess = Process::Start(startInfo);
+  for (int n = 0; n < 100 && !File::Exists(socketPath); ++n)
+  {
+    this_thread::sleep_for(chrono::milliseconds(100));
+  }
+  TEST(File::Exists(socketPath));
+  // the client gave up on the server during startup
+  TESTX(pSession->Reset());
+}
+END_TEST_FUNCTION();
+
+BEGIN_TEST_FUNCTION(2);
+{
+  // malformed requests
+  TEST(Exchange("X\n", 1) == "E\n");
+  TEST(Exchange("L\tapp\t/\t0\t1\t-\t\tsessioncache-test.tex\n", 1) == "E\n");
+  TEST(Exchange("L\tapp\t/\t2\t/\t1\t-\t\tsessioncache-test.tex\n", 1) == "E\n");
+  // the input directory is sent as the second working directory
+  PathName cwd;
+  cwd.SetToCurrentDirectory();
+  string request = "L\tapp\t" + cwd.ToString() + "\t2\t" + cwd.ToString() + "\t" + InputDir().ToString() + "\t" + std::to_string(static_cast<int>(FileType::TEX)) + "\t-\t\tsessioncache-test.tex\n";
+  string response = Exchange(request, 2);
+  TEST(response.compare(0, 2, "1\n") == 0 && IsTestFile(PathName(response.substr(2, response.length() - 3))));
+}
+END_TEST_FUNCTION();
+
+BEGIN_TEST_FUNCTION(3);
+{
+  // lookups of this process are served with its own input directories
+  TESTX(pSession->AddInputDirectory(InputDir(), true));
+  LocateOptions options;
+  options.fileType = FileType::TEX;
+  LocateResult result = pSession->Locate("sessioncache-test.tex", options);
+  TEST(result.pathNames.size() == 1 && IsTestFile(result.pathNames[0]));
+  result = pSession->Locate("./sessioncache-test.tex", options);
+  TEST(result.pathNames.size() == 1 && IsTestFile(result.pathNames[0]));
+  TEST(pSession->Locate("sessioncache-missing.tex", options).pathNames.empty());
+}
+END_TEST_FUNCTION();
+
+BEGIN_TEST_FUNCTION(4);
+{
+  TESTX(Touch(StopFile()));
+  TEST(serverProcess->WaitForExit(30000));
+  TEST(serverProcess->get_ExitCode() == 0);
+  serverProcess = nullptr;
+  TESTX(tmpDir->Delete());
+  tmpDir = nullptr;
+}
+END_TEST_FUNCTION();
+
+BEGIN_TEST_PROGRAM();
+{
+  CALL_TEST_FUNCTION(1);
+  CALL_TEST_FUNCTION(2);
+  CALL_TEST_FUNCTION(3);
+  CALL_TEST_FUNCTION(4);
+}
+END_TEST_PROGRAM();
+
+END_TEST_SCRIPT();
+
+RUN_TEST_SCRIPT();
@@ -23,6 +23,8 @@
 
 #include "config.h"
 
+#include <climits>
+
 #include <fmt/format.h>
 #include <fmt/ostream.h>
 
@@ -69,6 +71,9 @@ int DviImpl::RulePixels(int x)
   }
 }
 
+// number of pages which are loaded ahead of the current page
+const int pagesAhead = 10;
+
 DviImpl::DviImpl(const char* fileName, const char* metafontMode, int resolution, int shrinkFactor, DviAccess dviAccess, DviPageMode pageMode, const PaperSizeInfo & paperSizeInfo, bool landscape, IDviCallback* dviCallback, TraceCallback* traceCallback) :
   currentColor(rgbDefaultColor),
   dviAccess(dviAccess),
@@ -96,25 +101,24 @@ DviImpl::DviImpl(const char* fileName, const char* metafontMode, int resolution,
 
   dviInfo.lastWriteTime = 0;
   fontMap = new FontMap;
-  hByeByeEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
-  if (hByeByeEvent == nullptr)
-  {
-    MIKTEX_FATAL_WINDOWS_ERROR("CreateEventW");
-  }
-  hNewPageEvent = CreateEventW(nullptr, FALSE, FALSE, nullptr);
-  if (hNewPageEvent == nullptr)
-  {
-    MIKTEX_FATAL_WINDOWS_ERROR("CreateEventW");
-  }
-  hScannedEvent = CreateEventW(nullptr, FALSE, FALSE, nullptr);
-  if (hScannedEvent == nullptr)
-  {
-    MIKTEX_FATAL_WINDOWS_ERROR("CreateEventW");
-  }
   if (dviAccess == DviAccess::Random)
   {
     garbageCollectorThread = thread(&DviImpl::GarbageCollector, this);
-    pageLoaderThread = thread(&DviImpl::PageLoader, this);
+    // pages ahead of the current page are loaded concurrently
+    unsigned numPageLoaders = thread::hardware_concurrency();
+    if (numPageLoaders == 0)
+    {
+      numPageLoaders = 1;
+    }
+    else if (numPageLoaders > pagesAhead)
+    {
+      numPageLoaders = pagesAhead;
+    }
+    pageLoaderThreads.reserve(numPageLoaders);
+    for (unsigned idx = 0; idx < numPageLoaders; ++idx)
+    {
+      pageLoaderThreads.push_back(thread(&DviImpl::PageLoader, this));
+    }
   }
 }
 
@@ -131,20 +135,21 @@ DviImpl::~DviImpl()
 
 void DviImpl::Dispose()
 {
-  if (hByeByeEvent != nullptr)
   {
-    if (!SetEvent(hByeByeEvent))
-    {
-      MIKTEX_FATAL_WINDOWS_ERROR("SetEvent");
-    }
+    lock_guard<mutex> lockGuard(eventMutex);
+    byeBye = true;
   }
+  eventCondition.notify_all();
   if (garbageCollectorThread.joinable())
   {
     garbageCollectorThread.join();
   }
-  if (pageLoaderThread.joinable())
+  for (thread& pageLoaderThread : pageLoaderThreads)
   {
-    pageLoaderThread.join();
+    if (pageLoaderThread.joinable())
+    {
+      pageLoaderThread.join();
+    }
   }
   BEGIN_CRITICAL_SECTION(dviMutex)
   {
@@ -154,21 +159,6 @@ void DviImpl::Dispose()
       delete fontMap;
       fontMap = nullptr;
     }
-    if (hByeByeEvent != nullptr)
-    {
-      CloseHandle(hByeByeEvent);
-      hByeByeEvent = nullptr;
-    }
-    if (hNewPageEvent != nullptr)
-    {
-      CloseHandle(hNewPageEvent);
-      hNewPageEvent = nullptr;
-    }
-    if (hScannedEvent != nullptr)
-    {
-      CloseHandle(hScannedEvent);
-      hScannedEvent = nullptr;
-    }
   }
   END_CRITICAL_SECTION();
   if (trace_dvifile != nullptr)
@@ -520,8 +510,12 @@ void DviImpl::Scan()
   }
 #endif
 
-  // wake up page loader thread
-  SetEvent(hScannedEvent);
+  // wake up page loader threads
+  {
+    lock_guard<mutex> lockGuard(eventMutex);
+    scanned = true;
+  }
+  eventCondition.notify_all();
 
   hasDviFileChanged = false;
 }
@@ -613,10 +607,12 @@ PageStatus DviImpl::GetPageStatus(int pageIdx)
 
     lastChecked = now;
 
+#if defined(MIKTEX_WINDOWS)
     if (session->IsFileAlreadyOpen(dviFileName))
     {
       return PageStatus::Loaded;
     }
+#endif
 
     if (!File::Exists(dviFileName))
     {
@@ -655,7 +651,7 @@ void DviImpl::DoPage(int pageIdx)
 
   Progress(DviNotification::BeginLoadPage, fmt::format(T_("loading page #{0}..."), pageIdx));
 
-  bool background = pageLoaderThread.joinable() && this_thread::get_id() == pageLoaderThread.get_id();
+  bool background = IsBackgroundThread();
 
   if (background)
   {
@@ -668,11 +664,13 @@ void DviImpl::DoPage(int pageIdx)
 
   try
   {
+#if defined(MIKTEX_WINDOWS)
     if (session->IsFileAlreadyOpen(dviFileName))
     {
       trace_error->WriteLine("libdvi", T_("the DVI file is used by another process"));
       throw DviFileInUseException("", T_("The DVI file is used by another process."), MiKTeXException::KVMAP(), MIKTEX_SOURCE_LOCATION());
     }
+#endif
 
     InputStream inputStream(dviFileName.GetData());
 
@@ -697,14 +695,7 @@ void DviImpl::DoPage(int pageIdx)
 
 bool DviImpl::DoNextCommand(InputStream & inputStream, DviPageImpl & page)
 {
-  MIKTEX_ASSERT(hByeByeEvent != nullptr);
-
-  DWORD wait = WaitForSingleObject(hByeByeEvent, 0);
-  if (wait == WAIT_FAILED)
-  {
-    MIKTEX_FATAL_WINDOWS_ERROR("WaitForSingleObject");
-  }
-  if (wait == WAIT_OBJECT_0)
+  if (byeBye)
   {
     throw OperationCancelledException();
   }
@@ -772,7 +763,7 @@ bool DviImpl::DoNextCommand(InputStream & inputStream, DviPageImpl & page)
       currentState.z = 0;
 
       unsigned long pl;
-      const BYTE* p = pVfChar->GetPacket(pl);
+      const unsigned char* p = pVfChar->GetPacket(pl);
 
       InputStream inputStream(p, pl);
 
@@ -1168,6 +1159,12 @@ Dvi* Dvi::Create(const char* fileName, const char* metafontMode, int resolution,
 
 Dvi* Dvi::Create(const char* fileName, const char* metafontMode, int resolution, int shrinkFactor, DviAccess dviAccess, DviPageMode pageMode, const PaperSizeInfo & paperSizeInfo, bool landscape, IDviCallback* dviCallback, TraceCallback* traceCallback)
 {
+#if !defined(MIKTEX_WINDOWS)
+  if (pageMode == DviPageMode::Dvips)
+  {
+    MIKTEX_FATAL_ERROR(T_("The Dvips page mode is not supported on this platform."));
+  }
+#endif
   DviImpl* dviImpl = new DviImpl(fileName, metafontMode, resolution, shrinkFactor, dviAccess, pageMode, paperSizeInfo, landscape, dviCallback, traceCallback);
   return dviImpl;
 }
@@ -1244,9 +1241,7 @@ DviPage* DviImpl::GetPage(int pageIdx)
     dviPage->Lock();
     try
     {
-      if ((!pageLoaderThread.joinable() || this_thread::get_id() != pageLoaderThread.get_id())
-        && (!garbageCollectorThread.joinable() || this_thread::get_id() != garbageCollectorThread.get_id())
-        && currentPageIdx != pageIdx)
+      if (!IsBackgroundThread() && currentPageIdx != pageIdx)
       {
         trace_dvifile->WriteLine("libdvi", fmt::format(T_("getting page #{0}"), pageIdx));
         if (pageIdx < currentPageIdx)
@@ -1258,10 +1253,11 @@ DviPage* DviImpl::GetPage(int pageIdx)
           direction = 1;
         }
         currentPageIdx = pageIdx;
-        if (!SetEvent(hNewPageEvent))
         {
-          MIKTEX_FATAL_WINDOWS_ERROR("SetEvent");
+          lock_guard<mutex> lockGuard(eventMutex);
+          newPage = true;
         }
+        eventCondition.notify_all();
       }
       return dviPage;
     }
@@ -1333,8 +1329,7 @@ DviPage* DviImpl::GetLoadedPage(int pageIdx)
       return dviPage;
     }
     default:
-      MIKTEX_ASSERT(false);
-      __assume (false);
+      MIKTEX_UNEXPECTED();
     }
   }
   END_CRITICAL_SECTION();
@@ -1342,8 +1337,7 @@ DviPage* DviImpl::GetLoadedPage(int pageIdx)
 
 void DviImpl::Progress(DviNotification nf, const string& msg)
 {
-  if ((pageLoaderThread.joinable() && this_thread::get_id() == pageLoaderThread.get_id())
-    || (garbageCollectorThread.joinable() && this_thread::get_id() == garbageCollectorThread.get_id()))
+  if (IsBackgroundThread())
   {
     return;
   }
@@ -1377,90 +1371,107 @@ const unsigned long limitNormalPrio = 20 * 1024 * 1024;
 const unsigned long limitAboveNormalPrio = 50 * 1024 * 1024;
 const unsigned long limitHighestPrio = 100 * 1024 * 1024;
 
-void DviImpl::PageLoader()
+bool DviImpl::IsBackgroundThread()
 {
-  try
+  thread::id id = this_thread::get_id();
+  if (garbageCollectorThread.joinable() && id == garbageCollectorThread.get_id())
+  {
+    return true;
+  }
+  for (const thread& pageLoaderThread : pageLoaderThreads)
   {
-#if 1
-    if (SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_LOWEST) == 0)
+    if (pageLoaderThread.joinable() && id == pageLoaderThread.get_id())
     {
-      MIKTEX_FATAL_WINDOWS_ERROR("SetThreadPriority");
+      return true;
     }
-#endif
-
-    MIKTEX_ASSERT(hByeByeEvent != nullptr);
-    MIKTEX_ASSERT(hNewPageEvent != nullptr);
-    MIKTEX_ASSERT(hScannedEvent != nullptr);
-
-    HANDLE handles[2];
+  }
+  return false;
+}
 
-    handles[0] = hByeByeEvent;
-    handles[1] = hScannedEvent;
+bool DviImpl::WaitForByeBye(unsigned long milliseconds)
+{
+  unique_lock<mutex> lock(eventMutex);
+  return eventCondition.wait_for(lock, chrono::milliseconds(milliseconds), [this]() { return byeBye.load(); });
+}
 
-    unsigned long wait = WaitForMultipleObjects(2, handles, FALSE, INFINITE);
+// values as used by Windows
+enum class ThreadPriority
+{
+  Lowest = -2,
+  BelowNormal = -1,
+  Normal = 0,
+  AboveNormal = 1,
+  Highest = 2
+};
+
+STATICFUNC(void) SetCurrentThreadPriority(ThreadPriority priority)
+{
+#if defined(MIKTEX_WINDOWS)
+  if (!SetThreadPriority(GetCurrentThread(), static_cast<int>(priority)))
+  {
+    MIKTEX_FATAL_WINDOWS_ERROR("SetThreadPriority");
+  }
+#endif
+}
 
-    if (wait == WAIT_FAILED)
-    {
-      MIKTEX_FATAL_WINDOWS_ERROR("WaitForMultipleObjects");
-    }
+void DviImpl::PageLoader()
+{
+  try
+  {
+    SetCurrentThreadPriority(ThreadPriority::Lowest);
 
-    if (wait == WAIT_OBJECT_0)
     {
-      return;
+      unique_lock<mutex> lock(eventMutex);
+      eventCondition.wait(lock, [this]() { return byeBye || scanned; });
     }
 
-    for (int pageIdx = currentPageIdx + 1; (wait = WaitForSingleObject(hByeByeEvent, sleepDurationBelowNormalPrio)) != WAIT_OBJECT_0; pageIdx += direction)
+    while (!byeBye)
     {
-      if (wait == WAIT_FAILED)
-      {
-        MIKTEX_FATAL_WINDOWS_ERROR("WaitForSingleObject");
-      }
       DviPage* dviPage = nullptr;
       AutoUnlockPage autoUnlockPage(nullptr);
       BEGIN_CRITICAL_SECTION(dviMutex)
       {
-        wait = WaitForSingleObject(hNewPageEvent, 0);
-        if (wait == WAIT_FAILED)
-        {
-          MIKTEX_FATAL_WINDOWS_ERROR("WaitForSingleObject");
-        }
-        if (wait == WAIT_OBJECT_0)
         {
-          pageIdx = currentPageIdx;
-        }
-        if (pageIdx < 0 || pageIdx >= GetNumberOfPages())
-        {
-          pageIdx = currentPageIdx;
-          continue;
+          lock_guard<mutex> lockGuard(eventMutex);
+          if (newPage)
+          {
+            newPage = false;
+            nextPageIdx = currentPageIdx;
+          }
         }
+        int pageIdx = nextPageIdx;
+        bool inWindow;
         if (direction > 0)
         {
-          if (!(pageIdx >= currentPageIdx && pageIdx < currentPageIdx + 10))
-          {
-            continue;
-          }
+          inWindow = pageIdx >= currentPageIdx && pageIdx < currentPageIdx + pagesAhead;
         }
         else
         {
           MIKTEX_ASSERT(direction < 0);
-          if (!(pageIdx <= currentPageIdx && pageIdx > currentPageIdx - 10))
-          {
-            continue;
-          }
+          inWindow = pageIdx <= currentPageIdx && pageIdx > currentPageIdx - pagesAhead;
         }
-        DviPageImpl* pPageImpl = pages[pageIdx];
-        if (pPageImpl->IsLocked())
+        if (inWindow && pageIdx >= 0 && pageIdx < GetNumberOfPages())
         {
-          continue;
+          // claim the page; the other page loaders go on with the next one
+          nextPageIdx += direction;
+          if (!pages[pageIdx]->IsLocked())
+          {
+            dviPage = GetLoadedPage(pageIdx);
+            autoUnlockPage.Attach(dviPage);
+          }
         }
-        dviPage = GetLoadedPage(pageIdx);
-        autoUnlockPage.Attach(dviPage);
       }
       END_CRITICAL_SECTION();
       if (dviPage != nullptr)
       {
+        // make the bitmaps while other page loaders interpret the next pages
         dviPage->GetNumberOfDviBitmaps(defaultShrinkFactor);
       }
+      else
+      {
+        unique_lock<mutex> lock(eventMutex);
+        eventCondition.wait_for(lock, chrono::milliseconds(sleepDurationBelowNormalPrio), [this]() { return byeBye || newPage; });
+      }
     }
   }
 
@@ -1487,31 +1498,19 @@ void DviImpl::GarbageCollector()
 {
   try
   {
-    int priority = THREAD_PRIORITY_LOWEST;
+    ThreadPriority priority = ThreadPriority::Lowest;
     unsigned long sleepDuration = sleepDurationLowestPrio;
     time_t timeKeepBitmaps = timeKeepBitmapsLowestPrio;
-    if (!SetThreadPriority(GetCurrentThread(), priority))
-    {
-      MIKTEX_FATAL_WINDOWS_ERROR("SetThreadPriority");
-    }
-    DWORD wait;
-    while ((wait = WaitForSingleObject(hByeByeEvent, sleepDuration)) != WAIT_OBJECT_0)
+    SetCurrentThreadPriority(priority);
+    while (!WaitForByeBye(sleepDuration))
     {
-      if (wait == WAIT_FAILED)
-      {
-        MIKTEX_FATAL_WINDOWS_ERROR("WaitForSingleObject");
-      }
       size_t sizeBiggest = 0;
       int biggestPageIdx = -1;
       DviPageImpl* dviPage;
       size_t totalSize = 0;
       time_t now = time(nullptr);
-      for (int pageIdx = 0; (wait = WaitForSingleObject(hByeByeEvent, 0)) != WAIT_OBJECT_0; ++pageIdx)
+      for (int pageIdx = 0; !byeBye; ++pageIdx)
       {
-        if (wait == WAIT_FAILED)
-        {
-          MIKTEX_FATAL_WINDOWS_ERROR("WaitForSingleObject");
-        }
         BEGIN_CRITICAL_SECTION(dviMutex)
         {
           if (pageIdx >= GetNumberOfPages())
@@ -1520,7 +1519,7 @@ void DviImpl::GarbageCollector()
           }
           if (direction > 0)
           {
-            if (pageIdx >= currentPageIdx && pageIdx < currentPageIdx + 10)
+            if (pageIdx >= currentPageIdx && pageIdx < currentPageIdx + pagesAhead)
             {
               continue;
             }
@@ -1528,7 +1527,7 @@ void DviImpl::GarbageCollector()
           else
           {
             MIKTEX_ASSERT(direction < 0);
-            if (pageIdx <= currentPageIdx && pageIdx > currentPageIdx - 10)
+            if (pageIdx <= currentPageIdx && pageIdx > currentPageIdx - pagesAhead)
             {
               continue;
             }
@@ -1551,22 +1550,17 @@ void DviImpl::GarbageCollector()
         }
         END_CRITICAL_SECTION();
       }
-      wait = WaitForSingleObject(hByeByeEvent, 0);
-      if (wait == WAIT_FAILED)
-      {
-        MIKTEX_FATAL_WINDOWS_ERROR("WaitForSingleObject");
-      }
-      if (wait == WAIT_OBJECT_0)
+      if (byeBye)
       {
         break;
       }
-      int newPriority;
+      ThreadPriority newPriority;
       if (totalSize > limitHighestPrio)
       {
 #if 0
-        newPriority = THREAD_PRIORITY_HIGHEST;
+        newPriority = ThreadPriority::Highest;
 #else
-        newPriority = THREAD_PRIORITY_NORMAL;
+        newPriority = ThreadPriority::Normal;
 #endif
         sleepDuration = sleepDurationHighestPrio;
         timeKeepBitmaps = timeKeepBitmapsHighestPrio;
@@ -1574,39 +1568,36 @@ void DviImpl::GarbageCollector()
       else if (totalSize > limitAboveNormalPrio)
       {
 #if 0
-        newPriority = THREAD_PRIORITY_ABOVE_NORMAL;
+        newPriority = ThreadPriority::AboveNormal;
 #else
-        newPriority = THREAD_PRIORITY_NORMAL;
+        newPriority = ThreadPriority::Normal;
 #endif
         sleepDuration = sleepDurationAboveNormalPrio;
         timeKeepBitmaps = timeKeepBitmapsAboveNormalPrio;
       }
       else if (totalSize > limitNormalPrio)
       {
-        newPriority = THREAD_PRIORITY_NORMAL;
+        newPriority = ThreadPriority::Normal;
         sleepDuration = sleepDurationBelowNormalPrio;
         timeKeepBitmaps = timeKeepBitmapsNormalPrio;
       }
       else if (totalSize > limitBelowNormalPrio)
       {
-        newPriority = THREAD_PRIORITY_BELOW_NORMAL;
+        newPriority = ThreadPriority::BelowNormal;
         sleepDuration = sleepDurationBelowNormalPrio;
         timeKeepBitmaps = timeKeepBitmapsBelowNormalPrio;
       }
       else
       {
-        newPriority = THREAD_PRIORITY_LOWEST;
+        newPriority = ThreadPriority::Lowest;
         sleepDuration = sleepDurationLowestPrio;
         timeKeepBitmaps = timeKeepBitmapsLowestPrio;
       }
       if (newPriority != priority)
       {
         priority = newPriority;
-        if (!SetThreadPriority(GetCurrentThread(), priority))
-        {
-          MIKTEX_FATAL_WINDOWS_ERROR("SetThreadPriority");
-        }
-        trace_gc->WriteLine("libdvi", fmt::format(T_("gc priority: {0}"), priority));
+        SetCurrentThreadPriority(priority);
+        trace_gc->WriteLine("libdvi", fmt::format(T_("gc priority: {0}"), static_cast<int>(priority)));
       }
       if (biggestPageIdx < 0)
       {
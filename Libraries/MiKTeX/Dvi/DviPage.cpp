@@ -38,7 +38,7 @@ const int MaxVerticalWhite = 2;
 const int MaxHorizontalWhite = 32;
 #endif
 
-size_t DviPageImpl::totalSize = 0;
+atomic_size_t DviPageImpl::totalSize(0);
 
 #if defined(max)
 #undef max
@@ -222,6 +222,7 @@ int DviPageImpl::GetNumberOfDviBitmaps(int shrinkFactor)
   return static_cast<int>(shrinkedDviBitmaps[shrinkFactor].size());
 }
 
+#if defined(MIKTEX_WINDOWS)
 int DviPageImpl::GetNumberOfDibChunks(int shrinkFactor)
 {
   MIKTEX_ASSERT(IsLocked());
@@ -232,15 +233,18 @@ int DviPageImpl::GetNumberOfDibChunks(int shrinkFactor)
   }
   return static_cast<int>(shrinkedDibChunks[shrinkFactor].size());
 }
+#endif
 
 void DviPageImpl::MakeShrinkedRaster(int shrinkFactor)
 {
+#if defined(MIKTEX_WINDOWS)
   if (pageMode == DviPageMode::Dvips)
   {
     // make DIB chunks
     MakeDibChunks(shrinkFactor);
   }
   else
+#endif
   {
     if (!dviItems.empty())
     {
@@ -421,9 +425,9 @@ void DviPageImpl::MakeDviBitmap(int shrinkFactor, DviBitmap& bitmap, vector<DviI
     MIKTEX_ASSERT(itemBottom <= (bitmap.y + (bitmap.height - 1)));
     MIKTEX_ASSERT(item.GetRightShr(shrinkFactor) <= bitmap.x + bitmap.width - 1);
 
-    BYTE* raster = const_cast<BYTE*>(reinterpret_cast<const BYTE*>(bitmap.pixels));
+    unsigned char* raster = const_cast<unsigned char*>(reinterpret_cast<const unsigned char*>(bitmap.pixels));
 
-    const BYTE* rasterChar = reinterpret_cast<const BYTE*>(item.pkChar->GetBitmap(shrinkFactor));
+    const unsigned char* rasterChar = reinterpret_cast<const unsigned char*>(item.pkChar->GetBitmap(shrinkFactor));
 
     int column = itemLeft - bitmap.x;
 
@@ -435,8 +439,8 @@ void DviPageImpl::MakeDviBitmap(int shrinkFactor, DviBitmap& bitmap, vector<DviI
       {
         int idxRasterChar = i * itemSize + j;
 
-        BYTE byte = rasterChar[idxRasterChar];
-        BYTE mask = static_cast<BYTE>(byte >> bitShift);
+        unsigned char byte = rasterChar[idxRasterChar];
+        unsigned char mask = static_cast<unsigned char>(byte >> bitShift);
 
         if (mask != 0)
         {
@@ -480,6 +484,7 @@ void DviPageImpl::DestroyDviBitmaps()
   shrinkedDviBitmaps.clear();
 }
 
+#if defined(MIKTEX_WINDOWS)
 void DviPageImpl::DestroyDibChunks()
 {
   for (MAPNUMTODIBCHUNKVEC::iterator it = shrinkedDibChunks.begin(); it != shrinkedDibChunks.end(); ++it)
@@ -493,6 +498,7 @@ void DviPageImpl::DestroyDibChunks()
   }
   shrinkedDibChunks.clear();
 }
+#endif
 
 void DviPageImpl::FreeContents(bool keepSpecials, bool keepItems)
 {
@@ -520,9 +526,11 @@ void DviPageImpl::FreeContents(bool keepSpecials, bool keepItems)
   }
   haveShrinkedRaster.clear();
   DestroyDviBitmaps();
+#if defined(MIKTEX_WINDOWS)
   DestroyDibChunks();
   haveGraphicsInclusions.clear();
   graphicsInclusions.clear();
+#endif
   frozen = false;
 }
 
@@ -588,6 +596,7 @@ const DviBitmap& DviPageImpl::GetDviBitmap(int shrinkFactor, int idx)
   return shrinkedDviBitmaps[shrinkFactor][idx];
 }
 
+#if defined(MIKTEX_WINDOWS)
 shared_ptr<DibChunk> DviPageImpl::GetDibChunk(int shrinkFactor, int idx)
 {
   MIKTEX_ASSERT(IsLocked());
@@ -596,6 +605,7 @@ shared_ptr<DibChunk> DviPageImpl::GetDibChunk(int shrinkFactor, int idx)
   lastVisited = time(nullptr);
   return shrinkedDibChunks[shrinkFactor][idx];
 }
+#endif
 
 DviImpl* DviPageImpl::GetDviObject()
 {
@@ -713,6 +723,7 @@ HypertexSpecial* DviPageImpl::GetNextHyperref(int& idx)
   return nullptr;
 }
 
+#if defined(MIKTEX_WINDOWS)
 void DviPageImpl::MakeDibChunks(int shrinkFactor)
 {
   unique_ptr<Process> pDvips;
@@ -1084,3 +1095,4 @@ shared_ptr<GraphicsInclusion> DviPageImpl::GetGraphicsInclusion(int shrinkFactor
   lastVisited = time(nullptr);
   return graphicsInclusions[shrinkFactor][idx];
 }
+#endif
@@ -92,10 +92,6 @@ public:
   void
     Print();
 
-  // 16-bit raster word, big-endian
-private:
-  typedef short int RASTERWORD;
-
 private:
   int GetLower3();
 
@@ -108,9 +104,6 @@ private:
 private:
   bool IsLong();
 
-private:
-  unsigned long CountBits(const RASTERWORD* rasterWord, int xStart, int rasterWordsPerLine, int w, int h);
-
 private:
   void Unpack();
 
@@ -129,6 +122,10 @@ private:
 private:
   MAPINTTORASTER bitmaps;
 
+  // pages are rasterized concurrently
+private:
+  std::mutex bitmapMutex;
+
   // flag byte  
 private:
   int flag;
@@ -159,73 +156,7 @@ private:
 
   // the unpacked raster data
 private:
-  RASTERWORD* unpackedRaster = nullptr;
-
-  // rwords per line
-private:
-  int numberOfRasterWords;
-
-  // contains the powers of two
-private:
-  static const int powerOfTwo[32];
-
-  // contains various rows of black
-private:
-  static const int gpower[33]; // FIXME
-
-private:
-  class Unpacker
-  {
-  public:
-    Unpacker(const unsigned char* p, int dynf) :
-      raster(p),
-      dynf(dynf)
-    {
-    }
-
-  public:
-    void ResetBitWeight()
-    {
-      bitWeight = 0;
-    }
-
-  public:
-    int GetPackedNumber();
-
-    // dynamic packing variable
-  private:
-    int dynf;
-
-  private:
-    int GetByte()
-    {
-      return *raster++;
-    }
-
-    // the byte we are currently decimating
-  private:
-    int currentByte;
-
-    // weight of the current bit
-  private:
-    int bitWeight = 0;
-
-    // weight of the current position
-  public:
-    int rasterWordHeight; // FIXME
-
-  public:
-    int repeatCount; // FIXME
-
-  private:
-    const unsigned char* raster = nullptr;
-
-  private:
-    int GetNybble();
-
-  public:
-    bool GetBit();
-  };
+  PkRaster::RasterWord* unpackedRaster = nullptr;
 
 private:
   unique_ptr<TraceStream> trace_error;
@@ -241,8 +241,7 @@ void PkFont::Read()
         k = inputstream.ReadSignedQuad();
         break;
       default:
-        MIKTEX_ASSERT(false);
-        __assume (false);
+        MIKTEX_UNEXPECTED();
       }
       inputstream.SkipBytes(k);
     }
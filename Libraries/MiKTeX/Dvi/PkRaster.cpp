@@ -0,0 +1,417 @@
+/* PkRaster.cpp: PK glyph raster kernels
+
+   Copyright (C) 2024 Christian Schenk
+
+   This file is part of the MiKTeX DVI Library.
+
+   The MiKTeX DVI Library is free software; you can redistribute it
+   and/or modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2, or (at your option) any later version.
+
+   The MiKTeX DVI Library is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public
+   License along with the MiKTeX DVI Library; if not, write to the
+   Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139,
+   USA.  */
+
+#include <climits>
+#include <cstdint>
+#include <cstring>
+
+#include <vector>
+
+#include "PkRaster.h"
+
+using namespace std;
+
+typedef PkRaster::RasterWord RasterWord;
+
+const int bitsPerRasterWord = PkRaster::bitsPerRasterWord;
+
+namespace {
+
+  inline int PopCount(uint32_t v)
+  {
+#if defined(__GNUC__)
+    return __builtin_popcount(v);
+#else
+    v = v - ((v >> 1) & 0x55555555);
+    v = (v & 0x33333333) + ((v >> 2) & 0x33333333);
+    return static_cast<int>((((v + (v >> 4)) & 0x0f0f0f0f) * 0x01010101) >> 24);
+#endif
+  }
+
+  // spreads the eight pixels of a byte (MSB first) into the byte lanes
+  // 0..7 of a 64-bit word
+  struct SpreadBits
+  {
+    SpreadBits()
+    {
+      for (int n = 0; n < 256; ++n)
+      {
+        lanes[n] = 0;
+        for (int j = 0; j < 8; ++j)
+        {
+          if ((n & (0x80 >> j)) != 0)
+          {
+            lanes[n] |= 1ull << (8 * j);
+          }
+        }
+      }
+    }
+    uint64_t lanes[256];
+  };
+
+  const SpreadBits spreadBits;
+
+  // a lane must not overflow when 8 lanes are added up
+  const int maxLaneShrinkFactor = 16;
+
+  // mask for the bits [offset, offset + n) of a raster word
+  inline RasterWord BitMask(int offset, int n)
+  {
+    return static_cast<RasterWord>((0xffffu >> offset) & ~(0xffffu >> (offset + n)));
+  }
+
+  // sets the pixels [x, x + n) of a raster line
+  inline void SetBits(RasterWord* line, int x, int n)
+  {
+    while (n > 0)
+    {
+      int offset = x % bitsPerRasterWord;
+      int k = bitsPerRasterWord - offset;
+      if (k > n)
+      {
+        k = n;
+      }
+      line[x / bitsPerRasterWord] |= BitMask(offset, k);
+      x += k;
+      n -= k;
+    }
+  }
+
+  // counts the black pixels [x, x + n) of a raster line
+  inline int CountBits(const RasterWord* line, int x, int n)
+  {
+    int result = 0;
+    while (n > 0)
+    {
+      int offset = x % bitsPerRasterWord;
+      int k = bitsPerRasterWord - offset;
+      if (k > n)
+      {
+        k = n;
+      }
+      result += PopCount(line[x / bitsPerRasterWord] & BitMask(offset, k));
+      x += k;
+      n -= k;
+    }
+    return result;
+  }
+
+  class PackedRasterReader
+  {
+  public:
+    PackedRasterReader(const unsigned char* packedRaster, size_t packetSize, int dynf) :
+      current(packedRaster),
+      end(packedRaster + packetSize),
+      dynf(dynf)
+    {
+    }
+
+    // reading beyond the end yields zeroes
+  public:
+    bool overrun = false;
+
+  public:
+    int repeatCount = 0;
+
+  public:
+    unsigned GetBits(int n)
+    {
+      while (numBits < n)
+      {
+        bitBuffer = (bitBuffer << 8) | GetByte();
+        numBits += 8;
+      }
+      numBits -= n;
+      return static_cast<unsigned>(bitBuffer >> numBits) & ((1u << n) - 1);
+    }
+
+  public:
+    int GetPackedNumber()
+    {
+      // a repeat count may precede the run count
+      while (true)
+      {
+        int i = GetNybble();
+        if (i < 14)
+        {
+          return GetNumber(i);
+        }
+        repeatCount = i == 14 ? GetNumber(GetNybble()) : 1;
+        if (overrun || corrupt)
+        {
+          return 0;
+        }
+      }
+    }
+
+    // set, if a number is malformed or does not fit into an int
+  public:
+    bool corrupt = false;
+
+  private:
+    int GetNumber(int i)
+    {
+      if (i == 0)
+      {
+        // i leading zero nybbles are followed by i + 1 nybbles
+        uint64_t j;
+        do
+        {
+          j = GetNybble();
+          ++i;
+        } while (j == 0 && !overrun && i <= maxLeadingZeros);
+        if (j == 0)
+        {
+          corrupt = true;
+          return 0;
+        }
+        while (i > 0)
+        {
+          j = j * 16 + GetNybble();
+          --i;
+        }
+        uint64_t result = j - 15 + (13 - dynf) * 16 + dynf;
+        if (result > static_cast<uint64_t>(INT_MAX))
+        {
+          corrupt = true;
+          return 0;
+        }
+        return static_cast<int>(result);
+      }
+      else if (i <= dynf)
+      {
+        return i;
+      }
+      else if (i < 14)
+      {
+        return (i - dynf - 1) * 16 + GetNybble() + dynf + 1;
+      }
+      else
+      {
+        // a repeat count cannot be repeated
+        corrupt = true;
+        return 0;
+      }
+    }
+
+  private:
+    // 8 nybbles make up 32 bits
+    static const int maxLeadingZeros = 7;
+
+  private:
+    unsigned GetByte()
+    {
+      if (current == end)
+      {
+        overrun = true;
+        return 0;
+      }
+      return *current++;
+    }
+
+  private:
+    int GetNybble()
+    {
+      if (numBits == 0)
+      {
+        bitBuffer = GetByte();
+        numBits = 8;
+      }
+      numBits -= 4;
+      return static_cast<int>(bitBuffer >> numBits) & 0x0f;
+    }
+
+  private:
+    const unsigned char* current;
+
+  private:
+    const unsigned char* end;
+
+  private:
+    int dynf;
+
+  private:
+    uint64_t bitBuffer = 0;
+
+  private:
+    int numBits = 0;
+  };
+
+}
+
+bool PkRaster::Unpack(const unsigned char* packedRaster, size_t packetSize, int flag, int width, int height, RasterWord* raster)
+{
+  int dynf = flag >> 4;
+  if (dynf > 14 || width <= 0 || height <= 0)
+  {
+    return false;
+  }
+  int rasterWordsPerLine = GetRasterWordsPerLine(width);
+  PackedRasterReader reader(packedRaster, packetSize, dynf);
+  memset(raster, 0, sizeof(RasterWord) * rasterWordsPerLine * height);
+  if (dynf == 14)
+  {
+    // the raster is stored bit by bit; rows are not byte-aligned
+    for (RasterWord* line = raster; line < raster + rasterWordsPerLine * height; line += rasterWordsPerLine)
+    {
+      for (int x = 0; x < width; x += bitsPerRasterWord)
+      {
+        int n = width - x < bitsPerRasterWord ? width - x : bitsPerRasterWord;
+        line[x / bitsPerRasterWord] = static_cast<RasterWord>(reader.GetBits(n) << (bitsPerRasterWord - n));
+      }
+    }
+    return !reader.overrun;
+  }
+  // run-length encoded raster: set the black runs word by word
+  bool black = (flag & 8) != 0;
+  int row = 0;
+  int x = 0;
+  while (row < height)
+  {
+    int count = reader.GetPackedNumber();
+    if (reader.overrun || reader.corrupt || count < 0 || reader.repeatCount < 0)
+    {
+      return false;
+    }
+    while (count > 0)
+    {
+      if (row < 0 || row >= height)
+      {
+        return false;
+      }
+      RasterWord* line = raster + rasterWordsPerLine * row;
+      int n = width - x < count ? width - x : count;
+      if (black)
+      {
+        SetBits(line, x, n);
+      }
+      x += n;
+      count -= n;
+      if (x == width)
+      {
+        if (reader.repeatCount >= height - row)
+        {
+          return false;
+        }
+        for (int i = 1; i <= reader.repeatCount; ++i)
+        {
+          memcpy(line + rasterWordsPerLine * i, line, sizeof(RasterWord) * rasterWordsPerLine);
+        }
+        row += reader.repeatCount + 1;
+        reader.repeatCount = 0;
+        x = 0;
+      }
+    }
+    black = !black;
+  }
+  return true;
+}
+
+void PkRaster::CopyBits(const RasterWord* raster, int width, int height, unsigned char* bitmap, size_t bytesPerLine)
+{
+  int rasterWordsPerLine = GetRasterWordsPerLine(width);
+  for (int row = 0; row < height; ++row)
+  {
+    const RasterWord* line = raster + rasterWordsPerLine * row;
+    unsigned char* pbyte = bitmap + bytesPerLine * row;
+    for (int i = 0; i < rasterWordsPerLine; ++i)
+    {
+      *pbyte++ = static_cast<unsigned char>(line[i] >> 8);
+      *pbyte++ = static_cast<unsigned char>(line[i] & 0xff);
+    }
+  }
+}
+
+void PkRaster::BoxFilter(const RasterWord* raster, int width, int height, int shrinkFactor, int firstSampleWidth, int firstSampleHeight, int bitsPerPixel, unsigned char* bitmap, size_t bytesPerLine)
+{
+  int rasterWordsPerLine = GetRasterWordsPerLine(width);
+  int maxValue = (1 << bitsPerPixel) - 1;
+  int cellSize = shrinkFactor * shrinkFactor;
+  // 2^32 / (2 * cellSize), rounded up: exact for the numerators below
+  uint64_t reciprocal = ((1ull << 32) + 2 * cellSize - 1) / (2 * cellSize);
+  // the pixel counts of the columns of a band, eight byte lanes per word;
+  // turned into prefix sums, so that a cell can be summed up in O(1)
+  int numLanes = (width + 7) / 8;
+  uint64_t stackLanes[2 * (128 + 1)];
+  vector<uint64_t> heapLanes;
+  uint64_t* lanes = stackLanes;
+  if (numLanes > 128)
+  {
+    heapLanes.resize(2 * (numLanes + 1));
+    lanes = heapLanes.data();
+  }
+  uint64_t* bases = lanes + numLanes + 1;
+  int sampleHeight = firstSampleHeight;
+  for (int row = 0; row < height; row += sampleHeight, sampleHeight = shrinkFactor, bitmap += bytesPerLine)
+  {
+    const RasterWord* band = raster + rasterWordsPerLine * row;
+    const RasterWord* bandEnd = band + rasterWordsPerLine * (height - row < sampleHeight ? height - row : sampleHeight);
+    int sampleWidth = firstSampleWidth;
+    if (shrinkFactor > maxLaneShrinkFactor)
+    {
+      for (int col = 0, bitPos = 0; col < width; col += sampleWidth, sampleWidth = shrinkFactor, bitPos += bitsPerPixel)
+      {
+        int w = width - col < sampleWidth ? width - col : sampleWidth;
+        int count = 0;
+        for (const RasterWord* line = band; line < bandEnd; line += rasterWordsPerLine)
+        {
+          count += CountBits(line, col, w);
+        }
+        int value = static_cast<int>(((2 * count * maxValue + cellSize) * reciprocal) >> 32);
+        bitmap[bitPos / 8] |= static_cast<unsigned char>(value << (8 - bitsPerPixel - bitPos % 8));
+      }
+      continue;
+    }
+    memset(lanes, 0, sizeof(uint64_t) * (numLanes + 1));
+    for (const RasterWord* line = band; line < bandEnd; line += rasterWordsPerLine)
+    {
+      for (int k = 0; k < numLanes; k += 2)
+      {
+        lanes[k] += spreadBits.lanes[line[k / 2] >> 8];
+        if (k + 1 < numLanes)
+        {
+          lanes[k + 1] += spreadBits.lanes[line[k / 2] & 0xff];
+        }
+      }
+    }
+    // lane j of word k becomes the sum of the lanes 0..j-1; bases[k] is
+    // the sum of the words 0..k-1
+    uint64_t base = 0;
+    for (int k = 0; k <= numLanes; ++k)
+    {
+      uint64_t prefix = lanes[k] * 0x0101010101010101ull;
+      bases[k] = base;
+      base += prefix >> 56;
+      lanes[k] = prefix << 8;
+    }
+    int sumBefore = 0;
+    for (int col = 0, bitPos = 0; col < width; col += sampleWidth, sampleWidth = shrinkFactor, bitPos += bitsPerPixel)
+    {
+      int end = width - col < sampleWidth ? width : col + sampleWidth;
+      int sum = static_cast<int>(bases[end / 8] + ((lanes[end / 8] >> (8 * (end % 8))) & 0xff));
+      int count = sum - sumBefore;
+      sumBefore = sum;
+      // same as rounding count * maxValue / cellSize
+      int value = static_cast<int>(((2 * count * maxValue + cellSize) * reciprocal) >> 32);
+      bitmap[bitPos / 8] |= static_cast<unsigned char>(value << (8 - bitsPerPixel - bitPos % 8));
+    }
+  }
+}
@@ -0,0 +1,58 @@
+/* PkRaster.h:                                          -*- C++ -*-
+
+   Copyright (C) 2024 Christian Schenk
+
+   This file is part of the MiKTeX DVI Library.
+
+   The MiKTeX DVI Library is free software; you can redistribute it
+   and/or modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2, or (at your option) any later version.
+
+   The MiKTeX DVI Library is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public
+   License along with the MiKTeX DVI Library; if not, write to the
+   Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139,
+   USA.  */
+
+#pragma once
+
+#include <cstddef>
+
+/* PK glyph raster kernels.  They depend on nothing but the standard
+   library, so that pkbench can measure them in isolation. */
+
+class PkRaster
+{
+  // 16-bit raster word; the leftmost pixel is the most significant bit
+public:
+  typedef unsigned short RasterWord;
+
+public:
+  static const int bitsPerRasterWord = 16;
+
+public:
+  static int GetRasterWordsPerLine(int width)
+  {
+    return (width + bitsPerRasterWord - 1) / bitsPerRasterWord;
+  }
+
+  // decodes the packed raster of a character (PK flag byte `flag'); the
+  // raster must hold height * GetRasterWordsPerLine(width) words;
+  // returns false, if the packed data is corrupt
+public:
+  static bool Unpack(const unsigned char* packedRaster, size_t packetSize, int flag, int width, int height, RasterWord* raster);
+
+  // converts the raster into a 1-bit bitmap (MSB first)
+public:
+  static void CopyBits(const RasterWord* raster, int width, int height, unsigned char* bitmap, size_t bytesPerLine);
+
+  // shrinks the raster into a gray-scale bitmap (MSB first); the first
+  // sample cell of a row/column may be smaller than the shrink factor
+public:
+  static void BoxFilter(const RasterWord* raster, int width, int height, int shrinkFactor, int firstSampleWidth, int firstSampleHeight, int bitsPerPixel, unsigned char* bitmap, size_t bytesPerLine);
+};
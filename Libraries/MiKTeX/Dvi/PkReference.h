@@ -0,0 +1,353 @@
+/* PkReference.h: PK raster code before the PkRaster kernels  -*- C++ -*-
+
+   Copyright (C) 2024 Christian Schenk
+
+   This file is part of the MiKTeX DVI Library.
+
+   The MiKTeX DVI Library is free software; you can redistribute it
+   and/or modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2, or (at your option) any later version.
+
+   The MiKTeX DVI Library is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public
+   License along with the MiKTeX DVI Library; if not, write to the
+   Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139,
+   USA.  */
+
+/* The PkRaster kernels are checked against this code by pkbench and
+   by the dvi_pkshrink_test. */
+
+#pragma once
+
+#include <cstddef>
+
+#include <algorithm>
+#include <vector>
+
+#include "PkRaster.h"
+
+typedef PkRaster::RasterWord RasterWord;
+
+const int bitsPerPixel = 4;
+
+struct Glyph
+{
+  int flag = 0;
+  int width = 0;
+  int height = 0;
+  int cxOffset = 0;
+  int cyOffset = 0;
+  std::vector<unsigned char> packedRaster;
+  std::vector<RasterWord> raster;
+};
+
+/* The code below is the raster code of PkChar.cpp as it was before the
+   PkRaster kernels, modulo naming. */
+namespace Reference {
+
+  inline int powerOfTwo[32];
+
+  inline int gpower[33];
+
+  inline unsigned char bitcounts[1 << 16];
+
+  inline void Init()
+  {
+    for (int i = 0; i < 32; ++i)
+    {
+      powerOfTwo[i] = 1 << i;
+      gpower[i] = static_cast<int>((1u << i) - 1);
+    }
+    gpower[31] = 2147483647;
+    gpower[32] = -1;
+    for (int n = 0; n < (1 << 16); ++n)
+    {
+      int count = 0;
+      for (int k = n; k != 0; k >>= 1)
+      {
+        count += k & 1;
+      }
+      bitcounts[n] = static_cast<unsigned char>(count);
+    }
+  }
+
+  class Unpacker
+  {
+  public:
+    Unpacker(const unsigned char* p, int dynf) :
+      raster(p),
+      dynf(dynf)
+    {
+    }
+
+  public:
+    int GetNybble()
+    {
+      if (bitWeight == 0)
+      {
+        currentByte = *raster++;
+        bitWeight = 16;
+      }
+      int temp = currentByte / bitWeight;
+      currentByte -= temp * bitWeight;
+      bitWeight /= 16;
+      return temp;
+    }
+
+  public:
+    bool GetBit()
+    {
+      bitWeight /= 2;
+      if (bitWeight == 0)
+      {
+        currentByte = *raster++;
+        bitWeight = 128;
+      }
+      bool temp = currentByte >= bitWeight;
+      if (temp)
+      {
+        currentByte -= bitWeight;
+      }
+      return temp;
+    }
+
+  public:
+    int GetPackedNumber()
+    {
+      int i = GetNybble();
+      int j;
+      if (i == 0)
+      {
+        do
+        {
+          j = GetNybble();
+          ++i;
+        } while (j == 0);
+        while (i > 0)
+        {
+          j = j * 16 + GetNybble();
+          --i;
+        }
+        return j - 15 + (13 - dynf) * 16 + dynf;
+      }
+      else if (i <= dynf)
+      {
+        return i;
+      }
+      else if (i < 14)
+      {
+        return (i - dynf - 1) * 16 + GetNybble() + dynf + 1;
+      }
+      else
+      {
+        repeatCount = i == 14 ? GetPackedNumber() : 1;
+        return GetPackedNumber();
+      }
+    }
+
+  public:
+    const unsigned char* raster;
+
+  public:
+    int dynf;
+
+  public:
+    int currentByte = 0;
+
+  public:
+    int bitWeight = 0;
+
+  public:
+    int rasterWordHeight = 0;
+
+  public:
+    int repeatCount = 0;
+  };
+
+  inline bool Unpack(const Glyph& glyph, RasterWord* unpackedRaster)
+  {
+    const int bitsPerRasterWord = PkRaster::bitsPerRasterWord;
+    int dynf = glyph.flag >> 4;
+    Unpacker unp(glyph.packedRaster.data(), dynf);
+    int numberOfRasterWords = PkRaster::GetRasterWordsPerLine(glyph.width);
+    RasterWord rword = 0;
+    bool turnOn = (glyph.flag & 8) != 0;
+    if (dynf == 14)
+    {
+      for (int i = 1; i <= glyph.height; ++i)
+      {
+        rword = 0;
+        unp.rasterWordHeight = bitsPerRasterWord - 1;
+        for (int j = 1; j <= glyph.width; ++j)
+        {
+          if (unp.GetBit())
+          {
+            rword = static_cast<RasterWord>(rword + powerOfTwo[unp.rasterWordHeight]);
+          }
+          --unp.rasterWordHeight;
+          if (unp.rasterWordHeight == -1)
+          {
+            *unpackedRaster++ = rword;
+            rword = 0;
+            unp.rasterWordHeight = bitsPerRasterWord - 1;
+          }
+        }
+        if (unp.rasterWordHeight < bitsPerRasterWord - 1)
+        {
+          *unpackedRaster++ = rword;
+        }
+      }
+      return true;
+    }
+    int rows_left = glyph.height;
+    int h_bit = glyph.width;
+    unp.rasterWordHeight = bitsPerRasterWord;
+    while (rows_left > 0)
+    {
+      int count = unp.GetPackedNumber();
+      while (count > 0)
+      {
+        if (count < unp.rasterWordHeight && count < h_bit)
+        {
+          if (turnOn)
+          {
+            rword = static_cast<RasterWord>(rword + (gpower[unp.rasterWordHeight] - gpower[unp.rasterWordHeight - count]));
+          }
+          h_bit -= count;
+          unp.rasterWordHeight -= count;
+          count = 0;
+        }
+        else if (count >= h_bit && h_bit <= unp.rasterWordHeight)
+        {
+          if (turnOn)
+          {
+            rword = static_cast<RasterWord>(rword + (gpower[unp.rasterWordHeight] - gpower[unp.rasterWordHeight - h_bit]));
+          }
+          *unpackedRaster++ = rword;
+          for (int i = 1; i <= unp.repeatCount; ++i)
+          {
+            for (int j = 1; j <= numberOfRasterWords; ++j, ++unpackedRaster)
+            {
+              *unpackedRaster = unpackedRaster[-numberOfRasterWords];
+            }
+          }
+          rows_left = rows_left - unp.repeatCount - 1;
+          unp.repeatCount = 0;
+          rword = 0;
+          unp.rasterWordHeight = bitsPerRasterWord;
+          count -= h_bit;
+          h_bit = glyph.width;
+        }
+        else
+        {
+          if (turnOn)
+          {
+            rword = static_cast<RasterWord>(rword + gpower[unp.rasterWordHeight]);
+          }
+          *unpackedRaster++ = rword;
+          rword = 0;
+          count -= unp.rasterWordHeight;
+          h_bit -= unp.rasterWordHeight;
+          unp.rasterWordHeight = bitsPerRasterWord;
+        }
+      }
+      turnOn = !turnOn;
+    }
+    return rows_left == 0 && h_bit == glyph.width;
+  }
+
+  inline unsigned long CountBits(const RasterWord* rasterWord, int xStart, int rasterWordsPerLine, int w, int h)
+  {
+    const unsigned long bitsPerRasterWord = PkRaster::bitsPerRasterWord;
+    unsigned long result = 0;
+    unsigned long rightShift = bitsPerRasterWord - (xStart % bitsPerRasterWord);
+    rasterWord += xStart / bitsPerRasterWord;
+    while (w > 0)
+    {
+      unsigned long bitFieldLength = std::min(rightShift, static_cast<unsigned long>(w));
+      bitFieldLength = std::min(bitFieldLength, bitsPerRasterWord);
+      rightShift -= bitFieldLength;
+      const RasterWord* pRasterWord2 = rasterWord;
+      for (int i = 0; i < h; ++i, pRasterWord2 += rasterWordsPerLine)
+      {
+        RasterWord rw = *pRasterWord2;
+        rw >>= rightShift;
+        rw &= gpower[bitFieldLength];
+        result += bitcounts[rw];
+      }
+      if (rightShift == 0)
+      {
+        rightShift = bitsPerRasterWord;
+        rasterWord++;
+      }
+      w -= bitFieldLength;
+    }
+    return result;
+  }
+
+  inline void CopyBits(const Glyph& glyph, unsigned char* bitmap, std::size_t bytesPerLine)
+  {
+    const int bitsPerRasterWord = PkRaster::bitsPerRasterWord;
+    int rasterWordsPerLine = PkRaster::GetRasterWordsPerLine(glyph.width);
+    for (int row = 0; row < glyph.height; ++row)
+    {
+      unsigned char* pbyte = &bitmap[row * bytesPerLine];
+      unsigned long idxBit = 7;
+      for (int col = 0; col < glyph.width; ++col)
+      {
+        RasterWord rw = glyph.raster[rasterWordsPerLine * row + col / bitsPerRasterWord];
+        unsigned long n = (rw & powerOfTwo[bitsPerRasterWord - col % bitsPerRasterWord - 1]) ? 1 : 0;
+        if (idxBit == 0)
+        {
+          *pbyte |= static_cast<unsigned char>(n);
+          ++pbyte;
+          idxBit = 7;
+        }
+        else
+        {
+          *pbyte |= static_cast<unsigned char>((n << idxBit) & 0xff);
+          --idxBit;
+        }
+      }
+    }
+  }
+
+  inline void BoxFilter(const Glyph& glyph, int shrinkFactor, int sampleWidth0, int sampleHeight, unsigned char* bitmap, std::size_t bytesPerLine)
+  {
+    int rasterWordsPerLine = PkRaster::GetRasterWordsPerLine(glyph.width);
+    const RasterWord* unpackedRaster = glyph.raster.data();
+    for (int row = 0; row < glyph.height; bitmap += bytesPerLine)
+    {
+      unsigned char* pbyte = bitmap;
+      unsigned long idxBit = 7;
+      int sampleWidth = sampleWidth0;
+      for (int col = 0; col < glyph.width; )
+      {
+        unsigned long count = CountBits(unpackedRaster + rasterWordsPerLine * row, col, rasterWordsPerLine, std::min(sampleWidth, glyph.width - col), std::min(sampleHeight, glyph.height - row));
+        unsigned long n = static_cast<unsigned long>(static_cast<double>(count * ((1 << bitsPerPixel) - 1)) / static_cast<double>(shrinkFactor * shrinkFactor) + 0.5);
+        if (idxBit == bitsPerPixel - 1)
+        {
+          *pbyte |= static_cast<unsigned char>(n);
+          pbyte++;
+          idxBit = 7;
+        }
+        else
+        {
+          int shift = idxBit - bitsPerPixel + 1;
+          *pbyte |= static_cast<unsigned char>((n << shift) & 0xff);
+          idxBit -= bitsPerPixel;
+        }
+        col += sampleWidth;
+        sampleWidth = shrinkFactor;
+      }
+      row += sampleHeight;
+      sampleHeight = shrinkFactor;
+    }
+  }
+
+}
@@ -91,7 +91,7 @@ void VfChar::Read(InputStream& inputstream, int size, double conv)
   }
   else
   {
-    packet = new BYTE[packetSize];
+    packet = new unsigned char[packetSize];
   }
 
   inputstream.Read(packet, packetSize);
@@ -37,7 +37,7 @@ public:
   void Read(InputStream& inputStream, int size, double conv);
 
 public:
-  const BYTE* GetPacket(unsigned long& length)
+  const unsigned char* GetPacket(unsigned long& length)
   {
     length = packetSize;
     return packet;
@@ -47,10 +47,10 @@ private:
   int packetSize = 0;
 
 private:
-  BYTE smallPacket[1];
+  unsigned char smallPacket[1];
 
 private:
-  BYTE* packet = nullptr;
+  unsigned char* packet = nullptr;
 
 private:
   unique_ptr<TraceStream> trace_vfchar;
@@ -375,7 +375,7 @@ bool DviImpl::ParseColorSpec(const char* colorSpec, unsigned long& rgb)
     if (isRgb || isHsb)
     {
       float frac1, frac2, frac3;
-      if (sscanf_s(colorSpec, "%f %f %f", &frac1, &frac2, &frac3) != 3
+      if (sscanf(colorSpec, "%f %f %f", &frac1, &frac2, &frac3) != 3
         || frac1 < 0.0 || frac1 > 1.0
         || frac2 < 0.0 || frac2 > 1.0
         || frac3 < 0.0 || frac3 > 1.0)
@@ -403,7 +403,7 @@ bool DviImpl::ParseColorSpec(const char* colorSpec, unsigned long& rgb)
     else if (isGray)
     {
       float frac1;
-      if (sscanf_s(colorSpec, "%f", &frac1) != 1
+      if (sscanf(colorSpec, "%f", &frac1) != 1
         || frac1 < 0.0 || frac1 > 1.0)
       {
         trace_error->WriteLine("libdvi", fmt::format(T_("invalid gray value: {0}"), colorSpec));
@@ -419,7 +419,7 @@ bool DviImpl::ParseColorSpec(const char* colorSpec, unsigned long& rgb)
     else if (isCmyk)
     {
       float frac1, frac2, frac3, frac4;
-      if ((sscanf_s(colorSpec, "%f %f %f %f", &frac1, &frac2, &frac3, &frac4) != 4)
+      if ((sscanf(colorSpec, "%f %f %f %f", &frac1, &frac2, &frac3, &frac4) != 4)
         || frac1 < 0.0 || frac1 > 1.0
         || frac2 < 0.0 || frac2 > 1.0
         || frac3 < 0.0 || frac3 > 1.0
@@ -16,17 +16,38 @@
    License along with this program; if not, write to the Free Software
    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.  */
 
+#include <csetjmp>
 #include <cstdarg>
 #include <cstdlib>
 
+#include <algorithm>
+#include <chrono>
+#include <exception>
 #include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <fmt/format.h>
+
+#include <png.h>
 
 #include <miktex/App/Application>
+#include <miktex/Core/Directory>
+#include <miktex/Core/File>
+#include <miktex/Core/FileStream>
+#include <miktex/Core/Session>
 #include <miktex/Core/Text>
 #include <miktex/DVI/Dvi>
+#include <miktex/Util/PathName>
 #include <miktex/Util/StringUtil>
 #include <miktex/Wrappers/PoptWrapper>
 
+#if defined(max)
+#undef max
+#undef min
+#endif
+
 using namespace MiKTeX::App;
 using namespace MiKTeX::Core;
 using namespace MiKTeX::DVI;
@@ -38,14 +59,42 @@ using namespace std;
 
 enum {
   OPT_AAA = 1234,
-  OPT_TRACE,
-  OPT_PAGE_MODE
+  OPT_FORMAT,
+  OPT_MFMODE,
+  OPT_OUTPUT_DIRECTORY,
+  OPT_PAGE_MODE,
+  OPT_RESOLUTION,
+  OPT_SHRINK_FACTOR,
+  OPT_STATISTICS,
+  OPT_THREADS,
+  OPT_TRACE
 };
 
 static const struct poptOption long_options[] = {
+  {
+    "format", 0, POPT_ARG_STRING, nullptr, OPT_FORMAT, "Sets the image format (pbm, pgm or png).", "FORMAT"
+  },
+  {
+    "mfmode", 0, POPT_ARG_STRING, nullptr, OPT_MFMODE, "Sets the METAFONT mode.", "MODE"
+  },
+  {
+    "output-directory", 0, POPT_ARG_STRING, nullptr, OPT_OUTPUT_DIRECTORY, "Writes page images to DIR.", "DIR"
+  },
   {
     "page-mode", 0, POPT_ARG_STRING, nullptr, OPT_PAGE_MODE, "Sets the DVI page mode.", "PAGEMODE"
   },
+  {
+    "resolution", 0, POPT_ARG_STRING, nullptr, OPT_RESOLUTION, "Sets the resolution (in dots per inch).", "DPI"
+  },
+  {
+    "shrink-factor", 0, POPT_ARG_STRING, nullptr, OPT_SHRINK_FACTOR, "Sets the shrink factor.", "N"
+  },
+  {
+    "statistics", 0, POPT_ARG_NONE, nullptr, OPT_STATISTICS, "Prints timing statistics.", nullptr
+  },
+  {
+    "threads", 0, POPT_ARG_STRING, nullptr, OPT_THREADS, "Renders N pages in parallel.", "N"
+  },
   {
     "trace", 0, POPT_ARG_STRING, nullptr, OPT_TRACE, "Turn on tracing.", "TRACESTREAMS"
   },
@@ -53,26 +102,94 @@ static const struct poptOption long_options[] = {
   POPT_TABLEEND
 };
 
+enum class ImageFormat
+{
+  None,
+  PBM,
+  PGM,
+  PNG
+};
+
+// an 8-bit grayscale page image
+struct PageImage
+{
+  int width = 0;
+  int height = 0;
+  vector<unsigned char> pixels;
+};
+
 class DviScanner :
   public Application
 {
 public:
   void Run(int argc, const char** argv);
 
+private:
+  void ScanFile(const string& dviFileName);
+
+private:
+  void RenderPage(DviPage* dviPage, const PaperSizeInfo& paperSizeInfo, bool landscape, PageImage& image);
+
+private:
+  void WriteImage(const PageImage& image, const PathName& path);
+
+private:
+  void WritePnm(const PageImage& image, const PathName& path);
+
+private:
+  void WritePng(const PageImage& image, const PathName& path);
+
 private:
   DviPageMode pageMode = DviPageMode::Pk;
 
+private:
+  ImageFormat imageFormat = ImageFormat::PNG;
+
+private:
+  string metafontMode = "ljfour";
+
+private:
+  PathName outputDirectory;
+
+private:
+  int resolution = 600;
+
+private:
+  int shrinkFactor = 5;
+
+private:
+  unsigned numThreads = 0;
+
+private:
+  bool printStatistics = false;
+
 private:
   shared_ptr<Session> session;
 };
 
+inline int ParseNumber(const string& s, int minValue)
+{
+  int n = atoi(s.c_str());
+  if (n < minValue)
+  {
+    throw T_("invalid number");
+  }
+  return n;
+}
+
+// converts a Windows-style RGB value into a gray level
+inline int Gray(unsigned long rgb)
+{
+  int r = rgb & 0xff;
+  int g = (rgb >> 8) & 0xff;
+  int b = (rgb >> 16) & 0xff;
+  return (299 * r + 587 * g + 114 * b) / 1000;
+}
+
 void DviScanner::Run(int argc, const char** argv)
 {
   Session::InitInfo initInfo(argv[0]);
 
-  string metafontMode("ljfour");
-  int dpi = 600;
-
   PoptWrapper popt(argc, argv, long_options);
 
   popt.SetOtherOptionHelp(T_("[OPTION...] DVIFILE..."));
@@ -84,6 +201,30 @@ void DviScanner::Run(int argc, const char** argv)
     string optArg = popt.GetOptArg();
     switch (option)
     {
+    case OPT_FORMAT:
+      if (optArg == "pbm")
+      {
+        imageFormat = ImageFormat::PBM;
+      }
+      else if (optArg == "pgm")
+      {
+        imageFormat = ImageFormat::PGM;
+      }
+      else if (optArg == "png")
+      {
+        imageFormat = ImageFormat::PNG;
+      }
+      else
+      {
+        throw T_("invalid image format");
+      }
+      break;
+    case OPT_MFMODE:
+      metafontMode = optArg;
+      break;
+    case OPT_OUTPUT_DIRECTORY:
+      outputDirectory = optArg;
+      break;
     case OPT_PAGE_MODE:
       if (optArg == "pk")
       {
@@ -98,6 +239,18 @@ void DviScanner::Run(int argc, const char** argv)
         throw T_("invalid page mode");
       }
       break;
+    case OPT_RESOLUTION:
+      resolution = ParseNumber(optArg, 1);
+      break;
+    case OPT_SHRINK_FACTOR:
+      shrinkFactor = ParseNumber(optArg, 1);
+      break;
+    case OPT_STATISTICS:
+      printStatistics = true;
+      break;
+    case OPT_THREADS:
+      numThreads = ParseNumber(optArg, 1);
+      break;
     case OPT_TRACE:
       initInfo.SetTraceFlags(optArg);
       break;
@@ -118,32 +271,299 @@ void DviScanner::Run(int argc, const char** argv)
     throw 1;
   }
 
+  if (numThreads == 0)
+  {
+    numThreads = std::max(thread::hardware_concurrency(), 1u);
+  }
+
   // MIKTEX-TODO: pass argc/argv
   Init(initInfo);
   session = GetSession();
 
+  if (!outputDirectory.Empty())
+  {
+    Directory::Create(outputDirectory);
+  }
+
   for (const string& dviFileName : leftovers)
   {
-    unique_ptr<Dvi> dvi(Dvi::Create(dviFileName.c_str(), metafontMode.c_str(), dpi, 5, DviAccess::Sequential, pageMode, session->GetPaperSizeInfo("A4size"), false, nullptr, nullptr));
-    dvi->Scan();
-    for (int i = 0; i < dvi->GetNumberOfPages(); ++i)
+    ScanFile(dviFileName);
+  }
+
+  Finalize();
+}
+
+void DviScanner::ScanFile(const string& dviFileName)
+{
+  auto start = chrono::steady_clock::now();
+
+  unique_ptr<Dvi> dvi(Dvi::Create(dviFileName.c_str(), metafontMode.c_str(), resolution, shrinkFactor, DviAccess::Sequential, pageMode, session->GetPaperSizeInfo("A4size"), false, nullptr, nullptr));
+  dvi->Scan();
+
+  int numPages = dvi->GetNumberOfPages();
+  string baseName = PathName(dviFileName).GetFileNameWithoutExtension().ToString();
+
+  // the pages are interpreted one at a time and in order (papersize
+  // and landscape specials change the state of the Dvi object), but
+  // the bitmaps are made concurrently
+  int nextPageIdx = 0;
+  mutex loadMutex;
+  mutex errorMutex;
+  exception_ptr error;
+  auto worker = [&]()
+  {
+    try
     {
-      DviPage* dviPage = dvi->GetLoadedPage(i);
-      if (dviPage == nullptr)
+      while (true)
       {
-        break;
+        int pageIdx;
+        DviPage* dviPage;
+        PaperSizeInfo paperSizeInfo;
+        bool landscape;
+        {
+          lock_guard<mutex> lockGuard(loadMutex);
+          // claim the page while holding the lock, so that no other
+          // worker can load a later page first
+          if (nextPageIdx >= numPages)
+          {
+            break;
+          }
+          pageIdx = nextPageIdx++;
+          dviPage = dvi->GetLoadedPage(pageIdx);
+          // papersize and landscape specials are interpreted when the page is loaded
+          paperSizeInfo = dvi->GetPaperSizeInfo();
+          landscape = dvi->Landscape();
+        }
+        if (dviPage == nullptr)
+        {
+          break;
+        }
+        try
+        {
+          if (outputDirectory.Empty())
+          {
+            for (int j = 0; j < dviPage->GetNumberOfDviBitmaps(shrinkFactor); ++j)
+            {
+              dviPage->GetDviBitmap(shrinkFactor, j);
+            }
+          }
+          else
+          {
+            PageImage image;
+            RenderPage(dviPage, paperSizeInfo, landscape, image);
+            WriteImage(image, outputDirectory / fmt::format("{0}-{1}", baseName, pageIdx + 1));
+          }
+        }
+        catch (const exception&)
+        {
+          dviPage->Unlock();
+          throw;
+        }
+        dviPage->Unlock();
       }
-      for (int j = 0; j < dviPage->GetNumberOfDviBitmaps(5); ++j)
+    }
+    catch (const exception&)
+    {
       {
-        dviPage->GetDviBitmap(5, j);
+        lock_guard<mutex> lockGuard(errorMutex);
+        if (error == nullptr)
+        {
+          error = current_exception();
+        }
       }
-      dviPage->Unlock();
+      // let the other workers run out of pages
+      lock_guard<mutex> lockGuard(loadMutex);
+      nextPageIdx = numPages;
     }
-    dvi->Dispose();
-    dvi = nullptr;
+  };
+
+  vector<thread> threads;
+  for (unsigned idx = 1; idx < numThreads; ++idx)
+  {
+    threads.push_back(thread(worker));
+  }
+  worker();
+  for (thread& t : threads)
+  {
+    t.join();
   }
 
-  Finalize();
+  dvi->Dispose();
+  dvi = nullptr;
+
+  if (error != nullptr)
+  {
+    rethrow_exception(error);
+  }
+
+  if (printStatistics)
+  {
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    cout << fmt::format("{0}: {1} pages, {2} threads, {3:.3f} s, {4:.1f} pages/s", dviFileName, numPages, numThreads, seconds, seconds > 0 ? numPages / seconds : 0.0) << endl;
+  }
+}
+
+void DviScanner::RenderPage(DviPage* dviPage, const PaperSizeInfo& paperSizeInfo, bool landscape, PageImage& image)
+{
+  // paper size: 72nds of an inch => pixels
+  image.width = static_cast<int>(((resolution * paperSizeInfo.width) / 72.0) / shrinkFactor);
+  image.height = static_cast<int>(((resolution * paperSizeInfo.height) / 72.0) / shrinkFactor);
+  if (landscape)
+  {
+    swap(image.width, image.height);
+  }
+  image.pixels.assign(static_cast<size_t>(image.width) * image.height, 255);
+
+  auto fillRect = [&image](int left, int top, int right, int bottom, unsigned char gray)
+  {
+    left = std::max(left, 0);
+    top = std::max(top, 0);
+    right = std::min(right, image.width - 1);
+    bottom = std::min(bottom, image.height - 1);
+    for (int y = top; y <= bottom; ++y)
+    {
+      unsigned char* line = &image.pixels[static_cast<size_t>(y) * image.width];
+      for (int x = left; x <= right; ++x)
+      {
+        line[x] = gray;
+      }
+    }
+  };
+
+  auto drawRules = [&](bool blackBoards)
+  {
+    DviRule* rule;
+    for (int idx = 0; (rule = dviPage->GetRule(idx)) != nullptr; ++idx)
+    {
+      if (rule->IsBlackboard() == blackBoards)
+      {
+        fillRect(rule->GetLeft(shrinkFactor), rule->GetTop(shrinkFactor), rule->GetRight(shrinkFactor), rule->GetBottom(shrinkFactor), static_cast<unsigned char>(Gray(rule->GetBackgroundColor())));
+      }
+    }
+  };
+
+  drawRules(true);
+
+  // bitmap rows are stored bottom-up; a pixel is either 1 bit (no
+  // shrinking) or a 4-bit coverage value, left pixel in the high bits
+  int bitsPerPixel = shrinkFactor == 1 ? 1 : 4;
+  int maxCoverage = (1 << bitsPerPixel) - 1;
+  int numBitmaps = dviPage->GetNumberOfDviBitmaps(shrinkFactor);
+  for (int idx = 0; idx < numBitmaps; ++idx)
+  {
+    const DviBitmap& bitmap = dviPage->GetDviBitmap(shrinkFactor, idx);
+    const unsigned char* pixels = reinterpret_cast<const unsigned char*>(bitmap.pixels);
+    int foreground = Gray(bitmap.foregroundColor);
+    int background = Gray(bitmap.backgroundColor);
+    for (int row = 0; row < bitmap.height; ++row)
+    {
+      int y = bitmap.y + row;
+      if (y < 0 || y >= image.height)
+      {
+        continue;
+      }
+      const unsigned char* line = pixels + static_cast<size_t>(bitmap.height - row - 1) * bitmap.bytesPerLine;
+      unsigned char* imageLine = &image.pixels[static_cast<size_t>(y) * image.width];
+      for (int col = 0; col < bitmap.width; ++col)
+      {
+        int x = bitmap.x + col;
+        if (x < 0 || x >= image.width)
+        {
+          continue;
+        }
+        int bitPos = col * bitsPerPixel;
+        int coverage = (line[bitPos / 8] >> (8 - bitsPerPixel - bitPos % 8)) & maxCoverage;
+        if (coverage != 0)
+        {
+          imageLine[x] = static_cast<unsigned char>((background * (maxCoverage - coverage) + foreground * coverage) / maxCoverage);
+        }
+      }
+    }
+  }
+
+  drawRules(false);
+}
+
+void DviScanner::WriteImage(const PageImage& image, const PathName& path)
+{
+  switch (imageFormat)
+  {
+  case ImageFormat::PBM:
+    WritePnm(image, PathName(path).AppendExtension(".pbm"));
+    break;
+  case ImageFormat::PGM:
+    WritePnm(image, PathName(path).AppendExtension(".pgm"));
+    break;
+  case ImageFormat::PNG:
+    WritePng(image, PathName(path).AppendExtension(".png"));
+    break;
+  default:
+    MIKTEX_UNEXPECTED();
+  }
+}
+
+void DviScanner::WritePnm(const PageImage& image, const PathName& path)
+{
+  FileStream stream(File::Open(path, FileMode::Create, FileAccess::Write, false));
+  if (imageFormat == ImageFormat::PBM)
+  {
+    string header = fmt::format("P4\n{0} {1}\n", image.width, image.height);
+    stream.Write(header.c_str(), header.length());
+    vector<unsigned char> line((image.width + 7) / 8);
+    for (int y = 0; y < image.height; ++y)
+    {
+      std::fill(line.begin(), line.end(), 0);
+      const unsigned char* imageLine = &image.pixels[static_cast<size_t>(y) * image.width];
+      for (int x = 0; x < image.width; ++x)
+      {
+        if (imageLine[x] < 128)
+        {
+          line[x / 8] |= 0x80 >> (x % 8);
+        }
+      }
+      stream.Write(line.data(), line.size());
+    }
+  }
+  else
+  {
+    string header = fmt::format("P5\n{0} {1}\n255\n", image.width, image.height);
+    stream.Write(header.c_str(), header.length());
+    stream.Write(image.pixels.data(), image.pixels.size());
+  }
+  stream.Close();
+}
+
+void DviScanner::WritePng(const PageImage& image, const PathName& path)
+{
+  FileStream stream(File::Open(path, FileMode::Create, FileAccess::Write, false));
+  png_structp png = png_create_write_struct(PNG_LIBPNG_VER_STRING, nullptr, nullptr, nullptr);
+  if (png == nullptr)
+  {
+    MIKTEX_UNEXPECTED();
+  }
+  png_infop info = png_create_info_struct(png);
+  if (info == nullptr)
+  {
+    png_destroy_write_struct(&png, nullptr);
+    MIKTEX_UNEXPECTED();
+  }
+  if (setjmp(png_jmpbuf(png)))
+  {
+    png_destroy_write_struct(&png, &info);
+    MIKTEX_FATAL_ERROR_2(T_("The PNG file could not be written."), "path", path.ToString());
+  }
+  png_init_io(png, stream.GetFile());
+  png_set_IHDR(png, info, image.width, image.height, 8, PNG_COLOR_TYPE_GRAY, PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT);
+  png_uint_32 pixelsPerMeter = static_cast<png_uint_32>(resolution / shrinkFactor / 0.0254 + 0.5);
+  png_set_pHYs(png, info, pixelsPerMeter, pixelsPerMeter, PNG_RESOLUTION_METER);
+  png_write_info(png, info);
+  for (int y = 0; y < image.height; ++y)
+  {
+    png_write_row(png, &image.pixels[static_cast<size_t>(y) * image.width]);
+  }
+  png_write_end(png, info);
+  png_destroy_write_struct(&png, &info);
+  stream.Close();
 }
 
 int main(int argc, const char** argv)
@@ -111,7 +111,7 @@ DviSpecialType GraphicsSpecialImpl::Parse()
   {
     float texWidth;
     char unit[3];
-    if (sscanf_s(lpsz, "%f%2s", &texWidth, unit, 3) != 2)
+    if (sscanf(lpsz, "%f%2s", &texWidth, unit) != 2)
     {
       pDviPageImpl->Error(fmt::format(T_("invalid width specification: {0}"), lpsz));
       return DviSpecialType::Unknown;
@@ -132,7 +132,7 @@ DviSpecialType GraphicsSpecialImpl::Parse()
     if (*lpsz != 0)
     {
       float texHeight;
-      if (sscanf_s(lpsz, "%f%2s", &texHeight, unit, 3) != 2)
+      if (sscanf(lpsz, "%f%2s", &texHeight, unit) != 2)
       {
         pDviPageImpl->Error(fmt::format(T_("invalid width specification: {0}"), lpsz));
         return DviSpecialType::Unknown;
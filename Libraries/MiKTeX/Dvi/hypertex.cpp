@@ -24,6 +24,8 @@
 #include <fmt/format.h>
 #include <fmt/ostream.h>
 
+#include <miktex/Util/inliners.h>
+
 #include "internal.h"
 
 HyperTeXSpecialImpl::State HyperTeXSpecialImpl::state;
@@ -45,12 +47,12 @@ DviSpecial* DviImpl::ProcessHtmlSpecial(DviPageImpl* ppage, int x, int y, const
   {
     return new DviSpecialObject<HyperTeXSpecialImpl>(ppage, x, y, specialSpec);
   }
-  else if (_strnicmp(lpsz, "img", 3) == 0 && (lpsz[3] == ' ' || lpsz[3] == '\t'))
+  else if (CeeStringCompare(lpsz, "img", 3, true) == 0 && (lpsz[3] == ' ' || lpsz[3] == '\t'))
   {
     trace_error->WriteLine("libdvi", T_("img not yet supported"));
     return 0;
   }
-  else if ((_strnicmp(lpsz, "base", 4) == 0 && (lpsz[4] == ' ' || lpsz[4] == '\t'))
+  else if ((CeeStringCompare(lpsz, "base", 4, true) == 0 && (lpsz[4] == ' ' || lpsz[4] == '\t'))
     || tolower(*lpsz) == 'a' && (lpsz[1] == ' ' || lpsz[1] == '\t'))
   {
     bool isBaseUrl = (tolower(*lpsz) == 'b');
@@ -68,12 +70,12 @@ DviSpecial* DviImpl::ProcessHtmlSpecial(DviPageImpl* ppage, int x, int y, const
     }
     HyperTeXSpecialImpl::state.isName = false;
     HyperTeXSpecialImpl::state.isHref = false;
-    if (_strnicmp(lpsz, "name", 4) == 0)
+    if (CeeStringCompare(lpsz, "name", 4, true) == 0)
     {
       lpsz += 4;
       HyperTeXSpecialImpl::state.isName = true;
     }
-    else if (_strnicmp(lpsz, "href", 4) == 0)
+    else if (CeeStringCompare(lpsz, "href", 4, true) == 0)
     {
       lpsz += 4;
       HyperTeXSpecialImpl::state.isHref = true;
@@ -52,7 +52,9 @@
 #include <miktex/Util/PathName>
 #include <miktex/Core/Session>
 
+#if defined(MIKTEX_WINDOWS)
 #include <miktex/Graphics/DibChunker>
+#endif
 
 #include <miktex/Trace/TraceCallback>
 
@@ -409,6 +411,7 @@ public:
   virtual bool MIKTEXTHISCALL GetBoundingBox(int shrinkFactor, int& left, int& bottom, int& right, int& top) = 0;
 };
 
+#if defined(MIKTEX_WINDOWS)
 class MIKTEXNOVTABLE GraphicsInclusion
 {
 public:
@@ -417,6 +420,7 @@ public:
 public:
   virtual void MIKTEXTHISCALL Render(HDC hdc) = 0;
 };
+#endif
 
 struct DviBitmap
 {
@@ -470,20 +474,24 @@ public:
 public:
   virtual HypertexSpecial* MIKTEXTHISCALL GetNextHyperref(int& idx) = 0;
 
+#if defined(MIKTEX_WINDOWS)
 public:
   virtual std::shared_ptr<MiKTeX::Graphics::DibChunk> MIKTEXTHISCALL GetDibChunk(int shrinkFactor, int idx) = 0;
 
 public:
   virtual int MIKTEXTHISCALL GetNumberOfDibChunks(int shrinkFactor) = 0;
+#endif
 
 public:
   virtual DviPageMode MIKTEXTHISCALL GetDviPageMode() = 0;
 
+#if defined(MIKTEX_WINDOWS)
 public:
   virtual int MIKTEXTHISCALL GetNumberOfGraphicsInclusions(int shrinkFactor) = 0;
 
 public:
   virtual std::shared_ptr<GraphicsInclusion> MIKTEXTHISCALL GetGraphicsInclusion(int shrinkFactor, int idx) = 0;
+#endif
 
 };
 
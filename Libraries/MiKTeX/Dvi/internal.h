@@ -20,8 +20,12 @@
    USA.  */
 
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <mutex>
 #include <stack>
+#include <thread>
+#include <vector>
 
 #include <fmt/format.h>
 #include <fmt/ostream.h>
@@ -42,7 +46,9 @@ using namespace std::string_literals;
 using namespace MiKTeX::Configuration;
 using namespace MiKTeX::Core;
 using namespace MiKTeX::DVI;
+#if defined(MIKTEX_WINDOWS)
 using namespace MiKTeX::Graphics;
+#endif
 using namespace MiKTeX::Trace;
 using namespace MiKTeX::Util;
 
@@ -51,7 +57,9 @@ class DviImpl;
 
 #define DEFAULT_PAGE_MODE DviPageMode::Pk
 
+#if defined(MIKTEX_WINDOWS)
 #include "Dib.h"
+#endif
 
 #if !defined(UNUSED)
 #  if !defined(NDEBUG)
@@ -89,6 +97,12 @@ class DviImpl;
 #define END_CRITICAL_SECTION()                          \
   }
 
+#if !defined(MIKTEX_WINDOWS)
+#define RGB(r, g, b) \
+  (static_cast<unsigned long>(static_cast<unsigned char>(r)) \
+   | (static_cast<unsigned long>(static_cast<unsigned char>(g)) << 8) \
+   | (static_cast<unsigned long>(static_cast<unsigned char>(b)) << 16))
+#endif
 
 struct DviPoint
 {
@@ -104,6 +118,7 @@ public:
   int y;
 };
 
+#if defined(MIKTEX_WINDOWS)
 enum class ImageType
 {
   None,
@@ -221,6 +236,7 @@ private:
 private:
   int cy = -1;
 };
+#endif
 
 class StdoutReader :
   public IRunProcessCallback
@@ -244,19 +260,24 @@ typedef unordered_map<int, DviPoint> MAPNUMTOPOINT;
 
 typedef unordered_map<int, vector<DviBitmap> > MAPNUMTOBITMAPVEC;
 
+#if defined(MIKTEX_WINDOWS)
 typedef unordered_map<int, vector<shared_ptr<DibChunk> > > MAPNUMTODIBCHUNKVEC;
+#endif
 
 typedef unordered_map<string, unique_ptr<TemporaryFile> > TempFileCollection;
 
+#if defined(MIKTEX_WINDOWS)
 typedef unordered_map<int, vector<shared_ptr<GraphicsInclusion> > > MAPNUMTOGRINCVEC;
+#endif
 
-#include "Dib.h"
 #include "DviChar.h"
 #include "DviFont.h"
+#if defined(MIKTEX_WINDOWS)
 #include "Ghostscript.h"
+#endif
+#include "PkRaster.h"
 #include "PkChar.h"
 #include "PkFont.h"
-#include "PostScript.h"
 #include "Tfm.h"
 #include "VFont.h"
 #include "VfChar.h"
@@ -388,7 +409,7 @@ public:
   InputStream(const char* fileName);
 
 public:
-  InputStream(const BYTE* pBytes, size_t nBytes);
+  InputStream(const unsigned char* pBytes, size_t nBytes);
 
 public:
   ~InputStream();
@@ -626,8 +647,10 @@ private:
 };
 
 class DviPageImpl :
-  public DviPage,
-  public IDibChunkerCallback
+  public DviPage
+#if defined(MIKTEX_WINDOWS)
+  , public IDibChunkerCallback
+#endif
 {
 public:
   const DviBitmap& MIKTEXTHISCALL GetDviBitmap(int shrinkFactor, int idx) override;
@@ -659,11 +682,13 @@ public:
 public:
   HypertexSpecial* MIKTEXTHISCALL GetNextHyperref(int& idx) override;
 
+#if defined(MIKTEX_WINDOWS)
 public:
   shared_ptr<DibChunk> MIKTEXTHISCALL GetDibChunk(int shrinkFactor, int idx) override;
 
 public:
   int MIKTEXTHISCALL GetNumberOfDibChunks(int shrinkFactor) override;
+#endif
 
 public:
   DviPageMode MIKTEXTHISCALL GetDviPageMode() override
@@ -671,11 +696,13 @@ public:
     return pageMode;
   }
 
+#if defined(MIKTEX_WINDOWS)
 public:
   int MIKTEXTHISCALL GetNumberOfGraphicsInclusions(int shrinkFactor) override;
 
 public:
   shared_ptr<GraphicsInclusion> MIKTEXTHISCALL GetGraphicsInclusion(int shrinkFactor, int idx) override;
+#endif
 
 public:
   DviImpl* GetDviObject();
@@ -778,6 +805,7 @@ private:
 private:
   void DestroyDviBitmaps();
 
+#if defined(MIKTEX_WINDOWS)
 private:
   void DestroyDibChunks();
 
@@ -801,6 +829,7 @@ public:
 
 private:
   unique_ptr<Process> StartGhostscript(int shrinkFactor);
+#endif
 
 private:
   int GetReadPosition()
@@ -814,11 +843,13 @@ private:
 private:
   inline int WidthShrink(int shrinkFactor, int pxl); // FIXME
 
+#if defined(MIKTEX_WINDOWS)
 private:
   void DoPostScriptSpecials(int shrinkFactor);
 
 private:
   void DoGraphicsSpecials(int shrinkFactor);
+#endif
 
 private:
   shared_ptr<Session> session = MIKTEX_SESSION();
@@ -859,11 +890,13 @@ private:
 private:
   MAPNUMTOBOOL haveShrinkedRaster;
 
+#if defined(MIKTEX_WINDOWS)
 private:
   MAPNUMTOBOOL haveGraphicsInclusions;
 
 private:
   MAPNUMTOGRINCVEC graphicsInclusions;
+#endif
 
 private:
   time_t lastVisited;
@@ -877,6 +910,7 @@ private:
 private:
   MAPNUMTOBITMAPVEC shrinkedDviBitmaps;
 
+#if defined(MIKTEX_WINDOWS)
 private:
   MAPNUMTODIBCHUNKVEC shrinkedDibChunks;
 
@@ -888,6 +922,7 @@ private:
 
 private:
   string gsTranscript;
+#endif
 
 private:
   DviImpl* dviImpl;
@@ -896,7 +931,7 @@ private:
   mutex pageMutex;
 
 private:
-  size_t size = 0;
+  atomic_size_t size = 0;
 
 private:
   bool autoClean = false;
@@ -907,6 +942,7 @@ private:
 private:
   DviPageMode pageMode;
 
+#if defined(MIKTEX_WINDOWS)
 private:
   FileStream dvipsOut;
 
@@ -918,9 +954,11 @@ private:
 
 private:
   FileStream gsErr;
+#endif
 
+  // bitmaps of different pages are made concurrently
 private:
-  static size_t totalSize;
+  static atomic_size_t totalSize;
 
 private:
   friend DviImpl; // FIXME
@@ -1129,7 +1167,7 @@ public:
   bool FindGraphicsFile(const char* fileName, PathName& result);
 
 private:
-  bool InterpretSpecial(DviPageImpl* dviPage, int x, int y, InputStream& inputstream, DWORD p, DviSpecial*& special);
+  bool InterpretSpecial(DviPageImpl* dviPage, int x, int y, InputStream& inputstream, unsigned long p, DviSpecial*& special);
 
 private:
   bool SetCurrentColor(const char* colorSpec);
@@ -1200,21 +1238,38 @@ private:
 private:
   void PageLoader();
 
+private:
+  bool IsBackgroundThread();
+
+private:
+  bool WaitForByeBye(unsigned long milliseconds);
+
 private:
   shared_ptr<Session> session = MIKTEX_SESSION();
 
+  // protects byeBye, newPage and scanned
+private:
+  mutex eventMutex;
+
+private:
+  condition_variable eventCondition;
+
 private:
-  HANDLE hByeByeEvent;
+  atomic_bool byeBye = false;
 
 private:
-  HANDLE hNewPageEvent;
+  bool newPage = false;
 
 private:
-  HANDLE hScannedEvent;
+  bool scanned = false;
 
 private:
   int currentPageIdx = -1;
 
+  // the next page to be loaded by a page loader thread
+private:
+  int nextPageIdx = 0;
+
 private:
   int direction = 1;
 
@@ -1240,7 +1295,7 @@ private:
   thread garbageCollectorThread;
 
 private:
-  thread pageLoaderThread;
+  vector<thread> pageLoaderThreads;
 
   // resolution in dots per inch
 private:
@@ -1454,38 +1509,38 @@ public:
 public:
   int MIKTEXTHISCALL GetX() override
   {
-    return x;
+    return this->x;
   }
 
 public:
   int MIKTEXTHISCALL GetY() override
   {
-    return y;
+    return this->y;
   }
 
 public:
   const char* MIKTEXTHISCALL GetXXX() override
   {
-    return specialString.c_str();
+    return this->specialString.c_str();
   }
 
 public:
   DviSpecialType MIKTEXTHISCALL GetType() override
   {
-    return specialType;
+    return this->specialType;
   }
 
 public:
   DviSpecialObject(DviPageImpl* ppage, int x, int y, const char* specialSpec)
   {
-    pDviPageImpl = ppage;
+    this->pDviPageImpl = ppage;
     this->x = x;
     this->y = y;
     if (specialSpec != nullptr)
     {
-      specialString = specialSpec;
+      this->specialString = specialSpec;
     }
-    specialType = Parse();
+    this->specialType = this->Parse();
   }
 };
 
@@ -1616,7 +1671,7 @@ class MIKTEXNOVTABLE TpicSpecialRoot :
   public SpecialRoot
 {
 public:
-  static TpicContext TpicSpecialRoot::tpicContext;
+  static TpicContext tpicContext;
 };
 
 template<class T> class MIKTEXNOVTABLE TpicSpecialObject :
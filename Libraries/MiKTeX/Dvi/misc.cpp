@@ -65,7 +65,7 @@ InputStream::InputStream(const char* fileName) :
 {
 }
 
-InputStream::InputStream(const BYTE* pBytes, size_t nBytes)
+InputStream::InputStream(const unsigned char* pBytes, size_t nBytes)
 {
   this->pBytes = new char[nBytes];
   this->nBytes = nBytes;
@@ -246,6 +246,7 @@ int ScaleFix(int tfm, int z)
   return tfm;
 }
 
+#if defined(MIKTEX_WINDOWS)
 GraphicsInclusion::~GraphicsInclusion()
 {
 }
@@ -351,3 +352,4 @@ HENHMETAFILE GraphicsInclusionImpl::LoadEnhMetaFile(const PathName& fileName)
 
   return hEmf;
 }
+#endif
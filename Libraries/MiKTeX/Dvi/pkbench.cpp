@@ -0,0 +1,478 @@
+/* pkbench.cpp: PK glyph raster micro-benchmark
+
+   Copyright (C) 2024 Christian Schenk
+
+   This file is part of the MiKTeX DVI Library.
+
+   The MiKTeX DVI Library is free software; you can redistribute it
+   and/or modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2, or (at your option) any later version.
+
+   The MiKTeX DVI Library is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public
+   License along with the MiKTeX DVI Library; if not, write to the
+   Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139,
+   USA.  */
+
+/* Measures the PkRaster kernels against the bit-by-bit code they
+   replaced, on the characters of the given PK files, e.g.:
+
+     pkbench --output=results.json .../ljfour/public/cm/dpi600/cm*.pk
+
+   The outputs of both implementations are compared; the exit code is 1,
+   if they differ. */
+
+#include <cstdlib>
+#include <cstring>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "PkRaster.h"
+#include "PkReference.h"
+
+using namespace std;
+
+const int minShrinkFactor = 2;
+
+const int maxShrinkFactor = 8;
+
+struct BenchmarkResult
+{
+  string name;
+  size_t iterations = 0;
+  double seconds = 0.0;
+  size_t errors = 0;
+};
+
+
+class Benchmark
+{
+public:
+  int Main(int argc, const char** argv);
+
+private:
+  void ReadPkFile(const string& fileName);
+
+private:
+  void Measure(const string& name, const function<void()>& func);
+
+private:
+  void Compare(const string& name, const vector<unsigned char>& expected, const vector<unsigned char>& actual);
+
+private:
+  void RunUnpackBenchmarks();
+
+private:
+  void RunShrinkBenchmarks(int shrinkFactor);
+
+private:
+  void WriteResults(ostream& stream) const;
+
+private:
+  size_t iterations = 20;
+
+private:
+  vector<Glyph> glyphs;
+
+private:
+  vector<BenchmarkResult> results;
+};
+
+namespace {
+
+  class PkReader
+  {
+  public:
+    PkReader(const vector<unsigned char>& data) :
+      data(data)
+    {
+    }
+
+  public:
+    bool AtEnd() const
+    {
+      return pos >= data.size();
+    }
+
+  public:
+    int ReadByte()
+    {
+      if (pos >= data.size())
+      {
+        throw runtime_error("unexpected end of PK file");
+      }
+      return data[pos++];
+    }
+
+  public:
+    int ReadSignedByte()
+    {
+      return static_cast<signed char>(ReadByte());
+    }
+
+  public:
+    int ReadPair()
+    {
+      int b = ReadByte();
+      return (b << 8) | ReadByte();
+    }
+
+  public:
+    int ReadSignedPair()
+    {
+      return static_cast<short>(ReadPair());
+    }
+
+  public:
+    int ReadTrio()
+    {
+      int b = ReadPair();
+      return (b << 8) | ReadByte();
+    }
+
+  public:
+    int ReadSignedQuad()
+    {
+      unsigned b = ReadTrio();
+      return static_cast<int>((b << 8) | ReadByte());
+    }
+
+  public:
+    void Skip(size_t n)
+    {
+      pos += n;
+    }
+
+  public:
+    void Read(vector<unsigned char>& bytes, size_t n)
+    {
+      if (pos + n > data.size())
+      {
+        throw runtime_error("unexpected end of PK file");
+      }
+      bytes.assign(data.begin() + pos, data.begin() + pos + n);
+      pos += n;
+    }
+
+  private:
+    const vector<unsigned char>& data;
+
+  private:
+    size_t pos = 0;
+  };
+
+}
+
+void Benchmark::ReadPkFile(const string& fileName)
+{
+  ifstream stream(fileName, ios_base::binary);
+  if (!stream)
+  {
+    throw runtime_error(fileName + ": cannot open file");
+  }
+  vector<unsigned char> data((istreambuf_iterator<char>(stream)), istreambuf_iterator<char>());
+  PkReader reader(data);
+  while (!reader.AtEnd())
+  {
+    int flag = reader.ReadByte();
+    if (flag >= 240)
+    {
+      switch (flag)
+      {
+      case 240: // pk_xxx1
+        reader.Skip(reader.ReadByte());
+        break;
+      case 241:
+        reader.Skip(reader.ReadPair());
+        break;
+      case 242:
+        reader.Skip(reader.ReadTrio());
+        break;
+      case 243:
+        reader.Skip(reader.ReadSignedQuad());
+        break;
+      case 244: // pk_yyy
+        reader.Skip(4);
+        break;
+      case 247: // pk_pre
+        reader.ReadByte();
+        reader.Skip(reader.ReadByte() + 16);
+        break;
+      default:
+        break;
+      }
+      continue;
+    }
+    Glyph glyph;
+    glyph.flag = flag;
+    int packetSize;
+    if ((flag & 7) < 4)
+    {
+      packetSize = (((flag & 7) % 4) << 8 | reader.ReadByte()) - 8;
+      reader.Skip(5);
+      glyph.width = reader.ReadByte();
+      glyph.height = reader.ReadByte();
+      glyph.cxOffset = reader.ReadSignedByte();
+      glyph.cyOffset = reader.ReadSignedByte();
+    }
+    else if ((flag & 7) < 7)
+    {
+      packetSize = (((flag & 7) % 4) << 16 | reader.ReadPair()) - 13;
+      reader.Skip(6);
+      glyph.width = reader.ReadPair();
+      glyph.height = reader.ReadPair();
+      glyph.cxOffset = reader.ReadSignedPair();
+      glyph.cyOffset = reader.ReadSignedPair();
+    }
+    else
+    {
+      packetSize = reader.ReadSignedQuad() - 28;
+      reader.Skip(16);
+      glyph.width = reader.ReadSignedQuad();
+      glyph.height = reader.ReadSignedQuad();
+      glyph.cxOffset = reader.ReadSignedQuad();
+      glyph.cyOffset = reader.ReadSignedQuad();
+    }
+    reader.Read(glyph.packedRaster, packetSize);
+    if (glyph.width > 0 && glyph.height > 0)
+    {
+      glyph.raster.resize(static_cast<size_t>(PkRaster::GetRasterWordsPerLine(glyph.width)) * glyph.height);
+      if (!PkRaster::Unpack(glyph.packedRaster.data(), glyph.packedRaster.size(), glyph.flag, glyph.width, glyph.height, glyph.raster.data()))
+      {
+        throw runtime_error(fileName + ": bad packed raster");
+      }
+      glyphs.push_back(glyph);
+    }
+  }
+}
+
+void Benchmark::Measure(const string& name, const function<void()>& func)
+{
+  BenchmarkResult result;
+  result.name = name;
+  result.iterations = iterations * glyphs.size();
+  chrono::steady_clock::time_point start = chrono::steady_clock::now();
+  for (size_t i = 0; i < iterations; ++i)
+  {
+    func();
+  }
+  result.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+  results.push_back(result);
+}
+
+void Benchmark::Compare(const string& name, const vector<unsigned char>& expected, const vector<unsigned char>& actual)
+{
+  if (expected != actual)
+  {
+    for (BenchmarkResult& r : results)
+    {
+      if (r.name == name)
+      {
+        r.errors++;
+      }
+    }
+  }
+}
+
+void Benchmark::RunUnpackBenchmarks()
+{
+  size_t totalSize = 0;
+  for (const Glyph& glyph : glyphs)
+  {
+    totalSize = std::max(totalSize, glyph.raster.size());
+  }
+  vector<RasterWord> raster(totalSize);
+  Measure("unpack/reference", [&]()
+  {
+    for (const Glyph& glyph : glyphs)
+    {
+      Reference::Unpack(glyph, raster.data());
+    }
+  });
+  Measure("unpack/pkraster", [&]()
+  {
+    for (const Glyph& glyph : glyphs)
+    {
+      PkRaster::Unpack(glyph.packedRaster.data(), glyph.packedRaster.size(), glyph.flag, glyph.width, glyph.height, raster.data());
+    }
+  });
+  for (const Glyph& glyph : glyphs)
+  {
+    Reference::Unpack(glyph, raster.data());
+    if (!equal(glyph.raster.begin(), glyph.raster.end(), raster.begin()))
+    {
+      results.back().errors++;
+    }
+  }
+}
+
+void Benchmark::RunShrinkBenchmarks(int shrinkFactor)
+{
+  int bpp = shrinkFactor == 1 ? 1 : bitsPerPixel;
+  vector<size_t> offsets;
+  vector<size_t> bytesPerLine;
+  vector<int> sampleWidths;
+  vector<int> sampleHeights;
+  size_t totalSize = 0;
+  for (const Glyph& glyph : glyphs)
+  {
+    int widthShr = shrinkFactor == 1 ? glyph.width : (glyph.width + shrinkFactor - 1) / shrinkFactor + 1;
+    int heightShr = shrinkFactor == 1 ? glyph.height : (glyph.height + shrinkFactor - 1) / shrinkFactor + 1;
+    int sampleWidth = (glyph.cxOffset + 1) - ((glyph.cxOffset + 1) / shrinkFactor) * shrinkFactor;
+    int sampleHeight = (glyph.cyOffset + 1) - ((glyph.cyOffset + 1) / shrinkFactor) * shrinkFactor;
+    offsets.push_back(totalSize);
+    bytesPerLine.push_back(((widthShr * bpp + 31) / 32) * 4);
+    sampleWidths.push_back(sampleWidth <= 0 ? sampleWidth + shrinkFactor : sampleWidth);
+    sampleHeights.push_back(sampleHeight <= 0 ? sampleHeight + shrinkFactor : sampleHeight);
+    totalSize += heightShr * bytesPerLine.back();
+  }
+  vector<unsigned char> expected(totalSize);
+  vector<unsigned char> actual(totalSize);
+  string name = "shrink" + to_string(shrinkFactor);
+  Measure(name + "/reference", [&]()
+  {
+    fill(expected.begin(), expected.end(), 0);
+    for (size_t idx = 0; idx < glyphs.size(); ++idx)
+    {
+      if (shrinkFactor == 1)
+      {
+        Reference::CopyBits(glyphs[idx], &expected[offsets[idx]], bytesPerLine[idx]);
+      }
+      else
+      {
+        Reference::BoxFilter(glyphs[idx], shrinkFactor, sampleWidths[idx], sampleHeights[idx], &expected[offsets[idx]], bytesPerLine[idx]);
+      }
+    }
+  });
+  Measure(name + "/pkraster", [&]()
+  {
+    fill(actual.begin(), actual.end(), 0);
+    for (size_t idx = 0; idx < glyphs.size(); ++idx)
+    {
+      const Glyph& glyph = glyphs[idx];
+      if (shrinkFactor == 1)
+      {
+        PkRaster::CopyBits(glyph.raster.data(), glyph.width, glyph.height, &actual[offsets[idx]], bytesPerLine[idx]);
+      }
+      else
+      {
+        PkRaster::BoxFilter(glyph.raster.data(), glyph.width, glyph.height, shrinkFactor, sampleWidths[idx], sampleHeights[idx], bpp, &actual[offsets[idx]], bytesPerLine[idx]);
+      }
+    }
+  });
+  Compare(name + "/pkraster", expected, actual);
+}
+
+void Benchmark::WriteResults(ostream& stream) const
+{
+  stream
+    << "{\n"
+    << "  \"suite\": \"miktex-dvi-pkraster\",\n"
+    << "  \"glyphs\": " << glyphs.size() << ",\n"
+    << "  \"results\": [\n";
+  for (size_t idx = 0; idx < results.size(); ++idx)
+  {
+    const BenchmarkResult& r = results[idx];
+    double nsPerOp = r.iterations > 0 ? r.seconds * 1e9 / r.iterations : 0.0;
+    stream
+      << "    { \"name\": \"" << r.name << "\""
+      << ", \"iterations\": " << r.iterations
+      << fixed
+      << ", \"seconds\": " << setprecision(6) << r.seconds
+      << ", \"ns_per_op\": " << setprecision(1) << nsPerOp
+      << ", \"errors\": " << r.errors
+      << " }" << (idx + 1 < results.size() ? "," : "") << "\n";
+  }
+  stream
+    << "  ]\n"
+    << "}\n";
+}
+
+int Benchmark::Main(int argc, const char** argv)
+{
+  string outputFile;
+  vector<string> fileNames;
+  for (int idx = 1; idx < argc; ++idx)
+  {
+    string arg = argv[idx];
+    if (arg.compare(0, 13, "--iterations=") == 0)
+    {
+      iterations = std::max(atoi(arg.c_str() + 13), 1);
+    }
+    else if (arg.compare(0, 9, "--output=") == 0)
+    {
+      outputFile = arg.substr(9);
+    }
+    else if (arg.compare(0, 2, "--") == 0)
+    {
+      cerr << "usage: pkbench [--iterations=N] [--output=FILE] PKFILE..." << endl;
+      return 1;
+    }
+    else
+    {
+      fileNames.push_back(arg);
+    }
+  }
+  if (fileNames.empty())
+  {
+    cerr << "usage: pkbench [--iterations=N] [--output=FILE] PKFILE..." << endl;
+    return 1;
+  }
+  try
+  {
+    Reference::Init();
+    for (const string& fileName : fileNames)
+    {
+      ReadPkFile(fileName);
+    }
+    RunUnpackBenchmarks();
+    RunShrinkBenchmarks(1);
+    for (int shrinkFactor = minShrinkFactor; shrinkFactor <= maxShrinkFactor; ++shrinkFactor)
+    {
+      RunShrinkBenchmarks(shrinkFactor);
+    }
+  }
+  catch (const exception& ex)
+  {
+    cerr << ex.what() << endl;
+    return 1;
+  }
+  if (outputFile.empty())
+  {
+    WriteResults(cout);
+  }
+  else
+  {
+    ofstream stream(outputFile);
+    WriteResults(stream);
+  }
+  for (const BenchmarkResult& r : results)
+  {
+    if (r.errors > 0)
+    {
+      cerr << r.name << ": output differs from the reference implementation" << endl;
+      return 1;
+    }
+  }
+  return 0;
+}
+
+int main(int argc, const char** argv)
+{
+  Benchmark benchmark;
+  return benchmark.Main(argc, argv);
+}
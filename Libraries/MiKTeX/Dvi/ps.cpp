@@ -21,6 +21,9 @@
 
 #include "config.h"
 
+#include <miktex/Util/StringUtil>
+#include <miktex/Util/inliners.h>
+
 #include "internal.h"
 
 DviSpecialType PsdefSpecialImpl::Parse()
@@ -206,18 +209,18 @@ DviSpecialType PsfileSpecialImpl::Parse()
 
   CharBuffer<char> autoBuffer(specialString.length() + 1);
   char* specialSpec = autoBuffer.GetData();
-  strcpy_s(specialSpec, specialString.length() + 1, GetXXX());
+  StringUtil::CopyCeeString(specialSpec, specialString.length() + 1, GetXXX());
   pair<char*, char*> keyVal;
   while (*specialSpec && getkv(specialSpec, keyVal))
   {
-    if (_strcmpi(keyVal.first, "psfile") == 0)
+    if (CeeStringCompare(keyVal.first, "psfile", true) == 0)
     {
       if (keyVal.second != nullptr)
       {
         fileName = keyVal.second;
       }
     }
-    else if (_strcmpi(keyVal.first, "hsize") == 0)
+    else if (CeeStringCompare(keyVal.first, "hsize", true) == 0)
     {
       if (keyVal.second != nullptr)
       {
@@ -225,7 +228,7 @@ DviSpecialType PsfileSpecialImpl::Parse()
         hasHSize = true;
       }
     }
-    else if (_strcmpi(keyVal.first, "vsize") == 0)
+    else if (CeeStringCompare(keyVal.first, "vsize", true) == 0)
     {
       if (keyVal.second != nullptr)
       {
@@ -233,7 +236,7 @@ DviSpecialType PsfileSpecialImpl::Parse()
         hasVSize = true;
       }
     }
-    else if (_strcmpi(keyVal.first, "hoffset") == 0)
+    else if (CeeStringCompare(keyVal.first, "hoffset", true) == 0)
     {
       if (keyVal.second != nullptr)
       {
@@ -241,7 +244,7 @@ DviSpecialType PsfileSpecialImpl::Parse()
         hasHOffset = true;
       }
     }
-    else if (_strcmpi(keyVal.first, "voffset") == 0)
+    else if (CeeStringCompare(keyVal.first, "voffset", true) == 0)
     {
       if (keyVal.second != nullptr)
       {
@@ -249,7 +252,7 @@ DviSpecialType PsfileSpecialImpl::Parse()
         hasVOffset = true;
       }
     }
-    else if (_strcmpi(keyVal.first, "hscale") == 0)
+    else if (CeeStringCompare(keyVal.first, "hscale", true) == 0)
     {
       if (keyVal.second != nullptr)
       {
@@ -257,7 +260,7 @@ DviSpecialType PsfileSpecialImpl::Parse()
         hasHSale = true;
       }
     }
-    else if (_strcmpi(keyVal.first, "vscale") == 0)
+    else if (CeeStringCompare(keyVal.first, "vscale", true) == 0)
     {
       if (keyVal.second != nullptr)
       {
@@ -265,7 +268,7 @@ DviSpecialType PsfileSpecialImpl::Parse()
         hasVScale = true;
       }
     }
-    else if (_strcmpi(keyVal.first, "angle") == 0)
+    else if (CeeStringCompare(keyVal.first, "angle", true) == 0)
     {
       if (keyVal.second != nullptr)
       {
@@ -273,7 +276,7 @@ DviSpecialType PsfileSpecialImpl::Parse()
         hasAngle = true;
       }
     }
-    else if (_strcmpi(keyVal.first, "llx") == 0)
+    else if (CeeStringCompare(keyVal.first, "llx", true) == 0)
     {
       if (keyVal.second != nullptr)
       {
@@ -281,7 +284,7 @@ DviSpecialType PsfileSpecialImpl::Parse()
         hasLlx = true;
       }
     }
-    else if (_strcmpi(keyVal.first, "lly") == 0)
+    else if (CeeStringCompare(keyVal.first, "lly", true) == 0)
     {
       if (keyVal.second != nullptr)
       {
@@ -289,7 +292,7 @@ DviSpecialType PsfileSpecialImpl::Parse()
         hasLLy = true;
       }
     }
-    else if (_strcmpi(keyVal.first, "urx") == 0)
+    else if (CeeStringCompare(keyVal.first, "urx", true) == 0)
     {
       if (keyVal.second != nullptr)
       {
@@ -297,7 +300,7 @@ DviSpecialType PsfileSpecialImpl::Parse()
         hasUrx = true;
       }
     }
-    else if (_strcmpi(keyVal.first, "ury") == 0)
+    else if (CeeStringCompare(keyVal.first, "ury", true) == 0)
     {
       if (keyVal.second != nullptr)
       {
@@ -305,7 +308,7 @@ DviSpecialType PsfileSpecialImpl::Parse()
         hasUry = true;
       }
     }
-    else if (_strcmpi(keyVal.first, "rwi") == 0)
+    else if (CeeStringCompare(keyVal.first, "rwi", true) == 0)
     {
       if (keyVal.second != nullptr)
       {
@@ -313,7 +316,7 @@ DviSpecialType PsfileSpecialImpl::Parse()
         hasRwi = true;
       }
     }
-    else if (_strcmpi(keyVal.first, "rhi") == 0)
+    else if (CeeStringCompare(keyVal.first, "rhi", true) == 0)
     {
       if (keyVal.second != nullptr)
       {
@@ -321,7 +324,7 @@ DviSpecialType PsfileSpecialImpl::Parse()
         hasRhi = true;
       }
     }
-    else if (_strcmpi(keyVal.first, "clip") == 0)
+    else if (CeeStringCompare(keyVal.first, "clip", true) == 0)
     {
       isClipped = true;
       hasClipFlag = true;
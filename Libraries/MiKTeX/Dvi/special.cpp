@@ -259,7 +259,7 @@ bool DviImpl::InterpretSpecial(DviPageImpl* dviPage, int x, int y, InputStream&
   case 'p':
     if (strncmp(specialSpec, "pn", 2) == 0)
     {
-      if (sscanf_s(specialSpec, "pn %d", &TpicSpecialRoot::tpicContext.penSize) != 1)
+      if (sscanf(specialSpec, "pn %d", &TpicSpecialRoot::tpicContext.penSize) != 1)
       {
         trace_error->WriteLine("libdvi", fmt::format(T_("bad pn special: {0}"), specialSpec));
       }
@@ -278,7 +278,7 @@ bool DviImpl::InterpretSpecial(DviPageImpl* dviPage, int x, int y, InputStream&
     else if (strncmp(specialSpec, "pa", 2) == 0)
     {
       TpicSpecial::point p;
-      if (sscanf_s(specialSpec, "pa %d %d", &p.x, &p.y) != 2)
+      if (sscanf(specialSpec, "pa %d %d", &p.x, &p.y) != 2)
       {
         trace_error->WriteLine("libdvi", fmt::format(T_("bad pa special: {0}"), specialSpec));
       }
@@ -307,7 +307,7 @@ bool DviImpl::InterpretSpecial(DviPageImpl* dviPage, int x, int y, InputStream&
     }
     else if (strncmp(specialSpec, "sh", 2) == 0)
     {
-      if (sscanf_s(specialSpec, "sh %f", &TpicSpecialRoot::tpicContext.shade) != 2)
+      if (sscanf(specialSpec, "sh %f", &TpicSpecialRoot::tpicContext.shade) != 2)
       {
         trace_error->WriteLine("libdvi", fmt::format(T_("bad sh special: {0}"), specialSpec));
       }
@@ -0,0 +1,37 @@
+## compare.cmake: render DVI_FILE serially and in parallel
+##
+## Copyright (C) 2024 Christian Schenk
+##
+## This file is free software; the copyright holder gives
+## unlimited permission to copy and/or distribute it, with or
+## without modifications, as long as this notice is preserved.
+
+## The page images must not depend on the number of threads: papersize
+## and landscape specials affect the following pages.
+
+foreach(n 1 4)
+  file(REMOVE_RECURSE dviscan-${n})
+  execute_process(
+    COMMAND ${DVISCAN} --format=pbm --threads=${n} --output-directory=dviscan-${n} ${DVI_FILE}
+    RESULT_VARIABLE result
+  )
+  if(NOT result EQUAL 0)
+    message(FATAL_ERROR "dviscan --threads=${n} failed: ${result}")
+  endif()
+endforeach()
+
+file(GLOB images RELATIVE ${CMAKE_CURRENT_BINARY_DIR}/dviscan-1 ${CMAKE_CURRENT_BINARY_DIR}/dviscan-1/*.pbm)
+list(LENGTH images count)
+if(NOT count EQUAL PAGES)
+  message(FATAL_ERROR "expected ${PAGES} page images, got ${count}")
+endif()
+
+foreach(image ${images})
+  execute_process(
+    COMMAND ${CMAKE_COMMAND} -E compare_files dviscan-1/${image} dviscan-4/${image}
+    RESULT_VARIABLE result
+  )
+  if(NOT result EQUAL 0)
+    message(FATAL_ERROR "${image} differs")
+  endif()
+endforeach()
@@ -0,0 +1,104 @@
+/* pkraster.cpp: PK raster kernel tests
+
+   Copyright (C) 2024 Christian Schenk
+
+   This file is part of the MiKTeX DVI Library.
+
+   The MiKTeX DVI Library is free software; you can redistribute it
+   and/or modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2, or (at your option) any later version.
+
+   The MiKTeX DVI Library is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public
+   License along with the MiKTeX DVI Library; if not, write to the
+   Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139,
+   USA.  */
+
+/* Feeds valid and corrupt packets to PkRaster::Unpack.  Corrupt
+   packets must be rejected without touching memory outside of the
+   raster (best checked with a sanitizer build). */
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "PkRaster.h"
+
+using namespace std;
+
+typedef PkRaster::RasterWord RasterWord;
+
+// dyn_f = 13, first run is black
+const int flagBlack = 0xd8;
+
+int failures = 0;
+
+void Check(const string& name, bool expected, const vector<unsigned char>& packet, int flag, int width, int height, const vector<RasterWord>& expectedRaster = {})
+{
+  // guard words around the raster catch stray writes
+  const int guard = 64;
+  const RasterWord guardValue = 0x5a5a;
+  int rasterSize = PkRaster::GetRasterWordsPerLine(width) * height;
+  vector<RasterWord> buffer(guard + rasterSize + guard, guardValue);
+  RasterWord* raster = buffer.data() + guard;
+  bool result = PkRaster::Unpack(packet.data(), packet.size(), flag, width, height, raster);
+  bool ok = result == expected;
+  for (int i = 0; ok && i < guard; ++i)
+  {
+    ok = buffer[i] == guardValue && buffer[guard + rasterSize + i] == guardValue;
+  }
+  if (ok && result && !expectedRaster.empty())
+  {
+    ok = vector<RasterWord>(raster, raster + rasterSize) == expectedRaster;
+  }
+  if (!ok)
+  {
+    cerr << name << ": failed" << endl;
+    ++failures;
+  }
+}
+
+int main()
+{
+  // 2x2 black square: one run of 4 pixels
+  Check("valid", true, { 0x40 }, flagBlack, 2, 2, { 0xc000, 0xc000 });
+
+  // 2x2 black square: a run of 2, repeated once
+  Check("valid repeat", true, { 0xe1, 0x20 }, flagBlack, 2, 2, { 0xc000, 0xc000 });
+
+  // bit-mapped 3x2 raster: 101 010
+  Check("bit-mapped", true, { 0xa8 }, 0xe0, 3, 2, { 0xa000, 0x4000 });
+
+  Check("truncated", false, { 0x20 }, flagBlack, 2, 2);
+
+  Check("empty", false, {}, flagBlack, 2, 2);
+
+  Check("invalid dyn_f", false, { 0x40 }, 0xf8, 2, 2);
+
+  Check("invalid size", false, { 0x40 }, flagBlack, 0, 2);
+
+  // too many leading zero nybbles
+  Check("leading zeros", false, { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x1f }, flagBlack, 2, 2);
+
+  // 7 leading zeros and 8 nybbles: does not fit into an int
+  Check("int overflow", false, { 0x00, 0x00, 0x00, 0x0f, 0xff, 0xff, 0xff, 0xf0 }, flagBlack, 2, 2);
+
+  // huge repeat count
+  Check("repeat count", false, { 0xe0, 0x00, 0x00, 0x00, 0x7f, 0xff, 0xff, 0xf0, 0x20 }, flagBlack, 2, 2);
+
+  // a repeat count cannot be repeated
+  Check("nested repeat", false, { 0xee, 0xee, 0xe1, 0x20 }, flagBlack, 2, 2);
+
+  // more pixels than there are
+  Check("too many rows", false, { 0x50 }, flagBlack, 2, 2);
+
+  // endless repeat commands
+  Check("endless repeat", false, vector<unsigned char>(16, 0xff), flagBlack, 2, 2);
+
+  return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,128 @@
+/* pkshrink.cpp: PK raster shrink tests
+
+   Copyright (C) 2024 Christian Schenk
+
+   This file is part of the MiKTeX DVI Library.
+
+   The MiKTeX DVI Library is free software; you can redistribute it
+   and/or modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2, or (at your option) any later version.
+
+   The MiKTeX DVI Library is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public
+   License along with the MiKTeX DVI Library; if not, write to the
+   Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139,
+   USA.  */
+
+/* Compares PkRaster::CopyBits and PkRaster::BoxFilter with the code
+   they replaced, for shrink factors 1 to 8, on generated glyphs of
+   various sizes and reference points. */
+
+#include <iostream>
+#include <vector>
+
+#include "PkRaster.h"
+#include "PkReference.h"
+
+using namespace std;
+
+int failures = 0;
+
+unsigned long randomState = 12345;
+
+unsigned long Random()
+{
+  randomState = randomState * 1103515245 + 12345;
+  return (randomState >> 16) & 0x7fff;
+}
+
+// percentBlack pixels are set; the unused bits of the last raster word
+// of a row stay clear, as with an unpacked glyph
+Glyph MakeGlyph(int width, int height, int cxOffset, int cyOffset, unsigned percentBlack)
+{
+  Glyph glyph;
+  glyph.width = width;
+  glyph.height = height;
+  glyph.cxOffset = cxOffset;
+  glyph.cyOffset = cyOffset;
+  int rasterWordsPerLine = PkRaster::GetRasterWordsPerLine(width);
+  glyph.raster.resize(rasterWordsPerLine * height);
+  for (int row = 0; row < height; ++row)
+  {
+    for (int col = 0; col < width; ++col)
+    {
+      if (Random() % 100 < percentBlack)
+      {
+        glyph.raster[row * rasterWordsPerLine + col / PkRaster::bitsPerRasterWord] |= static_cast<RasterWord>(1 << (PkRaster::bitsPerRasterWord - 1 - col % PkRaster::bitsPerRasterWord));
+      }
+    }
+  }
+  return glyph;
+}
+
+// the same bitmap geometry as PkChar
+void Check(const Glyph& glyph, int shrinkFactor)
+{
+  int bpp = shrinkFactor == 1 ? 1 : bitsPerPixel;
+  int widthShr = shrinkFactor == 1 ? glyph.width : (glyph.width + shrinkFactor - 1) / shrinkFactor + 1;
+  int heightShr = shrinkFactor == 1 ? glyph.height : (glyph.height + shrinkFactor - 1) / shrinkFactor + 1;
+  int sampleWidth = (glyph.cxOffset + 1) - ((glyph.cxOffset + 1) / shrinkFactor) * shrinkFactor;
+  int sampleHeight = (glyph.cyOffset + 1) - ((glyph.cyOffset + 1) / shrinkFactor) * shrinkFactor;
+  if (sampleWidth <= 0)
+  {
+    sampleWidth += shrinkFactor;
+  }
+  if (sampleHeight <= 0)
+  {
+    sampleHeight += shrinkFactor;
+  }
+  size_t bytesPerLine = ((widthShr * bpp + 31) / 32) * 4;
+  vector<unsigned char> expected(heightShr * bytesPerLine);
+  vector<unsigned char> actual(heightShr * bytesPerLine);
+  if (shrinkFactor == 1)
+  {
+    Reference::CopyBits(glyph, expected.data(), bytesPerLine);
+    PkRaster::CopyBits(glyph.raster.data(), glyph.width, glyph.height, actual.data(), bytesPerLine);
+  }
+  else
+  {
+    Reference::BoxFilter(glyph, shrinkFactor, sampleWidth, sampleHeight, expected.data(), bytesPerLine);
+    PkRaster::BoxFilter(glyph.raster.data(), glyph.width, glyph.height, shrinkFactor, sampleWidth, sampleHeight, bpp, actual.data(), bytesPerLine);
+  }
+  if (expected != actual)
+  {
+    cerr << "shrink" << shrinkFactor << " " << glyph.width << "x" << glyph.height << "+" << glyph.cxOffset << "+" << glyph.cyOffset << ": failed" << endl;
+    ++failures;
+  }
+}
+
+int main()
+{
+  Reference::Init();
+  vector<Glyph> glyphs;
+  for (int width = 1; width <= 70; width += 3)
+  {
+    for (int height = 1; height <= 40; height += 5)
+    {
+      int cxOffset = static_cast<int>(Random() % (width + 8)) - 4;
+      int cyOffset = static_cast<int>(Random() % (height + 8)) - 4;
+      glyphs.push_back(MakeGlyph(width, height, cxOffset, cyOffset, 50));
+    }
+  }
+  glyphs.push_back(MakeGlyph(33, 17, 0, 16, 0));
+  glyphs.push_back(MakeGlyph(33, 17, 32, 0, 100));
+  glyphs.push_back(MakeGlyph(64, 64, 31, 63, 90));
+  for (int shrinkFactor = 1; shrinkFactor <= 8; ++shrinkFactor)
+  {
+    for (const Glyph& glyph : glyphs)
+    {
+      Check(glyph, shrinkFactor);
+    }
+  }
+  return failures == 0 ? 0 : 1;
+}
@@ -36,7 +36,7 @@ DviSpecialType TpicPolySpecialImpl::Parse()
   }
   else if (strncmp(GetXXX(), "da", 2) == 0)
   {
-    if (sscanf_s(GetXXX(), "da %f", &polyLength) != 1)
+    if (sscanf(GetXXX(), "da %f", &polyLength) != 1)
     {
       pDviPageImpl->Error(T_("bad da special"));
     }
@@ -47,7 +47,7 @@ DviSpecialType TpicPolySpecialImpl::Parse()
   }
   else if (strncmp(GetXXX(), "dt", 2) == 0)
   {
-    if (sscanf_s(GetXXX(), "dt %f", &polyLength) != 1)
+    if (sscanf(GetXXX(), "dt %f", &polyLength) != 1)
     {
       pDviPageImpl->Error(T_("bad dt special"));
     }
@@ -59,7 +59,7 @@ DviSpecialType TpicPolySpecialImpl::Parse()
   else if (strncmp(GetXXX(), "sp", 2) == 0)
   {
     isSpline = true;
-    if (sscanf_s(GetXXX(), "sp %f", &polyLength) == 1)
+    if (sscanf(GetXXX(), "sp %f", &polyLength) == 1)
     {
       if (polyLength > 0)
       {
@@ -79,7 +79,7 @@ DviSpecialType TpicPolySpecialImpl::Parse()
 DviSpecialType TpicArcSpecialImpl::Parse()
 {
   hasOutline = (strncmp(GetXXX(), "ar", 2) == 0);
-  if (sscanf_s(GetXXX() + 2, " %d %d %d %d %f %f", &cx, &cy, &m_rx, &m_ry, &m_s, &m_e) != 6)
+  if (sscanf(GetXXX() + 2, " %d %d %d %d %f %f", &cx, &cy, &m_rx, &m_ry, &m_s, &m_e) != 6)
   {
     pDviPageImpl->Error(T_("bad ar special"));
     return DviSpecialType::Unknown;
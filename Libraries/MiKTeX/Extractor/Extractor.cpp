@@ -21,13 +21,21 @@
 
 #include "config.h"
 
+#include <algorithm>
+#include <atomic>
+#include <exception>
 #include <memory>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <vector>
 
 #include "internal.h"
 
 #include "CabExtractor.h"
 #include "TarBzip2Extractor.h"
 #include "TarLzmaExtractor.h"
+#include "WriteBehindQueue.h"
 
 #if defined (MIKTEX_WINDOWS) && defined(ENABLE_WINDOWS_CAB_EXTRACTOR)
 #  include "win/winCabExtractor.h"
@@ -65,3 +73,74 @@ unique_ptr<Extractor> Extractor::CreateExtractor(ArchiveFileType archiveFileType
     UNIMPLEMENTED();
   }
 }
+
+void Extractor::ExtractAll(const vector<ExtractionJob>& jobs, unsigned numJobs)
+{
+  if (numJobs == 0)
+  {
+    numJobs = std::max(thread::hardware_concurrency(), 1u);
+  }
+  // one memory budget and one set of I/O threads for all archives
+  WriteBehindQueue writeBehindQueue;
+  atomic<size_t> nextJob(0);
+  mutex errorMutex;
+  exception_ptr error;
+  auto worker = [&]()
+  {
+    while (true)
+    {
+      {
+        lock_guard<mutex> lock(errorMutex);
+        if (error != nullptr)
+        {
+          return;
+        }
+      }
+      size_t idx = nextJob++;
+      if (idx >= jobs.size())
+      {
+        return;
+      }
+      const ExtractionJob& job = jobs[idx];
+      try
+      {
+        unique_ptr<Extractor> extractor = CreateExtractor(job.archiveFileType);
+        TarExtractor* tarExtractor = dynamic_cast<TarExtractor*>(extractor.get());
+        if (tarExtractor != nullptr)
+        {
+          tarExtractor->SetWriteBehindQueue(&writeBehindQueue);
+        }
+        extractor->Extract(job.path, job.destDir, job.makeDirectories, job.callback, job.prefix);
+      }
+      catch (...)
+      {
+        lock_guard<mutex> lock(errorMutex);
+        if (error == nullptr)
+        {
+          error = current_exception();
+        }
+      }
+    }
+  };
+  vector<thread> threads;
+  for (unsigned i = 1; i < numJobs && i < jobs.size(); ++i)
+  {
+    try
+    {
+      threads.push_back(thread(worker));
+    }
+    catch (const system_error&)
+    {
+      break;
+    }
+  }
+  worker();
+  for (thread& t : threads)
+  {
+    t.join();
+  }
+  if (error != nullptr)
+  {
+    rethrow_exception(error);
+  }
+}
@@ -21,9 +21,15 @@
 
 #include "config.h"
 
+#include <deque>
+#include <memory>
+#include <utility>
+#include <vector>
+
 #include <fmt/format.h>
 #include <fmt/ostream.h>
 
+#include <miktex/Core/AutoResource>
 #include <miktex/Core/Debug>
 #include <miktex/Core/Directory>
 #include <miktex/Core/FileStream>
@@ -32,6 +38,7 @@
 #include "internal.h"
 
 #include "TarExtractor.h"
+#include "WriteBehindQueue.h"
 
 using namespace std;
 
@@ -322,6 +329,35 @@ void TarExtractor::Extract(Stream* streamIn_, const PathName& destDir, bool make
     CharBuffer<char> buffer;
     buffer.Reserve(1024 * 1024);
 
+    unique_ptr<WriteBehindQueue> myWriteBehindQueue;
+    if (writeBehindQueue == nullptr)
+    {
+      myWriteBehindQueue = make_unique<WriteBehindQueue>();
+    }
+    WriteBehindQueue& writeBehind = writeBehindQueue != nullptr ? *writeBehindQueue : *myWriteBehindQueue;
+
+    // the client learns about a file when it has been written
+    deque<pair<PathName, size_t>> unreported;
+    auto reportWritten = [&](bool wait)
+    {
+      while (!unreported.empty())
+      {
+        if (wait)
+        {
+          writeBehind.WaitFor(unreported.front().first);
+        }
+        else if (writeBehind.IsPending(unreported.front().first))
+        {
+          break;
+        }
+        if (callback != nullptr)
+        {
+          callback->OnEndFileExtraction("", unreported.front().second);
+        }
+        unreported.pop_front();
+      }
+    };
+
     while ((len = Read(&header, sizeof(header))) > 0)
     {
       // read next header
@@ -400,30 +436,48 @@ void TarExtractor::Extract(Stream* streamIn_, const PathName& destDir, bool make
       // create the destination directory
       Directory::Create(PathName(path).RemoveFileSpec());
 
-      // remove the existing file
-      if (File::Exists(path))
-      {
-        File::Delete(path, { FileDeleteOption::TryHard });
-      }
-
-      // extract the file
-      FileStream streamOut(File::Open(path, FileMode::Create, FileAccess::Write, false));
       size_t bytesRead = 0;
-      while (bytesRead < size)
+      if (writeBehind.CanAccept(size))
       {
-        size_t remaining = size - bytesRead;
-        size_t n = (remaining > buffer.GetCapacity() ? buffer.GetCapacity() : remaining);
-        if (Read(buffer.GetData(), n) != n)
+        // read the file contents and let an I/O thread write the file
+        vector<unsigned char> data(size);
+        if (size > 0 && Read(&data[0], size) != size)
         {
           MIKTEX_UNEXPECTED();
         }
-        streamOut.Write(buffer.GetData(), n);
-        bytesRead += n;
+        bytesRead = size;
+        writeBehind.Submit(path, std::move(data), header.GetLastModificationTime());
+      }
+      else
+      {
+        // other extractions sharing the queue may write the same file
+        writeBehind.BeginWrite(path);
+        MIKTEX_AUTO(writeBehind.EndWrite(path));
+
+        // remove the existing file
+        if (File::Exists(path))
+        {
+          File::Delete(path, { FileDeleteOption::TryHard });
+        }
+
+        // extract the file
+        FileStream streamOut(File::Open(path, FileMode::Create, FileAccess::Write, false));
+        while (bytesRead < size)
+        {
+          size_t remaining = size - bytesRead;
+          size_t n = (remaining > buffer.GetCapacity() ? buffer.GetCapacity() : remaining);
+          if (Read(buffer.GetData(), n) != n)
+          {
+            MIKTEX_UNEXPECTED();
+          }
+          streamOut.Write(buffer.GetData(), n);
+          bytesRead += n;
+        }
+        // set time when the file was created
+        time_t time = header.GetLastModificationTime();
+        File::SetTimes(streamOut.GetFile(), time, time, time);
+        streamOut.Close();
       }
-      // set time when the file was created
-      time_t time = header.GetLastModificationTime();
-      File::SetTimes(streamOut.GetFile(), time, time, time);
-      streamOut.Close();
 
       // skip extra bytes
       if (bytesRead % sizeof(Header) > 0)
@@ -439,12 +493,12 @@ void TarExtractor::Extract(Stream* streamIn_, const PathName& destDir, bool make
 #endif
 
       // notify the client
-      if (callback != nullptr)
-      {
-        callback->OnEndFileExtraction("", size);
-      }
+      unreported.push_back(make_pair(path, size));
+      reportWritten(false);
     }
 
+    reportWritten(true);
+
     traceStream->WriteLine(TRACE_FACILITY, fmt::format(T_("extracted {0} file(s)"), fileCount));
   }
   catch (const exception&)
@@ -30,6 +30,8 @@
 
 BEGIN_INTERNAL_NAMESPACE;
 
+class WriteBehindQueue;
+
 class TarExtractor : public MiKTeX::Extractor::Extractor
 {
 public:
@@ -44,6 +46,14 @@ public:
 public:
   void MIKTEXTHISCALL Extract(MiKTeX::Core::Stream* stream, const MiKTeX::Util::PathName& destDir, bool makeDirectories, IExtractCallback* callback, const std::string& prefix) override;
 
+public:
+  // Lets the extractor write files through a queue which is shared with
+  // other extractions.
+  void SetWriteBehindQueue(WriteBehindQueue* writeBehindQueue)
+  {
+    this->writeBehindQueue = writeBehindQueue;
+  }
+
 protected:
   size_t Read(void* data, size_t numBytes)
   {
@@ -73,6 +83,9 @@ protected:
 protected:
   MiKTeX::Core::Stream* streamIn = nullptr;
 
+protected:
+  WriteBehindQueue* writeBehindQueue = nullptr;
+
 protected:
   void Skip(size_t bytes);
 
@@ -0,0 +1,197 @@
+/* WriteBehindQueue.cpp:
+
+   Copyright (C) 2024 Christian Schenk
+
+   This file is part of MiKTeX Extractor.
+
+   MiKTeX Extractor is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation; either version 2, or (at
+   your option) any later version.
+
+   MiKTeX Extractor is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with MiKTeX Extractor; if not, write to the Free Software
+   Foundation, 59 Temple Place - Suite 330, Boston, MA 02111-1307,
+   USA. */
+
+#include "config.h"
+
+#include <algorithm>
+#include <system_error>
+
+#include <miktex/Core/File>
+#include <miktex/Core/FileStream>
+
+#include "internal.h"
+
+#include "WriteBehindQueue.h"
+
+using namespace std;
+
+using namespace MiKTeX::Core;
+using namespace MiKTeX::Util;
+
+const size_t DEFAULT_MEMORY_BUDGET = 32 * 1024 * 1024;
+
+const unsigned DEFAULT_MAX_THREADS = 4;
+
+WriteBehindQueue::WriteBehindQueue() :
+  WriteBehindQueue(DEFAULT_MEMORY_BUDGET, std::min(std::max(thread::hardware_concurrency(), 1u), DEFAULT_MAX_THREADS))
+{
+}
+
+WriteBehindQueue::WriteBehindQueue(size_t memoryBudget, unsigned numThreads) :
+  memoryBudget(memoryBudget),
+  maxThreads(numThreads > 0 ? numThreads : 1)
+{
+}
+
+WriteBehindQueue::~WriteBehindQueue()
+{
+  {
+    lock_guard<std::mutex> lock(mutex);
+    cancelled = true;
+  }
+  queueChanged.notify_all();
+  for (thread& t : threads)
+  {
+    t.join();
+  }
+}
+
+void WriteBehindQueue::Submit(const PathName& path, vector<unsigned char>&& data, time_t lastWriteTime)
+{
+  string key = path.ToString();
+  size_t size = data.size();
+  unique_lock<std::mutex> lock(mutex);
+  itemDone.wait(lock, [&]() {
+    return error != nullptr || (pendingPaths.find(key) == pendingPaths.end() && (memoryInUse == 0 || memoryInUse + size <= memoryBudget));
+  });
+  ThrowIfFailed();
+  pendingPaths.insert(key);
+  memoryInUse += size;
+  queue.push_back(Item{ path, std::move(data), lastWriteTime });
+  if (threads.size() < maxThreads)
+  {
+    try
+    {
+      threads.push_back(thread(&WriteBehindQueue::Worker, this));
+    }
+    catch (const system_error&)
+    {
+      if (threads.empty())
+      {
+        // no I/O thread: write the file ourselves
+        Item item = std::move(queue.back());
+        queue.pop_back();
+        pendingPaths.erase(key);
+        memoryInUse -= size;
+        lock.unlock();
+        WriteFile(item);
+        return;
+      }
+    }
+  }
+  queueChanged.notify_one();
+}
+
+void WriteBehindQueue::WaitFor(const PathName& path)
+{
+  string key = path.ToString();
+  unique_lock<std::mutex> lock(mutex);
+  itemDone.wait(lock, [&]() { return error != nullptr || pendingPaths.find(key) == pendingPaths.end(); });
+  ThrowIfFailed();
+}
+
+void WriteBehindQueue::BeginWrite(const PathName& path)
+{
+  string key = path.ToString();
+  unique_lock<std::mutex> lock(mutex);
+  itemDone.wait(lock, [&]() { return error != nullptr || pendingPaths.find(key) == pendingPaths.end(); });
+  ThrowIfFailed();
+  pendingPaths.insert(key);
+}
+
+void WriteBehindQueue::EndWrite(const PathName& path)
+{
+  {
+    lock_guard<std::mutex> lock(mutex);
+    pendingPaths.erase(path.ToString());
+  }
+  itemDone.notify_all();
+}
+
+bool WriteBehindQueue::IsPending(const PathName& path)
+{
+  lock_guard<std::mutex> lock(mutex);
+  ThrowIfFailed();
+  return pendingPaths.find(path.ToString()) != pendingPaths.end();
+}
+
+void WriteBehindQueue::Worker()
+{
+  unique_lock<std::mutex> lock(mutex);
+  while (true)
+  {
+    queueChanged.wait(lock, [&]() { return cancelled || !queue.empty(); });
+    if (cancelled)
+    {
+      return;
+    }
+    Item item = std::move(queue.front());
+    queue.pop_front();
+    // after an error, the remaining files are dropped
+    bool skip = error != nullptr;
+    lock.unlock();
+    exception_ptr e;
+    if (!skip)
+    {
+      try
+      {
+        WriteFile(item);
+      }
+      catch (const exception&)
+      {
+        e = current_exception();
+      }
+    }
+    lock.lock();
+    if (e != nullptr && error == nullptr)
+    {
+      error = e;
+    }
+    pendingPaths.erase(item.path.ToString());
+    memoryInUse -= item.data.size();
+    itemDone.notify_all();
+  }
+}
+
+void WriteBehindQueue::ThrowIfFailed()
+{
+  if (error != nullptr)
+  {
+    rethrow_exception(error);
+  }
+}
+
+void WriteBehindQueue::WriteFile(const Item& item)
+{
+  // remove the existing file
+  if (File::Exists(item.path))
+  {
+    File::Delete(item.path, { FileDeleteOption::TryHard });
+  }
+  FileStream streamOut(File::Open(item.path, FileMode::Create, FileAccess::Write, false));
+  if (!item.data.empty())
+  {
+    streamOut.Write(&item.data[0], item.data.size());
+  }
+  // set time when the file was created
+  File::SetTimes(streamOut.GetFile(), item.lastWriteTime, item.lastWriteTime, item.lastWriteTime);
+  streamOut.Close();
+}
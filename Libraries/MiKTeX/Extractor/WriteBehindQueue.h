@@ -0,0 +1,146 @@
+/* WriteBehindQueue.h:                                   -*- C++ -*-
+
+   Copyright (C) 2024 Christian Schenk
+
+   This file is part of MiKTeX Extractor.
+
+   MiKTeX Extractor is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation; either version 2, or (at
+   your option) any later version.
+
+   MiKTeX Extractor is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with MiKTeX Extractor; if not, write to the Free Software
+   Foundation, 59 Temple Place - Suite 330, Boston, MA 02111-1307,
+   USA. */
+
+#pragma once
+
+#if !defined(A5C3E1F0B7D2486C9E4F1A2B3C4D5E6F)
+#define A5C3E1F0B7D2486C9E4F1A2B3C4D5E6F
+
+#include <cstddef>
+#include <ctime>
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+#include <miktex/Util/PathName>
+
+BEGIN_INTERNAL_NAMESPACE;
+
+// Writes extracted files on a small pool of I/O threads, so that the
+// decompression of the next file overlaps with writing the previous
+// ones. The file contents held by the queue never exceed the memory
+// budget: Submit() blocks until enough memory has been released.
+class WriteBehindQueue
+{
+public:
+  // Uses the default memory budget and up to one I/O thread per
+  // processor (at most four).
+  WriteBehindQueue();
+
+public:
+  WriteBehindQueue(std::size_t memoryBudget, unsigned numThreads);
+
+public:
+  WriteBehindQueue(const WriteBehindQueue& other) = delete;
+
+public:
+  WriteBehindQueue& operator=(const WriteBehindQueue& other) = delete;
+
+public:
+  ~WriteBehindQueue();
+
+public:
+  // Files which are too large have to be written by the caller.
+  bool CanAccept(std::size_t size) const
+  {
+    return size <= memoryBudget / 4;
+  }
+
+public:
+  void Submit(const MiKTeX::Util::PathName& path, std::vector<unsigned char>&& data, std::time_t lastWriteTime);
+
+public:
+  // Reserves a file which the caller writes itself: waits until no
+  // pending write refers to the file. Rethrows the first error, if any.
+  void BeginWrite(const MiKTeX::Util::PathName& path);
+
+public:
+  void EndWrite(const MiKTeX::Util::PathName& path);
+
+public:
+  // Checks whether a write of the file is still pending. Rethrows the
+  // first error, if any.
+  bool IsPending(const MiKTeX::Util::PathName& path);
+
+public:
+  // Waits until no pending write refers to the file. Rethrows the
+  // first error, if any.
+  void WaitFor(const MiKTeX::Util::PathName& path);
+
+private:
+  struct Item
+  {
+    MiKTeX::Util::PathName path;
+    std::vector<unsigned char> data;
+    std::time_t lastWriteTime;
+  };
+
+private:
+  void Worker();
+
+private:
+  void ThrowIfFailed();
+
+private:
+  static void WriteFile(const Item& item);
+
+private:
+  std::size_t memoryBudget;
+
+private:
+  std::size_t memoryInUse = 0;
+
+private:
+  unsigned maxThreads;
+
+private:
+  std::deque<Item> queue;
+
+private:
+  std::unordered_set<std::string> pendingPaths;
+
+private:
+  std::vector<std::thread> threads;
+
+private:
+  std::mutex mutex;
+
+private:
+  std::condition_variable queueChanged;
+
+private:
+  std::condition_variable itemDone;
+
+private:
+  bool cancelled = false;
+
+private:
+  std::exception_ptr error;
+};
+
+END_INTERNAL_NAMESPACE;
+
+#endif
@@ -33,6 +33,7 @@
 
 #include <memory>
 #include <string>
+#include <vector>
 
 #include <miktex/Util/PathName>
 #include <miktex/Core/Paths>
@@ -60,6 +61,16 @@ public:
   virtual bool MIKTEXTHISCALL OnError(const std::string& message) = 0;
 };
 
+struct ExtractionJob
+{
+  ArchiveFileType archiveFileType = ArchiveFileType::None;
+  MiKTeX::Util::PathName path;
+  MiKTeX::Util::PathName destDir;
+  bool makeDirectories = false;
+  IExtractCallback* callback = nullptr;
+  std::string prefix;
+};
+
 class MIKTEXNOVTABLE Extractor
 {
 public:
@@ -98,6 +109,13 @@ public:
 public:
   static MIKTEXEXTRACTORCEEAPI(std::unique_ptr<Extractor>) CreateExtractor(ArchiveFileType archiveFileType);
 
+  // Extracts a set of archives with up to numJobs archives (0: one per
+  // processor) being extracted at the same time. The archives share the
+  // memory budget and the I/O threads which write the extracted files.
+  // The callbacks of different jobs may be invoked concurrently.
+public:
+  static MIKTEXEXTRACTORCEEAPI(void) ExtractAll(const std::vector<ExtractionJob>& jobs, unsigned numJobs);
+
 public:
   static const std::string GetFileNameExtension(ArchiveFileType archiveFileType)
   {
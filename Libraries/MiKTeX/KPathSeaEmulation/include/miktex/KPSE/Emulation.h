@@ -742,6 +742,11 @@ typedef struct
 #define kpathsea_find_file_generic(kpse, name, format, must_exist, all) \
   miktex_kpathsea_find_file_generic(kpse, name, format, must_exist, all)
 
+/// Searches many files of the same format at once. Returns an array
+/// with one (possibly `NULL`) path per file name.
+#define kpathsea_find_files(kpse, names, count, format, must_exist) \
+  miktex_kpathsea_find_files(kpse, names, count, format, must_exist)
+
 #define kpathsea_in_name_ok(kpse, fname) miktex_kpathsea_in_name_ok(kpse, fname, 0)
 #define kpathsea_in_name_ok_silent(kpse, fname) miktex_kpathsea_in_name_ok(kpse, fname, 1)
 
@@ -774,6 +779,9 @@ typedef struct
 #define kpse_find_file(name, format, must_exist) \
   kpathsea_find_file(kpse_def, name, format, must_exist)
 
+#define kpse_find_files(names, count, format, must_exist) \
+  kpathsea_find_files(kpse_def, names, count, format, must_exist)
+
 #define kpse_find_ofm(name) kpse_find_file(name, kpse_ofm_format, 1)
 
 #define kpse_find_pict(name) kpse_find_file(name, kpse_pict_format, 1)
@@ -1067,6 +1075,8 @@ MIKTEXKPSCEEAPI(char*) miktex_kpathsea_find_file(kpathsea kpseInstance, const ch
 
 MIKTEXKPSCEEAPI(char**) miktex_kpathsea_find_file_generic(kpathsea kpseInstance, const char* fileName, kpse_file_format_type format, boolean mustExist, boolean all);
 
+MIKTEXKPSCEEAPI(char**) miktex_kpathsea_find_files(kpathsea kpseInstance, const char* const* fileNames, int numFiles, kpse_file_format_type format, int mustExist);
+
 MIKTEXKPSCEEAPI(char*) miktex_kpathsea_find_glyph(kpathsea kpseInstance, const char* fontName, unsigned dpi, kpse_file_format_type format, kpse_glyph_file_type* glyph_file);
 
 MIKTEXKPSCEEAPI(void) miktex_kpathsea_finish(kpathsea kpseInstance);
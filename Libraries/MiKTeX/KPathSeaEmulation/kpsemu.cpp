@@ -266,6 +266,46 @@ MIKTEXKPSCEEAPI(char*) miktex_kpathsea_find_file(kpathsea kpseInstance, const ch
   return xstrdup(result.GetData());
 }
 
+MIKTEXKPSCEEAPI(char**) miktex_kpathsea_find_files(kpathsea kpseInstance, const char* const* fileNames, int numFiles, kpse_file_format_type format, int mustExist)
+{
+  MIKTEX_ASSERT(kpseInstance != nullptr);
+  MIKTEX_ASSERT(fileNames != nullptr || numFiles == 0);
+  FileType fileType = ToFileType(format);
+  vector<FindRequest> requests;
+  requests.reserve(numFiles);
+  for (int idx = 0; idx < numFiles; ++idx)
+  {
+    MIKTEX_ASSERT(fileNames[idx] != nullptr);
+    FindRequest request;
+    request.fileName = fileNames[idx];
+    request.options.fileType = fileType;
+    if (mustExist)
+    {
+      request.options.create = true;
+      request.options.searchFileSystem = true;
+    }
+    requests.push_back(request);
+  }
+  shared_ptr<Session> session = MIKTEX_SESSION();
+  vector<LocateResult> results = session->FindFiles(requests);
+  char** stringList = XTALLOC(numFiles + 1, char*);
+  for (int idx = 0; idx < numFiles; ++idx)
+  {
+    if (results[idx].pathNames.empty())
+    {
+      stringList[idx] = nullptr;
+    }
+    else
+    {
+      PathName path = results[idx].pathNames[0];
+      path.ConvertToUnix();
+      stringList[idx] = xstrdup(path.GetData());
+    }
+  }
+  stringList[numFiles] = nullptr;
+  return stringList;
+}
+
 MIKTEXKPSCEEAPI(char**) miktex_kpathsea_find_file_generic(kpathsea kpseInstance, const char* fileName, kpse_file_format_type format, boolean mustExist, boolean all)
 {
   MIKTEX_ASSERT(kpseInstance != nullptr);
@@ -24,6 +24,7 @@
 #if defined(HAVE_LIBCURL)
 
 #include <algorithm>
+#include <mutex>
 #include <sstream>
 #include <thread>
 
@@ -112,8 +113,24 @@ string BuildUserAgentString()
   return str.str();
 }
 
+void CurlWebSession::GlobalInitialize()
+{
+  // curl_global_init() is not thread-safe
+  static once_flag initialized;
+  call_once(initialized, []()
+  {
+    CURLcode code = curl_global_init(CURL_GLOBAL_ALL);
+    if (code != CURLE_OK)
+    {
+      MIKTEX_FATAL_ERROR_2(T_("The cURL library could not be initialized."), "code", std::to_string(code));
+    }
+  });
+}
+
 void CurlWebSession::Initialize()
 {
+  GlobalInitialize();
+
   curlVersionInfo = curl_version_info(CURLVERSION_NOW);
 
   trace_curl->WriteLine(TRACE_FACILITY, fmt::format(T_("initializing cURL library version {0}"), curlVersionInfo->version));
@@ -177,6 +177,9 @@ public:
 public:
   void SetCustomHeaders(const std::unordered_map<std::string, std::string>& headers) override;
 
+public:
+  static void GlobalInitialize();
+
 private:
   void Initialize();
 
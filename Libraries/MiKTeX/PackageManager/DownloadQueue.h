@@ -0,0 +1,230 @@
+/**
+ * @file DownloadQueue.h
+ * @author Christian Schenk
+ * @brief Parallel download queue
+ *
+ * @copyright Copyright © 2024 Christian Schenk
+ *
+ * This file is part of MiKTeX Package Manager.
+ *
+ * MiKTeX Package Manager is licensed under GNU General Public License version 2
+ * or any later version.
+ */
+
+#pragma once
+
+#include <cstddef>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief A queue of items which are transferred by a pool of worker threads.
+ *
+ * Workers take the items in queue order. They run at most `window` items ahead
+ * of the consumer, which collects the items by key. The queue depends on
+ * nothing but the standard library, so that it can be tested in isolation.
+ */
+template<class Item> class DownloadQueue
+{
+public:
+
+    /**
+     * @brief Transfers one item.
+     */
+    typedef std::function<void(Item&)> Transfer;
+
+    /**
+     * @brief Prepares a worker.
+     *
+     * Called once on each worker thread. The returned function is used for all
+     * items taken by this worker (e.g., it owns the worker's connection).
+     */
+    typedef std::function<Transfer()> WorkerInit;
+
+    ~DownloadQueue()
+    {
+        Stop();
+    }
+
+    /**
+     * @brief Appends an item.
+     * @param key The key by which the item is collected.
+     * @param item The item.
+     * @return Returns `false`, if the key has already been queued.
+     */
+    bool Add(const std::string& key, std::unique_ptr<Item> item)
+    {
+        if (index.find(key) != index.end())
+        {
+            return false;
+        }
+        index[key] = slots.size();
+        slots.push_back(std::make_unique<Slot>());
+        slots.back()->item = std::move(item);
+        return true;
+    }
+
+    std::size_t GetSize() const
+    {
+        return slots.size();
+    }
+
+    bool IsStopped() const
+    {
+        return stopped;
+    }
+
+    /**
+     * @brief Starts the workers.
+     * @param numWorkers The number of worker threads.
+     * @param window The number of items workers may run ahead of the consumer.
+     * @param workerInit The worker initialization function.
+     */
+    void Start(std::size_t numWorkers, std::size_t window, WorkerInit workerInit)
+    {
+        collected = 0;
+        next = 0;
+        this->window = window > 0 ? window : 1;
+        stopped = false;
+        for (std::size_t idx = 0; idx < numWorkers; ++idx)
+        {
+            threads.push_back(std::thread(&DownloadQueue::Work, this, workerInit));
+        }
+    }
+
+    /**
+     * @brief Waits for an item.
+     * @param key The key of the item.
+     * @param exception Receives the exception thrown by the transfer, if any.
+     * @param onIdle Called (without holding the lock) while waiting. It may
+     *   throw, e.g., if the operation has been cancelled.
+     * @return Returns the item, or `nullptr`, if the key is unknown or the item
+     *   has already been collected.
+     */
+    std::unique_ptr<Item> Collect(const std::string& key, std::exception_ptr& exception, std::function<void()> onIdle = nullptr)
+    {
+        using namespace std::chrono_literals;
+        std::unique_lock<std::mutex> lock(mutex);
+        auto it = index.find(key);
+        if (it == index.end() || slots[it->second]->item == nullptr)
+        {
+            return nullptr;
+        }
+        Slot* slot = slots[it->second].get();
+        while (!condition.wait_for(lock, 100ms, [slot]() { return slot->done; }))
+        {
+            if (onIdle)
+            {
+                lock.unlock();
+                onIdle();
+                lock.lock();
+            }
+        }
+        std::unique_ptr<Item> result = std::move(slot->item);
+        exception = slot->exception;
+        collected += 1;
+        lock.unlock();
+        condition.notify_all();
+        return result;
+    }
+
+    /**
+     * @brief Stops the workers and discards all items which have not been
+     *   collected.
+     */
+    void Stop()
+    {
+        {
+            std::lock_guard<std::mutex> lockGuard(mutex);
+            stopped = true;
+        }
+        condition.notify_all();
+        for (std::thread& t : threads)
+        {
+            t.join();
+        }
+        threads.clear();
+        slots.clear();
+        index.clear();
+    }
+
+private:
+
+    struct Slot
+    {
+        std::unique_ptr<Item> item;
+        bool done = false;
+        std::exception_ptr exception;
+    };
+
+    void Work(WorkerInit workerInit)
+    {
+        Transfer transfer;
+        std::exception_ptr initException;
+        try
+        {
+            transfer = workerInit();
+        }
+        catch (...)
+        {
+            // fail the items taken by this worker, so that nobody waits forever
+            initException = std::current_exception();
+        }
+        while (true)
+        {
+            Slot* slot;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                condition.wait(lock, [this]()
+                {
+                    return stopped || next >= slots.size() || next < collected + window;
+                });
+                if (stopped || next >= slots.size())
+                {
+                    break;
+                }
+                slot = slots[next++].get();
+            }
+            if (initException != nullptr)
+            {
+                slot->exception = initException;
+            }
+            else
+            {
+                try
+                {
+                    transfer(*slot->item);
+                }
+                catch (...)
+                {
+                    slot->exception = std::current_exception();
+                }
+            }
+            {
+                std::lock_guard<std::mutex> lockGuard(mutex);
+                slot->done = true;
+            }
+            condition.notify_all();
+        }
+    }
+
+    std::size_t collected = 0;
+    std::condition_variable condition;
+    std::unordered_map<std::string, std::size_t> index;
+    std::mutex mutex;
+    std::size_t next = 0;
+    std::vector<std::unique_ptr<Slot>> slots;
+    std::atomic_bool stopped{ false };
+    std::vector<std::thread> threads;
+    std::size_t window = 1;
+};
@@ -13,6 +13,7 @@
 
 #include "config.h"
 
+#include <algorithm>
 #include <future>
 
 #include <fmt/format.h>
@@ -46,6 +47,14 @@ using namespace MiKTeX::Util;
 
 using namespace MiKTeX::Packages::D6AAD62216146D44B580E92711724B78;
 
+const string OBSOLETE_CONTAINER_ID = "_miktex-obsolete";
+const string UNCATEGORIZED_CONTAINER_ID = "_miktex-all-the-rest";
+
+inline bool IsSyntheticContainer(const string& packageId)
+{
+    return packageId == OBSOLETE_CONTAINER_ID || packageId == UNCATEGORIZED_CONTAINER_ID;
+}
+
 PackageDataStore::PackageDataStore() :
     // TODO: trace callback
     trace_mpm(TraceStream::Open(MIKTEX_TRACE_MPM)),
@@ -78,6 +87,7 @@ void PackageDataStore::SaveVarData()
 
 void PackageDataStore::Clear()
 {
+    manifestIndex.Close();
     packageTable.clear();
     installedFileInfoTable.clear();
     loadedAllPackageManifests = false;
@@ -86,6 +96,20 @@ void PackageDataStore::Clear()
 
 tuple<bool, PackageInfo> PackageDataStore::TryGetPackage(const string& packageId)
 {
+    if (!loadedAllPackageManifests && manifestIndex.IsOpen())
+    {
+        try
+        {
+            return TryGetPackageFromIndex(packageId);
+        }
+        catch (const MiKTeXException&)
+        {
+            // the caller must discard the index and load all package
+            // manifests (while holding the lock)
+            indexDamaged = true;
+            throw;
+        }
+    }
     MIKTEX_EXPECT(loadedAllPackageManifests);
     auto it = packageTable.find(packageId);
     if (it == packageTable.end())
@@ -138,25 +162,56 @@ PackageDataStore::iterator PackageDataStore::end()
 void PackageDataStore::DefinePackage(const PackageInfo& packageInfo)
 {
     pair<PackageDefinitionTable::iterator, bool> p = packageTable.insert(make_pair(packageInfo.id, packageInfo));
+    ApplyVarData(p.first->second);
+}
+
+void PackageDataStore::ApplyVarData(PackageInfo& packageInfo)
+{
     if (session->IsMiKTeXDirect())
     {
         // installed from the start
-        p.first->second.isRemovable = false;
-        p.first->second.isObsolete = false;
-        p.first->second.timeInstalledCommon = packageInfo.timePackaged;
-        p.first->second.timeInstalledUser = packageInfo.timePackaged;
+        packageInfo.isRemovable = false;
+        packageInfo.isObsolete = false;
+        packageInfo.timeInstalledCommon = packageInfo.timePackaged;
+        packageInfo.timeInstalledUser = packageInfo.timePackaged;
     }
     else
     {
-        p.first->second.isRemovable = IsRemovable(p.first->second.id);
-        p.first->second.isObsolete = IsObsolete(p.first->second.id);
-        p.first->second.timeInstalledCommon = GetTimeInstalled(p.first->second.id, ConfigurationScope::Common);
-        p.first->second.timeInstalledUser = GetTimeInstalled(p.first->second.id, ConfigurationScope::User);
-        if (p.first->second.IsInstalled())
+        packageInfo.isRemovable = IsRemovable(packageInfo.id);
+        packageInfo.isObsolete = IsObsolete(packageInfo.id);
+        packageInfo.timeInstalledCommon = GetTimeInstalled(packageInfo.id, ConfigurationScope::Common);
+        packageInfo.timeInstalledUser = GetTimeInstalled(packageInfo.id, ConfigurationScope::User);
+        if (packageInfo.IsInstalled())
+        {
+            packageInfo.releaseState = GetReleaseState(packageInfo.id);
+        }
+    }
+}
+
+PackageInfo PackageDataStore::GetPackage(const string& packageId)
+{
+    if (!loadedAllPackageManifests && manifestIndex.IsOpen())
+    {
+        bool knownPackage;
+        PackageInfo packageInfo;
+        try
+        {
+            tie(knownPackage, packageInfo) = TryGetPackageFromIndex(packageId);
+        }
+        catch (const MiKTeXException&)
+        {
+            // the caller must discard the index and load all package
+            // manifests (while holding the lock)
+            indexDamaged = true;
+            throw;
+        }
+        if (!knownPackage)
         {
-            p.first->second.releaseState = GetReleaseState(p.first->second.id);
+            MIKTEX_FATAL_ERROR_2(T_("The requested package is unknown."), "name", packageId);
         }
+        return packageInfo;
     }
+    return (*this)[packageId];
 }
 
 void PackageDataStore::IncrementFileRefCounts(const string& packageId)
@@ -169,6 +224,29 @@ void PackageDataStore::IncrementFileRefCounts(const string& packageId)
 
 unsigned long PackageDataStore::GetFileRefCount(const PathName& path)
 {
+    if (!loadedAllPackageManifests && manifestIndex.IsOpen())
+    {
+        try
+        {
+            // count the installed packages which contain the file
+            unsigned long refCount = 0;
+            for (const string& packageId : manifestIndex.GetPackagesOfFile(path))
+            {
+                if (IsValidTimeT(GetTimeInstalled(packageId, ConfigurationScope::User)) || IsValidTimeT(GetTimeInstalled(packageId, ConfigurationScope::Common)))
+                {
+                    refCount++;
+                }
+            }
+            return refCount;
+        }
+        catch (const MiKTeXException&)
+        {
+            // the caller must discard the index and load all package
+            // manifests (while holding the lock)
+            indexDamaged = true;
+            throw;
+        }
+    }
     MIKTEX_EXPECT(loadedAllPackageManifests);
     InstalledFileInfoTable::const_iterator it = installedFileInfoTable.find(path.ToString());
     if (it == installedFileInfoTable.end())
@@ -232,27 +310,217 @@ PackageDataStore& PackageDataStore::Load()
     }
     unique_ptr<StopWatch> stopWatch = StopWatch::Start(trace_stopwatch.get(), TRACE_FACILITY, "loading all package manifests");
     NeedPackageManifestsIni();
+    manifestIndex.Close();
     unique_ptr<Cfg> cfg = Cfg::Create();
-    if (!session->IsAdminMode())
+    bool first = true;
+    for (const PathName& path : GetPackageManifestsIniFiles())
     {
-        PathName userPath = session->GetSpecialPath(SpecialPath::UserInstallRoot) / MIKTEX_PATH_PACKAGE_MANIFESTS_INI;
-        if (File::Exists(userPath))
+        if (File::Exists(path))
         {
-            cfg->Read(userPath);
+            if (!first)
+            {
+                cfg->SetOptions({ Cfg::Option::NoOverwriteKeys });
+            }
+            cfg->Read(path);
         }
+        first = false;
+    }
+    Load(*cfg);
+    loadedAllPackageManifests = true;
+    WriteIndex();
+    return *this;
+}
+
+vector<PathName> PackageDataStore::GetPackageManifestsIniFiles()
+{
+    vector<PathName> result;
+    if (!session->IsAdminMode())
+    {
+        result.push_back(session->GetSpecialPath(SpecialPath::UserInstallRoot) / MIKTEX_PATH_PACKAGE_MANIFESTS_INI);
     }
     if (session->IsAdminMode() || session->IsSharedSetup() && session->GetSpecialPath(SpecialPath::UserInstallRoot).Canonicalize() != session->GetSpecialPath(SpecialPath::CommonInstallRoot).Canonicalize())
     {
-        PathName commonPath = session->GetSpecialPath(SpecialPath::CommonInstallRoot) / MIKTEX_PATH_PACKAGE_MANIFESTS_INI;
-        if (File::Exists(commonPath))
+        result.push_back(session->GetSpecialPath(SpecialPath::CommonInstallRoot) / MIKTEX_PATH_PACKAGE_MANIFESTS_INI);
+    }
+    return result;
+}
+
+PathName PackageDataStore::GetIndexPath()
+{
+    PathName path = session->GetSpecialPath(SpecialPath::InstallRoot) / MIKTEX_PATH_PACKAGE_MANIFESTS_INI;
+    path.SetExtension(".idx");
+    return path;
+}
+
+bool PackageDataStore::TryOpenIndex()
+{
+    if (manifestIndex.IsOpen())
+    {
+        return true;
+    }
+    if (session->IsMiKTeXDirect() || indexDamaged)
+    {
+        return false;
+    }
+    PathName indexPath = GetIndexPath();
+    try
+    {
+        if (manifestIndex.Open(indexPath, GetPackageManifestsIniFiles()))
         {
-            cfg->SetOptions({ Cfg::Option::NoOverwriteKeys });
-            cfg->Read(commonPath);
+            trace_mpm->WriteLine(TRACE_FACILITY, fmt::format(T_("using package manifest index {0}"), Q_(indexPath)));
+            return true;
+        }
+    }
+    catch (const MiKTeXException& e)
+    {
+        trace_mpm->WriteLine(TRACE_FACILITY, TraceLevel::Warning, fmt::format(T_("package manifest index {0} cannot be used: {1}"), Q_(indexPath), e.GetErrorMessage()));
+        manifestIndex.Close();
+    }
+    return false;
+}
+
+void PackageDataStore::WriteIndex()
+{
+    if (session->IsMiKTeXDirect() || packageTable.empty())
+    {
+        return;
+    }
+    PathName indexPath = GetIndexPath();
+    vector<PathName> sources = GetPackageManifestsIniFiles();
+    try
+    {
+        if (!indexDamaged && manifestIndex.Open(indexPath, sources))
+        {
+            // up-to-date
+            manifestIndex.Close();
+            return;
+        }
+        // leave out what depends on mutable package data: the synthetic
+        // containers are created when a record is looked up
+        vector<PackageInfo> copies;
+        copies.reserve(packageTable.size());
+        vector<const PackageInfo*> packages;
+        packages.reserve(packageTable.size());
+        for (const auto& kv : packageTable)
+        {
+            const PackageInfo& packageInfo = kv.second;
+            if (IsSyntheticContainer(packageInfo.id))
+            {
+                continue;
+            }
+            if (any_of(packageInfo.requiredBy.begin(), packageInfo.requiredBy.end(), IsSyntheticContainer))
+            {
+                copies.push_back(packageInfo);
+                vector<string>& requiredBy = copies.back().requiredBy;
+                requiredBy.erase(remove_if(requiredBy.begin(), requiredBy.end(), IsSyntheticContainer), requiredBy.end());
+                packages.push_back(&copies.back());
+            }
+            else
+            {
+                packages.push_back(&packageInfo);
+            }
+        }
+        PackageManifestIndex::Write(indexPath, sources, packages);
+        indexDamaged = false;
+        trace_mpm->WriteLine(TRACE_FACILITY, fmt::format(T_("wrote package manifest index {0}"), Q_(indexPath)));
+    }
+    catch (const MiKTeXException& e)
+    {
+        // the index is an optimization; go on without it
+        manifestIndex.Close();
+        trace_mpm->WriteLine(TRACE_FACILITY, TraceLevel::Warning, fmt::format(T_("package manifest index {0} could not be written: {1}"), Q_(indexPath), e.GetErrorMessage()));
+    }
+}
+
+void PackageDataStore::DiscardDamagedIndex(const MiKTeXException& e)
+{
+    trace_mpm->WriteLine(TRACE_FACILITY, TraceLevel::Warning, fmt::format(T_("package manifest index {0} is damaged: {1}"), Q_(GetIndexPath()), e.GetErrorMessage()));
+    manifestIndex.Close();
+    // do not use the index again, until Load() has written a new one
+    indexDamaged = true;
+}
+
+tuple<bool, PackageInfo> PackageDataStore::TryGetPackageFromIndex(const string& packageId)
+{
+    PackageInfo packageInfo;
+    if (IsSyntheticContainer(packageId))
+    {
+        packageInfo = MakeSyntheticContainer(packageId);
+        for (const string& id : manifestIndex.GetPackageIds())
+        {
+            PackageInfo pkg;
+            manifestIndex.TryGetPackage(id, pkg);
+            if (GetSyntheticContainer(pkg) == packageId)
+            {
+                packageInfo.requiredPackages.push_back(id);
+            }
+        }
+        if (packageInfo.requiredPackages.empty())
+        {
+            return make_tuple(false, PackageInfo());
+        }
+    }
+    else
+    {
+        if (!manifestIndex.TryGetPackage(packageId, packageInfo))
+        {
+            return make_tuple(false, PackageInfo());
+        }
+        string containerId = GetSyntheticContainer(packageInfo);
+        if (!containerId.empty())
+        {
+            packageInfo.requiredBy.push_back(containerId);
+        }
+    }
+    ApplyVarData(packageInfo);
+    vector<time_t> requirementsTimeInstalled;
+    for (const string& req : packageInfo.requiredPackages)
+    {
+        if (!manifestIndex.HasPackage(req))
+        {
+            continue;
+        }
+        // the same var data Load() applies to the requirement's record
+        PackageInfo requirement;
+        requirement.id = req;
+        ApplyVarData(requirement);
+        requirementsTimeInstalled.push_back(requirement.GetTimeInstalled());
+    }
+    ApplyContainerTimeInstalled(packageInfo, requirementsTimeInstalled);
+    return make_tuple(true, packageInfo);
+}
+
+void PackageDataStore::ApplyContainerTimeInstalled(PackageInfo& packageInfo, const vector<time_t>& requirementsTimeInstalled)
+{
+    // a container counts as installed when its requirements were installed
+    // FIXME
+    time_t timeInstalledMin = static_cast<time_t>(0xffffffffffffffffULL);
+    time_t timeInstalledMax = 0;
+    for (time_t timeInstalled : requirementsTimeInstalled)
+    {
+        if (timeInstalled < timeInstalledMin)
+        {
+            timeInstalledMin = timeInstalled;
+        }
+        if (timeInstalled > timeInstalledMax)
+        {
+            timeInstalledMax = timeInstalled;
+        }
+    }
+    if (timeInstalledMin > 0)
+    {
+        if (packageInfo.IsPureContainer() || (packageInfo.IsInstalled() && packageInfo.GetTimeInstalled() < timeInstalledMax))
+        {
+            if (session->IsAdminMode())
+            {
+                packageInfo.timeInstalledCommon = timeInstalledMax;
+            }
+            else
+            {
+                packageInfo.timeInstalledUser = timeInstalledMax;
+            }
         }
     }
-    Load(*cfg);
-    loadedAllPackageManifests = true;
-    return *this;
 }
 
 void PackageDataStore::Load(Cfg& cfg)
@@ -289,7 +557,7 @@ void PackageDataStore::Load(Cfg& cfg)
         DefinePackage(packageInfo);
 
         // increment file ref counts, if package is installed
-        if (packageInfo.IsInstalled())
+        if (packageTable[packageInfo.id].IsInstalled())
         {
             IncrementFileRefCounts(packageInfo.runFiles);
             IncrementFileRefCounts(packageInfo.docFiles);
@@ -303,9 +571,7 @@ void PackageDataStore::Load(Cfg& cfg)
     for (auto& kv : packageTable)
     {
         PackageInfo& pkg = kv.second;
-        // FIXME
-        time_t timeInstalledMin = static_cast<time_t>(0xffffffffffffffffULL);
-        time_t timeInstalledMax = 0;
+        vector<time_t> requirementsTimeInstalled;
         for (const string& req : pkg.requiredPackages)
         {
             PackageDefinitionTable::iterator it3 = packageTable.find(req);
@@ -316,72 +582,61 @@ void PackageDataStore::Load(Cfg& cfg)
             else
             {
                 it3->second.requiredBy.push_back(pkg.id);
-                if (it3->second.GetTimeInstalled() < timeInstalledMin)
-                {
-                    timeInstalledMin = it3->second.GetTimeInstalled();
-                }
-                if (it3->second.GetTimeInstalled() > timeInstalledMax)
-                {
-                    timeInstalledMax = it3->second.GetTimeInstalled();
-                }
-            }
-        }
-        if (timeInstalledMin > 0)
-        {
-            if (pkg.IsPureContainer() || (pkg.IsInstalled() && pkg.GetTimeInstalled() < timeInstalledMax))
-            {
-                if (session->IsAdminMode())
-                {
-                    pkg.timeInstalledCommon = timeInstalledMax;
-                }
-                else
-                {
-                    pkg.timeInstalledUser = timeInstalledMax;
-                }
+                requirementsTimeInstalled.push_back(it3->second.GetTimeInstalled());
             }
         }
+        ApplyContainerTimeInstalled(pkg, requirementsTimeInstalled);
     }
 
-    // create "Obsolete" container
-    PackageInfo piObsolete;
-    piObsolete.id = "_miktex-obsolete";
-    piObsolete.displayName = T_("Obsolete");
-    piObsolete.title = T_("Obsolete packages");
-    piObsolete.description = T_("Packages that were removed from the MiKTeX package repository.");
+    // create "Obsolete" and "Uncategorized" containers
+    PackageInfo piObsolete = MakeSyntheticContainer(OBSOLETE_CONTAINER_ID);
+    PackageInfo piOther = MakeSyntheticContainer(UNCATEGORIZED_CONTAINER_ID);
     for (auto& kv : packageTable)
     {
         PackageInfo& pkg = kv.second;
-        if (!pkg.IsContained() && !pkg.IsContainer() && IsObsolete(pkg.id))
+        string containerId = GetSyntheticContainer(pkg);
+        if (containerId.empty())
         {
-            piObsolete.requiredPackages.push_back(pkg.id);
-            pkg.requiredBy.push_back(piObsolete.id);
+            continue;
         }
+        (containerId == OBSOLETE_CONTAINER_ID ? piObsolete : piOther).requiredPackages.push_back(pkg.id);
+        pkg.requiredBy.push_back(containerId);
     }
-    if (!piObsolete.requiredPackages.empty())
+    for (const PackageInfo* container : { &piObsolete, &piOther })
     {
-        // insert "Obsolete" into the database
-        DefinePackage(piObsolete);
+        if (!container->requiredPackages.empty())
+        {
+            // insert the container into the database
+            DefinePackage(*container);
+        }
     }
+}
 
-    // create "Uncategorized" container
-    PackageInfo piOther;
-    piOther.id = "_miktex-all-the-rest";
-    piOther.displayName = T_("Uncategorized");
-    piOther.title = T_("Uncategorized packages");
-    for (auto& kv : packageTable)
+PackageInfo PackageDataStore::MakeSyntheticContainer(const string& packageId)
+{
+    PackageInfo packageInfo;
+    packageInfo.id = packageId;
+    if (packageId == OBSOLETE_CONTAINER_ID)
     {
-        PackageInfo& pkg = kv.second;
-        if (!pkg.IsContained() && !pkg.IsContainer())
-        {
-            piOther.requiredPackages.push_back(pkg.id);
-            pkg.requiredBy.push_back(piOther.id);
-        }
+        packageInfo.displayName = T_("Obsolete");
+        packageInfo.title = T_("Obsolete packages");
+        packageInfo.description = T_("Packages that were removed from the MiKTeX package repository.");
     }
-    if (!piOther.requiredPackages.empty())
+    else
+    {
+        packageInfo.displayName = T_("Uncategorized");
+        packageInfo.title = T_("Uncategorized packages");
+    }
+    return packageInfo;
+}
+
+string PackageDataStore::GetSyntheticContainer(const PackageInfo& packageInfo)
+{
+    if (packageInfo.IsContained() || packageInfo.IsContainer())
     {
-        // insert "Other" into the database
-        DefinePackage(piOther);
+        return "";
     }
+    return IsObsolete(packageInfo.id) ? OBSOLETE_CONTAINER_ID : UNCATEGORIZED_CONTAINER_ID;
 }
 
 void PackageDataStore::LoadVarData()
@@ -500,7 +755,7 @@ void PackageDataStore::IncrementFileRefCounts(const vector<string>& files)
 #if POLLUTE_THE_DEBUG_STREAM
         if (installedFileInfoTable[file].refCount >= 2)
         {
-            trace_mpm->WriteLine(TRACE_FACILITY, TraceLevel::Debug, fmt::format(T_("{0}: ref count > 1"), Q_(file)));
+            trace_mpm->WriteLine(TRACE_FACILITY, TraceLevel::Debug, [&]() { return fmt::format(T_("{0}: ref count > 1"), Q_(file)); });
         }
 #endif
     }
@@ -19,6 +19,7 @@
 #include <string>
 #include <tuple>
 #include <unordered_map>
+#include <vector>
 
 #include <miktex/Util/PathName>
 #include <miktex/Core/Session>
@@ -29,6 +30,7 @@
 #include <miktex/PackageManager/PackageManager>
 
 #include "ComboCfg.h"
+#include "PackageManifestIndex.h"
 
 MPM_INTERNAL_BEGIN_NAMESPACE;
 
@@ -93,10 +95,7 @@ public:
      * @param packageId The package ID.
      * @return Returns the requested record.
      */
-    MiKTeX::Packages::PackageInfo GetPackage(const std::string& packageId)
-    {
-        return (*this)[packageId];
-    }
+    MiKTeX::Packages::PackageInfo GetPackage(const std::string& packageId);
 
     /**
      * Increments the reference counts of all files in a package.
@@ -175,6 +174,36 @@ public:
      */
     std::tuple<bool, MiKTeX::Packages::PackageInfo> TryGetPackage(const std::string& packageId);
 
+    /**
+     * @brief Tries to open the package manifest index.
+     *
+     * If the index is open, `TryGetPackage()`, `GetPackage()` and
+     * `GetFileRefCount()` can be used without loading all package manifests.
+     * If one of these finds the index damaged, it throws and
+     * `IsIndexDamaged()` returns `true`; the caller must then call
+     * `DiscardDamagedIndex()` and `Load()`, which (re-)creates the index.
+     * The caller must hold the package database lock.
+     *
+     * @return Returns `true`, if an up-to-date index is available.
+     */
+    bool TryOpenIndex();
+
+    /**
+     * @brief Closes a damaged package manifest index.
+     * @param e The exception thrown while reading the index.
+     */
+    void DiscardDamagedIndex(const MiKTeX::Core::MiKTeXException& e);
+
+    bool IsIndexDamaged() const
+    {
+        return indexDamaged;
+    }
+
+    bool IsIndexOpen() const
+    {
+        return manifestIndex.IsOpen();
+    }
+
     class iterator
     {
     public:
@@ -227,6 +256,11 @@ private:
     typedef std::unordered_map<std::string, InstalledFileInfo, hash_path, equal_path> InstalledFileInfoTable;
 
     MiKTeX::Packages::PackageInfo& operator[](const std::string& packageId);
+    void ApplyContainerTimeInstalled(MiKTeX::Packages::PackageInfo& packageInfo, const std::vector<std::time_t>& requirementsTimeInstalled);
+    void ApplyVarData(MiKTeX::Packages::PackageInfo& packageInfo);
+    MiKTeX::Util::PathName GetIndexPath();
+    std::string GetSyntheticContainer(const MiKTeX::Packages::PackageInfo& packageInfo);
+    std::vector<MiKTeX::Util::PathName> GetPackageManifestsIniFiles();
     MiKTeX::Packages::RepositoryReleaseState GetReleaseState(const std::string& packageId);
     bool IsObsolete(const std::string& packageId);
     bool IsRemovable(const std::string& packageId);
@@ -235,10 +269,15 @@ private:
     void IncrementFileRefCounts(const std::vector<std::string>& files);
     void Load(MiKTeX::Core::Cfg& cfg);
     void LoadVarData();
+    MiKTeX::Packages::PackageInfo MakeSyntheticContainer(const std::string& packageId);
+    std::tuple<bool, MiKTeX::Packages::PackageInfo> TryGetPackageFromIndex(const std::string& packageId);
+    void WriteIndex();
 
     ComboCfg comboCfg;
+    bool indexDamaged = false;
     InstalledFileInfoTable installedFileInfoTable;
     bool loadedAllPackageManifests = false;
+    PackageManifestIndex manifestIndex;
     PackageDefinitionTable packageTable;
     std::shared_ptr<MiKTeX::Core::Session> session = MIKTEX_SESSION();
     std::unique_ptr<MiKTeX::Trace::TraceStream> trace_mpm;
@@ -13,6 +13,7 @@
 
 #include "config.h"
 
+#include <algorithm>
 #include <set>
 #include <unordered_set>
 
@@ -43,6 +44,7 @@
 #include "TpmParser.h"
 
 using namespace std;
+using namespace std::chrono_literals;
 
 using namespace MiKTeX::Configuration;
 using namespace MiKTeX::Core;
@@ -55,6 +57,16 @@ using namespace MiKTeX::Packages::D6AAD62216146D44B580E92711724B78;
 
 constexpr const char* LF = "\n";
 
+constexpr int DEFAULT_MAX_PARALLEL_DOWNLOADS = 4;
+
+constexpr size_t EXTRACTION_BATCH_SIZE = 16;
+
+#if defined(CURL_MAX_WRITE_SIZE)
+constexpr size_t DOWNLOAD_BUFFER_SIZE = 2 * CURL_MAX_WRITE_SIZE;
+#else
+constexpr size_t DOWNLOAD_BUFFER_SIZE = 32 * 1024;
+#endif
+
 template<typename T1, typename T2> double Divide(T1 a, T2 b)
 {
     return static_cast<double>(a) / static_cast<double>(b);
@@ -153,12 +165,7 @@ void PackageInstallerImpl::Download(const string& url, const PathName& dest, siz
 
     // receive the data
     trace_mpm->WriteLine(TRACE_FACILITY, fmt::format(T_("start writing on {0}"), Q_(dest)));
-#if defined(CURL_MAX_WRITE_SIZE)
-    const size_t bufsize = 2 * CURL_MAX_WRITE_SIZE;
-#else
-    const size_t bufsize = 32 * 1024;
-#endif
-    char buf[bufsize];
+    char buf[DOWNLOAD_BUFFER_SIZE];
     size_t n;
     size_t received = 0;
     clock_t start = clock();
@@ -215,14 +222,15 @@ void PackageInstallerImpl::Download(const string& url, const PathName& dest, siz
     }
 }
 
-void PackageInstallerImpl::OnBeginFileExtraction(const string& fileName, size_t uncompressedSize)
+void PackageInstallerImpl::PackageInstallation::OnBeginFileExtraction(const string& fileName, size_t uncompressedSize)
 {
     UNUSED_ALWAYS(uncompressedSize);
 
     // update progress info
     {
-        lock_guard<mutex> lockGuard(progressIndicatorMutex);
-        progressInfo.fileName = fileName;
+        lock_guard<mutex> lockGuard(installer->progressIndicatorMutex);
+        UpdateProgressInfo();
+        installer->progressInfo.fileName = fileName;
     }
 
     if (!fileName.empty())
@@ -234,7 +242,7 @@ void PackageInstallerImpl::OnBeginFileExtraction(const string& fileName, size_t
     Notify(Notification::InstallFileStart);
 }
 
-void PackageInstallerImpl::OnEndFileExtraction(const string& fileName, size_t uncompressedSize)
+void PackageInstallerImpl::PackageInstallation::OnEndFileExtraction(const string& fileName, size_t uncompressedSize)
 {
     if (!fileName.empty())
     {
@@ -243,27 +251,51 @@ void PackageInstallerImpl::OnEndFileExtraction(const string& fileName, size_t un
 
     // update progress info
     {
-        lock_guard<mutex> lockGuard(progressIndicatorMutex);
-        progressInfo.fileName = "";
-        progressInfo.cFilesPackageInstallCompleted += 1;
-        progressInfo.cFilesInstallCompleted += 1;
-        progressInfo.cbPackageInstallCompleted += uncompressedSize;
-        progressInfo.cbInstallCompleted += uncompressedSize;
+        lock_guard<mutex> lockGuard(installer->progressIndicatorMutex);
+        filesCompleted += 1;
+        bytesCompleted += uncompressedSize;
+        UpdateProgressInfo();
+        installer->progressInfo.fileName = "";
+        installer->progressInfo.cFilesInstallCompleted += 1;
+        installer->progressInfo.cbInstallCompleted += uncompressedSize;
     }
 
     // notify client: end of file extraction
     Notify(Notification::InstallFileEnd);
 }
 
-bool PackageInstallerImpl::OnError(const string& message)
+bool PackageInstallerImpl::PackageInstallation::OnError(const string& message)
 {
+    // the client cannot be asked on an extraction thread: give up
+    if (this_thread::get_id() != clientThread)
+    {
+        return false;
+    }
+
     // we have a problem: let the client decide how to proceed
-    return !AbortOrRetry(message);
+    return !installer->AbortOrRetry(message);
 }
 
-void PackageInstallerImpl::ExtractFiles(const PathName& archiveFileName, ArchiveFileType archiveFileType)
+void PackageInstallerImpl::PackageInstallation::UpdateProgressInfo()
 {
-    MiKTeX::Extractor::Extractor::CreateExtractor(archiveFileType)->Extract(archiveFileName, session->GetSpecialPath(SpecialPath::InstallRoot), true, this, TEXMF_PREFIX_DIRECTORY);
+    // archive files are extracted concurrently: show the package of the
+    // file at hand
+    ProgressInfo& progressInfo = installer->progressInfo;
+    progressInfo.packageId = packageId;
+    progressInfo.displayName = package.displayName;
+    progressInfo.cFilesPackageInstallCompleted = filesCompleted;
+    progressInfo.cFilesPackageInstallTotal = package.GetNumFiles();
+    progressInfo.cbPackageInstallCompleted = bytesCompleted;
+    progressInfo.cbPackageInstallTotal = package.GetSize();
+}
+
+void PackageInstallerImpl::PackageInstallation::Notify(Notification nf)
+{
+    // the client is called on the installer's thread only
+    if (this_thread::get_id() == clientThread)
+    {
+        installer->Notify(nf);
+    }
 }
 
 void PackageInstallerImpl::InstallRepositoryManifest(bool fromCache)
@@ -710,7 +742,7 @@ void PackageInstallerImpl::RemoveFiles(const vector<string>& toBeRemoved, bool s
         // only delete if the reference count reached zero
         if (refCount > 0)
         {
-            trace_mpm->WriteLine(TRACE_FACILITY, fmt::format(T_("will not delete {0} (ref count is {1})"), Q_(path), refCount));
+            trace_mpm->WriteLine(TRACE_FACILITY, [&]() { return fmt::format(T_("will not delete {0} (ref count is {1})"), Q_(path), refCount); });
             done = true;
         }
         else if (File::Exists(path))
@@ -734,7 +766,7 @@ void PackageInstallerImpl::RemoveFiles(const vector<string>& toBeRemoved, bool s
         }
         else
         {
-            trace_mpm->WriteLine(TRACE_FACILITY, fmt::format(T_("file {0} does not exist"), Q_(path)));
+            trace_mpm->WriteLine(TRACE_FACILITY, [&]() { return fmt::format(T_("file {0} does not exist"), Q_(path)); });
             done = true;
         }
 
@@ -1009,12 +1041,16 @@ void PackageInstallerImpl::UpdateFndb(const unordered_set<PathName>& installedFi
     }
 }
 
-void PackageInstallerImpl::InstallPackage(const string& packageId, Cfg& packageManifests)
+unique_ptr<PackageInstallerImpl::PackageInstallation> PackageInstallerImpl::BeginInstallPackage(const string& packageId)
 {
     trace_mpm->WriteLine(TRACE_FACILITY, TraceLevel::Info, fmt::format(T_("installing package {0}"), Q_(packageId)));
 
+    unique_ptr<PackageInstallation> installation = make_unique<PackageInstallation>(this);
+    installation->packageId = packageId;
+
     // search the package table
-    PackageInfo package = packageDataStore->GetPackage(packageId);
+    installation->package = packageDataStore->GetPackage(packageId);
+    const PackageInfo& package = installation->package;
 
     NeedRepository();
 
@@ -1037,9 +1073,10 @@ void PackageInstallerImpl::InstallPackage(const string& packageId, Cfg& packageM
     // notify client: beginning of package installation
     Notify(Notification::InstallPackageStart);
 
-    PathName pathArchiveFile;
+    PathName& pathArchiveFile = installation->archiveFile;
     ArchiveFileType aft = repositoryManifest.GetArchiveFileType(packageId);
-    unique_ptr<TemporaryFile> temporaryFile;
+    installation->archiveFileType = aft;
+    unique_ptr<TemporaryFile>& temporaryFile = installation->temporaryFile;
 
     // get hold of the archive file
     if (repositoryType == RepositoryType::Remote
@@ -1048,12 +1085,25 @@ void PackageInstallerImpl::InstallPackage(const string& packageId, Cfg& packageM
         PathName packageFileName(packageId);
         packageFileName.AppendExtension(MiKTeX::Extractor::Extractor::GetFileNameExtension(aft));
 
-        if (repositoryType == RepositoryType::Remote)
+        unique_ptr<PackageDownload> download;
+        if (repositoryType == RepositoryType::Remote && (download = WaitForDownload(packageId)) != nullptr)
+        {
+            // the package has been fetched by a download worker
+            temporaryFile = std::move(download->archiveFile);
+            pathArchiveFile = temporaryFile->GetPathName();
+            lock_guard<mutex> lockGuard(progressIndicatorMutex);
+            progressInfo.cbPackageDownloadCompleted = download->received;
+            if (download->expectedSize > 0 && download->expectedSize != download->received)
+            {
+                MIKTEX_FATAL_ERROR_2(FatalError(ERROR_SIZE_MISMATCH), "dest", pathArchiveFile.ToString(), "expectecSize", std::to_string(download->expectedSize), "received", std::to_string(download->received));
+            }
+        }
+        else if (repositoryType == RepositoryType::Remote)
         {
             // take hold of the package
             temporaryFile = TemporaryFile::Create();
             pathArchiveFile = temporaryFile->GetPathName();
-            Download(MakeUrl(packageFileName.ToString()), temporaryFile->GetPathName());
+            Download(MakeUrl(packageFileName.ToString()), temporaryFile->GetPathName(), repositoryManifest.GetArchiveFileSize(packageId));
         }
         else
         {
@@ -1063,7 +1113,10 @@ void PackageInstallerImpl::InstallPackage(const string& packageId, Cfg& packageM
         }
 
         // check to see whether the digest is good
-        if (!CheckArchiveFile(packageId, pathArchiveFile, false))
+        bool digestOk = download != nullptr
+            ? CheckArchiveFile(packageId, pathArchiveFile, download->digest, false)
+            : CheckArchiveFile(packageId, pathArchiveFile, false);
+        if (!digestOk)
         {
             LoadRepositoryManifest(true);
             CheckArchiveFile(packageId, pathArchiveFile, true);
@@ -1088,9 +1141,8 @@ void PackageInstallerImpl::InstallPackage(const string& packageId, Cfg& packageM
 
     if (repositoryType == RepositoryType::Remote || repositoryType == RepositoryType::Local)
     {
-        // unpack the archive file
+        // the archive file is extracted by InstallPackages()
         ReportLine(fmt::format(T_("extracting files from {0}..."), Q_(packageId + MiKTeX::Extractor::Extractor::GetFileNameExtension(aft))));
-        ExtractFiles(pathArchiveFile, aft);
     }
     else if (repositoryType == RepositoryType::MiKTeXDirect)
     {
@@ -1111,6 +1163,19 @@ void PackageInstallerImpl::InstallPackage(const string& packageId, Cfg& packageM
         MIKTEX_UNEXPECTED();
     }
 
+    installation->installedFiles = std::move(installedFiles);
+    installation->removedFiles = std::move(removedFiles);
+    installedFiles.clear();
+    removedFiles.clear();
+
+    return installation;
+}
+
+void PackageInstallerImpl::EndInstallPackage(PackageInstallation& installation, Cfg& packageManifests)
+{
+    const string& packageId = installation.packageId;
+    const PackageInfo& package = installation.package;
+
     // parse the new package manifest file
     PathName pathPackageFile = session->GetSpecialPath(SpecialPath::InstallRoot) / MIKTEX_PATH_PACKAGE_MANIFEST_DIR / packageId;
     pathPackageFile.AppendExtension(MIKTEX_PACKAGE_MANIFEST_FILE_SUFFIX);
@@ -1124,7 +1189,7 @@ void PackageInstallerImpl::InstallPackage(const string& packageId, Cfg& packageM
     PackageManager::PutPackageManifest(packageManifests, newPackage, newPackage.timePackaged);
 
     // update file name database
-    UpdateFndb(installedFiles, removedFiles, "");
+    UpdateFndb(installation.installedFiles, installation.removedFiles, "");
     UpdateFndb(GetFiles(session->GetMpmRootPath(), newPackage), GetFiles(session->GetMpmRootPath(), package), packageId);
 
     // set the timeInstalled value => package is installed
@@ -1150,6 +1215,40 @@ void PackageInstallerImpl::InstallPackage(const string& packageId, Cfg& packageM
     Notify(Notification::InstallPackageEnd);
 }
 
+void PackageInstallerImpl::InstallPackages(const vector<string>& packages, Cfg& packageManifests)
+{
+    // the archive files of a batch are extracted at the same time; a
+    // batch is small, because fetched archive files occupy disk space
+    // until they have been extracted
+    for (size_t batchStart = 0; batchStart < packages.size(); batchStart += EXTRACTION_BATCH_SIZE)
+    {
+        size_t batchEnd = min(batchStart + EXTRACTION_BATCH_SIZE, packages.size());
+        vector<unique_ptr<PackageInstallation>> installations;
+        vector<ExtractionJob> jobs;
+        for (size_t idx = batchStart; idx < batchEnd; ++idx)
+        {
+            installations.push_back(BeginInstallPackage(packages[idx]));
+            PackageInstallation& installation = *installations.back();
+            if (!installation.archiveFile.Empty())
+            {
+                ExtractionJob job;
+                job.archiveFileType = installation.archiveFileType;
+                job.path = installation.archiveFile;
+                job.destDir = session->GetSpecialPath(SpecialPath::InstallRoot);
+                job.makeDirectories = true;
+                job.callback = &installation;
+                job.prefix = TEXMF_PREFIX_DIRECTORY;
+                jobs.push_back(job);
+            }
+        }
+        MiKTeX::Extractor::Extractor::ExtractAll(jobs, 0);
+        for (unique_ptr<PackageInstallation>& installation : installations)
+        {
+            EndInstallPackage(*installation, packageManifests);
+        }
+    }
+}
+
 void PackageInstallerImpl::DownloadPackage(const string& packageId)
 {
     size_t expectedSize;
@@ -1175,16 +1274,164 @@ void PackageInstallerImpl::DownloadPackage(const string& packageId)
     PathName pathArchiveFile(packageId);
     pathArchiveFile.AppendExtension(MiKTeX::Extractor::Extractor::GetFileNameExtension(aft));
 
-    // download the archive file
-    Download(pathArchiveFile, expectedSize);
+    unique_ptr<PackageDownload> download = WaitForDownload(packageId);
 
-    // check to see whether the archive file is ok
-    CheckArchiveFile(packageId, downloadDirectory / pathArchiveFile.ToString(), true);
+    if (download != nullptr)
+    {
+        // the archive file has been fetched by a download worker
+        {
+            lock_guard<mutex> lockGuard(progressIndicatorMutex);
+            progressInfo.cbPackageDownloadCompleted = download->received;
+        }
+        if (expectedSize > 0 && expectedSize != download->received)
+        {
+            MIKTEX_FATAL_ERROR_2(FatalError(ERROR_SIZE_MISMATCH), "dest", download->archiveFile->GetPathName().ToString(), "expectecSize", std::to_string(expectedSize), "received", std::to_string(download->received));
+        }
+        CheckArchiveFile(packageId, download->archiveFile->GetPathName(), download->digest, true);
+        download->archiveFile->Keep();
+    }
+    else
+    {
+        // download the archive file
+        Download(pathArchiveFile, expectedSize);
+
+        // check to see whether the archive file is ok
+        CheckArchiveFile(packageId, downloadDirectory / pathArchiveFile.ToString(), true);
+    }
 
     // notify client: end of package download
     Notify(Notification::DownloadPackageEnd);
 }
 
+void PackageInstallerImpl::StartDownloads(const vector<string>& packages, const PathName& directory)
+{
+    MIKTEX_ASSERT(repositoryType == RepositoryType::Remote);
+    MIKTEX_ASSERT(downloadQueue.GetSize() == 0);
+
+    int maxParallelDownloads = session->GetConfigValue(MIKTEX_CONFIG_SECTION_MPM, MIKTEX_CONFIG_VALUE_MAX_PARALLEL_DOWNLOADS, ConfigValue(DEFAULT_MAX_PARALLEL_DOWNLOADS)).GetInt();
+    if (maxParallelDownloads <= 1 || packages.size() <= 1)
+    {
+        return;
+    }
+    size_t numWorkers = min(static_cast<size_t>(maxParallelDownloads), packages.size());
+
+    for (const string& packageId : packages)
+    {
+        ArchiveFileType aft = repositoryManifest.GetArchiveFileType(packageId);
+        PathName packageFileName(packageId);
+        packageFileName.AppendExtension(MiKTeX::Extractor::Extractor::GetFileNameExtension(aft));
+        unique_ptr<PackageDownload> download = make_unique<PackageDownload>();
+        download->packageId = packageId;
+        download->url = MakeUrl(packageFileName.ToString());
+        download->expectedSize = repositoryManifest.GetArchiveFileSize(packageId);
+        download->archiveFile = TemporaryFile::Create(directory / packageFileName.ToString());
+        downloadQueue.Add(packageId, std::move(download));
+    }
+    downloadsStarted = chrono::steady_clock::now();
+
+    trace_mpm->WriteLine(TRACE_FACILITY, fmt::format(T_("downloading {0} archive files over {1} connections"), downloadQueue.GetSize(), numWorkers));
+
+    // the library must not be initialized by the workers concurrently
+    WebSession::GlobalInitialize();
+
+    // do not run too far ahead of the consumer: archive files which have
+    // been fetched but not yet collected occupy disk space
+    downloadQueue.Start(numWorkers, 4 * numWorkers, [this]()
+    {
+        // each worker has its own connection
+        shared_ptr<WebSession> webSession = WebSession::Create(&downloadProgressNotify);
+        return [this, webSession](PackageDownload& download)
+        {
+            TransferPackage(*webSession, download);
+        };
+    });
+}
+
+void PackageInstallerImpl::StopDownloads()
+{
+    // this deletes archive files which have not been collected
+    downloadQueue.Stop();
+    downloadTemporaryDirectory = nullptr;
+}
+
+void PackageInstallerImpl::OnDownloadProgress()
+{
+    // called on a worker thread: the client is notified by the consumer
+    if (downloadQueue.IsStopped())
+    {
+        throw OperationCancelledException();
+    }
+}
+
+void PackageInstallerImpl::TransferPackage(WebSession& webSession, PackageDownload& download)
+{
+    PathName dest = download.archiveFile->GetPathName();
+
+    trace_mpm->WriteLine(TRACE_FACILITY, fmt::format(T_("going to download: {0} => {1}"), Q_(download.url), Q_(dest)));
+
+    // output is collected and reported by the consumer
+    download.report.push_back(fmt::format(T_("downloading {0} (expecting {1} bytes)..."), Q_(download.url), download.expectedSize));
+
+    unique_ptr<WebFile> webFile(webSession.OpenUrl(download.url));
+    FileStream destStream(File::Open(dest, FileMode::Create, FileAccess::Write, false));
+    unique_ptr<char[]> buf = make_unique<char[]>(DOWNLOAD_BUFFER_SIZE);
+    size_t n;
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    while ((n = webFile->Read(buf.get(), DOWNLOAD_BUFFER_SIZE)) > 0)
+    {
+        OnDownloadProgress();
+        destStream.Write(buf.get(), n);
+        download.received += n;
+        lock_guard<mutex> lockGuard(progressIndicatorMutex);
+        progressInfo.cbDownloadCompleted += n;
+    }
+    destStream.Close();
+    webFile->Close();
+
+    double mb = Divide(download.received, 1000000);
+    double seconds = max(chrono::duration<double>(chrono::steady_clock::now() - start).count(), 0.001);
+    trace_mpm->WriteLine(TRACE_FACILITY, fmt::format(T_("downloaded {0:.2f} MB in {1:.2f} seconds"), mb, seconds));
+    download.report.push_back(fmt::format(T_("{0:.2f} MB, {1:.2f} Mbit/s"), mb, Divide(8 * mb, seconds)));
+
+    // calculate the digest while we are at it
+    download.digest = MD5::FromFile(dest);
+}
+
+unique_ptr<PackageInstallerImpl::PackageDownload> PackageInstallerImpl::WaitForDownload(const string& packageId)
+{
+    exception_ptr exception;
+    unique_ptr<PackageDownload> result = downloadQueue.Collect(packageId, exception, [this]()
+    {
+        {
+            lock_guard<mutex> lockGuard(progressIndicatorMutex);
+            double seconds = chrono::duration<double>(chrono::steady_clock::now() - downloadsStarted).count();
+            if (seconds >= 1.0)
+            {
+                double bytesPerSecond = Divide(progressInfo.cbDownloadCompleted, seconds);
+                progressInfo.bytesPerSecond = static_cast<unsigned long>(bytesPerSecond);
+                if (bytesPerSecond > 0 && progressInfo.cbDownloadTotal > progressInfo.cbDownloadCompleted)
+                {
+                    progressInfo.timeRemaining = static_cast<unsigned long>(Divide(progressInfo.cbDownloadTotal - progressInfo.cbDownloadCompleted, bytesPerSecond));
+                }
+            }
+        }
+        Notify();
+    });
+    if (result == nullptr)
+    {
+        return nullptr;
+    }
+    for (const string& line : result->report)
+    {
+        ReportLine(line);
+    }
+    if (exception != nullptr)
+    {
+        rethrow_exception(exception);
+    }
+    return result;
+}
+
 void PackageInstallerImpl::CalculateExpenditure(bool downloadOnly)
 {
     ProgressInfo package;
@@ -1276,8 +1523,12 @@ bool PackageInstallerImpl::CheckArchiveFile(const std::string& packageId, const
     {
         MIKTEX_FATAL_ERROR_2(FatalError(ERROR_MISSING_PACKAGE), "package", packageId, "archiveFile", archiveFileName.ToString());
     }
+    return CheckArchiveFile(packageId, archiveFileName, MD5::FromFile(archiveFileName), mustBeOk);
+}
+
+bool PackageInstallerImpl::CheckArchiveFile(const std::string& packageId, const PathName& archiveFileName, const MD5& digest2, bool mustBeOk)
+{
     MD5 digest1 = repositoryManifest.GetArchiveFileDigest(packageId);
-    MD5 digest2 = MD5::FromFile(archiveFileName);
     bool ok = (digest1 == digest2);
     if (!ok && mustBeOk)
     {
@@ -1743,11 +1994,24 @@ void PackageInstallerImpl::InstallRemove(Role role)
             packageManifests->Read(packageManifestsIni);
         }
 
+        // fetch archive files in the background while installing
+        if (repositoryType == RepositoryType::Remote)
+        {
+            downloadTemporaryDirectory = TemporaryDirectory::Create();
+            StartDownloads(toBeInstalled, downloadTemporaryDirectory->GetPathName());
+        }
+
         // install packages
-        for (const string& p : toBeInstalled)
+        try
+        {
+            InstallPackages(toBeInstalled, *packageManifests);
+        }
+        catch (...)
         {
-            InstallPackage(p, *packageManifests);
+            StopDownloads();
+            throw;
         }
+        StopDownloads();
 
         // remove packages
         for (const string& p : toBeRemoved)
@@ -1769,10 +2033,7 @@ void PackageInstallerImpl::InstallRemove(Role role)
         {
             CheckDependencies(tmp, p, false, 0);
         }
-        for (const string& p : tmp)
-        {
-            InstallPackage(p, *packageManifests);
-        }
+        InstallPackages(vector<string>(tmp.begin(), tmp.end()), *packageManifests);
 
         if (File::Exists(packageManifestsIni))
         {
@@ -1959,10 +2220,20 @@ void PackageInstallerImpl::Download()
     Download(PathName(MIKTEX_PACKAGE_MANIFESTS_ARCHIVE_FILE_NAME));
 
     // download archive files
-    for (const string& p : toBeInstalled)
+    StartDownloads(toBeInstalled, downloadDirectory);
+    try
+    {
+        for (const string& p : toBeInstalled)
+        {
+            DownloadPackage(p);
+        }
+    }
+    catch (...)
     {
-        DownloadPackage(p);
+        StopDownloads();
+        throw;
     }
+    StopDownloads();
 }
 
 void PackageInstallerImpl::DownloadAsync()
@@ -13,6 +13,7 @@
 
 #pragma once
 
+#include <chrono>
 #include <memory>
 #include <mutex>
 #include <set>
@@ -20,11 +21,14 @@
 #include <vector>
 
 #include <miktex/Core/Cfg>
+#include <miktex/Core/MD5>
 #include <miktex/Core/Session>
+#include <miktex/Core/TemporaryDirectory>
 #include <miktex/Core/TemporaryFile>
 #include <miktex/Extractor/Extractor>
 #include <miktex/Trace/Trace>
 
+#include "DownloadQueue.h"
 #include "PackageManagerImpl.h"
 #include "RepositoryManifest.h"
 
@@ -45,7 +49,6 @@ class PackageInstallerImpl :
     public IProgressNotify_,
     public MiKTeX::Core::ICreateFndbCallback,
     public MiKTeX::Core::IRunProcessCallback,
-    public MiKTeX::Extractor::IExtractCallback,
     public MiKTeX::Packages::PackageInstaller
 {
 
@@ -61,9 +64,6 @@ public:
     void MIKTEXTHISCALL FindUpgradesAsync(PackageLevel packageLevel) override;
     void MIKTEXTHISCALL InstallRemove(Role role) override;
     void MIKTEXTHISCALL InstallRemoveAsync(Role role) override;
-    void MIKTEXTHISCALL OnBeginFileExtraction(const std::string& fileName, std::size_t uncompressedSize) override;
-    void MIKTEXTHISCALL OnEndFileExtraction(const std::string& fileName, std::size_t uncompressedSize) override;
-    bool MIKTEXTHISCALL OnError(const std::string& message) override;
     bool MIKTEXTHISCALL OnProcessOutput(const void* pOutput, std::size_t n) override;
     void OnProgress() override;
     void MIKTEXTHISCALL RegisterComponents(bool doRegister) override;
@@ -171,8 +171,69 @@ private:
         ERROR_SOURCE_FILE_NOT_FOUND,
     };
 
+    struct PackageDownload
+    {
+        std::string packageId;
+        std::string url;
+        std::size_t expectedSize = 0;
+        std::unique_ptr<MiKTeX::Core::TemporaryFile> archiveFile;
+        std::size_t received = 0;
+        MiKTeX::Core::MD5 digest;
+        std::vector<std::string> report;
+    };
+
+    // forwards the progress of a download worker's web session; unlike
+    // OnProgress(), this never calls into the client
+    class DownloadProgressNotify :
+        public IProgressNotify_
+    {
+    public:
+        DownloadProgressNotify(PackageInstallerImpl* installer) :
+            installer(installer)
+        {
+        }
+        void OnProgress() override
+        {
+            installer->OnDownloadProgress();
+        }
+    private:
+        PackageInstallerImpl* installer;
+    };
+
+    // a package being installed; its archive file is extracted together
+    // with those of other packages, so the extraction callbacks may be
+    // invoked on extraction threads
+    class PackageInstallation :
+        public MiKTeX::Extractor::IExtractCallback
+    {
+    public:
+        PackageInstallation(PackageInstallerImpl* installer) :
+            installer(installer)
+        {
+        }
+        void MIKTEXTHISCALL OnBeginFileExtraction(const std::string& fileName, std::size_t uncompressedSize) override;
+        void MIKTEXTHISCALL OnEndFileExtraction(const std::string& fileName, std::size_t uncompressedSize) override;
+        bool MIKTEXTHISCALL OnError(const std::string& message) override;
+        std::string packageId;
+        MiKTeX::Packages::PackageInfo package;
+        MiKTeX::Extractor::ArchiveFileType archiveFileType = MiKTeX::Extractor::ArchiveFileType::None;
+        MiKTeX::Util::PathName archiveFile;
+        std::unique_ptr<MiKTeX::Core::TemporaryFile> temporaryFile;
+        std::unordered_set<MiKTeX::Util::PathName> installedFiles;
+        std::unordered_set<MiKTeX::Util::PathName> removedFiles;
+    private:
+        void Notify(MiKTeX::Packages::Notification nf);
+        void UpdateProgressInfo();
+        PackageInstallerImpl* installer;
+        std::thread::id clientThread = std::this_thread::get_id();
+        std::size_t filesCompleted = 0;
+        std::size_t bytesCompleted = 0;
+    };
+
+    std::unique_ptr<PackageInstallation> BeginInstallPackage(const std::string& packageId);
     void CalculateExpenditure(bool downloadOnly = false);
     bool CheckArchiveFile(const std::string& packageId, const MiKTeX::Util::PathName& archiveFileName, bool mustBeOk);
+    bool CheckArchiveFile(const std::string& packageId, const MiKTeX::Util::PathName& archiveFileName, const MiKTeX::Core::MD5& digest, bool mustBeOk);
     void CheckDependencies(std::set<std::string>& packages, const std::string& packageId, bool force, int level);
     void CleanUpUserDatabase();
     void CopyFiles(const MiKTeX::Util::PathName& pathSourceRoot, const std::vector<std::string>& fileList);
@@ -181,13 +242,13 @@ private:
     void Download(const std::string& url, const MiKTeX::Util::PathName& dest, std::size_t expectedSize = 0);
     void DownloadPackage(const std::string& packageId);
     void DownloadThread();
-    void ExtractFiles(const MiKTeX::Util::PathName& archiveFileName, MiKTeX::Extractor::ArchiveFileType archiveFileType);
+    void EndInstallPackage(PackageInstallation& installation, MiKTeX::Core::Cfg& packageManifests);
     std::string FatalError(ErrorCode error);
     void FindUpdatesNoLock();
     void FindUpdatesThread();
     void FindUpgradesNoLock(PackageLevel packageLevel);
     void FindUpgradesThread();
-    void InstallPackage(const std::string& packageId, MiKTeX::Core::Cfg& packageManifests);
+    void InstallPackages(const std::vector<std::string>& packages, MiKTeX::Core::Cfg& packageManifests);
     void HandleObsoletePackageManifests(MiKTeX::Core::Cfg& cfgExisting, const MiKTeX::Core::Cfg& cfgNew);
     void InstallRemoveThread();
     void InstallRepositoryManifest(bool fromCache);
@@ -195,6 +256,7 @@ private:
     std::string MakeUrl(const std::string& relPath);
     void MyCopyFile(const MiKTeX::Util::PathName& source, const MiKTeX::Util::PathName& dest, std::size_t& size);
     void NeedRepository();
+    void OnDownloadProgress();
     bool MIKTEXTHISCALL OnProgress(unsigned level, const MiKTeX::Util::PathName& directory) override;
     bool MIKTEXTHISCALL ReadDirectory(const MiKTeX::Util::PathName& path, std::vector<std::string>& subDirNames, std::vector<std::string>& fileNames, std::vector<std::string>& fileNameInfos) override;
     void RegisterComponents(bool doRegister, const std::vector<std::string>& packages);
@@ -202,7 +264,11 @@ private:
     void RemovePackage(const std::string& packageId, MiKTeX::Core::Cfg& packageManifests);
     void ReportLine(const std::string& s);
     void RunOneMiKTeXUtility(const std::vector<std::string>& arguments);
+    void StartDownloads(const std::vector<std::string>& packages, const MiKTeX::Util::PathName& directory);
     void StartWorkerThread(void (PackageInstallerImpl::* method)());
+    void StopDownloads();
+    void TransferPackage(WebSession& webSession, PackageDownload& download);
+    std::unique_ptr<PackageDownload> WaitForDownload(const std::string& packageId);
     void UpdateDbNoLock(UpdateDbOptionSet options);
     void UpdateDbThread();
     void UpdateFndb(const std::unordered_set<MiKTeX::Util::PathName>& installedFiles, const std::unordered_set<MiKTeX::Util::PathName>& removedFiles, const std::string& packageId);
@@ -240,6 +306,10 @@ private:
     MiKTeX::Packages::PackageInstallerCallback* callback = nullptr;
     Role currentRole;
     MiKTeX::Util::PathName downloadDirectory;
+    DownloadProgressNotify downloadProgressNotify{ this };
+    DownloadQueue<PackageDownload> downloadQueue;
+    std::chrono::steady_clock::time_point downloadsStarted;
+    std::unique_ptr<MiKTeX::Core::TemporaryDirectory> downloadTemporaryDirectory;
     bool enablePostProcessing = true;
     std::unordered_set<MiKTeX::Util::PathName> installedFiles;
     PackageDataStore* packageDataStore = nullptr;
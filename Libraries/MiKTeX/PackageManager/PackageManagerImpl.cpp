@@ -179,32 +179,68 @@ void PackageManagerImpl::UnloadDatabase()
     ClearAll();
 }
 
-bool PackageManagerImpl::TryGetPackageInfo(const string& packageId, PackageInfo& packageInfo)
+void PackageManagerImpl::OpenIndexOrLoad()
 {
-    if (!packageDataStore.LoadedAllPackageManifests())
+    if (packageDataStore.LoadedAllPackageManifests() || packageDataStore.IsIndexOpen())
     {
-        MPM_LOCK_BEGIN(this)
+        return;
+    }
+    MPM_LOCK_BEGIN(this)
+    {
+        if (!packageDataStore.TryOpenIndex())
         {
             packageDataStore.Load();
         }
-        MPM_LOCK_END();
     }
+    MPM_LOCK_END();
+}
+
+void PackageManagerImpl::ReloadDamagedIndex(const MiKTeXException& e)
+{
+    MPM_LOCK_BEGIN(this)
+    {
+        packageDataStore.DiscardDamagedIndex(e);
+        packageDataStore.Load();
+    }
+    MPM_LOCK_END();
+}
+
+bool PackageManagerImpl::TryGetPackageInfo(const string& packageId, PackageInfo& packageInfo)
+{
+    OpenIndexOrLoad();
     bool knownPackage;
-    tie(knownPackage, packageInfo) = packageDataStore.TryGetPackage(packageId);
+    try
+    {
+        tie(knownPackage, packageInfo) = packageDataStore.TryGetPackage(packageId);
+    }
+    catch (const MiKTeXException& e)
+    {
+        if (packageDataStore.LoadedAllPackageManifests() || !packageDataStore.IsIndexDamaged())
+        {
+            throw;
+        }
+        ReloadDamagedIndex(e);
+        tie(knownPackage, packageInfo) = packageDataStore.TryGetPackage(packageId);
+    }
     return knownPackage;
 }
 
 PackageInfo PackageManagerImpl::GetPackageInfo(const string& packageId)
 {
-    if (!packageDataStore.LoadedAllPackageManifests())
+    OpenIndexOrLoad();
+    try
+    {
+        return packageDataStore.GetPackage(packageId);
+    }
+    catch (const MiKTeXException& e)
     {
-        MPM_LOCK_BEGIN(this)
+        if (packageDataStore.LoadedAllPackageManifests() || !packageDataStore.IsIndexDamaged())
         {
-            packageDataStore.Load();
+            throw;
         }
-        MPM_LOCK_END();
+        ReloadDamagedIndex(e);
+        return packageDataStore.GetPackage(packageId);
     }
-    return packageDataStore.GetPackage(packageId);
 }
 
 bool PackageManager::TryGetRemotePackageRepository(string& url, RepositoryReleaseState& repositoryReleaseState)
@@ -1129,10 +1165,8 @@ bool PackageManagerImpl::TryCollectFileDigests(const PathName& prefix, const vec
     return true;
 }
 
-bool PackageManagerImpl::TryVerifyInstalledPackageNoLock(const string& packageId)
+PathName PackageManagerImpl::GetVerificationPrefix(const PackageInfo& packageInfo)
 {
-    PackageInfo packageInfo = packageDataStore.GetPackage(packageId);
-
     PathName prefix;
 
     if (!session->IsAdminMode() && packageInfo.IsInstalled(ConfigurationScope::User))
@@ -1145,6 +1179,15 @@ bool PackageManagerImpl::TryVerifyInstalledPackageNoLock(const string& packageId
         prefix = session->GetSpecialPath(SpecialPath::CommonInstallRoot);
     }
 
+    return prefix;
+}
+
+bool PackageManagerImpl::TryVerifyInstalledPackageNoLock(const string& packageId)
+{
+    PackageInfo packageInfo = packageDataStore.GetPackage(packageId);
+
+    PathName prefix = GetVerificationPrefix(packageInfo);
+
     FileDigestTable fileDigests;
 
     if (!TryCollectFileDigests(prefix, packageInfo.runFiles, fileDigests)
@@ -1154,29 +1197,40 @@ bool PackageManagerImpl::TryVerifyInstalledPackageNoLock(const string& packageId
         return false;
     }
 
-    MD5Builder md5Builder;
-
-    for (const pair<string, MD5> p : fileDigests)
-    {
-        PathName path(p.first);
-        // we must dosify the path name for backward compatibility
-        path.ConvertToDos();
-        md5Builder.Update(path.GetData(), path.GetLength());
-        md5Builder.Update(p.second.data(), p.second.size());
-    }
+    MD5 digest = PackageVerifier::GetPackageDigest(fileDigests);
 
-    bool ok = md5Builder.Final() == packageInfo.digest;
+    bool ok = digest == packageInfo.digest;
 
     if (!ok)
     {
         trace_mpm->WriteLine(TRACE_FACILITY, TraceLevel::Warning, fmt::format(T_("package {0} verification failed: some files have been modified"), Q_(packageId)));
         trace_mpm->WriteLine(TRACE_FACILITY, TraceLevel::Warning, fmt::format(T_("expected digest: {0}"), packageInfo.digest.ToString()));
-        trace_mpm->WriteLine(TRACE_FACILITY, TraceLevel::Warning, fmt::format(T_("computed digest: {0}"), md5Builder.GetMD5().ToString()));
+        trace_mpm->WriteLine(TRACE_FACILITY, TraceLevel::Warning, fmt::format(T_("computed digest: {0}"), digest.ToString()));
     }
 
     return ok;
 }
 
+bool PackageManagerImpl::VerifyInstalledPackagesNoLock(const vector<string>& packageIds, const VerifyOptions& options, PackageVerificationCallback* callback)
+{
+    vector<PackageVerificationJob> jobs;
+    jobs.reserve(packageIds.size());
+    for (const string& packageId : packageIds)
+    {
+        PackageInfo packageInfo = packageDataStore.GetPackage(packageId);
+        PackageVerificationJob job;
+        job.packageId = packageId;
+        job.prefix = GetVerificationPrefix(packageInfo);
+        job.files = packageInfo.runFiles;
+        job.files.insert(job.files.end(), packageInfo.docFiles.begin(), packageInfo.docFiles.end());
+        job.files.insert(job.files.end(), packageInfo.sourceFiles.begin(), packageInfo.sourceFiles.end());
+        job.expectedDigest = packageInfo.digest;
+        jobs.push_back(job);
+    }
+    PackageVerifier verifier(options, trace_mpm.get());
+    return verifier.Run(jobs, callback);
+}
+
 string PackageManagerImpl::GetContainerPathNoLock(const string& packageId, bool useDisplayNames)
 {
     string path;
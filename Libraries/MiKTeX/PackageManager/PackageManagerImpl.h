@@ -27,6 +27,7 @@
 
 #include "PackageDataStore.h"
 #include "PackageRepositoryDataStore.h"
+#include "PackageVerifier.h"
 #include "WebSession.h"
 
 #define MPM_LOCK_BEGIN(packageManager)                                      \
@@ -39,8 +40,6 @@
 
 MPM_INTERNAL_BEGIN_NAMESPACE;
 
-typedef std::map<std::string, MiKTeX::Core::MD5, MiKTeX::Core::less_icase_dos> FileDigestTable;
-
 class PackageManagerImpl :
     public std::enable_shared_from_this<PackageManagerImpl>,
     public MiKTeX::Packages::PackageManager,
@@ -140,6 +139,21 @@ public:
 
     bool MIKTEXTHISCALL TryVerifyInstalledPackageNoLock(const std::string& packageId);
 
+    bool MIKTEXTHISCALL VerifyInstalledPackages(const std::vector<std::string>& packageIds, const MiKTeX::Packages::VerifyOptions& options, MiKTeX::Packages::PackageVerificationCallback* callback) override
+    {
+        if (!packageDataStore.LoadedAllPackageManifests())
+        {
+            MPM_LOCK_BEGIN(this)
+            {
+                packageDataStore.Load();
+            }
+            MPM_LOCK_END();
+        }
+        return VerifyInstalledPackagesNoLock(packageIds, options, callback);
+    }
+
+    bool VerifyInstalledPackagesNoLock(const std::vector<std::string>& packageIds, const MiKTeX::Packages::VerifyOptions& options, MiKTeX::Packages::PackageVerificationCallback* callback);
+
     std::string MIKTEXTHISCALL GetContainerPath(const std::string& packageId, bool useDisplayNames) override
     {
         if (!packageDataStore.LoadedAllPackageManifests())
@@ -162,7 +176,10 @@ public:
 
 private:
 
+    void OpenIndexOrLoad();
+    void ReloadDamagedIndex(const MiKTeX::Core::MiKTeXException& e);
     bool TryGetFileDigest(const MiKTeX::Util::PathName& prefix, const std::string& fileName, bool& haveDigest, MiKTeX::Core::MD5& digest);
+    MiKTeX::Util::PathName GetVerificationPrefix(const MiKTeX::Packages::PackageInfo& packageInfo);
     bool TryCollectFileDigests(const MiKTeX::Util::PathName& prefix, const std::vector<std::string>& files, FileDigestTable& fileDigests);
     void Dispose();
 
@@ -0,0 +1,490 @@
+/**
+ * @file PackageManifestIndex.cpp
+ * @author Christian Schenk
+ * @brief Compiled package manifest index
+ *
+ * @copyright Copyright © 2024 Christian Schenk
+ *
+ * This file is part of MiKTeX Package Manager.
+ *
+ * MiKTeX Package Manager is licensed under GNU General Public License version 2
+ * or any later version.
+ */
+
+#include "config.h"
+
+#include <cstring>
+
+#include <chrono>
+#include <filesystem>
+#include <system_error>
+#include <unordered_map>
+
+#include <miktex/Core/File>
+#include <miktex/Core/TemporaryFile>
+#include <miktex/Core/equal_icase>
+#include <miktex/Core/hash_icase>
+
+#include "internal.h"
+
+#include "PackageManifestIndex.h"
+
+using namespace std;
+
+using namespace MiKTeX::Core;
+using namespace MiKTeX::Packages;
+using namespace MiKTeX::Util;
+
+using namespace MiKTeX::Packages::D6AAD62216146D44B580E92711724B78;
+
+/*
+ * Layout of the index file (native byte order; the file is a local cache):
+ *
+ *   header        magic, version, sizeof(size_t), number of sources,
+ *                 number/offset of package slots, number/offset of file slots
+ *   sources       (exists, size, last write time in ns) of each INI file
+ *   package slots (hash, record offset); open addressing, linear probing
+ *   file slots    (hash, record offset); open addressing, linear probing
+ *   records       package records and file records
+ *
+ * A record offset of zero denotes an empty slot. Records are validated when
+ * they are read.
+ */
+
+constexpr uint32_t INDEX_MAGIC = 0x584d504d; // "MPMX"
+constexpr uint32_t INDEX_VERSION = 2;
+constexpr uint32_t HEADER_SIZE = 32;
+constexpr uint32_t SOURCE_SIZE = 24;
+constexpr uint32_t SLOT_SIZE = 16;
+
+namespace
+{
+    class IndexWriter
+    {
+    public:
+        uint32_t Offset() const
+        {
+            return static_cast<uint32_t>(bytes.size());
+        }
+        void Put(const void* p, size_t n)
+        {
+            const unsigned char* b = static_cast<const unsigned char*>(p);
+            bytes.insert(bytes.end(), b, b + n);
+        }
+        void PutUInt32(uint32_t v)
+        {
+            Put(&v, sizeof(v));
+        }
+        void PutUInt64(uint64_t v)
+        {
+            Put(&v, sizeof(v));
+        }
+        void PutString(const string& s)
+        {
+            PutUInt32(static_cast<uint32_t>(s.length()));
+            Put(s.data(), s.length());
+        }
+        void PutStrings(const vector<string>& v)
+        {
+            PutUInt32(static_cast<uint32_t>(v.size()));
+            for (const string& s : v)
+            {
+                PutString(s);
+            }
+        }
+        void PutSlot(uint32_t slotsOffset, uint32_t numSlots, uint64_t hash, uint32_t recordOffset)
+        {
+            uint32_t idx = static_cast<uint32_t>(hash & (numSlots - 1));
+            while (true)
+            {
+                unsigned char* slot = &bytes[slotsOffset + idx * SLOT_SIZE];
+                uint32_t existing;
+                memcpy(&existing, slot + 8, sizeof(existing));
+                if (existing == 0)
+                {
+                    memcpy(slot, &hash, sizeof(hash));
+                    memcpy(slot + 8, &recordOffset, sizeof(recordOffset));
+                    return;
+                }
+                idx = (idx + 1) & (numSlots - 1);
+            }
+        }
+        vector<unsigned char> bytes;
+    };
+
+    uint32_t NumSlots(size_t n)
+    {
+        // keep the load factor below 0.5
+        uint32_t numSlots = 16;
+        while (numSlots < 2 * n)
+        {
+            numSlots *= 2;
+        }
+        return numSlots;
+    }
+
+    void GetStamp(const PathName& path, uint64_t& exists, uint64_t& fileSize, uint64_t& lastWriteTime)
+    {
+        exists = File::Exists(path) ? 1 : 0;
+        fileSize = exists != 0 ? File::GetSize(path) : 0;
+        lastWriteTime = 0;
+        if (exists != 0)
+        {
+            // File::GetLastWriteTime() has a resolution of one second: too
+            // coarse for files which are rewritten in quick succession
+            error_code ec;
+            auto time = filesystem::last_write_time(filesystem::u8path(path.ToString()), ec);
+            if (ec)
+            {
+                MIKTEX_FATAL_ERROR_2(T_("The modification time of a file could not be determined."), "path", path.ToString(), "reason", ec.message());
+            }
+            lastWriteTime = static_cast<uint64_t>(chrono::duration_cast<chrono::nanoseconds>(time.time_since_epoch()).count());
+        }
+    }
+}
+
+void PackageManifestIndex::Write(const PathName& path, const vector<PathName>& sources, const vector<const PackageInfo*>& packages)
+{
+    typedef unordered_map<string, vector<uint32_t>, hash_path, equal_path> FileTable;
+
+    IndexWriter writer;
+
+    uint32_t numPackageSlots = NumSlots(packages.size());
+    uint32_t packageSlotsOffset = HEADER_SIZE + static_cast<uint32_t>(sources.size()) * SOURCE_SIZE;
+
+    // reserve header, sources and package slots; file slots follow later
+    writer.bytes.resize(packageSlotsOffset + numPackageSlots * SLOT_SIZE);
+
+    FileTable fileTable;
+    for (const PackageInfo* packageInfo : packages)
+    {
+        uint32_t recordOffset = writer.Offset();
+        writer.PutString(packageInfo->id);
+        writer.PutString(packageInfo->displayName);
+        writer.PutString(packageInfo->title);
+        writer.PutString(packageInfo->version);
+        writer.PutString(packageInfo->versionDate);
+        writer.PutString(packageInfo->targetSystem);
+        writer.PutString(packageInfo->minTargetSystemVersion);
+        writer.PutString(packageInfo->description);
+        writer.PutString(packageInfo->creator);
+        writer.PutString(packageInfo->ctanPath);
+        writer.PutString(packageInfo->copyrightOwner);
+        writer.PutString(packageInfo->copyrightYear);
+        writer.PutString(packageInfo->licenseType);
+        writer.Put(packageInfo->digest.data(), packageInfo->digest.size());
+        writer.PutUInt64(packageInfo->archiveFileSize);
+        writer.PutUInt64(packageInfo->sizeRunFiles);
+        writer.PutUInt64(packageInfo->sizeDocFiles);
+        writer.PutUInt64(packageInfo->sizeSourceFiles);
+        writer.PutUInt64(static_cast<uint64_t>(packageInfo->timePackaged));
+        writer.PutStrings(packageInfo->runFiles);
+        writer.PutStrings(packageInfo->docFiles);
+        writer.PutStrings(packageInfo->sourceFiles);
+        writer.PutStrings(packageInfo->requiredPackages);
+        writer.PutStrings(packageInfo->requiredBy);
+        writer.PutSlot(packageSlotsOffset, numPackageSlots, hash_icase()(packageInfo->id), recordOffset);
+        for (const vector<string>* files : { &packageInfo->runFiles, &packageInfo->docFiles, &packageInfo->sourceFiles })
+        {
+            for (const string& file : *files)
+            {
+                fileTable[file].push_back(recordOffset);
+            }
+        }
+    }
+
+    uint32_t numFileSlots = NumSlots(fileTable.size());
+    uint32_t fileSlotsOffset = writer.Offset();
+    writer.bytes.resize(fileSlotsOffset + numFileSlots * SLOT_SIZE);
+    for (const auto& kv : fileTable)
+    {
+        uint32_t recordOffset = writer.Offset();
+        writer.PutString(kv.first);
+        writer.PutUInt32(static_cast<uint32_t>(kv.second.size()));
+        for (uint32_t packageRecordOffset : kv.second)
+        {
+            writer.PutUInt32(packageRecordOffset);
+        }
+        writer.PutSlot(fileSlotsOffset, numFileSlots, PathName(kv.first).GetHash(), recordOffset);
+    }
+
+    // fill in the header
+    IndexWriter header;
+    header.PutUInt32(INDEX_MAGIC);
+    header.PutUInt32(INDEX_VERSION);
+    header.PutUInt32(static_cast<uint32_t>(sizeof(size_t)));
+    header.PutUInt32(static_cast<uint32_t>(sources.size()));
+    header.PutUInt32(numPackageSlots);
+    header.PutUInt32(packageSlotsOffset);
+    header.PutUInt32(numFileSlots);
+    header.PutUInt32(fileSlotsOffset);
+    for (const PathName& source : sources)
+    {
+        uint64_t exists, fileSize, lastWriteTime;
+        GetStamp(source, exists, fileSize, lastWriteTime);
+        header.PutUInt64(exists);
+        header.PutUInt64(fileSize);
+        header.PutUInt64(lastWriteTime);
+    }
+    MIKTEX_ASSERT(header.bytes.size() == packageSlotsOffset);
+    memcpy(writer.bytes.data(), header.bytes.data(), header.bytes.size());
+
+    // write a uniquely named temporary file and move it into place, so that
+    // readers never see a partially written index, even if several processes
+    // write the index at the same time
+    PathName directory = path.GetDirectoryName();
+    unique_ptr<TemporaryFile> tempFile = TemporaryFile::Create(directory);
+    PathName tempPath = tempFile->GetPathName();
+    File::WriteBytes(tempPath, writer.bytes);
+    File::SetAttributes(tempPath, {});
+    File::Move(tempPath, path, { FileMoveOption::ReplaceExisting });
+    tempFile->Keep();
+}
+
+bool PackageManifestIndex::Open(const PathName& path, const vector<PathName>& sources)
+{
+    Close();
+    // a truncated index is treated like a missing one
+    if (!File::Exists(path) || File::GetSize(path) < HEADER_SIZE)
+    {
+        return false;
+    }
+    mappedFile.reset(MemoryMappedFile::Create());
+    data = static_cast<const unsigned char*>(mappedFile->Open(path, false));
+    size = mappedFile->GetSize();
+    bool ok = size >= HEADER_SIZE
+        && ReadUInt32(0) == INDEX_MAGIC
+        && ReadUInt32(4) == INDEX_VERSION
+        && ReadUInt32(8) == sizeof(size_t)
+        && ReadUInt32(12) == sources.size();
+    if (ok)
+    {
+        numPackageSlots = ReadUInt32(16);
+        packageSlotsOffset = ReadUInt32(20);
+        numFileSlots = ReadUInt32(24);
+        fileSlotsOffset = ReadUInt32(28);
+        ok = packageSlotsOffset == HEADER_SIZE + sources.size() * SOURCE_SIZE
+            && static_cast<uint64_t>(packageSlotsOffset) + static_cast<uint64_t>(numPackageSlots) * SLOT_SIZE <= size
+            && static_cast<uint64_t>(fileSlotsOffset) + static_cast<uint64_t>(numFileSlots) * SLOT_SIZE <= size
+            && numPackageSlots > 0 && (numPackageSlots & (numPackageSlots - 1)) == 0
+            && numFileSlots > 0 && (numFileSlots & (numFileSlots - 1)) == 0
+            && fileSlotsOffset >= packageSlotsOffset + numPackageSlots * SLOT_SIZE;
+    }
+    for (size_t idx = 0; ok && idx < sources.size(); ++idx)
+    {
+        uint64_t exists, fileSize, lastWriteTime;
+        GetStamp(sources[idx], exists, fileSize, lastWriteTime);
+        uint32_t offset = HEADER_SIZE + static_cast<uint32_t>(idx) * SOURCE_SIZE;
+        ok = ReadUInt64(offset) == exists && ReadUInt64(offset + 8) == fileSize && ReadUInt64(offset + 16) == lastWriteTime;
+    }
+    if (!ok)
+    {
+        Close();
+    }
+    return ok;
+}
+
+void PackageManifestIndex::Close()
+{
+    if (mappedFile != nullptr)
+    {
+        mappedFile->Close();
+        mappedFile = nullptr;
+    }
+    data = nullptr;
+    size = 0;
+}
+
+bool PackageManifestIndex::HasPackage(const string& packageId) const
+{
+    return FindPackageRecord(packageId) != 0;
+}
+
+bool PackageManifestIndex::TryGetPackage(const string& packageId, PackageInfo& packageInfo) const
+{
+    uint32_t offset = FindPackageRecord(packageId);
+    if (offset == 0)
+    {
+        return false;
+    }
+    packageInfo = PackageInfo();
+    ReadPackageRecord(offset, packageInfo);
+    return true;
+}
+
+vector<string> PackageManifestIndex::GetPackageIds() const
+{
+    MIKTEX_ASSERT(IsOpen());
+    vector<string> result;
+    for (uint32_t idx = 0; idx < numPackageSlots; ++idx)
+    {
+        uint32_t offset = ReadUInt32(packageSlotsOffset + idx * SLOT_SIZE + 8);
+        if (offset != 0)
+        {
+            CheckRecordOffset(offset, packageSlotsOffset + numPackageSlots * SLOT_SIZE, fileSlotsOffset);
+            result.push_back(ReadString(offset));
+        }
+    }
+    return result;
+}
+
+vector<string> PackageManifestIndex::GetPackagesOfFile(const PathName& path) const
+{
+    MIKTEX_ASSERT(IsOpen());
+    vector<string> result;
+    uint64_t hash = path.GetHash();
+    uint32_t idx = static_cast<uint32_t>(hash & (numFileSlots - 1));
+    for (uint32_t probe = 0; probe < numFileSlots; ++probe)
+    {
+        uint32_t slot = fileSlotsOffset + idx * SLOT_SIZE;
+        uint32_t offset = ReadUInt32(slot + 8);
+        if (offset == 0)
+        {
+            break;
+        }
+        CheckRecordOffset(offset, fileSlotsOffset + numFileSlots * SLOT_SIZE, static_cast<uint32_t>(size));
+        if (ReadUInt64(slot) == hash)
+        {
+            if (PathName::Equals(PathName(ReadString(offset)), path))
+            {
+                uint32_t count = ReadUInt32(offset);
+                offset += 4;
+                for (uint32_t n = 0; n < count; ++n, offset += 4)
+                {
+                    uint32_t packageRecordOffset = ReadUInt32(offset);
+                    CheckRecordOffset(packageRecordOffset, packageSlotsOffset + numPackageSlots * SLOT_SIZE, fileSlotsOffset);
+                    result.push_back(ReadString(packageRecordOffset));
+                }
+                break;
+            }
+        }
+        idx = (idx + 1) & (numFileSlots - 1);
+    }
+    return result;
+}
+
+uint32_t PackageManifestIndex::FindPackageRecord(const string& packageId) const
+{
+    MIKTEX_ASSERT(IsOpen());
+    uint64_t hash = hash_icase()(packageId);
+    uint32_t idx = static_cast<uint32_t>(hash & (numPackageSlots - 1));
+    for (uint32_t probe = 0; probe < numPackageSlots; ++probe)
+    {
+        uint32_t slot = packageSlotsOffset + idx * SLOT_SIZE;
+        uint32_t offset = ReadUInt32(slot + 8);
+        if (offset == 0)
+        {
+            return 0;
+        }
+        CheckRecordOffset(offset, packageSlotsOffset + numPackageSlots * SLOT_SIZE, fileSlotsOffset);
+        if (ReadUInt64(slot) == hash)
+        {
+            uint32_t recordOffset = offset;
+            if (equal_icase()(ReadString(offset), packageId))
+            {
+                return recordOffset;
+            }
+        }
+        idx = (idx + 1) & (numPackageSlots - 1);
+    }
+    return 0;
+}
+
+void PackageManifestIndex::CheckRecordOffset(uint32_t offset, uint32_t recordsBegin, uint32_t recordsEnd) const
+{
+    if (offset < recordsBegin || offset >= recordsEnd)
+    {
+        MIKTEX_UNEXPECTED();
+    }
+}
+
+void PackageManifestIndex::ReadPackageRecord(uint32_t offset, PackageInfo& packageInfo) const
+{
+    auto readStrings = [this, &offset]()
+    {
+        uint32_t count = ReadUInt32(offset);
+        offset += 4;
+        // each string takes at least 4 bytes
+        if (static_cast<uint64_t>(offset) + static_cast<uint64_t>(count) * 4 > size)
+        {
+            MIKTEX_UNEXPECTED();
+        }
+        vector<string> result;
+        result.reserve(count);
+        for (uint32_t n = 0; n < count; ++n)
+        {
+            result.push_back(ReadString(offset));
+        }
+        return result;
+    };
+    auto readUInt64 = [this, &offset]()
+    {
+        uint64_t v = ReadUInt64(offset);
+        offset += 8;
+        return v;
+    };
+    packageInfo.id = ReadString(offset);
+    packageInfo.displayName = ReadString(offset);
+    packageInfo.title = ReadString(offset);
+    packageInfo.version = ReadString(offset);
+    packageInfo.versionDate = ReadString(offset);
+    packageInfo.targetSystem = ReadString(offset);
+    packageInfo.minTargetSystemVersion = ReadString(offset);
+    packageInfo.description = ReadString(offset);
+    packageInfo.creator = ReadString(offset);
+    packageInfo.ctanPath = ReadString(offset);
+    packageInfo.copyrightOwner = ReadString(offset);
+    packageInfo.copyrightYear = ReadString(offset);
+    packageInfo.licenseType = ReadString(offset);
+    if (static_cast<uint64_t>(offset) + packageInfo.digest.size() > size)
+    {
+        MIKTEX_UNEXPECTED();
+    }
+    memcpy(packageInfo.digest.data(), data + offset, packageInfo.digest.size());
+    offset += static_cast<uint32_t>(packageInfo.digest.size());
+    packageInfo.archiveFileSize = static_cast<size_t>(readUInt64());
+    packageInfo.sizeRunFiles = static_cast<size_t>(readUInt64());
+    packageInfo.sizeDocFiles = static_cast<size_t>(readUInt64());
+    packageInfo.sizeSourceFiles = static_cast<size_t>(readUInt64());
+    packageInfo.timePackaged = static_cast<time_t>(readUInt64());
+    packageInfo.runFiles = readStrings();
+    packageInfo.docFiles = readStrings();
+    packageInfo.sourceFiles = readStrings();
+    packageInfo.requiredPackages = readStrings();
+    packageInfo.requiredBy = readStrings();
+}
+
+string PackageManifestIndex::ReadString(uint32_t& offset) const
+{
+    uint32_t length = ReadUInt32(offset);
+    offset += 4;
+    if (static_cast<uint64_t>(offset) + length > size)
+    {
+        MIKTEX_UNEXPECTED();
+    }
+    string result(reinterpret_cast<const char*>(data + offset), length);
+    offset += length;
+    return result;
+}
+
+uint32_t PackageManifestIndex::ReadUInt32(uint32_t offset) const
+{
+    if (static_cast<uint64_t>(offset) + 4 > size)
+    {
+        MIKTEX_UNEXPECTED();
+    }
+    uint32_t v;
+    memcpy(&v, data + offset, sizeof(v));
+    return v;
+}
+
+uint64_t PackageManifestIndex::ReadUInt64(uint32_t offset) const
+{
+    if (static_cast<uint64_t>(offset) + 8 > size)
+    {
+        MIKTEX_UNEXPECTED();
+    }
+    uint64_t v;
+    memcpy(&v, data + offset, sizeof(v));
+    return v;
+}
@@ -0,0 +1,122 @@
+/**
+ * @file PackageManifestIndex.h
+ * @author Christian Schenk
+ * @brief Compiled package manifest index
+ *
+ * @copyright Copyright © 2024 Christian Schenk
+ *
+ * This file is part of MiKTeX Package Manager.
+ *
+ * MiKTeX Package Manager is licensed under GNU General Public License version 2
+ * or any later version.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <miktex/Core/MemoryMappedFile>
+#include <miktex/Util/PathName>
+
+#include <miktex/PackageManager/PackageManager>
+
+MPM_INTERNAL_BEGIN_NAMESPACE;
+
+/**
+ * @brief A memory-mapped index of package manifests.
+ *
+ * The index is a binary image of the package records which have been loaded
+ * from `package-manifests.ini`. It contains a hash table (package ID to
+ * package record) and a reverse hash table (file name to package records).
+ * Mutable package data (e.g., installation timestamps) is not part of the
+ * index, and neither is anything derived from it (the "Obsolete" and
+ * "Uncategorized" containers).
+ *
+ * The index remembers the size and the modification time (in nanoseconds) of
+ * the INI files it was built from. An index is ignored if one of these files
+ * has changed. Opening an index checks the header only: records are validated
+ * when they are read, and lookups throw, if the index is damaged.
+ */
+class PackageManifestIndex
+{
+public:
+
+    /**
+     * @brief Closes the index.
+     */
+    void Close();
+
+    /**
+     * @brief Tests whether a package record exists.
+     * @param packageId The package ID.
+     * @return Returns `true`, if the record exists.
+     */
+    bool HasPackage(const std::string& packageId) const;
+
+    bool IsOpen() const
+    {
+        return data != nullptr;
+    }
+
+    /**
+     * @brief Gets the IDs of all package records.
+     * @return Returns the package IDs.
+     */
+    std::vector<std::string> GetPackageIds() const;
+
+    /**
+     * @brief Gets the IDs of all packages which contain a file.
+     * @param path The (TEXMF-prefixed) path to the file.
+     * @return Returns the package IDs.
+     */
+    std::vector<std::string> GetPackagesOfFile(const MiKTeX::Util::PathName& path) const;
+
+    /**
+     * @brief Opens an index file.
+     * @param path Path to the index file.
+     * @param sources The INI files the index must have been built from.
+     * @return Returns `false`, if the index does not exist, has a damaged
+     * header or is out of date.
+     */
+    bool Open(const MiKTeX::Util::PathName& path, const std::vector<MiKTeX::Util::PathName>& sources);
+
+    /**
+     * @brief Looks up a package record.
+     * @param packageId The package ID.
+     * @param[out] packageInfo The package record (without mutable data).
+     * @return Returns `true`, if the record was found.
+     */
+    bool TryGetPackage(const std::string& packageId, MiKTeX::Packages::PackageInfo& packageInfo) const;
+
+    /**
+     * @brief Writes an index file.
+     * @param path Path to the index file.
+     * @param sources The INI files the records were loaded from.
+     * @param packages The package records.
+     */
+    static void Write(const MiKTeX::Util::PathName& path, const std::vector<MiKTeX::Util::PathName>& sources, const std::vector<const MiKTeX::Packages::PackageInfo*>& packages);
+
+private:
+
+    void CheckRecordOffset(std::uint32_t offset, std::uint32_t recordsBegin, std::uint32_t recordsEnd) const;
+    std::uint32_t FindPackageRecord(const std::string& packageId) const;
+    void ReadPackageRecord(std::uint32_t offset, MiKTeX::Packages::PackageInfo& packageInfo) const;
+    std::string ReadString(std::uint32_t& offset) const;
+    std::uint32_t ReadUInt32(std::uint32_t offset) const;
+    std::uint64_t ReadUInt64(std::uint32_t offset) const;
+
+    const unsigned char* data = nullptr;
+    std::unique_ptr<MiKTeX::Core::MemoryMappedFile> mappedFile;
+    std::uint32_t fileSlotsOffset = 0;
+    std::uint32_t numFileSlots = 0;
+    std::uint32_t numPackageSlots = 0;
+    std::uint32_t packageSlotsOffset = 0;
+    std::size_t size = 0;
+};
+
+MPM_INTERNAL_END_NAMESPACE;
@@ -0,0 +1,390 @@
+/**
+ * @file PackageVerifier.cpp
+ * @author Christian Schenk
+ * @brief Parallel package verification
+ *
+ * @copyright Copyright © 2024 Christian Schenk
+ *
+ * This file is part of MiKTeX Package Manager.
+ *
+ * MiKTeX Package Manager is licensed under GNU General Public License version 2
+ * or any later version.
+ */
+
+#include "config.h"
+
+#include <cstdlib>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <system_error>
+#include <thread>
+
+#include <fmt/format.h>
+#include <fmt/ostream.h>
+
+#include <miktex/Core/Directory>
+#include <miktex/Core/File>
+#include <miktex/Core/Paths>
+#include <miktex/Core/TemporaryFile>
+#include <miktex/Trace/Trace>
+
+#include "internal.h"
+
+#include "PackageVerifier.h"
+
+using namespace std;
+
+using namespace MiKTeX::Core;
+using namespace MiKTeX::Packages;
+using namespace MiKTeX::Trace;
+using namespace MiKTeX::Util;
+
+using namespace MiKTeX::Packages::D6AAD62216146D44B580E92711724B78;
+
+const char* const CACHE_FILE_NAME = "package-verification.txt";
+const char* const CACHE_FILE_HEADER = "miktex-package-verification 1";
+
+PackageVerifier::PackageVerifier(const VerifyOptions& options, TraceStream* trace_mpm) :
+    options(options),
+    trace_mpm(trace_mpm)
+{
+}
+
+MD5 PackageVerifier::GetPackageDigest(const FileDigestTable& fileDigests)
+{
+    MD5Builder md5Builder;
+    for (const pair<string, MD5>& p : fileDigests)
+    {
+        PathName path(p.first);
+        // we must dosify the path name for backward compatibility
+        path.ConvertToDos();
+        md5Builder.Update(path.GetData(), path.GetLength());
+        md5Builder.Update(p.second.data(), p.second.size());
+    }
+    return md5Builder.Final();
+}
+
+PathName PackageVerifier::GetCachePath(const PathName& prefix)
+{
+    return prefix / MIKTEX_PATH_MIKTEX_CONFIG_DIR / CACHE_FILE_NAME;
+}
+
+void PackageVerifier::LoadCache(const PathName& prefix)
+{
+    Cache& cache = caches[prefix];
+    PathName path = GetCachePath(prefix);
+    if (!options.useCache || !File::Exists(path))
+    {
+        return;
+    }
+    ifstream stream = File::CreateInputStream(path);
+    string line;
+    if (!getline(stream, line) || line != CACHE_FILE_HEADER)
+    {
+        return;
+    }
+    while (getline(stream, line))
+    {
+        // <md5> TAB <size> TAB <last write time> TAB <path>
+        size_t tab1 = line.find('\t');
+        size_t tab2 = tab1 == string::npos ? string::npos : line.find('\t', tab1 + 1);
+        size_t tab3 = tab2 == string::npos ? string::npos : line.find('\t', tab2 + 1);
+        if (tab3 == string::npos)
+        {
+            cache.clear();
+            return;
+        }
+        CacheRecord record;
+        try
+        {
+            record.digest = MD5::Parse(line.substr(0, tab1));
+        }
+        catch (const exception&)
+        {
+            cache.clear();
+            return;
+        }
+        record.size = static_cast<size_t>(strtoull(line.c_str() + tab1 + 1, nullptr, 10));
+        record.lastWriteTime = static_cast<time_t>(strtoll(line.c_str() + tab2 + 1, nullptr, 10));
+        cache[line.substr(tab3 + 1)] = record;
+    }
+}
+
+void PackageVerifier::SaveCaches()
+{
+    for (const auto& kv : caches)
+    {
+        PathName path = GetCachePath(kv.first);
+        try
+        {
+            PathName directory = path.GetDirectoryName();
+            Directory::Create(directory);
+            // concurrent verifications must not write to the same temporary file
+            unique_ptr<TemporaryFile> tempFile = TemporaryFile::Create(directory);
+            PathName tempPath = tempFile->GetPathName();
+            ofstream stream = File::CreateOutputStream(tempPath);
+            stream << CACHE_FILE_HEADER << "\n";
+            for (const auto& entry : kv.second)
+            {
+                if (entry.first.find('\n') != string::npos)
+                {
+                    continue;
+                }
+                stream << entry.second.digest.ToString() << "\t" << entry.second.size << "\t" << static_cast<long long>(entry.second.lastWriteTime) << "\t" << entry.first << "\n";
+            }
+            stream.close();
+            File::SetAttributes(tempPath, {});
+            File::Move(tempPath, path, { FileMoveOption::ReplaceExisting });
+            tempFile->Keep();
+        }
+        catch (const exception& e)
+        {
+            // e.g., the common installation directory is read-only
+            trace_mpm->WriteLine(TRACE_FACILITY, TraceLevel::Warning, fmt::format(T_("package verification cache cannot be saved: {0}"), e.what()));
+        }
+    }
+}
+
+// Called on a worker thread; the cache is not modified while the
+// workers are running.
+void PackageVerifier::HashFile(FileTask& task)
+{
+    try
+    {
+        if (!File::Exists(task.path))
+        {
+            task.status = FileStatus::Missing;
+            return;
+        }
+        if (task.path.HasExtension(MIKTEX_PACKAGE_MANIFEST_FILE_SUFFIX))
+        {
+            task.status = FileStatus::NoDigest;
+            return;
+        }
+        task.record.size = File::GetSize(task.path);
+        task.record.lastWriteTime = File::GetLastWriteTime(task.path);
+        if (options.useCache)
+        {
+            const Cache& cache = caches.at(task.prefix);
+            auto it = cache.find(task.path.ToString());
+            if (it != cache.end() && it->second.size == task.record.size && it->second.lastWriteTime == task.record.lastWriteTime)
+            {
+                task.record.digest = it->second.digest;
+                task.status = FileStatus::Digest;
+                return;
+            }
+        }
+        task.record.digest = MD5::FromFile(task.path);
+        // don't remember a file which has been changed while reading it
+        if (File::GetSize(task.path) != task.record.size || File::GetLastWriteTime(task.path) != task.record.lastWriteTime)
+        {
+            task.record.lastWriteTime = 0;
+        }
+        task.status = FileStatus::Digest;
+    }
+    catch (const exception& e)
+    {
+        task.error = e.what();
+        task.status = FileStatus::Failed;
+    }
+}
+
+bool PackageVerifier::ReportPackage(const PackageVerificationJob& job, const vector<FileTask*>& files)
+{
+    FileDigestTable fileDigests;
+    bool ok = true;
+    for (FileTask* task : files)
+    {
+        switch (task->status)
+        {
+        case FileStatus::Missing:
+            trace_mpm->WriteLine(TRACE_FACILITY, TraceLevel::Warning, fmt::format(T_("package verification failed: file {0} does not exist"), Q_(task->path)));
+            ok = false;
+            break;
+        case FileStatus::Failed:
+            trace_mpm->WriteLine(TRACE_FACILITY, TraceLevel::Warning, fmt::format(T_("package verification failed: file {0} cannot be read: {1}"), Q_(task->path), task->error));
+            ok = false;
+            break;
+        case FileStatus::Digest:
+            fileDigests[task->fileName] = task->record.digest;
+            break;
+        default:
+            break;
+        }
+    }
+    if (ok)
+    {
+        MD5 digest = GetPackageDigest(fileDigests);
+        ok = digest == job.expectedDigest;
+        if (!ok)
+        {
+            trace_mpm->WriteLine(TRACE_FACILITY, TraceLevel::Warning, fmt::format(T_("package {0} verification failed: some files have been modified"), Q_(job.packageId)));
+            trace_mpm->WriteLine(TRACE_FACILITY, TraceLevel::Warning, fmt::format(T_("expected digest: {0}"), job.expectedDigest.ToString()));
+            trace_mpm->WriteLine(TRACE_FACILITY, TraceLevel::Warning, fmt::format(T_("computed digest: {0}"), digest.ToString()));
+        }
+    }
+    return ok;
+}
+
+void PackageVerifier::UpdateCache(const PackageVerificationJob& job, const vector<FileTask*>& files, bool ok)
+{
+    // only the files of a correctly installed package are remembered
+    Cache& cache = caches[job.prefix];
+    for (FileTask* task : files)
+    {
+        if (task->status != FileStatus::Digest)
+        {
+            continue;
+        }
+        if (ok && task->record.lastWriteTime != 0)
+        {
+            cache[task->path.ToString()] = task->record;
+        }
+        else
+        {
+            cache.erase(task->path.ToString());
+        }
+    }
+}
+
+bool PackageVerifier::Run(const vector<PackageVerificationJob>& jobs, PackageVerificationCallback* callback)
+{
+    vector<FileTask> tasks;
+    vector<vector<FileTask*>> filesOfJob(jobs.size());
+    for (size_t idx = 0; idx < jobs.size(); ++idx)
+    {
+        const PackageVerificationJob& job = jobs[idx];
+        if (caches.find(job.prefix) == caches.end())
+        {
+            LoadCache(job.prefix);
+        }
+        for (const string& fileName : job.files)
+        {
+            string unprefixed;
+            if (!PackageManager::StripTeXMFPrefix(fileName, unprefixed))
+            {
+                continue;
+            }
+            FileTask task;
+            task.job = idx;
+            task.fileName = fileName;
+            task.path = job.prefix / unprefixed;
+            task.prefix = job.prefix;
+            tasks.push_back(task);
+        }
+    }
+    // the tasks vector does not change from now on
+    vector<atomic<size_t>> pendingFiles(jobs.size());
+    for (FileTask& task : tasks)
+    {
+        filesOfJob[task.job].push_back(&task);
+    }
+    std::mutex completedMutex;
+    condition_variable completedChanged;
+    deque<size_t> completed;
+    for (size_t idx = 0; idx < jobs.size(); ++idx)
+    {
+        pendingFiles[idx] = filesOfJob[idx].size();
+        if (filesOfJob[idx].empty())
+        {
+            completed.push_back(idx);
+        }
+    }
+
+    atomic<size_t> nextTask(0);
+    auto worker = [&]()
+    {
+        size_t idx;
+        while ((idx = nextTask++) < tasks.size())
+        {
+            HashFile(tasks[idx]);
+            if (--pendingFiles[tasks[idx].job] == 0)
+            {
+                lock_guard<std::mutex> lock(completedMutex);
+                completed.push_back(tasks[idx].job);
+                completedChanged.notify_one();
+            }
+        }
+    };
+
+    unsigned numThreads = options.numThreads;
+    if (numThreads == 0)
+    {
+        numThreads = std::max(thread::hardware_concurrency(), 1u);
+    }
+    numThreads = static_cast<unsigned>(std::min<size_t>(numThreads, std::max<size_t>(tasks.size(), 1)));
+    vector<thread> threads;
+    threads.reserve(numThreads);
+    for (unsigned i = 0; i < numThreads; ++i)
+    {
+        try
+        {
+            threads.push_back(thread(worker));
+        }
+        catch (const system_error&)
+        {
+            break;
+        }
+    }
+    if (threads.empty())
+    {
+        worker();
+    }
+
+    // report the results as the packages complete
+    bool allOk = true;
+    vector<bool> okOfJob(jobs.size());
+    try
+    {
+        for (size_t reported = 0; reported < jobs.size(); ++reported)
+        {
+            size_t idx;
+            {
+                unique_lock<std::mutex> lock(completedMutex);
+                completedChanged.wait(lock, [&]() { return !completed.empty(); });
+                idx = completed.front();
+                completed.pop_front();
+            }
+            bool ok = ReportPackage(jobs[idx], filesOfJob[idx]);
+            okOfJob[idx] = ok;
+            if (!ok)
+            {
+                allOk = false;
+            }
+            if (callback != nullptr)
+            {
+                callback->OnPackageVerified(jobs[idx].packageId, ok);
+            }
+        }
+    }
+    catch (...)
+    {
+        // let the workers run out of tasks before the threads go away
+        nextTask = tasks.size();
+        for (thread& t : threads)
+        {
+            t.join();
+        }
+        throw;
+    }
+
+    for (thread& t : threads)
+    {
+        t.join();
+    }
+
+    // the workers have finished reading the caches
+    for (size_t idx = 0; idx < jobs.size(); ++idx)
+    {
+        UpdateCache(jobs[idx], filesOfJob[idx], okOfJob[idx]);
+    }
+    SaveCaches();
+
+    return allOk;
+}
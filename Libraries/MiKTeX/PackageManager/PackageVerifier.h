@@ -0,0 +1,120 @@
+/**
+ * @file PackageVerifier.h
+ * @author Christian Schenk
+ * @brief Parallel package verification
+ *
+ * @copyright Copyright © 2024 Christian Schenk
+ *
+ * This file is part of MiKTeX Package Manager.
+ *
+ * MiKTeX Package Manager is licensed under GNU General Public License version 2
+ * or any later version.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <ctime>
+
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <miktex/Core/MD5>
+#include <miktex/Core/less_icase_dos>
+#include <miktex/Trace/TraceStream>
+#include <miktex/Util/PathName>
+
+#include <miktex/PackageManager/PackageManager>
+
+#include "internal.h"
+
+MPM_INTERNAL_BEGIN_NAMESPACE;
+
+typedef std::map<std::string, MiKTeX::Core::MD5, MiKTeX::Core::less_icase_dos> FileDigestTable;
+
+/**
+ * @brief The files of a package which is to be verified.
+ */
+struct PackageVerificationJob
+{
+    std::string packageId;
+    MiKTeX::Util::PathName prefix;
+    std::vector<std::string> files;
+    MiKTeX::Core::MD5 expectedDigest;
+};
+
+/**
+ * @brief Verifies packages by hashing their files on worker threads.
+ *
+ * The digests of verified files are remembered in a cache file next to
+ * the package database of each installation directory. If requested,
+ * files whose size and last write time match the cache record are
+ * not read again.
+ */
+class PackageVerifier
+{
+public:
+
+    PackageVerifier(const MiKTeX::Packages::VerifyOptions& options, MiKTeX::Trace::TraceStream* trace_mpm);
+
+    /**
+     * @brief Computes the package digest from the digests of its files.
+     * @param fileDigests The file digests.
+     * @return Returns the package digest.
+     */
+    static MiKTeX::Core::MD5 GetPackageDigest(const FileDigestTable& fileDigests);
+
+    /**
+     * @brief Verifies packages.
+     * @param jobs The packages to be verified.
+     * @param callback Receives the per-package results on the calling thread.
+     * @return Returns `true`, if all packages are correctly installed.
+     */
+    bool Run(const std::vector<PackageVerificationJob>& jobs, MiKTeX::Packages::PackageVerificationCallback* callback);
+
+private:
+
+    struct CacheRecord
+    {
+        std::size_t size = 0;
+        std::time_t lastWriteTime = 0;
+        MiKTeX::Core::MD5 digest;
+    };
+
+    typedef std::unordered_map<std::string, CacheRecord> Cache;
+
+    enum class FileStatus
+    {
+        Pending,
+        Missing,
+        NoDigest,
+        Digest,
+        Failed,
+    };
+
+    struct FileTask
+    {
+        std::size_t job;
+        std::string fileName;
+        MiKTeX::Util::PathName path;
+        MiKTeX::Util::PathName prefix;
+        FileStatus status = FileStatus::Pending;
+        CacheRecord record;
+        std::string error;
+    };
+
+    static MiKTeX::Util::PathName GetCachePath(const MiKTeX::Util::PathName& prefix);
+    void HashFile(FileTask& task);
+    void LoadCache(const MiKTeX::Util::PathName& prefix);
+    bool ReportPackage(const PackageVerificationJob& job, const std::vector<FileTask*>& files);
+    void SaveCaches();
+    void UpdateCache(const PackageVerificationJob& job, const std::vector<FileTask*>& files, bool ok);
+
+    std::map<MiKTeX::Util::PathName, Cache> caches;
+    MiKTeX::Packages::VerifyOptions options;
+    MiKTeX::Trace::TraceStream* trace_mpm;
+};
+
+MPM_INTERNAL_END_NAMESPACE;
@@ -49,3 +49,10 @@ shared_ptr<WebSession> WebSession::Create(IProgressNotify_* pIProgressNotify)
     MIKTEX_FATAL_ERROR(T_("libCURL does not seem to be available."));
 #endif
 }
+
+void WebSession::GlobalInitialize()
+{
+#if defined(HAVE_LIBCURL)
+  CurlWebSession::GlobalInitialize();
+#endif
+}
@@ -55,6 +55,11 @@ public:
 
 public:
   static std::shared_ptr<WebSession> Create(IProgressNotify_* pIProgressNotify);
+
+  // initializes the underlying library; must be called before sessions
+  // are used on more than one thread
+public:
+  static void GlobalInitialize();
 };
 
 MPM_INTERNAL_END_NAMESPACE;
@@ -72,6 +72,26 @@ struct InstallationSummary
   std::size_t packageCount = 0;
 };
 
+/// Package verification options.
+struct VerifyOptions
+{
+  /// Number of threads hashing files (`0`: one per processor).
+  unsigned numThreads = 0;
+  /// Trust files whose size and last write time are unchanged
+  /// since the last verification.
+  bool useCache = false;
+};
+
+/// Package verification callback interface.
+class MIKTEXNOVTABLE PackageVerificationCallback
+{
+  /// Reports the result of a package verification.
+  /// @param packageId Identifies the package.
+  /// @param ok Indicates whether the package is correctly installed.
+public:
+  virtual void MIKTEXTHISCALL OnPackageVerified(const std::string& packageId, bool ok) = 0;
+};
+
 /// The package manager interface.
 class MIKTEXNOVTABLE PackageManager
 {
@@ -175,6 +195,19 @@ public:
 public:
   virtual bool MIKTEXTHISCALL TryVerifyInstalledPackage(const std::string& packageId) = 0;
 
+  /// @brief Verifies installed packages.
+  ///
+  /// The files of all packages are read in parallel. Results are
+  /// reported on the calling thread, in the order in which the
+  /// packages complete.
+  ///
+  /// @param packageIds Identifies the packages.
+  /// @param options Verification options.
+  /// @param callback Pointer to an object which receives the results.
+  /// @return Returns `true`, if all packages are correctly installed.
+public:
+  virtual bool MIKTEXTHISCALL VerifyInstalledPackages(const std::vector<std::string>& packageIds, const VerifyOptions& options, PackageVerificationCallback* callback) = 0;
+
   /// Builds the container path of a package.
   /// @param packageId Identifies the package.
   /// @param useDisplayNames Indicates whether to use user friendly names.
@@ -0,0 +1,207 @@
+/**
+ * @file test/downloadqueue.cpp
+ * @author Christian Schenk
+ * @brief Download queue tests
+ *
+ * @copyright Copyright © 2024 Christian Schenk
+ *
+ * This file is part of MiKTeX Package Manager.
+ *
+ * MiKTeX Package Manager is licensed under GNU General Public License version 2
+ * or any later version.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include "DownloadQueue.h"
+
+using namespace std;
+
+struct Item
+{
+    Item(int number) :
+        number(number)
+    {
+        ++alive;
+    }
+    ~Item()
+    {
+        --alive;
+    }
+    int number;
+    bool transferred = false;
+    static atomic_int alive;
+};
+
+atomic_int Item::alive{ 0 };
+
+int failures = 0;
+
+void Check(const string& name, bool ok)
+{
+    if (!ok)
+    {
+        cerr << name << ": failed" << endl;
+        ++failures;
+    }
+}
+
+void Fill(DownloadQueue<Item>& queue, int count)
+{
+    for (int idx = 0; idx < count; ++idx)
+    {
+        queue.Add(to_string(idx), make_unique<Item>(idx));
+    }
+}
+
+// items are transferred, and workers do not run ahead too far
+void TestOrder()
+{
+    const int count = 50;
+    const size_t window = 3;
+    atomic_int collected{ 0 };
+    atomic_bool tooFarAhead{ false };
+    DownloadQueue<Item> queue;
+    Fill(queue, count);
+    Check("duplicate key", !queue.Add("0", make_unique<Item>(0)));
+    queue.Start(4, window, [&]()
+    {
+        return [&](Item& item)
+        {
+            if (item.number > collected + static_cast<int>(window))
+            {
+                tooFarAhead = true;
+            }
+            this_thread::sleep_for(chrono::milliseconds(1));
+            item.transferred = true;
+        };
+    });
+    bool ok = true;
+    for (int idx = 0; idx < count; ++idx)
+    {
+        exception_ptr exception;
+        unique_ptr<Item> item = queue.Collect(to_string(idx), exception);
+        ok = ok && item != nullptr && item->number == idx && item->transferred && exception == nullptr;
+        collected += 1;
+    }
+    Check("order", ok);
+    Check("window", !tooFarAhead);
+    exception_ptr exception;
+    Check("collected twice", queue.Collect("0", exception) == nullptr);
+    Check("unknown key", queue.Collect("unknown", exception) == nullptr);
+    queue.Stop();
+}
+
+// a failed transfer is reported to the consumer; other items are not affected
+void TestFailure()
+{
+    DownloadQueue<Item> queue;
+    Fill(queue, 10);
+    queue.Start(3, 10, []()
+    {
+        return [](Item& item)
+        {
+            if (item.number == 4)
+            {
+                throw runtime_error("failed");
+            }
+            item.transferred = true;
+        };
+    });
+    bool ok = true;
+    for (int idx = 0; idx < 10; ++idx)
+    {
+        exception_ptr exception;
+        unique_ptr<Item> item = queue.Collect(to_string(idx), exception);
+        ok = ok && item != nullptr && (idx == 4 ? exception != nullptr && !item->transferred : exception == nullptr && item->transferred);
+    }
+    Check("failure", ok);
+    queue.Stop();
+}
+
+// a worker which cannot be initialized fails its items instead of hanging
+void TestWorkerInitFailure()
+{
+    DownloadQueue<Item> queue;
+    Fill(queue, 5);
+    queue.Start(2, 5, []() -> DownloadQueue<Item>::Transfer
+    {
+        throw runtime_error("no connection");
+    });
+    bool ok = true;
+    for (int idx = 0; idx < 5; ++idx)
+    {
+        exception_ptr exception;
+        unique_ptr<Item> item = queue.Collect(to_string(idx), exception);
+        ok = ok && item != nullptr && exception != nullptr;
+    }
+    Check("worker init failure", ok);
+    queue.Stop();
+}
+
+// the idle function can abort waiting
+void TestCancel()
+{
+    DownloadQueue<Item> queue;
+    Fill(queue, 5);
+    queue.Start(1, 1, [&]()
+    {
+        return [&](Item&)
+        {
+            while (!queue.IsStopped())
+            {
+                this_thread::sleep_for(chrono::milliseconds(1));
+            }
+            throw runtime_error("cancelled");
+        };
+    });
+    bool cancelled = false;
+    try
+    {
+        exception_ptr exception;
+        queue.Collect("0", exception, []() { throw runtime_error("cancel"); });
+    }
+    catch (const runtime_error&)
+    {
+        cancelled = true;
+    }
+    Check("cancel", cancelled);
+    queue.Stop();
+}
+
+// stopping joins the workers and deletes the items which have not been collected
+void TestStop()
+{
+    {
+        DownloadQueue<Item> queue;
+        Fill(queue, 20);
+        queue.Start(4, 2, []()
+        {
+            return [](Item& item)
+            {
+                item.transferred = true;
+            };
+        });
+        exception_ptr exception;
+        unique_ptr<Item> item = queue.Collect("0", exception);
+        queue.Stop();
+        Check("stop", Item::alive == 1 && queue.GetSize() == 0 && queue.IsStopped());
+        Check("collect after stop", queue.Collect("1", exception) == nullptr);
+    }
+    Check("leak", Item::alive == 0);
+}
+
+int main()
+{
+    TestOrder();
+    TestFailure();
+    TestWorkerInitFailure();
+    TestCancel();
+    TestStop();
+    return failures == 0 ? 0 : 1;
+}
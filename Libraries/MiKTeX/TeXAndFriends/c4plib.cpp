@@ -18,6 +18,8 @@
 #   include <unistd.h>
 #endif
 
+#include <sys/stat.h>
+
 #if defined(MIKTEX_TEXMF_SHARED)
 #   define C4PEXPORT MIKTEXDLLEXPORT
 #else
@@ -41,6 +43,7 @@ C4P_BEGIN_NAMESPACE;
 void C4P_text::DiscardLine()
 {
     AssertValid();
+    DropReadAhead();
     // FIXME: OS X
     while (!feof(file) && GetChar() != '\n')
     {
@@ -72,6 +75,7 @@ inline bool C4P_text::IsTerminal()
 char C4P_text::GetChar()
 {
     AssertValid();
+    DropReadAhead();
     if (!IsPascalFileIO())
     {
         PascalFileIO(true);
@@ -132,6 +136,110 @@ C4P_real C4P_text::GetReal()
     MIKTEX_UNIMPLEMENTED();
 }
 
+constexpr size_t READ_AHEAD_SIZE = 128 * 1024;
+
+bool C4P_text::CanReadAhead()
+{
+    if ((flags & ReadAheadChecked) == 0)
+    {
+        flags |= ReadAheadChecked;
+        int fd = fileno(file);
+        // we must be able to seek back (see DropReadAhead()); this rules out
+        // terminals, pipes and streams with newline translation
+        if (fd > 2 && (flags & TextMode) == 0)
+        {
+#if defined(MIKTEX_WINDOWS)
+            struct _stat64 statbuf;
+            if (_fstat64(fd, &statbuf) == 0 && (statbuf.st_mode & _S_IFMT) == _S_IFREG)
+#else
+            struct stat statbuf;
+            if (fstat(fd, &statbuf) == 0 && S_ISREG(statbuf.st_mode))
+#endif
+            {
+                flags |= ReadAheadAllowed;
+            }
+        }
+    }
+    return (flags & ReadAheadAllowed) != 0 && !IsPascalFileIO();
+}
+
+bool C4P_text::FillReadAhead()
+{
+    MIKTEX_ASSERT(readAheadPos == readAheadEnd);
+    if (readAheadBuffer.empty())
+    {
+        readAheadBuffer.resize(READ_AHEAD_SIZE);
+    }
+    readAheadPos = 0;
+    readAheadEnd = 0;
+    size_t n;
+    while (true)
+    {
+        errno = 0;
+        n = fread(readAheadBuffer.data(), 1, readAheadBuffer.size(), file);
+        if (n > 0 || ferror(file) == 0)
+        {
+            break;
+        }
+        if (errno != EINTR)
+        {
+            MIKTEX_FATAL_CRT_ERROR_2("fread", "path", path.ToString());
+        }
+        clearerr(file);
+    }
+    readAheadEnd = n;
+    return n > 0;
+}
+
+size_t C4P_text::ReadLine(char* buf, size_t pos, size_t size, int& lastChar)
+{
+    AssertValid();
+    MIKTEX_ASSERT(CanReadAhead());
+    while (pos < size)
+    {
+        if (readAheadPos == readAheadEnd && !FillReadAhead())
+        {
+            lastChar = EOF;
+            return pos;
+        }
+        const char* start = readAheadBuffer.data() + readAheadPos;
+        size_t avail = readAheadEnd - readAheadPos;
+        size_t n = min(avail, size - pos);
+        const char* eol = static_cast<const char*>(memchr(start, '\n', n));
+        const char* cr = static_cast<const char*>(memchr(start, '\r', eol == nullptr ? n : eol - start));
+        if (cr != nullptr)
+        {
+            eol = cr;
+        }
+        if (eol == nullptr)
+        {
+            memcpy(buf + pos, start, n);
+            pos += n;
+            readAheadPos += n;
+            lastChar = static_cast<unsigned char>(start[n - 1]);
+            continue;
+        }
+        size_t len = eol - start;
+        memcpy(buf + pos, start, len);
+        pos += len;
+        readAheadPos += len + 1;
+        if (*eol == '\r')
+        {
+            // swallow the LF of a CR/LF pair
+            if (readAheadPos < readAheadEnd || FillReadAhead())
+            {
+                if (readAheadBuffer[readAheadPos] == '\n')
+                {
+                    readAheadPos++;
+                }
+            }
+        }
+        lastChar = '\n';
+        return pos;
+    }
+    return pos;
+}
+
 bool FileRoot::Open(const PathName& path, FileMode mode, FileAccess access, bool text, bool mustExist)
 {
     this->path = path;
@@ -150,6 +258,10 @@ bool FileRoot::Open(const PathName& path, FileMode mode, FileAccess access, bool
         }
     }
     Attach(file, true);
+    if (text)
+    {
+        flags |= TextMode;
+    }
     return true;
 }
 
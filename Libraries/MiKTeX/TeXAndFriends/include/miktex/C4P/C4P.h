@@ -86,6 +86,8 @@ public:
         AssertValid();
         FILE* file = this->file;
         this->file = nullptr;
+        readAheadPos = 0;
+        readAheadEnd = 0;
         if ((flags & NotOwner) != 0)
         {
             std::shared_ptr<MiKTeX::Core::Session> session = MIKTEX_SESSION();
@@ -101,6 +103,8 @@ public:
             flags |= NotOwner;
         }
         this->file = file;
+        readAheadPos = 0;
+        readAheadEnd = 0;
     }
 
     operator FILE*()
@@ -111,6 +115,8 @@ public:
     FILE*& fileref()
     {
         flags = 0;
+        readAheadPos = 0;
+        readAheadEnd = 0;
         return file;
     }
 
@@ -119,12 +125,43 @@ public:
         return file;
     }
 
+    /// Hands the unread part of the read-ahead buffer back to the stream.
+    void DropReadAhead()
+    {
+        if (readAheadPos != readAheadEnd)
+        {
+            long n = static_cast<long>(readAheadEnd - readAheadPos);
+            readAheadPos = 0;
+            readAheadEnd = 0;
+            if (fseek(file, -n, SEEK_CUR) != 0)
+            {
+                MIKTEX_FATAL_CRT_ERROR_2("fseek", "path", path.ToString());
+            }
+        }
+    }
+
 protected:
 
+    bool HaveReadAhead() const
+    {
+        return readAheadPos != readAheadEnd;
+    }
+
     FILE* file = nullptr;
-    enum { NotOwner = 0x00000001 };
+    enum {
+        NotOwner = 0x00000001,
+        TextMode = 0x00000002,
+        ReadAheadChecked = 0x00000004,
+        ReadAheadAllowed = 0x00000008,
+    };
     unsigned flags = 0;
     MiKTeX::Util::PathName path;
+
+    // read-ahead buffer of the line reader (see C4P_text::ReadLine);
+    // only used for regular files opened in binary mode
+    std::vector<char> readAheadBuffer;
+    std::size_t readAheadPos = 0;
+    std::size_t readAheadEnd = 0;
 };
 
 template<class T> struct BufferedFile :
@@ -176,6 +213,11 @@ public:
 
     bool Eof()
     {
+        if (HaveReadAhead())
+        {
+            return false;
+        }
+
         if (feof(file) != 0)
         {
             return true;
@@ -207,6 +249,12 @@ public:
 
     bool Eoln()
     {
+        if (HaveReadAhead())
+        {
+            char ch = readAheadBuffer[readAheadPos];
+            return ch == '\r' || ch == '\n';
+        }
+
         if (feof(file) != 0)
         {
             return true;
@@ -258,6 +306,8 @@ public:
     void Reset()
     {
         AssertValid();
+        readAheadPos = 0;
+        readAheadEnd = 0;
         rewind(*this);
         Read();
     }
@@ -265,6 +315,8 @@ public:
     void Rewrite()
     {
         AssertValid();
+        readAheadPos = 0;
+        readAheadEnd = 0;
         rewind(*this);
     }
 
@@ -272,6 +324,7 @@ public:
     {
         AssertValid();
         MIKTEX_ASSERT(IsPascalFileIO());
+        DropReadAhead();
         if (fwrite(&currentElement, sizeof(ElementType), 1, *this) != 1 || ferror(*this) != 0)
         {
             MIKTEX_FATAL_CRT_ERROR_2("fwrite", "path", path.ToString());
@@ -281,6 +334,7 @@ public:
     void Seek(long offset, int origin)
     {
         AssertValid();
+        DropReadAhead();
         if (fseek(*this, offset, origin) != 0)
         {
             MIKTEX_FATAL_CRT_ERROR_2("fseek", "path", path.ToString(), "offset", std::to_string(offset), "origin", std::to_string(origin));
@@ -301,6 +355,7 @@ protected:
     {
         AssertValid();
         MIKTEX_ASSERT_BUFFER(buf, n);
+        DropReadAhead();
         if (feof(*this) != 0)
         {
             MIKTEX_FATAL_ERROR_2(MIKTEXTEXT("Read operation failed: end of file reached"), "path", path.ToString(), "n", std::to_string(n));
@@ -331,6 +386,12 @@ public:
     C4PTHISAPI(char) GetChar();
     C4PTHISAPI(int) GetInteger();
     C4PTHISAPI(void) DiscardLine();
+    C4PTHISAPI(bool) CanReadAhead();
+    C4PTHISAPI(std::size_t) ReadLine(char* buf, std::size_t pos, std::size_t size, int& lastChar);
+
+private:
+
+    bool FillReadAhead();
 };
 
 #define c4pargc GetArgC()
@@ -514,6 +575,7 @@ protected:
     template<class Ft> long c4pftell(Ft& f)
     {
         f.AssertValid();
+        f.DropReadAhead();
         long n = ftell(f);
         if (n < 0)
         {
@@ -100,6 +100,7 @@ public:
     MIKTEXMFTHISAPI(bool) OpenFontFile(C4P::BufferedFile<unsigned char>* file, const std::string& fontName, MiKTeX::Core::FileType filetype, const char* generator);
     MIKTEXMFTHISAPI(bool) OpenMemoryDumpFile(const MiKTeX::Util::PathName& fileName, FILE** file, void* buf, std::size_t size, bool renew);
     MIKTEXMFTHISAPI(bool) ParseFirstLineP() const;
+    MIKTEXMFTHISAPI(bool) ReadMemoryDumpFile(FILE* file, void* buf, std::size_t size);
     MIKTEXMFTHISAPI(int) GetInteraction() const;
     MIKTEXMFTHISAPI(int) GetTeXStringLength(int stringNumber) const;
     MIKTEXMFTHISAPI(int) GetTeXStringStart(int stringNumber) const;
@@ -208,6 +209,10 @@ public:
     template<typename FILE_, typename ELETYPE_> void Undump(FILE_& f, ELETYPE_& e, std::size_t n)
     {
         f.PascalFileIO(false);
+        if (ReadMemoryDumpFile(static_cast<FILE*>(f), &e, sizeof(e) * n))
+        {
+        return;
+        }
         if (fread(&e, sizeof(e), n, static_cast<FILE*>(f)) != n)
         {
         MIKTEX_FATAL_CRT_ERROR("fread");
@@ -11,6 +11,8 @@
  * version 2 or any later version.
  */
 
+#include <array>
+#include <cstring>
 #include <unordered_map>
 
 #include <fmt/format.h>
@@ -129,6 +131,7 @@ public:
     TriState allowInput = TriState::Undetermined;
     TriState allowOutput = TriState::Undetermined;
     unordered_map<const FILE*, OpenFileInfo> openFiles;
+    C4P::C4P_text* currentInputFile = nullptr;
 };
 
 WebAppInputLine::WebAppInputLine() :
@@ -622,6 +625,11 @@ void WebAppInputLine::BufferSizeExceeded() const
 size_t WebAppInputLine::InputLineInternal(FILE* f, char* buffer, char* buffer2, size_t bufferSize, size_t bufferPosition, int& lastChar) const
 {
     MIKTEX_ASSERT(buffer2 == nullptr);
+    C4P::C4P_text* textFile = pimpl->currentInputFile;
+    if (textFile != nullptr && static_cast<FILE*>(*textFile) == f && textFile->CanReadAhead())
+    {
+        return textFile->ReadLine(buffer, bufferPosition, bufferSize, lastChar);
+    }
     do
     {
         errno = 0;
@@ -633,6 +641,20 @@ size_t WebAppInputLine::InputLineInternal(FILE* f, char* buffer, char* buffer2,
     return bufferPosition;
 }
 
+static bool IsIdentity(const char* xord)
+{
+    static const auto identity = []()
+    {
+        array<char, 256> result;
+        for (int i = 0; i < 256; ++i)
+        {
+            result[i] = static_cast<char>(i);
+        }
+        return result;
+    }();
+    return memcmp(xord, identity.data(), identity.size()) == 0;
+}
+
 /**
  * @brief Read a line of input.
  *
@@ -662,7 +684,17 @@ bool WebAppInputLine::InputLine(C4P::C4P_text& f, C4P::C4P_boolean bypassEndOfLi
     char* buffer2 = inputOutput->buffer2();
     int lastChar = EOF;
 
-    last = static_cast<C4P::C4P_signed32>(InputLineInternal(f, buffer, buffer2, bufsize, first, lastChar));
+    pimpl->currentInputFile = &f;
+    try
+    {
+        last = static_cast<C4P::C4P_signed32>(InputLineInternal(f, buffer, buffer2, bufsize, first, lastChar));
+    }
+    catch (...)
+    {
+        pimpl->currentInputFile = nullptr;
+        throw;
+    }
+    pimpl->currentInputFile = nullptr;
 
     if (lastChar == EOF && last == first)
     {
@@ -697,9 +729,12 @@ bool WebAppInputLine::InputLine(C4P::C4P_text& f, C4P::C4P_boolean bypassEndOfLi
         last--;
     }
 
-    for (int i = first; i <= last; i++)
+    if (!IsIdentity(xord))
     {
-        buffer[i] = xord[buffer[i] & 0xff];
+        for (int i = first; i <= last; i++)
+        {
+            buffer[i] = xord[buffer[i] & 0xff];
+        }
     }
 
     if (AmI(TeXjpEngine))
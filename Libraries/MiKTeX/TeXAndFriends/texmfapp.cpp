@@ -11,7 +11,10 @@
  * version 2 or any later version.
  */
 
+#include <chrono>
+#include <cstring>
 #include <sstream>
+#include <unordered_map>
 
 #include <fmt/format.h>
 #include <fmt/ostream.h>
@@ -19,7 +22,12 @@
 #include <miktex/Configuration/ConfigNames>
 
 #include <miktex/Core/AutoResource>
+#include <miktex/Core/BZip2Stream>
+#include <miktex/Core/DependencyLog>
 #include <miktex/Core/Directory>
+#include <miktex/Core/GzipStream>
+#include <miktex/Core/LzmaStream>
+#include <miktex/Core/MemoryMappedFile>
 #include <miktex/Core/Paths>
 #include <miktex/Core/StreamReader>
 
@@ -67,6 +75,7 @@ public:
     bool showFileLineErrorMessages;
     bool haltOnError;
     bool isInitProgram;
+    bool recordDependencies;
     bool recordFileNames;
     bool disableExtensions;
     bool setJobTime;
@@ -78,8 +87,58 @@ public:
     IErrorHandler* errorHandler = nullptr;
     ITeXMFMemoryHandler* memoryHandler = nullptr;
     UserParams userParams;
+    unique_ptr<MemoryMappedFile> memoryDumpMapping;
+    unique_ptr<Stream> memoryDumpStream;
+    vector<unsigned char> memoryDumpBuffer;
+    FILE* memoryDumpFile = nullptr;
+    string memoryDumpSource;
+    const unsigned char* memoryDumpData = nullptr;
+    size_t memoryDumpSize = 0;
+    size_t memoryDumpOffset = 0;
+    size_t memoryDumpTotal = 0;
+    chrono::time_point<chrono::steady_clock> memoryDumpStart;
+    bool FillMemoryDumpBuffer();
+    void ReleaseMemoryDumpSource();
 };
 
+bool TeXMFApp::impl::FillMemoryDumpBuffer()
+{
+    if (memoryDumpStream == nullptr)
+    {
+        return false;
+    }
+    memoryDumpData = memoryDumpBuffer.data();
+    memoryDumpSize = memoryDumpStream->Read(memoryDumpBuffer.data(), memoryDumpBuffer.size());
+    memoryDumpOffset = 0;
+    return memoryDumpSize > 0;
+}
+
+void TeXMFApp::impl::ReleaseMemoryDumpSource()
+{
+    if (memoryDumpFile == nullptr)
+    {
+        return;
+    }
+    if (trace_time != nullptr)
+    {
+        auto elapsed = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - memoryDumpStart).count();
+        trace_time->WriteLine("libtexmf", fmt::format("memory dump file: {0} bytes undumped from the {1} in {2} ms", memoryDumpTotal, memoryDumpSource, elapsed));
+    }
+    if (memoryDumpMapping != nullptr)
+    {
+        memoryDumpMapping->Close();
+        memoryDumpMapping = nullptr;
+    }
+    memoryDumpStream = nullptr;
+    memoryDumpBuffer.clear();
+    memoryDumpBuffer.shrink_to_fit();
+    memoryDumpFile = nullptr;
+    memoryDumpData = nullptr;
+    memoryDumpSize = 0;
+    memoryDumpOffset = 0;
+    memoryDumpTotal = 0;
+}
+
 TeXMFApp::TeXMFApp() :
     pimpl(make_unique<impl>())
 {
@@ -143,14 +202,90 @@ void TeXMFApp::Init(vector<char*>& args)
     pimpl->interactionMode = -1;
     pimpl->isInitProgram = false;
     pimpl->parseFirstLine = false;
+    pimpl->recordDependencies = false;
     pimpl->recordFileNames = false;
     pimpl->setJobTime = false;
     pimpl->showFileLineErrorMessages = false;
     pimpl->timeStatistics = false;
 }
 
+static PathName MakeJobFilePath(const TeXMFApp& app, const string& jobName, const string& extension)
+{
+    string fileName;
+    if (jobName.length() > 2 && jobName.front() == '"' && jobName.back() == '"')
+    {
+        fileName = jobName.substr(1, jobName.length() - 2);
+    }
+    else
+    {
+        fileName = jobName;
+    }
+    PathName path = app.GetAuxDirectory();
+    if (path.Empty())
+    {
+        path = app.GetOutputDirectory();
+    }
+    path /= fileName;
+    path.AppendExtension(extension);
+    return path;
+}
+
+static void WriteDependencyLog(shared_ptr<Session> session, const PathName& logPath)
+{
+    vector<pair<PathName, FileAccess>> files;
+    unordered_map<string, size_t> fileIndex;
+    for (const FileInfoRecord& fir : session->GetFileInfoRecords())
+    {
+        PathName path(fir.fileName);
+        if (path == logPath)
+        {
+            continue;
+        }
+        auto it = fileIndex.find(path.ToString());
+        if (it == fileIndex.end())
+        {
+            fileIndex[path.ToString()] = files.size();
+            files.push_back(make_pair(path, fir.access));
+        }
+        else if (files[it->second].second != fir.access)
+        {
+            files[it->second].second = FileAccess::ReadWrite;
+        }
+    }
+    vector<DependencyLogRecord> records;
+    for (const auto& f : files)
+    {
+        if (File::Exists(f.first))
+        {
+            records.push_back(DependencyLog::MakeRecord(f.first, f.second));
+        }
+    }
+    DependencyLog::Write(logPath, records);
+}
+
 void TeXMFApp::Finalize()
 {
+    // we also get here, if the job has been stopped by an exception:
+    // make sure that the recorder log is complete
+    GetSession()->FlushRecorder();
+    if (pimpl->recordDependencies && !pimpl->jobName.empty())
+    {
+        // the dependency log is optional: do not fail the job
+        PathName logPath = MakeJobFilePath(*this, pimpl->jobName, ".dep");
+        try
+        {
+            WriteDependencyLog(GetSession(), logPath);
+        }
+        catch (const MiKTeXException& e)
+        {
+            LogWarn(fmt::format("dependency log {0} could not be written: {1}", Q_(logPath), e.GetErrorMessage()));
+        }
+        catch (const exception& e)
+        {
+            LogWarn(fmt::format("dependency log {0} could not be written: {1}", Q_(logPath), e.what()));
+        }
+    }
+    pimpl->ReleaseMemoryDumpSource();
     if (pimpl->trace_time != nullptr)
     {
         pimpl->trace_time->Close();
@@ -185,24 +320,7 @@ void TeXMFApp::OnTeXMFFinishJob()
 {
     if (pimpl->recordFileNames)
     {
-        string fileName;
-        if (pimpl->jobName.length() > 2 && pimpl->jobName.front() == '"' && pimpl->jobName.back() == '"')
-        {
-            fileName = pimpl->jobName.substr(1, pimpl->jobName.length() - 2);
-        }
-        else
-        {
-            fileName = pimpl->jobName;
-        }
-        shared_ptr<Session> session = GetSession();
-        PathName recorderPath = GetAuxDirectory();
-        if (recorderPath.Empty())
-        {
-            recorderPath = GetOutputDirectory();
-        }
-        recorderPath /= fileName;
-        recorderPath.AppendExtension(".fls");
-        session->SetRecorderPath(recorderPath);
+        GetSession()->SetRecorderPath(MakeJobFilePath(*this, pimpl->jobName, ".fls"));
     }
     if (pimpl->timeStatistics)
     {
@@ -237,6 +355,7 @@ enum {
     OPT_POOL_SIZE,
     OPT_QUIET,
     OPT_RECORDER,
+    OPT_RECORD_DEPENDENCIES,
     OPT_STACK_SIZE,
     OPT_STRICT,
     OPT_STRING_VACANCIES,
@@ -306,6 +425,7 @@ void TeXMFApp::AddOptions()
     AddOption("pool-size", fmt::format(T_("Set {0} to N."), "pool_size"), FIRST_OPTION_VAL + pimpl->optBase + OPT_POOL_SIZE, POPT_ARG_STRING, "N");
     AddOption("quiet", T_("Suppress all output (except errors)."), FIRST_OPTION_VAL + pimpl->optBase + OPT_QUIET);
     AddOption("recorder", T_("Turn on the file name recorder to leave a trace of the files opened for input and output in a file with extension .fls."), FIRST_OPTION_VAL + pimpl->optBase + OPT_RECORDER);
+    AddOption("record-dependencies", T_("Write size, time stamp and MD5 of the files opened for input and output to a binary dependency log with extension .dep."), FIRST_OPTION_VAL + pimpl->optBase + OPT_RECORD_DEPENDENCIES);
     AddOption("stack-size", fmt::format(T_("Set {0} to N."), "stack_size"), FIRST_OPTION_VAL + pimpl->optBase + OPT_STACK_SIZE, POPT_ARG_STRING, "N");
     AddOption("strict", T_("Disable MiKTeX extensions."), FIRST_OPTION_VAL + pimpl->optBase + OPT_STRICT, POPT_ARG_NONE | POPT_ARGFLAG_DOC_HIDDEN);
 
@@ -549,6 +669,11 @@ bool TeXMFApp::ProcessOption(int opt, const string& optArg)
         pimpl->recordFileNames = true;
         break;
 
+    case OPT_RECORD_DEPENDENCIES:
+        session->StartFileInfoRecorder(false);
+        pimpl->recordDependencies = true;
+        break;
+
     case OPT_STACK_SIZE:
         pimpl->userParams["stack_size"] = std::stoi(optArg);
         break;
@@ -716,11 +841,74 @@ bool TeXMFApp::OpenMemoryDumpFile(const PathName& fileName_, FILE** ppFile, void
     }
 #endif
 
+    pimpl->ReleaseMemoryDumpSource();
+
     FileStream stream(session->OpenFile(path, FileMode::Open, FileAccess::Read, false));
 
+    // compressed format files are decompressed by a background thread;
+    // uncompressed format files are mapped, so that the undump
+    // operations do not have to go through stdio
+    unsigned char magic[6] = { 0 };
+    size_t magicSize = stream.Read(magic, sizeof(magic));
+    stream.Seek(0, SeekOrigin::Begin);
+    pimpl->memoryDumpStart = chrono::steady_clock::now();
+    try
+    {
+        if (magicSize >= 2 && magic[0] == 0x1f && magic[1] == 0x8b)
+        {
+            pimpl->memoryDumpStream = GzipStream::Create(path, true);
+            pimpl->memoryDumpSource = "gzip stream";
+        }
+        else if (magicSize >= 6 && memcmp(magic, "\xfd" "7zXZ\0", 6) == 0)
+        {
+            pimpl->memoryDumpStream = LzmaStream::Create(path, true);
+            pimpl->memoryDumpSource = "xz stream";
+        }
+        else if (magicSize >= 3 && memcmp(magic, "BZh", 3) == 0)
+        {
+            pimpl->memoryDumpStream = BZip2Stream::Create(path, true);
+            pimpl->memoryDumpSource = "bzip2 stream";
+        }
+        if (pimpl->memoryDumpStream != nullptr)
+        {
+            pimpl->memoryDumpBuffer.resize(256 * 1024);
+        }
+        else
+        {
+            unique_ptr<MemoryMappedFile> mapping(MemoryMappedFile::Create());
+            pimpl->memoryDumpData = reinterpret_cast<const unsigned char*>(mapping->Open(path, false));
+            pimpl->memoryDumpSize = mapping->GetSize();
+            pimpl->memoryDumpOffset = 0;
+            pimpl->memoryDumpMapping = std::move(mapping);
+            pimpl->memoryDumpSource = "file mapping";
+        }
+        pimpl->memoryDumpFile = stream.GetFile();
+    }
+    catch (const MiKTeXException& e)
+    {
+        if (pimpl->memoryDumpStream != nullptr)
+        {
+            throw;
+        }
+        // fall back to fread()
+        if (pimpl->trace_time != nullptr)
+        {
+            pimpl->trace_time->WriteLine("libtexmf", fmt::format("memory dump file {0} cannot be mapped: {1}", Q_(path), e.GetErrorMessage()));
+        }
+        pimpl->memoryDumpData = nullptr;
+        pimpl->memoryDumpSize = 0;
+    }
+
     if (pBuf != nullptr)
     {
-        if (stream.Read(pBuf, size) != size)
+        if (pimpl->memoryDumpFile != nullptr)
+        {
+            if (!ReadMemoryDumpFile(stream.GetFile(), pBuf, size))
+            {
+                MIKTEX_UNEXPECTED();
+            }
+        }
+        else if (stream.Read(pBuf, size) != size)
         {
             MIKTEX_UNEXPECTED();
         }
@@ -733,6 +921,39 @@ bool TeXMFApp::OpenMemoryDumpFile(const PathName& fileName_, FILE** ppFile, void
     return true;
 }
 
+bool TeXMFApp::ReadMemoryDumpFile(FILE* file, void* buf, size_t size)
+{
+    if (file == nullptr || file != pimpl->memoryDumpFile)
+    {
+        return false;
+    }
+    unsigned char* dest = reinterpret_cast<unsigned char*>(buf);
+    while (size > 0)
+    {
+        if (pimpl->memoryDumpOffset == pimpl->memoryDumpSize && !pimpl->FillMemoryDumpBuffer())
+        {
+            MIKTEX_FATAL_ERROR(T_("Bad format file."));
+        }
+        size_t n = std::min(size, pimpl->memoryDumpSize - pimpl->memoryDumpOffset);
+        memcpy(dest, pimpl->memoryDumpData + pimpl->memoryDumpOffset, n);
+        pimpl->memoryDumpOffset += n;
+        pimpl->memoryDumpTotal += n;
+        dest += n;
+        size -= n;
+    }
+    if (pimpl->memoryDumpOffset == pimpl->memoryDumpSize && !pimpl->FillMemoryDumpBuffer())
+    {
+        // move the stream to the end of the file, so that eof() works as
+        // expected; the source is not needed anymore
+        if (fseek(file, 0, SEEK_END) != 0)
+        {
+            MIKTEX_FATAL_CRT_ERROR("fseek");
+        }
+        pimpl->ReleaseMemoryDumpSource();
+    }
+    return true;
+}
+
 void TeXMFApp::ProcessCommandLineOptions()
 {
     if (StringUtil::Contains(GetInitProgramName(), Utils::GetExeName()))
@@ -51,7 +51,7 @@ public:
   {
     if (traceStream != nullptr)
     {
-      traceStream->WriteLine(facility, fmt::format("stopwatch START: {}", message));
+      traceStream->WriteLine(facility, [&]() { return fmt::format("stopwatch START: {}", message); });
     }
   }
 
@@ -82,7 +82,7 @@ public:
     chrono::duration<double> elapsedTime = chrono::duration_cast<chrono::duration<double>>(stop - start);
     if (traceStream != nullptr)
     {
-      traceStream->WriteLine(facility, fmt::format("stopwatch STOP: {} ({:.4f} seconds)", message, elapsedTime.count()));
+      traceStream->WriteLine(facility, [&]() { return fmt::format("stopwatch STOP: {} ({:.4f} seconds)", message, elapsedTime.count()); });
       traceStream = nullptr;
     }
     return elapsedTime.count();
@@ -41,6 +41,7 @@
 #include <ctime>
 
 #include <algorithm>
+#include <atomic>
 #include <codecvt>
 #include <exception>
 #include <memory>
@@ -114,7 +115,7 @@ struct TraceStreamInfo
 {
   string name;
   vector<string> enabledFor;
-  TraceLevel level;
+  atomic<TraceLevel> level;
   vector<TraceCallback*> callbacks;
 };
 
@@ -124,9 +125,15 @@ class TraceStreamImpl :
 public:
   void MIKTEXTHISCALL Close() override;
 
+public:
+  using TraceStream::IsEnabled;
+
 public:
   bool MIKTEXTHISCALL IsEnabled(const std::string& facility, TraceLevel level) override;
 
+public:
+  using TraceStream::WriteLine;
+
 public:
   void MIKTEXTHISCALL WriteLine(const std::string& facility, TraceLevel level, const std::string& text) override;
 
@@ -138,6 +145,7 @@ public:
     info(info),
     callback(callback)
   {
+    enabledLevel = &info->level;
     if (callback != nullptr)
     {
       info->callbacks.push_back(callback);
@@ -323,8 +331,7 @@ void TraceStreamImpl::Close()
 
 bool TraceStreamImpl::IsEnabled(const string& facility, TraceLevel level)
 {
-  return (this->info->enabledFor.empty() || find(this->info->enabledFor.begin(), this->info->enabledFor.end(), facility) != this->info->enabledFor.end())
-    && level <= this->info->level;
+  return IsEnabled(level) && (this->info->enabledFor.empty() || find(this->info->enabledFor.begin(), this->info->enabledFor.end(), facility) != this->info->enabledFor.end());
 }
 
 string TraceCallback::TraceMessage::ToString() const
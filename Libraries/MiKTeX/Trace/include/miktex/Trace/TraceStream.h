@@ -1,6 +1,6 @@
 /* miktex/Trace/TraceStream.h:                           -*- C++ -*-
 
-   Copyright (C) 1996-2020 Christian Schenk
+   Copyright (C) 1996-2024 Christian Schenk
 
    This file is part of the MiKTeX Trace Library.
 
@@ -26,8 +26,11 @@
 
 #include "config.h"
 
+#include <atomic>
 #include <memory>
 #include <string>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 #include "TraceCallback.h"
@@ -47,12 +50,45 @@ public:
 public:
   virtual bool MIKTEXTHISCALL IsEnabled(const std::string& facility, TraceLevel level) = 0;
 
+  /// Tests whether the stream is enabled for a trace level.
+  /// This test does not consider facilities.  It is cheap and should be
+  /// used to guard the construction of trace messages.
+  /// @param level The trace level.
+  /// @return Returns `false`, if no message of this level can be written.
+public:
+  bool IsEnabled(TraceLevel level) const
+  {
+    return enabledLevel != nullptr && level <= enabledLevel->load(std::memory_order_relaxed);
+  }
+
 public:
   virtual void MIKTEXTHISCALL WriteLine(const std::string& facility, TraceLevel level, const std::string& text) = 0;
 
 public:
   virtual void MIKTEXTHISCALL WriteLine(const std::string& facility, const std::string& text) = 0;
 
+  /// Writes a trace message which is built on demand.
+  /// @param facility The facility.
+  /// @param level The trace level.
+  /// @param makeText A callable which builds the message.  It is not called,
+  /// if the stream is disabled for the facility or the trace level.
+public:
+  template<typename MakeText, typename = std::enable_if_t<std::is_invocable_r_v<std::string, MakeText>>>
+  void WriteLine(const std::string& facility, TraceLevel level, MakeText&& makeText)
+  {
+    if (IsEnabled(level) && IsEnabled(facility, level))
+    {
+      WriteLine(facility, level, std::string(std::forward<MakeText>(makeText)()));
+    }
+  }
+
+public:
+  template<typename MakeText, typename = std::enable_if_t<std::is_invocable_r_v<std::string, MakeText>>>
+  void WriteLine(const std::string& facility, MakeText&& makeText)
+  {
+    WriteLine(facility, TraceLevel::Trace, std::forward<MakeText>(makeText));
+  }
+
 public:
   static MIKTEXTRACECEEAPI(std::unique_ptr<TraceStream>) Open(const std::string& name, TraceLevel level, TraceCallback* callback);
 
@@ -74,6 +110,10 @@ public:
 
 public:
   static MIKTEXTRACECEEAPI(std::string) MakeOption(const std::string& name, const std::string& facility, TraceLevel level);
+
+  /// The highest enabled trace level (maintained by the implementation).
+protected:
+  const std::atomic<TraceLevel>* enabledLevel = nullptr;
 };
 
 MIKTEX_TRACE_END_NAMESPACE;
@@ -0,0 +1,184 @@
+/* dvipdfm-x/miktex/deflate.cpp: Flate compression on worker threads
+
+   Copyright (C) 2024 Christian Schenk
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published
+   by the Free Software Foundation; either version 2, or (at your
+   option) any later version.
+
+   This file is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this file; if not, write to the Free Software
+   Foundation, 59 Temple Place - Suite 330, Boston, MA 02111-1307,
+   USA.  */
+
+#include "dvipdfm-x.h"
+
+#include <cstdlib>
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <zlib.h>
+
+using namespace std;
+
+struct miktex_deflate_job
+{
+  const unsigned char* data = nullptr;
+  size_t length = 0;
+  int level = 0;
+  unsigned char* result = nullptr;
+  size_t resultLength = 0;
+  bool done = false;
+};
+
+namespace {
+
+  void Deflate(miktex_deflate_job* job)
+  {
+    uLongf bufferLength = compressBound(static_cast<uLong>(job->length));
+    unsigned char* buffer = static_cast<unsigned char*>(malloc(bufferLength));
+    if (buffer != nullptr && compress2(buffer, &bufferLength, job->data, static_cast<uLong>(job->length), job->level) == Z_OK)
+    {
+      job->result = buffer;
+      job->resultLength = bufferLength;
+    }
+    else
+    {
+      free(buffer);
+    }
+  }
+
+  class DeflatePool
+  {
+  public:
+    static DeflatePool& GetInstance()
+    {
+      static DeflatePool instance;
+      return instance;
+    }
+
+  public:
+    ~DeflatePool()
+    {
+      {
+        lock_guard<mutex> lock(mtx);
+        stopped = true;
+      }
+      workAvailable.notify_all();
+      for (thread& t : workers)
+      {
+        t.join();
+      }
+    }
+
+  public:
+    void Submit(miktex_deflate_job* job)
+    {
+      {
+        lock_guard<mutex> lock(mtx);
+        if (!started)
+        {
+          // the main thread helps out in Wait()
+          unsigned numWorkers = max(thread::hardware_concurrency(), 1u) - 1;
+          for (unsigned i = 0; i < numWorkers; ++i)
+          {
+            workers.emplace_back(&DeflatePool::WorkerLoop, this);
+          }
+          started = true;
+        }
+        queue.push_back(job);
+      }
+      workAvailable.notify_one();
+    }
+
+    // waits for the job to be done; a job which no worker has picked up
+    // yet is done by the calling thread
+  public:
+    void Wait(miktex_deflate_job* job)
+    {
+      unique_lock<mutex> lock(mtx);
+      auto it = find(queue.begin(), queue.end(), job);
+      if (it != queue.end())
+      {
+        queue.erase(it);
+        lock.unlock();
+        Deflate(job);
+        return;
+      }
+      jobDone.wait(lock, [job] { return job->done; });
+    }
+
+  private:
+    void WorkerLoop()
+    {
+      unique_lock<mutex> lock(mtx);
+      while (true)
+      {
+        workAvailable.wait(lock, [this] { return stopped || !queue.empty(); });
+        if (queue.empty())
+        {
+          return;
+        }
+        miktex_deflate_job* job = queue.front();
+        queue.pop_front();
+        lock.unlock();
+        Deflate(job);
+        lock.lock();
+        job->done = true;
+        jobDone.notify_all();
+      }
+    }
+
+  private:
+    mutex mtx;
+
+  private:
+    condition_variable workAvailable;
+
+  private:
+    condition_variable jobDone;
+
+  private:
+    deque<miktex_deflate_job*> queue;
+
+  private:
+    vector<thread> workers;
+
+  private:
+    bool started = false;
+
+  private:
+    bool stopped = false;
+  };
+
+}
+
+extern "C" miktex_deflate_job* miktex_deflate_start(const unsigned char* data, size_t length, int level)
+{
+  miktex_deflate_job* job = new miktex_deflate_job;
+  job->data = data;
+  job->length = length;
+  job->level = level;
+  DeflatePool::GetInstance().Submit(job);
+  return job;
+}
+
+extern "C" unsigned char* miktex_deflate_finish(miktex_deflate_job* job, size_t* length)
+{
+  DeflatePool::GetInstance().Wait(job);
+  unsigned char* result = job->result;
+  *length = job->resultLength;
+  delete job;
+  return result;
+}
@@ -21,8 +21,10 @@
 
 #if defined(__cplusplus)
 #include <cstdarg>
+#include <cstddef>
 #else
 #include <stdarg.h>
+#include <stddef.h>
 #endif
 
 #if defined(__cplusplus)
@@ -34,6 +36,14 @@ void miktex_log_info_va(const char* format, va_list args);
 void miktex_log_warn_va(const char* format, va_list args);
 void miktex_read_config_files();
 
+/* Flate compression on worker threads: miktex_deflate_start() queues
+   the data (which must stay valid until the job is finished);
+   miktex_deflate_finish() waits for the job and returns the compressed
+   data (to be free()d), or NULL, if compression failed. */
+typedef struct miktex_deflate_job miktex_deflate_job;
+miktex_deflate_job* miktex_deflate_start(const unsigned char* data, size_t length, int level);
+unsigned char* miktex_deflate_finish(miktex_deflate_job* job, size_t* length);
+
 #if defined(__cplusplus)
 }
 #endif
@@ -47,6 +47,10 @@
 #include "pdfobj.h"
 #include "pdfdev.h"
 
+#if defined(MIKTEX)
+#include <miktex/dvipdfm-x.h>
+#endif
+
 #define STREAM_ALLOC_SIZE      4096u
 #define ARRAY_ALLOC_SIZE       256
 #define IND_OBJECTS_ALLOC_SIZE 512
@@ -58,6 +62,15 @@
 /* Objects with this flag will not be encrypted.
    This implies OBJ_NO_OBJSTM if encryption is turned on.        */
 
+#if defined(MIKTEX)
+#define DEFLATE_MIN_LENGTH  8192u
+/* Smaller streams are compressed when they are written.         */
+#define DEFLATE_MAX_PENDING 32
+/* At most this many streams are being compressed in the
+   background.  This number, and not the thread count, decides
+   where the streams end up in the file.                         */
+#endif
+
 /* Any of these types can be represented as follows */
 struct pdf_obj 
 {
@@ -142,6 +155,12 @@ struct pdf_stream
   size_t              max_length;
   int32_t             _flags;
   struct decode_parms decodeparms;
+#if defined(MIKTEX)
+  miktex_deflate_job *deflate_job;    /* pending compression */
+  unsigned char      *deflate_input;
+  size_t              deflate_input_length;
+  int                 deflate_filters;
+#endif
 };
 
 struct pdf_indirect
@@ -231,6 +250,16 @@ struct pdf_out {
   pdf_obj      *xref_stream;
   pdf_obj      *output_stream;
   pdf_obj      *current_objstm;
+#if defined(MIKTEX)
+  /* Stream objects being compressed, in the order of release.
+   * They are written when the queue is full or at the end.
+   */
+  struct {
+    pdf_obj    *objects[DEFLATE_MAX_PENDING];
+    int         first;
+    int         count;
+  } pending;
+#endif
   /* The following flag bits are (8,338,607+1)/8 bytes data
    * each bit represenging if the object is freed.
    * Where the value 8,338,607 is taken from PDF ref. manual, v.1.7,
@@ -290,6 +319,10 @@ init_pdf_out_struct (pdf_out *p)
   p->xref_stream    = NULL;
   p->output_stream  = NULL;
   p->current_objstm = NULL;
+#if defined(MIKTEX)
+  p->pending.first  = 0;
+  p->pending.count  = 0;
+#endif
 
   p->free_list = NEW((PDF_NUM_INDIRECT_MAX+1)/8, char);
   memset(p->free_list, 0, (PDF_NUM_INDIRECT_MAX+1)/8);
@@ -344,6 +377,10 @@ static void     release_dict    (pdf_dict *dict);
 
 static void     write_stream    (pdf_out *p, pdf_stream *stream);
 static void     release_stream  (pdf_stream *stream);
+#if defined(MIKTEX)
+static int      start_deflate   (pdf_out *p, pdf_obj *object);
+static void     flush_pending_stream (pdf_out *p);
+#endif
 
 static void
 pdf_out_set_compression (pdf_out *p, int level)
@@ -670,6 +707,12 @@ pdf_out_flush (void)
       p->current_objstm =NULL;
     }
 
+#if defined(MIKTEX)
+    /* Write streams still being compressed */
+    while (p->pending.count > 0)
+      flush_pending_stream(p);
+#endif
+
     /*
      * Label xref stream - we need the number of correct objects
      * for the xref stream dictionary (= trailer).
@@ -1884,6 +1927,13 @@ pdf_new_stream (int flags)
   data->decodeparms.bits_per_component = 0;
   data->decodeparms.colors    = 0;
 
+#if defined(MIKTEX)
+  data->deflate_job     = NULL;
+  data->deflate_input   = NULL;
+  data->deflate_input_length = 0;
+  data->deflate_filters = 0;
+#endif
+
   result->data = data;
   result->flags |= OBJ_NO_OBJSTM;
 
@@ -2179,8 +2229,173 @@ filter_create_predictor_dict (int predictor, int32_t columns,
   return  parms;
 }
 
+#ifdef HAVE_ZLIB
+/* Apply the predictor filter, if requested.  */
 static void
-write_stream (pdf_out *p, pdf_stream *stream)
+apply_predictor (pdf_out *p, pdf_stream *stream,
+                 unsigned char **data, size_t *length)
+{
+  unsigned char *filtered        = *data;
+  size_t         filtered_length = *length;
+
+  if ( p->options.compression.use_predictor &&
+      (stream->_flags & STREAM_USE_PREDICTOR) &&
+      !pdf_lookup_dict(stream->dict, "DecodeParms")) {
+    int      bits_per_pixel  = stream->decodeparms.colors *
+                                 stream->decodeparms.bits_per_component;
+    int32_t  len  = (stream->decodeparms.columns * bits_per_pixel + 7) / 8;
+    int32_t  rows = stream->stream_length / len;
+    unsigned char *filtered2 = NULL;
+    int32_t        length2 = stream->stream_length;
+    pdf_obj       *parms;
+
+    parms = filter_create_predictor_dict(stream->decodeparms.predictor,
+                                      stream->decodeparms.columns,
+                                      stream->decodeparms.bits_per_component,
+                                      stream->decodeparms.colors);
+
+    switch (stream->decodeparms.predictor) {
+    case 2: /* TIFF2 */
+      filtered2 = filter_TIFF2_apply_filter(filtered,
+                                       stream->decodeparms.columns,
+                                       rows,
+                                       stream->decodeparms.bits_per_component,
+                                       stream->decodeparms.colors, &length2);
+      break;
+    case 15: /* PNG optimun */
+      filtered2 = filter_PNG15_apply_filter(filtered,
+                                       stream->decodeparms.columns,
+                                       rows,
+                                       stream->decodeparms.bits_per_component,
+                                       stream->decodeparms.colors, &length2);
+      break;
+    default:
+      WARN("Unknown/unsupported Predictor function %d.",
+           stream->decodeparms.predictor);
+      break;
+    }
+    if (parms && filtered2) {
+      RELEASE(filtered);
+      filtered = filtered2;
+      filtered_length = length2;
+      pdf_add_dict(stream->dict, pdf_new_name("DecodeParms"), parms);
+    }
+  }
+
+  *data   = filtered;
+  *length = filtered_length;
+}
+
+/* Add FlateDecode to the filters of the stream.  Returns 1, if
+ * the stream has already had filters.
+ */
+static int
+add_flate_filter (pdf_stream *stream)
+{
+  pdf_obj *filters     = pdf_lookup_dict(stream->dict, "Filter");
+  pdf_obj *filter_name = pdf_new_name("FlateDecode");
+
+  if (filters)
+    /*
+     * FlateDecode is the first filter to be applied to the stream.
+     */
+    pdf_unshift_array(filters, filter_name);
+  else
+    /*
+     * Adding the filter as a name instead of a one-element array
+     * is crucial because otherwise Adobe Reader cannot read the
+     * cross-reference stream any more, cf. the PDF v1.5 Errata.
+     */
+    pdf_add_dict(stream->dict, pdf_new_name("Filter"), filter_name);
+
+  return filters ? 1 : 0;
+}
+#endif /* HAVE_ZLIB */
+
+static int
+is_metadata_stream (pdf_stream *stream)
+{
+  pdf_obj *type = pdf_lookup_dict(stream->dict, "Type");
+
+  return type && !strcmp("Metadata", pdf_name_value(type));
+}
+
+#if defined(MIKTEX)
+/* Queue a stream object, which is about to be written, for
+ * compression on a worker thread.  Returns 0 if the stream should
+ * be written right away.
+ */
+static int
+start_deflate (pdf_out *p, pdf_obj *object)
+{
+  pdf_stream *stream;
+
+  if (object->type != PDF_STREAM || object == p->xref_stream)
+    return 0;
+  stream = object->data;
+  if (stream->stream_length < DEFLATE_MIN_LENGTH ||
+      !(stream->_flags & STREAM_COMPRESS) ||
+      p->options.compression.level <= 0 ||
+      is_metadata_stream(stream))
+    return 0;
+
+  if (p->pending.count == DEFLATE_MAX_PENDING)
+    flush_pending_stream(p);
+
+  stream->deflate_input = NEW(stream->stream_length, unsigned char);
+  memcpy(stream->deflate_input, stream->stream, stream->stream_length);
+  stream->deflate_input_length = stream->stream_length;
+  apply_predictor(p, stream,
+                  &stream->deflate_input, &stream->deflate_input_length);
+  stream->deflate_filters = add_flate_filter(stream);
+  stream->deflate_job = miktex_deflate_start(stream->deflate_input,
+                                             stream->deflate_input_length,
+                                             p->options.compression.level);
+
+  p->pending.objects[(p->pending.first + p->pending.count) % DEFLATE_MAX_PENDING] = object;
+  p->pending.count++;
+
+  return 1;
+}
+
+/* Write (and release) the oldest stream object being compressed. */
+static void
+flush_pending_stream (pdf_out *p)
+{
+  pdf_obj *object = p->pending.objects[p->pending.first];
+
+  p->pending.first = (p->pending.first + 1) % DEFLATE_MAX_PENDING;
+  p->pending.count--;
+
+  pdf_flush_obj(p, object);
+  release_stream(object->data);
+  object->type = -1;
+  object->data = NULL;
+  RELEASE(object);
+}
+
+static unsigned char *
+finish_deflate (pdf_out *p, pdf_stream *stream, size_t *length)
+{
+  unsigned char *result;
+
+  result = miktex_deflate_finish(stream->deflate_job, length);
+  stream->deflate_job = NULL;
+  if (!result)
+    ERROR("Zlib error");
+  RELEASE(stream->deflate_input);
+  stream->deflate_input = NULL;
+  p->output.compression_saved +=
+    stream->deflate_input_length - *length
+      - (stream->deflate_filters ? strlen("/FlateDecode "): strlen("/Filter/FlateDecode\n"));
+
+  return result;
+}
+#endif
+
+/* Returns the filtered (i.e., compressed) stream data. */
+static unsigned char *
+filter_stream (pdf_out *p, pdf_stream *stream, size_t *length)
 {
   unsigned char *filtered;
   size_t         filtered_length;
@@ -2191,8 +2406,6 @@ write_stream (pdf_out *p, pdf_stream *stream)
 #endif
   unsigned char *buffer;
 
-  ASSERT(p);
-
   /*
    * Always work from a copy of the stream. All filters read from
    * "filtered" and leave their result in "filtered".
@@ -2205,12 +2418,8 @@ write_stream (pdf_out *p, pdf_stream *stream)
   filtered_length = stream->stream_length;
 
   /* PDF/A requires Metadata to be not filtered. */
-  {
-    pdf_obj *type;
-    type = pdf_lookup_dict(stream->dict, "Type");
-    if (type && !strcmp("Metadata", pdf_name_value(type))) {
-      stream->_flags &= ~STREAM_COMPRESS;
-    }
+  if (is_metadata_stream(stream)) {
+    stream->_flags &= ~STREAM_COMPRESS;
   }
 
 #ifdef HAVE_ZLIB
@@ -2218,73 +2427,14 @@ write_stream (pdf_out *p, pdf_stream *stream)
   if (stream->stream_length > 0 &&
       (stream->_flags & STREAM_COMPRESS) &&
       p->options.compression.level > 0) {
-    pdf_obj *filters;
+    int has_filters;
 
     /* First apply predictor filter if requested. */
-    if ( p->options.compression.use_predictor &&
-        (stream->_flags & STREAM_USE_PREDICTOR) &&
-        !pdf_lookup_dict(stream->dict, "DecodeParms")) {
-      int      bits_per_pixel  = stream->decodeparms.colors *
-                                   stream->decodeparms.bits_per_component;
-      int32_t  len  = (stream->decodeparms.columns * bits_per_pixel + 7) / 8;
-      int32_t  rows = stream->stream_length / len;
-      unsigned char *filtered2 = NULL;
-      int32_t        length2 = stream->stream_length;
-      pdf_obj       *parms;
-
-      parms = filter_create_predictor_dict(stream->decodeparms.predictor,
-                                        stream->decodeparms.columns,
-                                        stream->decodeparms.bits_per_component,
-                                        stream->decodeparms.colors);
-
-      switch (stream->decodeparms.predictor) {
-      case 2: /* TIFF2 */
-        filtered2 = filter_TIFF2_apply_filter(filtered,
-                                         stream->decodeparms.columns,
-                                         rows,
-                                         stream->decodeparms.bits_per_component,
-                                         stream->decodeparms.colors, &length2);
-        break;
-      case 15: /* PNG optimun */
-        filtered2 = filter_PNG15_apply_filter(filtered,
-                                         stream->decodeparms.columns,
-                                         rows,
-                                         stream->decodeparms.bits_per_component,
-                                         stream->decodeparms.colors, &length2);
-        break;
-      default:
-        WARN("Unknown/unsupported Predictor function %d.",
-             stream->decodeparms.predictor);
-        break;
-      }
-      if (parms && filtered2) {
-        RELEASE(filtered);
-        filtered = filtered2;
-        filtered_length = length2;
-        pdf_add_dict(stream->dict, pdf_new_name("DecodeParms"), parms);
-      }
-    }
-
-    filters = pdf_lookup_dict(stream->dict, "Filter");
+    apply_predictor(p, stream, &filtered, &filtered_length);
 
     buffer_length = filtered_length + filtered_length/1000 + 14;
     buffer = NEW(buffer_length, unsigned char);
-    {
-      pdf_obj *filter_name = pdf_new_name("FlateDecode");
-
-      if (filters)
-        /*
-         * FlateDecode is the first filter to be applied to the stream.
-         */
-        pdf_unshift_array(filters, filter_name);
-      else
-        /*
-         * Adding the filter as a name instead of a one-element array
-         * is crucial because otherwise Adobe Reader cannot read the
-         * cross-reference stream any more, cf. the PDF v1.5 Errata.
-         */
-        pdf_add_dict(stream->dict, pdf_new_name("Filter"), filter_name);
-    }
+    has_filters = add_flate_filter(stream);
 #ifdef HAVE_ZLIB_COMPRESS2    
     if (compress2(buffer, &buffer_length, filtered,
         filtered_length, p->options.compression.level)) {
@@ -2299,13 +2449,31 @@ write_stream (pdf_out *p, pdf_stream *stream)
     RELEASE(filtered);
     p->output.compression_saved +=
       filtered_length - buffer_length
-        - (filters ? strlen("/FlateDecode "): strlen("/Filter/FlateDecode\n"));
+        - (has_filters ? strlen("/FlateDecode "): strlen("/Filter/FlateDecode\n"));
 
     filtered        = buffer;
     filtered_length = buffer_length;
   }
 #endif /* HAVE_ZLIB */
 
+  *length = filtered_length;
+  return filtered;
+}
+
+static void
+write_stream (pdf_out *p, pdf_stream *stream)
+{
+  unsigned char *filtered;
+  size_t         filtered_length;
+
+  ASSERT(p);
+
+#if defined(MIKTEX)
+  if (stream->deflate_job)
+    filtered = finish_deflate(p, stream, &filtered_length);
+  else
+#endif
+  filtered = filter_stream(p, stream, &filtered_length);
   /* AES will change the size of data! */
   if (p->state.enc_mode) {
     unsigned char *cipher = NULL;
@@ -3243,6 +3411,10 @@ pdf_release_obj (pdf_obj *object)
         if (!p->options.use_objstm || object->flags & OBJ_NO_OBJSTM ||
             (p->options.enable_encrypt && (object->flags & OBJ_NO_ENCRYPT)) ||
             object->generation) {
+#if defined(MIKTEX)
+          if (start_deflate(p, object))
+            return;
+#endif
           pdf_flush_obj(p, object);
         } else {
           if (!p->current_objstm) {
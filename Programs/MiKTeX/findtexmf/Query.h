@@ -0,0 +1,145 @@
+/* Query.h: parsing findtexmf queries                   -*- C++ -*-
+
+   Copyright (C) 2024 Christian Schenk
+
+   This file is part of FindTeXMF.
+
+   FindTeXMF is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published
+   by the Free Software Foundation; either version 2, or (at your
+   option) any later version.
+
+   FindTeXMF is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with FindTeXMF; if not, write to the Free Software
+   Foundation, 59 Temple Place - Suite 330, Boston, MA 02111-1307,
+   USA. */
+
+#pragma once
+
+#include <cstddef>
+
+#include <string>
+
+/* A query read from standard input.  Words are separated by blanks
+   and tabs; double quotes group words, so that a file type such as
+   --file-type="type1 fonts" can be given.  Within double quotes, \"
+   and \\ stand for " and \.  The file name is the rest of the line,
+   unless it starts with a double quote.  */
+
+enum class QueryError
+{
+  None,
+  UnterminatedQuote,
+  UnknownOption,
+  TrailingText
+};
+
+struct Query
+{
+  bool all = false;
+  bool haveFileType = false;
+  std::string fileType;
+  std::string fileName;
+  std::string unknownOption;
+};
+
+inline bool IsQueryBlank(char ch)
+{
+  return ch == ' ' || ch == '\t';
+}
+
+inline void SkipQueryBlanks(const std::string& line, std::size_t& pos)
+{
+  while (pos < line.length() && IsQueryBlank(line[pos]))
+  {
+    ++pos;
+  }
+}
+
+inline bool ReadQueryWord(const std::string& line, std::size_t& pos, std::string& word)
+{
+  word.clear();
+  bool quoted = false;
+  while (pos < line.length() && (quoted || !IsQueryBlank(line[pos])))
+  {
+    char ch = line[pos++];
+    if (ch == '"')
+    {
+      quoted = !quoted;
+    }
+    else if (quoted && ch == '\\' && pos < line.length() && (line[pos] == '"' || line[pos] == '\\'))
+    {
+      word += line[pos++];
+    }
+    else
+    {
+      word += ch;
+    }
+  }
+  return !quoted;
+}
+
+/* An empty file name means that there is nothing to look up.  */
+
+inline QueryError ParseQuery(const std::string& line, Query& query)
+{
+  std::size_t pos = 0;
+  SkipQueryBlanks(line, pos);
+  while (pos < line.length() && line[pos] == '-')
+  {
+    std::string opt;
+    if (!ReadQueryWord(line, pos, opt))
+    {
+      return QueryError::UnterminatedQuote;
+    }
+    SkipQueryBlanks(line, pos);
+    if (opt == "--")
+    {
+      break;
+    }
+    std::size_t nameStart = opt.length() > 1 && opt[1] == '-' ? 2 : 1;
+    std::size_t equal = opt.find('=');
+    std::string name = opt.substr(nameStart, equal == std::string::npos ? std::string::npos : equal - nameStart);
+    if (name == "all" && equal == std::string::npos)
+    {
+      query.all = true;
+    }
+    else if (name == "file-type" && equal != std::string::npos)
+    {
+      query.haveFileType = true;
+      query.fileType = opt.substr(equal + 1);
+    }
+    else
+    {
+      query.unknownOption = opt;
+      return QueryError::UnknownOption;
+    }
+  }
+  if (pos < line.length() && line[pos] == '"')
+  {
+    if (!ReadQueryWord(line, pos, query.fileName))
+    {
+      return QueryError::UnterminatedQuote;
+    }
+    SkipQueryBlanks(line, pos);
+    if (pos < line.length())
+    {
+      return QueryError::TrailingText;
+    }
+  }
+  else if (pos < line.length())
+  {
+    std::size_t end = line.length();
+    while (end > pos && IsQueryBlank(line[end - 1]))
+    {
+      --end;
+    }
+    query.fileName = line.substr(pos, end - pos);
+  }
+  return QueryError::None;
+}
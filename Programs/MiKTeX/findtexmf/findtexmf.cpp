@@ -31,6 +31,7 @@
 #include <iostream>
 
 #include "findtexmf-version.h"
+#include "Query.h"
 
 #include <miktex/App/Application>
 #include <miktex/Core/Exceptions>
@@ -77,12 +78,24 @@ private:
 private:
   void PrintSearchPath(const char* lpszSearchPath);
 
+private:
+  bool FindFile(const string& fileName, FileType fileType, bool all, vector<PathName>& result);
+
+private:
+  void Serve();
+
 public:
   int Run(int argc, const char** argv);
 
+private:
+  bool all = false;
+
 private:
   bool mustExist = false;
 
+private:
+  bool server = false;
+
 private:
   bool start = false;
 
@@ -100,11 +113,13 @@ enum Option
 {
   OPT_AAA = 256,
   OPT_ALIAS,
+  OPT_ALL,
   OPT_EXPAND_PATH,
   OPT_EXPAND_VAR,
   OPT_FILE_TYPE,
   OPT_LIST_FILE_TYPES,
   OPT_MUST_EXIST,
+  OPT_SERVER,
   OPT_SHOW_PATH,
   OPT_START,
   OPT_THE_NAME_OF_THE_GAME,
@@ -121,6 +136,14 @@ const struct poptOption FindTeXMF::aoption[] =
     T_("APP")
   },
 
+  {
+    "all", 0,
+    POPT_ARG_NONE | POPT_ARGFLAG_ONEDASH, nullptr,
+    OPT_ALL,
+    T_("Print all matching files."),
+    nullptr
+  },
+
   {
     "engine", 0,
     POPT_ARG_STRING | POPT_ARGFLAG_ONEDASH | POPT_ARGFLAG_DOC_HIDDEN, nullptr,
@@ -153,6 +176,14 @@ const struct poptOption FindTeXMF::aoption[] =
     nullptr
   },
 
+  {
+    "server", 0,
+    POPT_ARG_NONE | POPT_ARGFLAG_ONEDASH, nullptr,
+    OPT_SERVER,
+    T_("Same as --stdin."),
+    nullptr
+  },
+
   {
     "show-path", 0,
     POPT_ARG_STRING | POPT_ARGFLAG_ONEDASH, nullptr,
@@ -169,6 +200,14 @@ const struct poptOption FindTeXMF::aoption[] =
     nullptr
   },
 
+  {
+    "stdin", 0,
+    POPT_ARG_NONE | POPT_ARGFLAG_ONEDASH, nullptr,
+    OPT_SERVER,
+    T_("Read queries from standard input, one per line, and answer each query with the found files, followed by an empty line."),
+    nullptr
+  },
+
   {
     "the-name-of-the-game", 0,
     POPT_ARG_STRING | POPT_ARGFLAG_ONEDASH, nullptr,
@@ -238,6 +277,104 @@ void FindTeXMF::PrintSearchPath(const char* lpszSearchPath)
   cout << endl;
 }
 
+bool FindTeXMF::FindFile(const string& fileName, FileType fileType, bool all, vector<PathName>& result)
+{
+  if (fileType == FileType::None)
+  {
+    fileType = session->DeriveFileType(PathName(fileName));
+    if (fileType == FileType::None)
+    {
+      fileType = FileType::TEX;
+    }
+  }
+  result.clear();
+  if (all)
+  {
+    return session->FindFile(fileName, fileType, { Session::FindFileOption::All }, result);
+  }
+  PathName path;
+  if (!session->FindFile(fileName, fileType, path))
+  {
+    return false;
+  }
+  result.push_back(path);
+  return true;
+}
+
+/* Answer queries read from standard input.  A query is a file name,
+   optionally preceded by --file-type=FILETYPE and/or --all (see
+   Query.h for quoting).  The answer is the list of found files (one
+   per line), terminated by an empty line.  A failed lookup is reported
+   on stderr and answered with an empty list.  The file name databases
+   are loaded once: files installed or FNDB refreshes done while
+   serving are not seen.  */
+
+void FindTeXMF::Serve()
+{
+  string line;
+  vector<PathName> result;
+  while (getline(cin, line))
+  {
+    if (!line.empty() && line.back() == '\r')
+    {
+      line.pop_back();
+    }
+    Query query;
+    bool valid = true;
+    switch (ParseQuery(line, query))
+    {
+    case QueryError::None:
+      break;
+    case QueryError::UnterminatedQuote:
+      cerr << T_("Unterminated quote in query.") << endl;
+      valid = false;
+      break;
+    case QueryError::UnknownOption:
+      cerr << fmt::format(T_("Unknown query option: {0}."), query.unknownOption) << endl;
+      valid = false;
+      break;
+    case QueryError::TrailingText:
+      cerr << T_("Unexpected text after the quoted file name.") << endl;
+      valid = false;
+      break;
+    }
+    FileType queryFileType = fileType;
+    bool queryAll = all || query.all;
+    if (valid && query.haveFileType)
+    {
+      queryFileType = session->DeriveFileType(PathName(query.fileType));
+      if (queryFileType == FileType::None)
+      {
+        cerr << fmt::format(T_("Unknown file type: {0}."), query.fileType) << endl;
+        valid = false;
+      }
+    }
+    if (valid && !query.fileName.empty())
+    {
+      const string& fileName = query.fileName;
+      try
+      {
+        if (FindFile(fileName, queryFileType, queryAll, result))
+        {
+          for (const PathName& path : result)
+          {
+            cout << path << "\n";
+          }
+        }
+      }
+      catch (const MiKTeXException& e)
+      {
+        cerr << fmt::format("{0}: {1}", fileName, e.GetErrorMessage()) << endl;
+      }
+      catch (const exception& e)
+      {
+        cerr << fmt::format("{0}: {1}", fileName, e.what()) << endl;
+      }
+    }
+    cout << endl;
+  }
+}
+
 int FindTeXMF::Run(int argc, const char** argv)
 {
   session = GetSession();
@@ -258,6 +395,11 @@ int FindTeXMF::Run(int argc, const char** argv)
       session->PushAppName(optArg);
       break;
 
+    case OPT_ALL:
+
+      all = true;
+      break;
+
     case OPT_EXPAND_VAR:
 
       cout << session->Expand(optArg, { ExpandOption::Values }, nullptr) << endl;
@@ -290,6 +432,11 @@ int FindTeXMF::Run(int argc, const char** argv)
       mustExist = true;
       break;
 
+    case OPT_SERVER:
+
+      server = true;
+      break;
+
     case OPT_SHOW_PATH:
 
     {
@@ -336,6 +483,16 @@ int FindTeXMF::Run(int argc, const char** argv)
 
   vector<string> leftovers = popt.GetLeftovers();
 
+  if (server)
+  {
+    if (!leftovers.empty() || start)
+    {
+      FatalError(T_("--stdin cannot be combined with file names or --start."));
+    }
+    Serve();
+    return EXIT_SUCCESS;
+  }
+
   if (leftovers.empty())
   {
     if (!needArg)
@@ -350,24 +507,19 @@ int FindTeXMF::Run(int argc, const char** argv)
 
   int exitCode = EXIT_SUCCESS;
 
+  vector<PathName> result;
+
   for (const string& fileName : leftovers)
   {
-    PathName path;
-    FileType filetype = fileType;
-    if (filetype == FileType::None)
+    if (FindFile(fileName, fileType, all, result))
     {
-      filetype = session->DeriveFileType(PathName(fileName));
-      if (filetype == FileType::None)
+      for (const PathName& path : result)
       {
-        filetype = FileType::TEX;
+        cout << path << endl;
       }
-    }
-    bool found = session->FindFile(fileName, filetype, path);
-    if (found)
-    {
-      cout << path << endl;
       if (start)
       {
+        const PathName& path = result[0];
 #if defined(MIKTEX_WINDOWS)
         PathName pathDir(path);
         pathDir.RemoveFileSpec();
@@ -0,0 +1,98 @@
+/* test/query.cpp: findtexmf query tests
+
+   Copyright (C) 2024 Christian Schenk
+
+   This file is part of FindTeXMF.
+
+   FindTeXMF is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published
+   by the Free Software Foundation; either version 2, or (at your
+   option) any later version.
+
+   FindTeXMF is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with FindTeXMF; if not, write to the Free Software
+   Foundation, 59 Temple Place - Suite 330, Boston, MA 02111-1307,
+   USA. */
+
+#include <iostream>
+#include <string>
+
+#include "Query.h"
+
+using namespace std;
+
+int failures = 0;
+
+void Check(const string& name, bool ok)
+{
+  if (!ok)
+  {
+    cerr << name << ": failed" << endl;
+    ++failures;
+  }
+}
+
+Query Parse(const string& line, QueryError expected = QueryError::None)
+{
+  Query query;
+  Check("error: " + line, ParseQuery(line, query) == expected);
+  return query;
+}
+
+// a bare file name, which may contain blanks
+void TestFileName()
+{
+  Query query = Parse("  article.cls \t");
+  Check("plain", query.fileName == "article.cls" && !query.all && !query.haveFileType);
+  query = Parse("my file.tex");
+  Check("blanks", query.fileName == "my file.tex");
+  query = Parse("C:\\texmf\\tex\\x.sty");
+  Check("backslashes", query.fileName == "C:\\texmf\\tex\\x.sty");
+  query = Parse("   ");
+  Check("empty", query.fileName.empty());
+}
+
+// file types with blanks must be quoted
+void TestOptions()
+{
+  Query query = Parse("--all --file-type=tex plain.tex");
+  Check("options", query.all && query.haveFileType && query.fileType == "tex" && query.fileName == "plain.tex");
+  query = Parse("-file-type=\"type1 fonts\" cmr10.pfb");
+  Check("quoted type", query.fileType == "type1 fonts" && query.fileName == "cmr10.pfb");
+  query = Parse("--file-type=\"opentype fonts\"\t--all\tlmroman10-regular.otf");
+  Check("tabs", query.fileType == "opentype fonts" && query.all && query.fileName == "lmroman10-regular.otf");
+  query = Parse("\"--all\"");
+  Check("quoted dash", !query.all && query.fileName == "--all");
+  query = Parse("-- --all");
+  Check("end of options", !query.all && query.fileName == "--all");
+  query = Parse("--format=tex x", QueryError::UnknownOption);
+  Check("unknown option", query.unknownOption == "--format=tex");
+  Parse("--all=yes x", QueryError::UnknownOption);
+  Parse("--file-type=\"type1 fonts cmr10.pfb", QueryError::UnterminatedQuote);
+}
+
+// a quoted file name
+void TestQuotedFileName()
+{
+  Query query = Parse("--all \"my file.tex\"  ");
+  Check("quoted name", query.all && query.fileName == "my file.tex");
+  query = Parse("\"say \\\"hello\\\".tex\"");
+  Check("escaped quote", query.fileName == "say \"hello\".tex");
+  query = Parse("\"a\\\\b\\c.tex\"");
+  Check("escaped backslash", query.fileName == "a\\b\\c.tex");
+  Parse("\"my file.tex\" x", QueryError::TrailingText);
+  Parse("\"my file.tex", QueryError::UnterminatedQuote);
+}
+
+int main()
+{
+  TestFileName();
+  TestOptions();
+  TestQuotedFileName();
+  return failures == 0 ? 0 : 1;
+}
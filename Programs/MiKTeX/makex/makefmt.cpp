@@ -15,7 +15,11 @@
 
 #include "makefmt-version.h"
 
+#include <lzma.h>
+#include <zlib.h>
+
 #include <miktex/Configuration/ConfigNames>
+#include <miktex/Core/File>
 #include <miktex/Core/TemporaryDirectory>
 #include <miktex/Util/Tokenizer>
 
@@ -125,6 +129,7 @@ public:
 private:
 
     PdfConfigValues ParsePdfConfigFiles() const;
+    void CompressFormatFile(const PathName& path);
     void CreateDestinationDirectory() override;
     void FindInputFile(const PathName& inputName, PathName& inputFile);
     void InstallPdftexConfigTeX() const;
@@ -320,6 +325,60 @@ void MakeFmt::CreateDestinationDirectory()
     destinationDirectory = CreateDirectoryFromTemplate(session->GetConfigValue(MIKTEX_CONFIG_SECTION_MAKEFMT, MIKTEX_CONFIG_VALUE_DESTDIR, &callback).GetString());
 }
 
+void MakeFmt::CompressFormatFile(const PathName& path)
+{
+    string codec = session->GetConfigValue(MIKTEX_CONFIG_SECTION_TEXANDFRIENDS, MIKTEX_CONFIG_VALUE_FORMAT_COMPRESSION, ConfigValue("none")).GetString();
+    if (codec.empty() || codec == "none")
+    {
+        return;
+    }
+    if (engine == Engine::HiTeX || engine == Engine::LuaTeX || engine == Engine::LuaHBTeX)
+    {
+        // these engines do not load formats through the TeXMF framework
+        return;
+    }
+    vector<unsigned char> data = File::ReadAllBytes(path);
+    vector<unsigned char> compressed;
+    if (codec == "gzip")
+    {
+        z_stream zs;
+        memset(&zs, 0, sizeof(zs));
+        if (deflateInit2(&zs, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 16 + MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+        {
+            FatalError(T_("The gzip encoder could not be initialized."));
+        }
+        compressed.resize(deflateBound(&zs, static_cast<uLong>(data.size())));
+        zs.next_in = data.data();
+        zs.avail_in = static_cast<uInt>(data.size());
+        zs.next_out = compressed.data();
+        zs.avail_out = static_cast<uInt>(compressed.size());
+        int ret = deflate(&zs, Z_FINISH);
+        compressed.resize(zs.total_out);
+        deflateEnd(&zs);
+        if (ret != Z_STREAM_END)
+        {
+            FatalError(fmt::format(T_("The format file could not be compressed (gzip error {0})."), ret));
+        }
+    }
+    else if (codec == "xz")
+    {
+        compressed.resize(lzma_stream_buffer_bound(data.size()));
+        size_t outPos = 0;
+        lzma_ret ret = lzma_easy_buffer_encode(LZMA_PRESET_DEFAULT, LZMA_CHECK_CRC32, nullptr, data.data(), data.size(), compressed.data(), &outPos, compressed.size());
+        if (ret != LZMA_OK)
+        {
+            FatalError(fmt::format(T_("The format file could not be compressed (xz error {0})."), static_cast<int>(ret)));
+        }
+        compressed.resize(outPos);
+    }
+    else
+    {
+        FatalError(fmt::format(T_("Unknown format file compression: {0}"), codec));
+    }
+    Verbose(fmt::format(T_("Compressing the format file ({0}): {1} -> {2} bytes..."), codec, data.size(), compressed.size()));
+    File::WriteBytes(path, compressed);
+}
+
 void MakeFmt::FindInputFile(const PathName& inputName, PathName& inputFile)
 {
     if (!session->FindFile(inputName.ToString(), FileType::TEX, inputFile))
@@ -498,7 +557,8 @@ void MakeFmt::Run(int argc, const char** argv)
         FatalError(fmt::format(T_("{0} failed on {1}."), GetEngineExeName(), Q_(name)));
     }
 
-    // install format file
+    // compress and install format file
+    CompressFormatFile(wrkDir->GetPathName() / formatFile.ToString());
     Install(wrkDir->GetPathName() / formatFile.ToString(), pathDest);
 }
 
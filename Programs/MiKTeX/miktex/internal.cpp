@@ -29,6 +29,15 @@ using namespace MiKTeX::Core;
 using namespace MiKTeX::Packages;
 using namespace MiKTeX::Util;
 
+int OneMiKTeXUtility::ParseThreadCount(ApplicationContext& ctx, const string& arg, const string& errorMessage)
+{
+    if (arg.empty() || arg.find_first_not_of("0123456789") != string::npos || arg.length() > 4)
+    {
+        ctx.ui->IncorrectUsage(fmt::format("{0}: {1}", arg, errorMessage));
+    }
+    return std::stoi(arg);
+}
+
 string OneMiKTeXUtility::Unescape(const string& s)
 {
     stringstream out;
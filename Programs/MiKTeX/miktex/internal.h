@@ -33,6 +33,7 @@ namespace OneMiKTeXUtility
     {
     public:
         virtual void RunProcess(const MiKTeX::Util::PathName& fileName, const std::vector<std::string>& arguments) = 0;
+        virtual void RunProcess(const MiKTeX::Util::PathName& fileName, const std::vector<std::string>& arguments, const std::string& jobName) = 0;
     };
 
     class MIKTEXNOVTABLE Program
@@ -101,6 +102,10 @@ namespace OneMiKTeXUtility
         return argv;
     }
 
+    /// Parses the argument of a --threads (or --jobs) option: a number
+    /// between 0 and 9999.
+    int ParseThreadCount(ApplicationContext& ctx, const std::string& arg, const std::string& errorMessage);
+
     std::string Unescape(const std::string& s);
     void ReadNames(const MiKTeX::Util::PathName& path, std::vector<std::string>& list);
 }
@@ -17,6 +17,7 @@
 #include <iomanip>
 #include <iostream>
 #include <map>
+#include <mutex>
 #include <string>
 #include <tuple>
 #include <vector>
@@ -243,6 +244,8 @@ private:
 
     void RunProcess(const MiKTeX::Util::PathName& fileName, const std::vector<std::string>& arguments) override;
 
+    void RunProcess(const MiKTeX::Util::PathName& fileName, const std::vector<std::string>& arguments, const std::string& jobName) override;
+
     std::vector<std::string> args;
     OneMiKTeXUtility::ApplicationContext ctx;
     MiKTeX::Configuration::TriState enableInstaller = MiKTeX::Configuration::TriState::Undetermined;
@@ -250,6 +253,7 @@ private:
     std::shared_ptr<MiKTeX::Packages::PackageManager> packageManager;
     std::shared_ptr<MiKTeX::Packages::PackageInstaller> packageInstaller;
     std::vector<MiKTeX::Trace::TraceCallback::TraceMessage> pendingTraceMessages;
+    std::mutex processOutputMutex;
     bool quiet = false;
     std::shared_ptr<MiKTeX::Core::Session> session;
     std::map<std::string, std::unique_ptr<OneMiKTeXUtility::Topics::Topic>> topics;
@@ -400,6 +404,11 @@ string Timestamp()
 }
 
 void MiKTeXApp::RunProcess(const PathName& fileName, const vector<string>& arguments)
+{
+    RunProcess(fileName, arguments, "");
+}
+
+void MiKTeXApp::RunProcess(const PathName& fileName, const vector<string>& arguments, const string& jobName)
 {
     ProcessOutput<4096> output;
     int exitCode;
@@ -407,7 +416,13 @@ void MiKTeXApp::RunProcess(const PathName& fileName, const vector<string>& argum
     if (!Process::Run(fileName, arguments, &output, &exitCode, &miktexException, nullptr) || exitCode != 0)
     {
         auto outputBytes = output.GetStandardOutput();
+        lock_guard<mutex> lockGuard(this->processOutputMutex);
         PathName outfile = this->session->GetSpecialPath(SpecialPath::LogDirectory) / fileName.GetFileNameWithoutExtension().ToString();
+        if (!jobName.empty())
+        {
+            outfile += "_";
+            outfile += jobName;
+        }
         outfile += "_";
         outfile += Timestamp().c_str();
         outfile.SetExtension(".out");
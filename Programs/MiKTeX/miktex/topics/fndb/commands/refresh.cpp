@@ -51,7 +51,7 @@ namespace
 
         std::string Synopsis() override
         {
-            return "refresh";
+            return "refresh [--threads <n>]";
         }
     };
 }
@@ -73,7 +73,7 @@ unique_ptr<Command> Commands::Refresh()
     return make_unique<RefreshCommand>();
 }
 
-void RefreshFilenameDatabase(ApplicationContext& ctx, const PathName& root)
+void RefreshFilenameDatabase(ApplicationContext& ctx, const PathName& root, unsigned numThreads)
 {
     if (!ctx.session->UnloadFilenameDatabase())
     {
@@ -89,16 +89,24 @@ void RefreshFilenameDatabase(ApplicationContext& ctx, const PathName& root)
     {
         ctx.ui->Verbose(1, fmt::format(T_("Creating FNDB for user root directory ({0})..."), Q_(root.ToDisplayString())));
     }
-    Fndb::Create(fndbPath, root, nullptr);
+    Fndb::Create(fndbPath, root, nullptr, true, false, numThreads);
 }
 
 enum Option
 {
     OPT_AAA = 1,
+    OPT_THREADS,
 };
 
 static const struct poptOption options[] =
 {
+    {
+        "threads", 0,
+        POPT_ARG_STRING, nullptr,
+        OPT_THREADS,
+        T_("Scan the root directories with n threads (0: one thread per processor).  The default is 1."),
+        "n"
+    },
     POPT_AUTOHELP
     POPT_TABLEEND
 };
@@ -108,8 +116,15 @@ int RefreshCommand::Execute(ApplicationContext& ctx, const vector<string>& argum
     auto argv = MakeArgv(arguments);
     PoptWrapper popt(static_cast<int>(argv.size() - 1), &argv[0], options);
     int option;
+    unsigned numThreads = 1;
     while ((option = popt.GetNextOpt()) >= 0)
     {
+        switch (option)
+        {
+        case OPT_THREADS:
+            numThreads = ParseThreadCount(ctx, popt.GetOptArg(), T_("invalid number of threads"));
+            break;
+        }
     }
     if (option != -1)
     {
@@ -126,7 +141,7 @@ int RefreshCommand::Execute(ApplicationContext& ctx, const vector<string>& argum
         {
             if (ctx.session->IsCommonRootDirectory(r))
             {
-                RefreshFilenameDatabase(ctx, ctx.session->GetRootDirectoryPath(r));
+                RefreshFilenameDatabase(ctx, ctx.session->GetRootDirectoryPath(r), numThreads);
             }
             else
             {
@@ -137,7 +152,7 @@ int RefreshCommand::Execute(ApplicationContext& ctx, const vector<string>& argum
         {
             if (!ctx.session->IsCommonRootDirectory(r) || ctx.session->IsMiKTeXPortable())
             {
-                RefreshFilenameDatabase(ctx, ctx.session->GetRootDirectoryPath(r));
+                RefreshFilenameDatabase(ctx, ctx.session->GetRootDirectoryPath(r), numThreads);
             }
             else
             {
@@ -0,0 +1,106 @@
+/**
+ * @file topics/fndb/commands/serve.cpp
+ * @author Christian Schenk
+ * @brief fndb serve
+ *
+ * @copyright Copyright © 2024 Christian Schenk
+ *
+ * This file is part of One MiKTeX Utility.
+ *
+ * One MiKTeX Utility is licensed under GNU General Public
+ * License version 2 or any later version.
+ */
+
+#include <config.h>
+
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fmt/format.h>
+#include <fmt/ostream.h>
+
+#include <miktex/Core/SessionCache>
+#include <miktex/Util/PathName>
+#include <miktex/Wrappers/PoptWrapper>
+
+#include "internal.h"
+
+#include "commands.h"
+
+namespace
+{
+    class ServeCommand :
+        public OneMiKTeXUtility::Topics::Command
+    {
+        std::string Description() override
+        {
+            return T_("Serve file lookups of other MiKTeX programs");
+        }
+
+        int MIKTEXTHISCALL Execute(OneMiKTeXUtility::ApplicationContext& ctx, const std::vector<std::string>& arguments) override;
+
+        std::string Name() override
+        {
+            return "serve";
+        }
+
+        std::string Synopsis() override
+        {
+            return "serve";
+        }
+    };
+}
+
+using namespace std;
+
+using namespace MiKTeX::Core;
+using namespace MiKTeX::Util;
+using namespace MiKTeX::Wrappers;
+
+using namespace OneMiKTeXUtility;
+using namespace OneMiKTeXUtility::Topics;
+using namespace OneMiKTeXUtility::Topics::FNDB;
+
+unique_ptr<Command> Commands::Serve()
+{
+    return make_unique<ServeCommand>();
+}
+
+static const struct poptOption options[] =
+{
+    POPT_AUTOHELP
+    POPT_TABLEEND
+};
+
+int ServeCommand::Execute(ApplicationContext& ctx, const vector<string>& arguments)
+{
+    auto argv = MakeArgv(arguments);
+    PoptWrapper popt(static_cast<int>(argv.size() - 1), &argv[0], options);
+    int option;
+    while ((option = popt.GetNextOpt()) >= 0)
+    {
+    }
+    if (option != -1)
+    {
+        ctx.ui->IncorrectUsage(fmt::format("{0}: {1}", popt.BadOption(POPT_BADOPTION_NOALIAS), popt.Strerror(option)));
+    }
+    if (!popt.GetLeftovers().empty())
+    {
+        ctx.ui->IncorrectUsage(T_("unexpected command arguments"));
+    }
+    auto server = SessionCacheServer::Create();
+    server->Start();
+    ctx.ui->Verbose(1, fmt::format(T_("Serving file lookups on {0}..."), Q_(server->GetSocketPath().ToDisplayString())));
+    while (!ctx.program->Canceled() && server->IsRunning())
+    {
+        this_thread::sleep_for(200ms);
+    }
+    if (!server->IsRunning())
+    {
+        ctx.ui->Verbose(1, T_("The root directory configuration has changed."));
+    }
+    server->Stop();
+    return 0;
+}
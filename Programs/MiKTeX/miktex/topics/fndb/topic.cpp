@@ -41,6 +41,7 @@ namespace
         {
             this->RegisterCommand(OneMiKTeXUtility::Topics::FNDB::Commands::Refresh());
             this->RegisterCommand(OneMiKTeXUtility::Topics::FNDB::Commands::Remove());
+            this->RegisterCommand(OneMiKTeXUtility::Topics::FNDB::Commands::Serve());
         }
     };
 }
@@ -448,7 +448,7 @@ bool Replace(string& s, const string& s2, const string& s3)
     return true;
 }
 
-bool FontMapManager::LocateFontMapFile(const string& fileNameTemplate, PathName& path, bool mustExist)
+string FontMapManager::ExpandFontMapFileName(const string& fileNameTemplate)
 {
     string fileName;
     fileName = fileNameTemplate;
@@ -457,6 +457,12 @@ bool FontMapManager::LocateFontMapFile(const string& fileNameTemplate, PathName&
     Replace(fileName, "@scEmbed@", this->Option("scEmbed"));
     Replace(fileName, "@tcEmbed@", this->Option("tcEmbed"));
     Replace(fileName, "@koEmbed@", this->Option("koEmbed"));
+    return fileName;
+}
+
+bool FontMapManager::LocateFontMapFile(const string& fileNameTemplate, PathName& path, bool mustExist)
+{
+    string fileName = ExpandFontMapFileName(fileNameTemplate);
     ctx->installer->EnableInstaller(mustExist);
     bool found = this->ctx->session->FindFile(fileName, FileType::MAP, path);
     ctx->installer->EnableInstaller(true);
@@ -471,6 +477,34 @@ bool FontMapManager::LocateFontMapFile(const string& fileNameTemplate, PathName&
     return found;
 }
 
+vector<PathName> FontMapManager::LocateFontMapFiles(const set<string>& fileNames)
+{
+    vector<FindRequest> requests;
+    for (const string& fn : fileNames)
+    {
+        FindRequest request;
+        request.fileName = ExpandFontMapFileName(fn);
+        request.options.fileType = FileType::MAP;
+        requests.push_back(request);
+    }
+    ctx->installer->EnableInstaller(false);
+    vector<LocateResult> results = this->ctx->session->FindFiles(requests);
+    ctx->installer->EnableInstaller(true);
+    vector<PathName> paths;
+    for (size_t idx = 0; idx < requests.size(); ++idx)
+    {
+        if (results[idx].pathNames.empty())
+        {
+            Verbose(3, fmt::format(T_("Not using font map file {0}"), Q_(requests[idx].fileName)));
+        }
+        else
+        {
+            paths.push_back(results[idx].pathNames[0]);
+        }
+    }
+    return paths;
+}
+
 void FontMapManager::WriteHeader(ostream& writer, const PathName& fileName)
 {
     writer
@@ -767,29 +801,19 @@ void FontMapManager::ReadDvipsFontMapFile(const string& fileName, set<DvipsFontM
 set<DvipsFontMapEntry> FontMapManager::CatDvipsFontMaps(const set<string>& fileNames)
 {
     set<DvipsFontMapEntry> result;
-    for (const string& fn : fileNames)
+    for (const PathName& path : LocateFontMapFiles(fileNames))
     {
-        ReadDvipsFontMapFile(fn, result, false);
+        ParseDvipsFontMapFile(path, result);
     }
     return result;
 }
 
-void FontMapManager::ReadDvipdfmxFontMapFile(const string& fileName, set<DvipdfmxFontMapEntry>& result, bool mustExist)
-{
-    PathName path;
-    if (!LocateFontMapFile(fileName, path, mustExist))
-    {
-        return;
-    }
-    ParseDvipdfmxFontMapFile(path, result);
-}
-
 set<DvipdfmxFontMapEntry> FontMapManager::CatDvipdfmxFontMaps(const set<string>& fileNames)
 {
     set<DvipdfmxFontMapEntry> result;
-    for (const string& fn : fileNames)
+    for (const PathName& path : LocateFontMapFiles(fileNames))
     {
-        ReadDvipdfmxFontMapFile(fn, result, false);
+        ParseDvipdfmxFontMapFile(path, result);
     }
     return result;
 }
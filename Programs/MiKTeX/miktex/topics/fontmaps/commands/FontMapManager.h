@@ -23,6 +23,7 @@
 #include <iostream>
 #include <map>
 #include <set>
+#include <vector>
 
 #include <miktex/Core/Utils>
 
@@ -89,11 +90,13 @@ private:
 
     void WriteConfigFile(const MiKTeX::Util::PathName& path, const Configuration& config);
 
+    std::string ExpandFontMapFileName(const std::string& fileNameTemplate);
+
     bool LocateFontMapFile(const std::string& fileName, MiKTeX::Util::PathName& path, bool mustExist);
 
-    void ReadDvipsFontMapFile(const std::string& fileName, std::set<MiKTeX::Core::DvipsFontMapEntry>& fontMapEntries, bool mustExist);
+    std::vector<MiKTeX::Util::PathName> LocateFontMapFiles(const std::set<std::string>& fileNames);
 
-    void ReadDvipdfmxFontMapFile(const std::string& fileName, std::set<DvipdfmxFontMapEntry>& fontMapEntries, bool mustExist);
+    void ReadDvipsFontMapFile(const std::string& fileName, std::set<MiKTeX::Core::DvipsFontMapEntry>& fontMapEntries, bool mustExist);
 
     void WriteHeader(std::ostream& writer, const MiKTeX::Util::PathName& fileName);
 
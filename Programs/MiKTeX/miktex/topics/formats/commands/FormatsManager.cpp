@@ -13,13 +13,20 @@
 
 #include <config.h>
 
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include <fmt/format.h>
 #include <fmt/ostream.h>
 
 #include <miktex/Configuration/ConfigurationProvider>
+#include <miktex/Core/Exceptions>
 #include <miktex/Core/Paths>
 #include <miktex/Core/Session>
 #include <miktex/Util/PathName>
@@ -41,16 +48,67 @@ void FormatsManager::Init(ApplicationContext& ctx)
     this->ctx = &ctx;
 }
 
-void FormatsManager::Build(const string& formatKey)
+void FormatsManager::Build(const vector<string>& formatKeys, unsigned numJobs)
+{
+    map<string, Job> jobs;
+    vector<string> order;
+    for (const auto& formatKey : formatKeys)
+    {
+        this->Plan(formatKey, jobs, order);
+    }
+    if (order.empty())
+    {
+        return;
+    }
+    if (numJobs == 0)
+    {
+        numJobs = std::max(thread::hardware_concurrency(), 1u);
+    }
+    numJobs = static_cast<unsigned>(std::min(static_cast<size_t>(numJobs), order.size()));
+    this->RunJobs(jobs, order, numJobs);
+    size_t numNotBuilt = 0;
+    for (const auto& formatKey : order)
+    {
+        const Job& job = jobs.at(formatKey);
+        if (job.state == JobState::Failed)
+        {
+            this->ctx->ui->Warning(fmt::format(T_("{0}: the format could not be built: {1}"), formatKey, job.errorMessage));
+            numNotBuilt++;
+        }
+        else if (job.state == JobState::Skipped)
+        {
+            this->ctx->ui->Warning(fmt::format(T_("{0}: the format has not been built: {1}"), formatKey, job.errorMessage));
+            numNotBuilt++;
+        }
+    }
+    if (numNotBuilt > 0)
+    {
+        this->ctx->ui->FatalError(fmt::format(T_("{0} of {1} formats could not be built"), numNotBuilt, order.size()));
+    }
+}
+
+void FormatsManager::Plan(const string& formatKey, map<string, Job>& jobs, vector<string>& order)
 {
     if (find(this->formatsMade.begin(), this->formatsMade.end(), formatKey) != this->formatsMade.end())
     {
         return;
     }
 
-    auto formatInfo = this->Format(formatKey);
+    auto it = jobs.find(formatKey);
+    if (it != jobs.end())
+    {
+        if (it->second.state == JobState::Planning)
+        {
+            this->ctx->ui->FatalError(fmt::format(T_("{0}: rule recursion"), formatKey));
+        }
+        return;
+    }
+
+    Job& job = jobs[formatKey];
+
+    job.formatInfo = this->Format(formatKey);
 
-    this->ctx->ui->Verbose(0, fmt::format(T_("Building format '{0}' with engine '{1}'..."), formatInfo.key, formatInfo.compiler));
+    const FormatInfo& formatInfo = job.formatInfo;
 
     string maker;
 
@@ -75,7 +133,13 @@ void FormatsManager::Build(const string& formatKey)
             this->ctx->ui->FatalError(fmt::format(T_("{0}: rule recursion"), formatKey));
         }
         // RECURSION
-        this->Build(formatInfo.preloaded);
+        this->Plan(formatInfo.preloaded, jobs, order);
+        auto preloadedJob = jobs.find(formatInfo.preloaded);
+        if (preloadedJob != jobs.end())
+        {
+            job.preloaded = formatInfo.preloaded;
+            preloadedJob->second.dependents.push_back(formatKey);
+        }
         arguments.push_back("--preload="s + formatInfo.preloaded);
     }
 
@@ -91,20 +155,137 @@ void FormatsManager::Build(const string& formatKey)
         arguments.push_back("--engine-option="s + a);
     }
 
-    this->RunMakeTeX(maker, arguments);
+    if (!this->ctx->session->FindFile(maker, FileType::EXE, job.exe))
+    {
+        this->ctx->ui->FatalError(fmt::format(T_("{0}: not found"), Q_(maker)));
+    }
 
-    this->formatsMade.push_back(formatKey);
+    job.arguments = this->MakeTeXArguments(maker, arguments);
+    job.state = job.preloaded.empty() ? JobState::Ready : JobState::Waiting;
+
+    order.push_back(formatKey);
 }
 
-void FormatsManager::RunMakeTeX(const string& makeProg, const vector<string>& arguments)
+void FormatsManager::RunJobs(map<string, Job>& jobs, const vector<string>& order, unsigned numJobs)
 {
-    PathName exe;
+    mutex jobsMutex;
+    condition_variable jobsChanged;
+    deque<string> readyJobs;
+    size_t numUnfinished = order.size();
+    bool canceled = false;
+
+    for (const auto& formatKey : order)
+    {
+        if (jobs.at(formatKey).state == JobState::Ready)
+        {
+            readyJobs.push_back(formatKey);
+        }
+    }
+
+    // must be called with jobsMutex held
+    auto skipDependents = [&](const string& formatKey, const string& reason)
+    {
+        vector<string> pending = jobs.at(formatKey).dependents;
+        while (!pending.empty())
+        {
+            Job& dependent = jobs.at(pending.back());
+            pending.pop_back();
+            if (dependent.state != JobState::Waiting)
+            {
+                continue;
+            }
+            dependent.state = JobState::Skipped;
+            dependent.errorMessage = reason;
+            numUnfinished--;
+            pending.insert(pending.end(), dependent.dependents.begin(), dependent.dependents.end());
+        }
+    };
 
-    if (!this->ctx->session->FindFile(makeProg, FileType::EXE, exe))
+    auto worker = [&]()
     {
-        this->ctx->ui->FatalError(fmt::format(T_("{0}: not found"), Q_(makeProg)));
+        unique_lock<mutex> lock(jobsMutex);
+        while (true)
+        {
+            jobsChanged.wait(lock, [&]() { return numUnfinished == 0 || !readyJobs.empty(); });
+            if (readyJobs.empty())
+            {
+                return;
+            }
+            string formatKey = readyJobs.front();
+            readyJobs.pop_front();
+            Job& job = jobs.at(formatKey);
+            if (canceled || this->ctx->program->Canceled())
+            {
+                canceled = true;
+                job.state = JobState::Skipped;
+                job.errorMessage = T_("the operation has been canceled");
+                numUnfinished--;
+                skipDependents(formatKey, job.errorMessage);
+                jobsChanged.notify_all();
+                continue;
+            }
+            job.state = JobState::Running;
+            this->ctx->ui->Verbose(0, fmt::format(T_("Building format '{0}' with engine '{1}'..."), job.formatInfo.key, job.formatInfo.compiler));
+            lock.unlock();
+            string errorMessage;
+            try
+            {
+                this->ctx->processRunner->RunProcess(job.exe, job.arguments, formatKey);
+            }
+            catch (const MiKTeXException& e)
+            {
+                errorMessage = e.GetErrorMessage();
+            }
+            catch (const exception& e)
+            {
+                errorMessage = e.what();
+            }
+            lock.lock();
+            numUnfinished--;
+            if (errorMessage.empty())
+            {
+                job.state = JobState::Done;
+                this->formatsMade.push_back(formatKey);
+                for (const auto& dependentKey : job.dependents)
+                {
+                    Job& dependent = jobs.at(dependentKey);
+                    if (dependent.state == JobState::Waiting)
+                    {
+                        dependent.state = JobState::Ready;
+                        readyJobs.push_back(dependentKey);
+                    }
+                }
+            }
+            else
+            {
+                job.state = JobState::Failed;
+                job.errorMessage = errorMessage;
+                skipDependents(formatKey, fmt::format(T_("the preloaded format '{0}' could not be built"), formatKey));
+            }
+            jobsChanged.notify_all();
+        }
+    };
+
+    if (numJobs <= 1)
+    {
+        worker();
+        return;
     }
 
+    vector<thread> threads;
+    threads.reserve(numJobs);
+    for (unsigned idx = 0; idx < numJobs; ++idx)
+    {
+        threads.push_back(thread(worker));
+    }
+    for (auto& t : threads)
+    {
+        t.join();
+    }
+}
+
+vector<string> FormatsManager::MakeTeXArguments(const string& makeProg, const vector<string>& arguments)
+{
     vector<string> xArguments{ makeProg };
 
     xArguments.insert(xArguments.end(), arguments.begin(), arguments.end());
@@ -136,7 +317,7 @@ void FormatsManager::RunMakeTeX(const string& makeProg, const vector<string>& ar
     xArguments.push_back("--miktex-disable-maintenance");
     xArguments.push_back("--miktex-disable-diagnose");
 
-    this->ctx->processRunner->RunProcess(exe, xArguments);
+    return xArguments;
 }
 
 vector<FormatInfo> FormatsManager::Formats()
@@ -11,6 +11,7 @@
  * License version 2 or any later version.
  */
 
+#include <map>
 #include <string>
 #include <vector>
 
@@ -24,12 +25,36 @@ public:
 
     MiKTeX::Core::FormatInfo Format(const std::string& formatKey);
     std::vector<MiKTeX::Core::FormatInfo> Formats();
-    void Build(const std::string& formatKey);
+    void Build(const std::vector<std::string>& formatKeys, unsigned numJobs);
     void Init(OneMiKTeXUtility::ApplicationContext& ctx);
 
 private:
 
-    void RunMakeTeX(const std::string& makeProg, const std::vector<std::string>& arguments);
+    enum class JobState
+    {
+        Planning,
+        Waiting,
+        Ready,
+        Running,
+        Done,
+        Failed,
+        Skipped
+    };
+
+    struct Job
+    {
+        std::vector<std::string> arguments;
+        std::vector<std::string> dependents;
+        std::string errorMessage;
+        MiKTeX::Util::PathName exe;
+        MiKTeX::Core::FormatInfo formatInfo;
+        std::string preloaded;
+        JobState state = JobState::Planning;
+    };
+
+    std::vector<std::string> MakeTeXArguments(const std::string& makeProg, const std::vector<std::string>& arguments);
+    void Plan(const std::string& formatKey, std::map<std::string, Job>& jobs, std::vector<std::string>& order);
+    void RunJobs(std::map<std::string, Job>& jobs, const std::vector<std::string>& order, unsigned numJobs);
 
     OneMiKTeXUtility::ApplicationContext* ctx;
     std::vector<std::string> formatsMade;
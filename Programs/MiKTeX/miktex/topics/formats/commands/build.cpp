@@ -47,7 +47,7 @@ namespace
 
         std::string Synopsis() override
         {
-            return "build [--engine <engine>] [<key>]";
+            return "build [--engine <engine>] [--jobs <n>] [<key>]";
         }
     };
 }
@@ -69,6 +69,7 @@ enum Option
 {
     OPT_AAA = 1,
     OPT_ENGINE,
+    OPT_JOBS,
 };
 
 static const struct poptOption options[] =
@@ -80,6 +81,13 @@ static const struct poptOption options[] =
         T_("Engine to be used."),
         T_("ENGINE")
     },
+    {
+        "jobs", 0,
+        POPT_ARG_STRING, nullptr,
+        OPT_JOBS,
+        T_("Build up to n formats at the same time.  0 means one job per processor.  The default is 1."),
+        T_("N")
+    },
     POPT_AUTOHELP
     POPT_TABLEEND
 };
@@ -90,6 +98,7 @@ int BuildCommand::Execute(ApplicationContext& ctx, const vector<string>& argumen
     PoptWrapper popt(static_cast<int>(argv.size() - 1), &argv[0], options);
     int option;
     string engine;
+    unsigned numJobs = 1;
     while ((option = popt.GetNextOpt()) >= 0)
     {
         switch (option)
@@ -97,6 +106,9 @@ int BuildCommand::Execute(ApplicationContext& ctx, const vector<string>& argumen
         case OPT_ENGINE:
             engine = popt.GetOptArg();
             break;
+        case OPT_JOBS:
+            numJobs = ParseThreadCount(ctx, popt.GetOptArg(), T_("invalid number of jobs"));
+            break;
         }
     }
     if (option != -1)
@@ -112,14 +124,16 @@ int BuildCommand::Execute(ApplicationContext& ctx, const vector<string>& argumen
     mgr.Init(ctx);
     if (leftOvers.empty())
     {
+        vector<string> keys;
         for (auto& f : mgr.Formats())
         {
             if (!engine.empty() && engine != f.compiler)
             {
                 continue;
             }
-            mgr.Build(f.key);
+            keys.push_back(f.key);
         }
+        mgr.Build(keys, numJobs);
     }
     else
     {
@@ -132,7 +146,7 @@ int BuildCommand::Execute(ApplicationContext& ctx, const vector<string>& argumen
                 ctx.ui->FatalError(fmt::format(T_("{0}: cannot be built by {1}"), key, engine));
             }
         }
-        mgr.Build(key);
+        mgr.Build(vector<string>{ key }, numJobs);
     }
     return 0;
 }
@@ -51,10 +51,27 @@ namespace
 
         std::string Synopsis() override
         {
-            return "verify [--package-id-file=FILE] [<package-id>...]";
+            return "verify [--fast] [--package-id-file=FILE] [--threads=N] [<package-id>...]";
         }
 
-        void Verify(OneMiKTeXUtility::ApplicationContext& ctx, const std::vector<std::string>& toBeVerified);
+        void Verify(OneMiKTeXUtility::ApplicationContext& ctx, const std::vector<std::string>& toBeVerified, const MiKTeX::Packages::VerifyOptions& verifyOptions);
+    };
+
+    class VerificationReporter :
+        public MiKTeX::Packages::PackageVerificationCallback
+    {
+    public:
+
+        VerificationReporter(OneMiKTeXUtility::ApplicationContext& ctx) :
+            ctx(ctx)
+        {
+        }
+
+        void MIKTEXTHISCALL OnPackageVerified(const std::string& packageId, bool ok) override;
+
+    private:
+
+        OneMiKTeXUtility::ApplicationContext& ctx;
     };
 }
 
@@ -77,11 +94,20 @@ unique_ptr<Command> Commands::Verify()
 enum Option
 {
     OPT_AAA = 1,
+    OPT_FAST,
     OPT_PACKAGE_ID_FILE,
+    OPT_THREADS,
 };
 
 static const struct poptOption options[] =
 {
+    {
+        "fast", 0,
+        POPT_ARG_NONE, nullptr,
+        OPT_FAST,
+        T_("Do not read files which are unchanged since the last successful verification."),
+        nullptr
+    },
     {
         "package-id-file", 0,
         POPT_ARG_STRING, nullptr,
@@ -89,6 +115,13 @@ static const struct poptOption options[] =
         T_("Read package IDs from file."),
         "FILE"
     },
+    {
+        "threads", 0,
+        POPT_ARG_STRING, nullptr,
+        OPT_THREADS,
+        T_("Read the package files with n threads.  The default (0) is one thread per processor."),
+        "n"
+    },
     POPT_AUTOHELP
     POPT_TABLEEND
 };
@@ -100,13 +133,20 @@ int VerifyCommand::Execute(ApplicationContext& ctx, const vector<string>& argume
     int option;
     string repository;
     vector<string> toBeVerified;
+    VerifyOptions verifyOptions;
     while ((option = popt.GetNextOpt()) >= 0)
     {
         switch (option)
         {
+        case OPT_FAST:
+            verifyOptions.useCache = true;
+            break;
         case OPT_PACKAGE_ID_FILE:
             ReadNames(PathName(popt.GetOptArg()), toBeVerified);
             break;
+        case OPT_THREADS:
+            verifyOptions.numThreads = ParseThreadCount(ctx, popt.GetOptArg(), T_("invalid number of threads"));
+            break;
         }
     }
     if (option != -1)
@@ -115,11 +155,23 @@ int VerifyCommand::Execute(ApplicationContext& ctx, const vector<string>& argume
     }
     auto leftOvers = popt.GetLeftovers();
     toBeVerified.insert(toBeVerified.end(), leftOvers.begin(), leftOvers.end());
-    Verify(ctx, toBeVerified);
+    Verify(ctx, toBeVerified, verifyOptions);
     return 0;
 }
 
-void VerifyCommand::Verify(ApplicationContext& ctx, const vector<string>& toBeVerifiedArg)
+void VerificationReporter::OnPackageVerified(const string& packageId, bool ok)
+{
+    if (ok)
+    {
+        ctx.ui->Verbose(1, fmt::format(T_("{0}: this package is correctly installed."), packageId));
+    }
+    else
+    {
+        ctx.ui->Verbose(0, fmt::format(T_("{0}: this package needs to be reinstalled."), packageId));
+    }
+}
+
+void VerifyCommand::Verify(ApplicationContext& ctx, const vector<string>& toBeVerifiedArg, const VerifyOptions& verifyOptions)
 {
     vector<string> toBeVerified = toBeVerifiedArg;
     bool verifyAll = toBeVerified.empty();
@@ -135,15 +187,8 @@ void VerifyCommand::Verify(ApplicationContext& ctx, const vector<string>& toBeVe
             }
         }
     }
-    bool ok = true;
-    for (const string& packageID : toBeVerified)
-    {
-        if (!ctx.packageManager->TryVerifyInstalledPackage(packageID))
-        {
-            ctx.ui->Verbose(0, fmt::format(T_("{0}: this package needs to be reinstalled."), packageID));
-            ok = false;
-        }
-    }
+    VerificationReporter reporter(ctx);
+    bool ok = ctx.packageManager->VerifyInstalledPackages(toBeVerified, verifyOptions, &reporter);
     if (ok)
     {
         if (verifyAll)
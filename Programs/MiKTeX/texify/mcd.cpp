@@ -34,9 +34,11 @@
 
 #include <cctype>
 #include <cstdlib>
+#include <cstring>
 
 #include <algorithm>
 #include <iostream>
+#include <map>
 #include <memory>
 #include <vector>
 
@@ -45,6 +47,7 @@
 #include <miktex/App/Application>
 #include <miktex/Core/BufferSizes>
 #include <miktex/Core/CommandLineBuilder>
+#include <miktex/Core/DependencyLog>
 #include <miktex/Core/Directory>
 #include <miktex/Core/DirectoryLister>
 #include <miktex/Core/Environment>
@@ -52,6 +55,7 @@
 #include <miktex/Core/File>
 #include <miktex/Core/FileStream>
 #include <miktex/Core/FileType>
+#include <miktex/Core/MD5>
 #include <miktex/Core/MemoryMappedFile>
 #include <miktex/Core/Paths>
 #include <miktex/Core/Process>
@@ -174,6 +178,11 @@ vector<char> ReadFile(const PathName& fileName)
   return vec;
 }
 
+bool StartsWith(const string& s, const char* prefix)
+{
+  return s.compare(0, strlen(prefix), prefix) == 0;
+}
+
 bool Contains(const PathName& fileName, regex_t* preg)
 {
   vector<char> file = ReadFile(fileName);
@@ -320,6 +329,9 @@ public:
 public:
   int maxIterations = 5;
 
+public:
+  bool trackDependencies = false;
+
 public:
   vector<string> includeDirectories;
 
@@ -648,6 +660,15 @@ private:
 private:
   void RunBibTeX();
 
+private:
+  bool MustRunBibTeX(const PathName& auxName, bool logRequestsRun);
+
+private:
+  MD5 GetBibTeXInputDigest(const PathName& auxName);
+
+private:
+  void UpdateBibTeXInputDigest(MD5Builder& md5Builder, const PathName& auxName, int level);
+
 private:
   PathName GetTeXEnginePath(string& exeName);
 
@@ -663,6 +684,12 @@ private:
 private:
   bool Ready();
 
+private:
+  void SaveXrefDigests();
+
+private:
+  bool XrefFilesUnchanged(const vector<DependencyLogRecord>& records);
+
 #if defined(WITH_TEXINFO)
 private:
   bool Check_texinfo_tex();
@@ -733,6 +760,25 @@ private:
 private:
   vector<string> previousAuxFiles;
 
+  // --track-dependencies: digests of the BibTeX input (per aux file)
+  // at the time BibTeX was last run
+private:
+  map<string, MD5> bibtexInputDigests;
+
+  // --track-dependencies: digests of the index files at the time the
+  // index generator was last run
+private:
+  map<string, MD5> indexFileDigests;
+
+  // --track-dependencies: digests of the xref files before the last
+  // TeX run
+private:
+  map<string, MD5> previousXrefDigests;
+
+  // --track-dependencies: xref files written by the last TeX run
+private:
+  vector<string> writtenXrefFiles;
+
 private:
   McdApp* app = nullptr;
 
@@ -1274,12 +1320,15 @@ void Driver::RunBibTeX()
 
   int exitCode;
 
+  bool logRequestsRun = File::Exists(logName)
+    && (Contains(logName, &options->regex_citation_undefined)
+      || Contains(logName, &options->regex_no_file_bbl));
+
 #if defined(SF464378__CHAPTERBIB)
   if ((File::Exists(auxName)
     && File::Exists(logName)
     && Contains(logName, &options->regex_chapterbib)
-    && (Contains(logName, &options->regex_citation_undefined)
-      || Contains(logName, &options->regex_no_file_bbl))))
+    && (logRequestsRun || options->trackDependencies)))
   {
     app->Verbose(T_("ChapterBib detected. Preparing to run BibTeX on first-level aux files..."));
 
@@ -1299,7 +1348,8 @@ void Driver::RunBibTeX()
       subAuxName.AppendExtension(".aux");
       if (!(File::Exists(subAuxName)
         && Contains(subAuxName, &options->regex_bibdata)
-        && Contains(subAuxName, &options->regex_bibstyle)))
+        && Contains(subAuxName, &options->regex_bibstyle)
+        && MustRunBibTeX(subAuxName, logRequestsRun)))
       {
         continue;
       }
@@ -1341,9 +1391,7 @@ void Driver::RunBibTeX()
   if (!(File::Exists(auxName)
     && Contains(auxName, &options->regex_bibdata)
     && Contains(auxName, &options->regex_bibstyle)
-    && File::Exists(logName)
-    && (Contains(logName, &options->regex_citation_undefined)
-      || Contains(logName, &options->regex_no_file_bbl))))
+    && MustRunBibTeX(auxName, logRequestsRun)))
   {
     return;
   }
@@ -1364,6 +1412,120 @@ void Driver::RunBibTeX()
   }
 }
 
+/* _________________________________________________________________________
+
+   Driver::MustRunBibTeX
+
+   Decide if BibTeX has to be run on the given aux file.  Normally, we
+   ask the log file (citations undefined, .bbl file missing).  With
+   --track-dependencies, the log file decides only until BibTeX has
+   been run once; afterwards BibTeX is run again only if its input
+   (citations, databases, style) has changed.
+   _________________________________________________________________________ */
+
+bool Driver::MustRunBibTeX(const PathName& auxName, bool logRequestsRun)
+{
+  if (!options->trackDependencies)
+  {
+    return logRequestsRun;
+  }
+  MD5 digest = GetBibTeXInputDigest(auxName);
+  auto it = bibtexInputDigests.find(auxName.ToString());
+  if (it == bibtexInputDigests.end())
+  {
+    if (!logRequestsRun)
+    {
+      return false;
+    }
+  }
+  else if (it->second == digest)
+  {
+    app->Verbose(fmt::format(T_("BibTeX input of {} has not changed"), Q_(auxName)));
+    return false;
+  }
+  bibtexInputDigests[auxName.ToString()] = digest;
+  return true;
+}
+
+MD5 Driver::GetBibTeXInputDigest(const PathName& auxName)
+{
+  MD5Builder md5Builder;
+  UpdateBibTeXInputDigest(md5Builder, auxName, 0);
+  return md5Builder.Final();
+}
+
+/* _________________________________________________________________________
+
+   Driver::UpdateBibTeXInputDigest
+
+   Hash everything BibTeX reads: the \citation, \bibdata and \bibstyle
+   lines of the aux file (and of the aux files it \@inputs) and the
+   contents of the .bib and .bst files.
+   _________________________________________________________________________ */
+
+void Driver::UpdateBibTeXInputDigest(MD5Builder& md5Builder, const PathName& auxName, int level)
+{
+  const int maxAuxNesting = 10;
+  if (level > maxAuxNesting || !File::Exists(auxName))
+  {
+    return;
+  }
+  vector<char> auxFile = ReadFile(auxName);
+  const char* lpsz = &auxFile[0];
+  while (*lpsz != 0)
+  {
+    const char* lpszEnd = strchr(lpsz, '\n');
+    if (lpszEnd == nullptr)
+    {
+      lpszEnd = lpsz + strlen(lpsz);
+    }
+    string line(lpsz, lpszEnd);
+    lpsz = *lpszEnd == 0 ? lpszEnd : lpszEnd + 1;
+    FileType fileType = FileType::None;
+    if (StartsWith(line, "\\bibdata{"))
+    {
+      fileType = FileType::BIB;
+    }
+    else if (StartsWith(line, "\\bibstyle{"))
+    {
+      fileType = FileType::BST;
+    }
+    else if (StartsWith(line, "\\@input{"))
+    {
+      size_t end = line.find('}');
+      if (end != string::npos)
+      {
+        UpdateBibTeXInputDigest(md5Builder, PathName(line.substr(8, end - 8)), level + 1);
+      }
+      continue;
+    }
+    else if (!StartsWith(line, "\\citation{"))
+    {
+      continue;
+    }
+    md5Builder.Update(line.c_str(), line.length());
+    if (fileType == FileType::None)
+    {
+      continue;
+    }
+    size_t start = line.find('{') + 1;
+    size_t end = line.find('}', start);
+    if (end == string::npos)
+    {
+      continue;
+    }
+    for (const string& name : StringUtil::Split(line.substr(start, end - start), ','))
+    {
+      PathName path;
+      if (session->FindFile(name, fileType, path))
+      {
+        MD5 md5 = MD5::FromFile(path);
+        md5Builder.Update(md5.data(), md5.size());
+      }
+    }
+  }
+}
+
 /* _________________________________________________________________________
 
    Driver::RunIndexGenerator
@@ -1372,10 +1534,38 @@ void Driver::RunBibTeX()
    already exist, and after running TeX a first time the index files
    don't change, then there's no reason to run TeX again.  But we
    won't know that if the index files are out of date or nonexistent.
+
+   With --track-dependencies, index files which have not changed
+   since the index generator was last run are skipped.
    _________________________________________________________________________ */
 
-void Driver::RunIndexGenerator(const vector<string>& idxFiles)
+void Driver::RunIndexGenerator(const vector<string>& allIdxFiles)
 {
+  vector<string> idxFiles;
+  if (options->trackDependencies)
+  {
+    for (const string& idx : allIdxFiles)
+    {
+      MD5 digest = MD5::FromFile(PathName(idx));
+      auto it = indexFileDigests.find(idx);
+      if (it != indexFileDigests.end() && it->second == digest)
+      {
+        app->Verbose(fmt::format(T_("index file {} has not changed"), Q_(idx)));
+        continue;
+      }
+      indexFileDigests[idx] = digest;
+      idxFiles.push_back(idx);
+    }
+    if (idxFiles.empty())
+    {
+      return;
+    }
+  }
+  else
+  {
+    idxFiles = allIdxFiles;
+  }
+
 #if defined(WITH_TEXINFO)
   const string indexGenerator = macroLanguage == MacroLanguage::Texinfo
     ? options->texindexProgram
@@ -1533,6 +1723,10 @@ void Driver::RunTeX()
   {
     args.push_back("--interaction="s + "scrollmode");
   }
+  if (options->trackDependencies)
+  {
+    args.push_back("--record-dependencies");
+  }
   args.insert(args.end(), options->texOptions.begin(), options->texOptions.end());
 #if 0
   if (options->traceStreams.length() > 0)
@@ -1576,6 +1770,10 @@ void Driver::RunTeX()
    since texi2dvi does not try to compare xref files in subdirs.
    Performing xref files test is still good since LaTeX does not
    report changes in xref files.
+
+   With --track-dependencies, the dependency log of the TeX run tells
+   which files have been written; we are done, if none of them has
+   changed.  The log file is not consulted in that case.
    _________________________________________________________________________ */
 
 bool Driver::Ready()
@@ -1583,11 +1781,23 @@ bool Driver::Ready()
   PathName logName(jobName);
   logName.AppendExtension(".log");
 
+  // packages ask for another run, even if no xref file has changed
   if (Contains(logName, "Rerun to get"))
   {
     return false;
   }
 
+  if (options->trackDependencies)
+  {
+    PathName depName(jobName);
+    depName.AppendExtension(".dep");
+    if (File::Exists(depName))
+    {
+      return XrefFilesUnchanged(DependencyLog::Read(depName));
+    }
+    app->Verbose(fmt::format(T_("dependency log {} not found; comparing xref files"), Q_(depName)));
+  }
+
   vector<string> auxFiles;
 
   GetAuxFiles(auxFiles);
@@ -1618,6 +1828,72 @@ bool Driver::Ready()
   return true;
 }
 
+/* _________________________________________________________________________
+
+   Driver::SaveXrefDigests
+
+   Remember the contents of the xref files, i.e., of the files written
+   by the last TeX run (and of the usual suspects, in case there was
+   no last run).
+   _________________________________________________________________________ */
+
+void Driver::SaveXrefDigests()
+{
+  vector<string> xrefFiles = writtenXrefFiles;
+  vector<string> auxFiles;
+  GetAuxFiles(auxFiles);
+  for (const string& aux : auxFiles)
+  {
+    PathName path(aux);
+    path.MakeFullyQualified();
+    xrefFiles.push_back(path.ToString());
+  }
+  previousXrefDigests.clear();
+  for (const string& xref : xrefFiles)
+  {
+    PathName path(xref);
+    if (previousXrefDigests.find(xref) == previousXrefDigests.end() && File::Exists(path))
+    {
+      previousXrefDigests[xref] = MD5::FromFile(path);
+    }
+  }
+}
+
+bool Driver::XrefFilesUnchanged(const vector<DependencyLogRecord>& records)
+{
+  bool unchanged = true;
+  writtenXrefFiles.clear();
+  for (const DependencyLogRecord& record : records)
+  {
+    if (record.access == FileAccess::Read)
+    {
+      continue;
+    }
+    // the job's results change on every run
+    PathName fileName = record.path.GetFileName();
+    if (fileName.HasExtension(".log")
+      || fileName.HasExtension(".dvi")
+      || fileName.HasExtension(".xdv")
+      || fileName.HasExtension(".pdf")
+      || fileName.HasExtension(".synctex")
+      || fileName.HasExtension(".gz")
+      || fileName.HasExtension(".fls"))
+    {
+      continue;
+    }
+    PathName path(record.path);
+    path.MakeFullyQualified();
+    writtenXrefFiles.push_back(path.ToString());
+    auto it = previousXrefDigests.find(path.ToString());
+    if (unchanged && (it == previousXrefDigests.end() || it->second != record.md5))
+    {
+      app->Verbose(fmt::format(T_("xref file {} differed..."), Q_(record.path)));
+      unchanged = false;
+    }
+  }
+  return unchanged;
+}
+
 void Driver::InstallOutputFile()
 {
   const char* ext = options->outputType == OutputType::PDF ? ".pdf" : ".dvi";
@@ -1793,6 +2069,10 @@ void Driver::Run()
       RunIndexGenerator(idxFiles);
     }
     app->CheckCancel();
+    if (options->trackDependencies)
+    {
+      SaveXrefDigests();
+    }
     RunTeX();
     if (Ready())
     {
@@ -1845,6 +2125,7 @@ enum CommandLineOptions {
 #endif
   OPT_TEX_OPTION,
   OPT_TRACE,
+  OPT_TRACK_DEPENDENCIES,
   OPT_VERBOSE,
   OPT_VERSION,
   OPT_VIEWER_OPTION,
@@ -2041,6 +2322,14 @@ const struct poptOption optionTable[] = {
     T_("TRACESTREAMS"),
   },
 
+  {
+    "track-dependencies", 0,
+    POPT_ARG_NONE, nullptr,
+    OPT_TRACK_DEPENDENCIES,
+    T_("Decide by content hashes whether BibTeX, the index generator and TeX have to be run again."),
+    nullptr,
+  },
+
   {
     "run-viewer", 0,
     POPT_ARG_NONE, nullptr,
@@ -2219,6 +2508,9 @@ void McdApp::Run(int argc, const char** argv)
         options.traceStreams = optArg;
       }
       break;
+    case OPT_TRACK_DEPENDENCIES:
+      options.trackDependencies = true;
+      break;
     }
   }
 
@@ -0,0 +1,17 @@
+## compress.cmake
+##
+## Copyright (C) 2024 Christian Schenk
+## 
+## This file is free software; the copyright holder gives
+## unlimited permission to copy and/or distribute it, with or
+## without modifications, as long as this notice is preserved.
+
+## write INPUT compressed with CODEC (GZip, XZ) to OUTPUT, the way
+## makefmt compresses format files (no archive container)
+
+file(ARCHIVE_CREATE
+    OUTPUT ${OUTPUT}
+    PATHS ${INPUT}
+    FORMAT raw
+    COMPRESSION ${CODEC}
+)
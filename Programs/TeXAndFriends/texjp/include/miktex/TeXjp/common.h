@@ -3,7 +3,7 @@
  * @author Christian Schenk
  * @brief MiKTeX TeXjp base classes
  *
- * @copyright Copyright © 2021-2022 Christian Schenk
+ * @copyright Copyright © 2021-2024 Christian Schenk
  *
  * This file is free software; the copyright holder gives unlimited permission
  * to copy and/or distribute it, with or without modifications, as long as this
@@ -52,6 +52,18 @@ template<class FileType> inline void miktexwritechar(FileType& f, C4P::C4P_unsig
     putc2(static_cast<int>(ch), f);
 }
 
+// the format file may be mapped or compressed, i.e., the kanji encoding
+// must be read through the same cursor as the rest of the format file
+template<class FileType> inline void miktexundumpkanji(FileType& f)
+{
+    char buffer[12];
+    MiKTeX::TeXAndFriends::TeXMFApp::GetTeXMFApp()->Undump(f, buffer[0], sizeof(buffer));
+    undump_kanji_buffer(buffer);
+}
+
+#undef undumpkanji
+#define undumpkanji miktexundumpkanji
+
 namespace MiKTeX
 {
     namespace TeXjp
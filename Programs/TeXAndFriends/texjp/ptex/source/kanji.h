@@ -89,6 +89,7 @@ inline long inputline2(FILE* f, unsigned char* buffer, long pos, const long buff
 #if defined(MIKTEX)
 extern void dump_kanji(FILE* fp);
 extern void undump_kanji(FILE* fp);
+extern void undump_kanji_buffer(char* buffer);
 #else
 extern void dump_kanji (gzFile fp);
 extern void undump_kanji (gzFile fp);
@@ -52,8 +52,10 @@ void undump_kanji (gzFile fp)
 #endif
 {
     char buffer[12];
+#if !defined(MIKTEX)
     char *p;
     int i;
+#endif
 
 #if defined(MIKTEX)
 #if !defined(FMT_COMPRESS)
@@ -67,6 +69,17 @@ void undump_kanji (gzFile fp)
 #endif
 #else
     do_undump (buffer, 1, 12, fp);
+#endif
+#if defined(MIKTEX)
+    undump_kanji_buffer(buffer);
+}
+
+/* BUFFER holds the 12 bytes dumped by dump_kanji().  */
+void undump_kanji_buffer(char* buffer)
+{
+    char *p;
+    int i;
+
 #endif
     buffer[11] = 0;  /* force string termination, just in case */
 
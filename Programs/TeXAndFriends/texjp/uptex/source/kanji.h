@@ -84,6 +84,7 @@ extern void init_kanji (const_string file_str, const_string internal_str);
 #if defined(MIKTEX)
 extern void dump_kanji(FILE* fp);
 extern void undump_kanji(FILE* fp);
+extern void undump_kanji_buffer(char* buffer);
 #else
 extern void dump_kanji (gzFile fp);
 extern void undump_kanji (gzFile fp);
@@ -42,6 +42,7 @@ set(MIKTEX_CONFIG_VALUE_EDITOR "Editor")
 set(MIKTEX_CONFIG_VALUE_ENVVARS "EnvVars[]")
 set(MIKTEX_CONFIG_VALUE_EXTENSIONS "Extensions[]")
 set(MIKTEX_CONFIG_VALUE_FORCE_LOCAL_SERVER "ForceLocalServer")
+set(MIKTEX_CONFIG_VALUE_FORMAT_COMPRESSION "FormatCompression")
 set(MIKTEX_CONFIG_VALUE_GUESS_INPUT_KANJI_ENCODING "GuessInputKanjiEncoding")
 set(MIKTEX_CONFIG_VALUE_GUI_FRAMEWORK "GUIFramework")
 set(MIKTEX_CONFIG_VALUE_LAST_ADMIN_DIAGNOSE "LastAdminDiagnose")
@@ -55,6 +56,7 @@ set(MIKTEX_CONFIG_VALUE_LAST_USER_UPDATE "LastUserUpdate")
 set(MIKTEX_CONFIG_VALUE_LAST_USER_UPDATE_CHECK "LastUserUpdateCheck")
 set(MIKTEX_CONFIG_VALUE_LAST_USER_UPDATE_DB  "LastUserUpdateDb")
 set(MIKTEX_CONFIG_VALUE_LOCAL_REPOSITORY "LocalRepository")
+set(MIKTEX_CONFIG_VALUE_MAX_PARALLEL_DOWNLOADS "MaxParallelDownloads")
 set(MIKTEX_CONFIG_VALUE_MIKTEXDIRECT_ROOT "MiKTeXDirectRoot")
 set(MIKTEX_CONFIG_VALUE_NO_REGISTRY "NoRegistry")
 set(MIKTEX_CONFIG_VALUE_OTHER_COMMON_ROOTS "OtherCommonRoots")